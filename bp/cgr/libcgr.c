@@ -16,43 +16,171 @@
 #define CGRDEBUG	0
 #endif
 
+/*	Number of worker threads, in addition to the calling thread,
+ *	that run independent series of Dijkstra searches in parallel.
+ *	Define as 0 to compute all routes in the calling thread.	*/
+
+#ifndef CGR_THREADS
+#define	CGR_THREADS	2
+#endif
+
+/*	Maximum number of nodes whose route lists are computed in
+ *	parallel, in a single transaction, by cgr_precompute.		*/
+
+#ifndef CGR_PRECOMPUTE_BATCH
+#define	CGR_PRECOMPUTE_BATCH	4
+#endif
+
 #define	MAX_TIME	((unsigned int) ((1U << 31) - 1))
 
 /*		CGR-specific RFX data structures.			*/
 
+/*	For each contact on any computed route, the CGR database
+ *	retains a list of the routes that traverse that contact, so
+ *	that removal of the contact from the contact plan can be
+ *	applied only to those routes.  Citations are keyed by the
+ *	contact's identifying fields rather than by the address of
+ *	its IonCXref, since that address may already have been
+ *	reused by the time the removal is noted.			*/
+
+typedef struct
+{
+	uvast		fromNode;
+	uvast		toNode;
+	time_t		fromTime;
+	PsmAddress	routes;		/*	SM list: CgrRoute	*/
+} CgrCitation;		/*	CgrVdb citations tree is of these.	*/
+
+/*	All Dijkstra searches operate on a snapshot of the contact
+ *	graph that is held by each process, rather than on the
+ *	contact index itself.  The snapshot is a structure of arrays,
+ *	one element per contact, in contact index order (that is,
+ *	ordered by "from" node, "to" node, and start time), so the
+ *	contacts from each node are contiguous; the contacts from
+ *	node nodeNbr[n] are numbered firstContact[n] through
+ *	firstContact[n + 1] - 1.  Contacts for which no range is
+ *	known can never be used and are omitted.  The snapshot is
+ *	never modified once built, so any number of threads may
+ *	search it at once.  It is rebuilt whenever the CGR database's
+ *	graphVersion changes, i.e., whenever a contact or range is
+ *	inserted or removed.  Since no other process ever uses the
+ *	snapshot, it is allocated from the process's own heap rather
+ *	than from ION working memory.					*/
+
+typedef struct
+{
+	unsigned long	version;	/*	Of CgrVdb graph.	*/
+	int		contactsCount;
+	int		nodesCount;
+
+	/*	Per-contact arrays.					*/
+
+	uvast		*fromNode;
+	uvast		*toNode;
+	time_t		*fromTime;	/*	As from time(2).	*/
+	time_t		*toTime;	/*	As from time(2).	*/
+	uvast		*capacity;	/*	Bytes.			*/
+	unsigned int	*owlt;		/*	Including margin.	*/
+	int		*toNodeIdx;	/*	-1 if no contacts from.	*/
+	PsmAddress	*cxref;		/*	IonCXref address.	*/
+
+	/*	Per-node arrays.					*/
+
+	uvast		*nodeNbr;
+	int		*firstContact;	/*	nodesCount + 1 entries.	*/
+} CgrGraph;
+
+/*	Each thread that searches the graph has its own Dijkstra
+ *	work areas, one element per contact in the snapshot.  The
+ *	set of reached but unvisited contacts is a binary min-heap
+ *	keyed on arrival time.  A contact is simply re-inserted when
+ *	its arrival time improves; entries that have become stale are
+ *	discarded as they reach the top of the heap.  Like the
+ *	snapshot, the work areas are in the process's own heap.	*/
+
 typedef struct
 {
-	/*	Contact that forms the initial hop of the route.	*/
+	time_t		arrivalTime;	/*	As from time(2).	*/
+	int		contact;	/*	Index in CgrGraph.	*/
+} CgrHeapEntry;
 
-	uvast		toNodeNbr;	/*	Initial-hop neighbor.	*/
-	time_t		fromTime;	/*	As from time(2).	*/
-	time_t		toTime;		/*	As from time(2).	*/
+typedef struct
+{
+	CgrHeapEntry	*entries;
+	int		count;
+	int		capacity;
+} CgrHeap;
 
-	/*	Details of the route.					*/
+typedef struct
+{
+	int		capacity;	/*	Max contacts in graph.	*/
+	int		*predecessor;	/*	-1 = root of search.	*/
+	time_t		*arrivalTime;	/*	As from time(2).	*/
+	unsigned char	*visited;	/*	Boolean.		*/
+	unsigned char	*suppressed;	/*	Boolean.		*/
+	int		*hops;		/*	Path found by search.	*/
+	CgrHeap		heap;
+} CgrSearch;
+
+/*	In a series of searches implementing Yen's algorithm, each
+ *	path found is retained in private memory until the series is
+ *	complete.  The path's spurIdx is the index of the first hop
+ *	at which it deviates from the path from which it was derived.	*/
 
+typedef struct
+{
 	time_t		deliveryTime;	/*	As from time(2).	*/
-	PsmAddress	hops;		/*	SM list: IonCXref addr	*/
-	uvast		maxCapacity;
-	int		payloadClass;
-} CgrRoute;		/*	IonNode routingObject is list of these.	*/
+	int		spurIdx;
+	int		hopsCount;
+	int		*hops;		/*	Indices in CgrGraph.	*/
+} CgrPath;
+
+/*	A series of Dijkstra searches computes all routes of one
+ *	payload class to one station node.  Series are independent
+ *	of one another, so they are distributed among the threads of
+ *	a pool.  Each series only creates routes of its own; citing
+ *	the routes' contacts and inserting the routes into the
+ *	station node's list of routes is left to the calling thread.	*/
 
 typedef struct
 {
-	/*	Working values, reset for each Dijkstra run.		*/
+	CgrGraph	*graph;
+	IonNode		*stationNode;
+	time_t		currentTime;
+	int		payloadClass;
+	int		maxRoutes;	/*	0 = one per lead.	*/
+	PsmAddress	routes;		/*	SM list: CgrRoute	*/
+	int		result;		/*	0 or -1.		*/
+} CgrSeries;
 
-	IonCXref	*predecessor;	/*	On path to destination.	*/
-	uvast		capacity;
-	time_t		arrivalTime;	/*	As from time(2).	*/
-	int		visited;	/*	Boolean.		*/
-	int		suppressed;	/*	Boolean.		*/
-} CgrContactNote;	/*	IonCXref routingObject is one of these.	*/
+typedef struct
+{
+	pthread_mutex_t	mutex;
+	pthread_cond_t	workAvailable;
+	pthread_cond_t	workFinished;
+	CgrSeries	*series;
+	int		seriesCount;
+	int		nextSeries;
+	int		unfinished;
+	int		stopping;
+	int		threadsCount;
+	pthread_t	threads[CGR_THREADS + 1];
+
+	/*	Work areas of the worker threads, followed by the
+	 *	work area of the calling thread.			*/
+
+	CgrSearch	searches[CGR_THREADS + 1];
+} CgrPool;
 
 /*		Data structure for the CGR volatile database.		*/
 
 typedef struct
 {
 	time_t		lastLoadTime;	/*	Add/del contacts/ranges	*/
+	unsigned long	graphVersion;	/*	Incremented on edits.	*/
 	PsmAddress	routeLists;	/*	SM list: CgrRoute list	*/
+	PsmAddress	citations;	/*	SM RB tree: CgrCitation	*/
+	PsmAddress	revisedLists;	/*	SM list: CgrRoute list	*/
 } CgrVdb;
 
 /*		Data structure for temporary linked list.		*/
@@ -83,12 +211,164 @@ static uvast	_minCapacity(int payloadClass)
 
 /*		Functions for managing the CGR database.		*/
 
+static CgrVdb	*_cgrvdb(char **name);
+
+static int	orderCitations(PsmPartition partition, PsmAddress nodeData,
+			void *dataBuffer)
+{
+	CgrCitation	*argCitation;
+	CgrCitation	*citation;
+
+	argCitation = (CgrCitation *) dataBuffer;
+	citation = (CgrCitation *) psp(partition, nodeData);
+	if (citation->fromNode < argCitation->fromNode) return -1;
+	if (citation->fromNode > argCitation->fromNode) return 1;
+	if (citation->toNode < argCitation->toNode) return -1;
+	if (citation->toNode > argCitation->toNode) return 1;
+	if (citation->fromTime < argCitation->fromTime) return -1;
+	if (citation->fromTime > argCitation->fromTime) return 1;
+	return 0;
+}
+
+static CgrCitation	*findCitation(PsmPartition ionwm, CgrVdb *vdb,
+				uvast fromNode, uvast toNode, time_t fromTime)
+{
+	CgrCitation	arg;
+	PsmAddress	elt;
+	PsmAddress	nextElt;
+
+	arg.fromNode = fromNode;
+	arg.toNode = toNode;
+	arg.fromTime = fromTime;
+	elt = sm_rbt_search(ionwm, vdb->citations, orderCitations, &arg,
+			&nextElt);
+	if (elt == 0)
+	{
+		return NULL;
+	}
+
+	return (CgrCitation *) psp(ionwm, sm_rbt_data(ionwm, elt));
+}
+
+static int	citeContacts(PsmPartition ionwm, PsmAddress routeAddr)
+{
+	CgrVdb		*vdb = _cgrvdb(NULL);
+	CgrRoute	*route = (CgrRoute *) psp(ionwm, routeAddr);
+	PsmAddress	elt;
+	IonCXref	*contact;
+	CgrCitation	*citation;
+	PsmAddress	addr;
+	PsmAddress	citeElt;
+
+	/*	Note that each contact on this route is cited by the
+	 *	route, creating the contact's citation as necessary.	*/
+
+	for (elt = sm_list_first(ionwm, route->hops); elt;
+			elt = sm_list_next(ionwm, elt))
+	{
+		contact = (IonCXref *) psp(ionwm, sm_list_data(ionwm, elt));
+		citation = findCitation(ionwm, vdb, contact->fromNode,
+				contact->toNode, contact->fromTime);
+		if (citation == NULL)
+		{
+			addr = psm_zalloc(ionwm, sizeof(CgrCitation));
+			if (addr == 0)
+			{
+				putErrmsg("Can't create CGR citation.", NULL);
+				return -1;
+			}
+
+			citation = (CgrCitation *) psp(ionwm, addr);
+			citation->fromNode = contact->fromNode;
+			citation->toNode = contact->toNode;
+			citation->fromTime = contact->fromTime;
+			citation->routes = sm_list_create(ionwm);
+			if (citation->routes == 0)
+			{
+				psm_free(ionwm, addr);
+				putErrmsg("Can't create CGR citation.", NULL);
+				return -1;
+			}
+
+			oK(sm_list_user_data_set(ionwm, citation->routes,
+					addr));
+			if (sm_rbt_insert(ionwm, vdb->citations, addr,
+					orderCitations, citation) == 0)
+			{
+				sm_list_destroy(ionwm, citation->routes, NULL,
+						NULL);
+				psm_free(ionwm, addr);
+				putErrmsg("Can't insert CGR citation.", NULL);
+				return -1;
+			}
+		}
+
+		citeElt = sm_list_insert_last(ionwm, citation->routes,
+				routeAddr);
+		if (citeElt == 0
+		|| sm_list_insert_last(ionwm, route->citations, citeElt) == 0)
+		{
+			putErrmsg("Can't note CGR citation.", NULL);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void	discardRoute(PsmPartition ionwm, PsmAddress routeAddr)
+{
+	CgrVdb		*vdb = _cgrvdb(NULL);
+	CgrRoute	*route = (CgrRoute *) psp(ionwm, routeAddr);
+	PsmAddress	elt;
+	PsmAddress	citeElt;
+	PsmAddress	routes;
+	PsmAddress	addr;
+	CgrCitation	*citation;
+
+	/*	Withdraw the route's citations of its contacts,
+	 *	erasing every citation that is no longer needed.	*/
+
+	if (route->citations)
+	{
+		while ((elt = sm_list_first(ionwm, route->citations)) != 0)
+		{
+			citeElt = sm_list_data(ionwm, elt);
+			routes = sm_list_list(ionwm, citeElt);
+			sm_list_delete(ionwm, citeElt, NULL, NULL);
+			sm_list_delete(ionwm, elt, NULL, NULL);
+			if (sm_list_length(ionwm, routes) > 0 || vdb == NULL)
+			{
+				continue;
+			}
+
+			addr = sm_list_user_data(ionwm, routes);
+			citation = (CgrCitation *) psp(ionwm, addr);
+			sm_rbt_delete(ionwm, vdb->citations, orderCitations,
+					citation, NULL, NULL);
+			sm_list_destroy(ionwm, routes, NULL, NULL);
+			psm_free(ionwm, addr);
+		}
+
+		sm_list_destroy(ionwm, route->citations, NULL, NULL);
+	}
+
+	if (route->hops)
+	{
+		sm_list_destroy(ionwm, route->hops, NULL, NULL);
+	}
+
+	if (route->routeElt)
+	{
+		sm_list_delete(ionwm, route->routeElt, NULL, NULL);
+	}
+
+	psm_free(ionwm, routeAddr);
+}
+
 static void	discardRouteList(PsmPartition ionwm, PsmAddress routes)
 {
 	PsmAddress	elt2;
-	PsmAddress	next2;
-	PsmAddress	addr;
-	CgrRoute	*route;
 
 	if (routes == 0)
 	{
@@ -97,18 +377,9 @@ static void	discardRouteList(PsmPartition ionwm, PsmAddress routes)
 
 	/*	Erase all routes in the list.				*/
 
-	for (elt2 = sm_list_first(ionwm, routes); elt2; elt2 = next2)
+	while ((elt2 = sm_list_first(ionwm, routes)) != 0)
 	{
-		next2 = sm_list_next(ionwm, elt2);
-		addr = sm_list_data(ionwm, elt2);
-		route = (CgrRoute *) psp(ionwm, addr);
-		if (route->hops)
-		{
-			sm_list_destroy(ionwm, route->hops, NULL, NULL);
-		}
-
-		psm_free(ionwm, addr);
-		sm_list_delete(ionwm, elt2, NULL, NULL);
+		discardRoute(ionwm, sm_list_data(ionwm, elt2));
 	}
 
 	/*	Destroy the list of routes to this remote node.	*/
@@ -119,12 +390,19 @@ static void	discardRouteList(PsmPartition ionwm, PsmAddress routes)
 static void	discardRouteLists(CgrVdb *vdb)
 {
 	PsmPartition	ionwm = getIonwm();
+	IonVdb		*ionvdb = getIonVdb();
 	PsmAddress	elt;
 	PsmAddress	nextElt;
 	PsmAddress	routes;		/*	SM list: CgrRoute	*/
 	PsmAddress	addr;
 	IonNode		*node;
 
+	/*	All routes are to be recomputed, so neither the
+	 *	pending contact plan edits nor the notes of route
+	 *	lists awaiting revision are of any further use.		*/
+
+	sm_list_clear(ionwm, ionvdb->contactEdits, rfx_erase_data, NULL);
+	sm_list_clear(ionwm, vdb->revisedLists, NULL, NULL);
 	for (elt = sm_list_first(ionwm, vdb->routeLists); elt; elt = nextElt)
 	{
 		nextElt = sm_list_next(ionwm, elt);
@@ -212,6 +490,8 @@ static CgrVdb	*_cgrvdb(char **name)
 		vdb = (CgrVdb *) psp(ionwm, vdbAddress);
 		memset((char *) vdb, 0, sizeof(CgrVdb));
 		if ((vdb->routeLists = sm_list_create(ionwm)) == 0
+		|| (vdb->citations = sm_rbt_create(ionwm)) == 0
+		|| (vdb->revisedLists = sm_list_create(ionwm)) == 0
 		|| psm_catlg(ionwm, *name, vdbAddress) < 0)
 		{
 			sdr_exit_xn(sdr);
@@ -226,332 +506,619 @@ static CgrVdb	*_cgrvdb(char **name)
 	return vdb;
 }
 
-/*		Functions for loading the routing table.		*/
+/*		Functions for managing the contact graph snapshot.	*/
+
+static void	destroyGraph(CgrGraph *graph)
+{
+	if (graph == NULL)
+	{
+		return;
+	}
+
+	free(graph->fromNode);
+	free(graph->toNode);
+	free(graph->fromTime);
+	free(graph->toTime);
+	free(graph->capacity);
+	free(graph->owlt);
+	free(graph->toNodeIdx);
+	free(graph->cxref);
+	free(graph->nodeNbr);
+	free(graph->firstContact);
+	free(graph);
+}
+
+static int	findGraphNode(CgrGraph *graph, uvast nodeNbr)
+{
+	int	low = 0;
+	int	high = graph->nodesCount - 1;
+	int	mid;
+
+	while (low <= high)
+	{
+		mid = (low + high) / 2;
+		if (graph->nodeNbr[mid] < nodeNbr)
+		{
+			low = mid + 1;
+		}
+		else if (graph->nodeNbr[mid] > nodeNbr)
+		{
+			high = mid - 1;
+		}
+		else
+		{
+			return mid;
+		}
+	}
+
+	return -1;
+}
+
+static int	findGraphContact(CgrGraph *graph, uvast fromNode, uvast toNode,
+			time_t fromTime)
+{
+	int	nodeIdx;
+	int	i;
+
+	nodeIdx = findGraphNode(graph, fromNode);
+	if (nodeIdx < 0)
+	{
+		return -1;
+	}
+
+	for (i = graph->firstContact[nodeIdx];
+			i < graph->firstContact[nodeIdx + 1]; i++)
+	{
+		if (graph->toNode[i] == toNode
+		&& graph->fromTime[i] == fromTime)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
 
-static int	computeDistanceToStation(IonCXref *rootContact,
-			CgrContactNote *rootWork, IonNode *stationNode,
-			int payloadClass, CgrRoute *route)
+static int	getContactOwlt(IonCXref *contact, unsigned int *owlt)
 {
 	PsmPartition	ionwm = getIonwm();
 	IonVdb		*ionvdb = getIonVdb();
-	uvast		capacityFloor = _minCapacity(payloadClass);
-	IonCXref	*current;
-	CgrContactNote	*currentWork;
-	IonCXref	arg;
+	IonRXref	arg;
 	PsmAddress	elt;
-	IonCXref	*contact;
-	CgrContactNote	*work;
-	IonRXref	arg2;
-	PsmAddress	elt2;
 	IonRXref	*range;
 	unsigned int	owltMargin;
-	unsigned int	owlt;
-	time_t		transmitTime;
-	time_t		arrivalTime;
-	IonCXref	*finalContact = NULL;
-	time_t		earliestDeliveryTime = MAX_TIME;
-	IonCXref	*nextContact;
-	time_t		earliestArrivalTime;
-	time_t		earliestEndTime;
-	uvast		maxCapacity;
-	PsmAddress	addr;
 
-	/*	This is an implementation of Dijkstra's Algorithm.	*/
+	/*	Get OWLT between the nodes in contact, from applicable
+	 *	range in range index.  Returns 0 if there is no such
+	 *	range.							*/
 
-#if CGRDEBUG
-printf("\nSeeking a class %d route via contact to node " UVAST_FIELDSPEC
-" arrival time %u.\n", payloadClass, rootContact->toNode, (unsigned int)
-(rootWork->arrivalTime));
-#endif
-	current = rootContact;
-	currentWork = rootWork;
-	memset((char *) &arg, 0, sizeof(IonCXref));
-	memset((char *) &arg2, 0, sizeof(IonRXref));
-	while (1)
+	memset((char *) &arg, 0, sizeof(IonRXref));
+	arg.fromNode = contact->fromNode;
+	arg.toNode = contact->toNode;
+	for (oK(sm_rbt_search(ionwm, ionvdb->rangeIndex, rfx_order_ranges,
+			&arg, &elt)); elt; elt = sm_rbt_next(ionwm, elt))
 	{
-		/*	Consider all unvisited neighbors (i.e., next-
-		 *	hop contacts) of the current contact.		*/
+		range = (IonRXref *) psp(ionwm, sm_rbt_data(ionwm, elt));
+		if (range->fromNode > arg.fromNode
+		|| range->toNode > arg.toNode)
+		{
+			return 0;
+		}
 
-		arg.fromNode = current->toNode;
-#if CGRDEBUG
-printf("\nConsidering contacts from node " UVAST_FIELDSPEC ".\n", arg.fromNode);
-#endif
-		for (oK(sm_rbt_search(ionwm, ionvdb->contactIndex,
-				rfx_order_contacts, &arg, &elt));
-				elt; elt = sm_rbt_next(ionwm, elt))
+		if (range->toTime < contact->fromTime)
 		{
-			contact = (IonCXref *) psp(ionwm,
-					sm_rbt_data(ionwm, elt));
-#if CGRDEBUG
-printf("Examining contact from node " UVAST_FIELDSPEC " to node "
-UVAST_FIELDSPEC " starting at %u.\n", contact->fromNode, contact->toNode,
-(unsigned int) (contact->fromTime));
-#endif
-			if (contact->fromNode > arg.fromNode)
-			{
-#if CGRDEBUG
-printf("Contact is not from the node we're routing from (" UVAST_FIELDSPEC "\
-).\n", arg.fromNode);
-#endif
-				/*	No more relevant contacts.	*/
+			continue;	/*	Past.			*/
+		}
 
-				break;
-			}
+		if (range->fromTime > contact->fromTime)
+		{
+			return 0;
+		}
 
-			if (contact->toTime <= currentWork->arrivalTime)
-			{
-#if CGRDEBUG
-printf("Contact ends before current contact arrival time.\n");
-#endif
-				/*	Can't be a next-hop contact:
-				 *	transmission has stopped by
-				 *	the time of arrival of data
-				 *	during the current contact.	*/
+		/*	Allow for possible additional latency due to
+		 *	the movement of the receiving node during the
+		 *	propagation of signal from the sending node.	*/
 
-				continue;
-			}
+		owltMargin = ((MAX_SPEED_MPH / 3600) * range->owlt) / 186282;
+		*owlt = range->owlt + owltMargin;
+		return 1;
+	}
 
-			work = (CgrContactNote *) psp(ionwm,
-					contact->routingObject);
-			CHKERR(work);
-			if (work->suppressed || work->visited)
-			{
-#if CGRDEBUG
-printf("Contact to node " UVAST_FIELDSPEC " is suppressed or visited.\n",
-contact->toNode);
-#endif
-				continue;
-			}
+	return 0;
+}
 
-			/*	Exclude contact if its capacity is
-			 *	less than the floor for this payload
-			 *	class.					*/
+static CgrGraph	*buildGraph(unsigned long version)
+{
+	PsmPartition	ionwm = getIonwm();
+	IonVdb		*ionvdb = getIonVdb();
+	CgrGraph	*graph;
+	int		limit = 0;
+	PsmAddress	elt;
+	IonCXref	*contact;
+	unsigned int	owlt;
+	int		i;
 
-			if (work->capacity == 0)
-			{
-				work->capacity = contact->xmitRate *
-					(contact->toTime - contact->fromTime);
-			}
+	graph = (CgrGraph *) calloc(1, sizeof(CgrGraph));
+	if (graph == NULL)
+	{
+		putErrmsg("Can't create CGR contact graph.", NULL);
+		return NULL;
+	}
 
-			if (work->capacity < capacityFloor)
-			{
-#if CGRDEBUG
-printf("Contact capacity " UVAST_FIELDSPEC " too low for payload class.\n",
-work->capacity);
-#endif
-				continue;
-			}
+	memset((char *) graph, 0, sizeof(CgrGraph));
+	graph->version = version;
+	for (elt = sm_rbt_first(ionwm, ionvdb->contactIndex); elt;
+			elt = sm_rbt_next(ionwm, elt))
+	{
+		limit++;
+	}
 
-			/*	Get OWLT between the nodes in contact,
-			 *	from applicable range in range index.	*/
+	if (limit == 0)
+	{
+		limit = 1;	/*	Avoid zero-length allocations.	*/
+	}
 
-			arg2.fromNode = arg.fromNode;
-			arg2.toNode = contact->toNode;
-			for (oK(sm_rbt_search(ionwm, ionvdb->rangeIndex,
-					rfx_order_ranges, &arg2, &elt2));
-					elt2; elt2 = sm_rbt_next(ionwm, elt2))
-			{
-				range = (IonRXref *)
-					psp(ionwm, sm_rbt_data(ionwm, elt2));
-				CHKERR(range);
-				if (range->fromNode > arg2.fromNode
-				|| range->toNode > arg2.toNode)
-				{
-					elt2 = 0;
-					break;
-				}
+	graph->fromNode = (uvast *) calloc(limit, sizeof(uvast));
+	graph->toNode = (uvast *) calloc(limit, sizeof(uvast));
+	graph->fromTime = (time_t *) calloc(limit, sizeof(time_t));
+	graph->toTime = (time_t *) calloc(limit, sizeof(time_t));
+	graph->capacity = (uvast *) calloc(limit, sizeof(uvast));
+	graph->owlt = (unsigned int *) calloc(limit, sizeof(unsigned int));
+	graph->toNodeIdx = (int *) calloc(limit, sizeof(int));
+	graph->cxref = (PsmAddress *) calloc(limit, sizeof(PsmAddress));
+	graph->nodeNbr = (uvast *) calloc(limit, sizeof(uvast));
+	graph->firstContact = (int *) calloc(limit + 1, sizeof(int));
+	if (graph->fromNode == NULL || graph->toNode == NULL
+	|| graph->fromTime == NULL || graph->toTime == NULL
+	|| graph->capacity == NULL || graph->owlt == NULL
+	|| graph->toNodeIdx == NULL || graph->cxref == NULL
+	|| graph->nodeNbr == NULL || graph->firstContact == NULL)
+	{
+		destroyGraph(graph);
+		putErrmsg("Can't create CGR contact graph.", itoa(limit));
+		return NULL;
+	}
 
-				if (range->toTime < contact->fromTime)
-				{
-					continue;	/*	Past.	*/
-				}
+	/*	Copy all usable contacts, in contact index order,
+	 *	noting the first contact from each node.		*/
 
-				if (range->fromTime > contact->fromTime)
-				{
-					elt2 = 0;
-				}
+	for (elt = sm_rbt_first(ionwm, ionvdb->contactIndex); elt;
+			elt = sm_rbt_next(ionwm, elt))
+	{
+		contact = (IonCXref *) psp(ionwm, sm_rbt_data(ionwm, elt));
+		if (getContactOwlt(contact, &owlt) == 0)
+		{
+			continue;	/*	Unknown OWLT; unusable.	*/
+		}
 
-				break;
-			}
+		i = graph->contactsCount;
+		if (graph->nodesCount == 0
+		|| graph->nodeNbr[graph->nodesCount - 1] != contact->fromNode)
+		{
+			graph->nodeNbr[graph->nodesCount] = contact->fromNode;
+			graph->firstContact[graph->nodesCount] = i;
+			graph->nodesCount++;
+		}
 
-			if (elt2 == 0)
-			{
-#if CGRDEBUG
-printf("Don't have range for this contact.\n");
-#endif
-				/*	Don't know the OWLT between
-				 *	these BP nodes at this time,
-				 *	so can't consider in CGR.	*/
+		graph->fromNode[i] = contact->fromNode;
+		graph->toNode[i] = contact->toNode;
+		graph->fromTime[i] = contact->fromTime;
+		graph->toTime[i] = contact->toTime;
+		graph->capacity[i] = contact->xmitRate
+				* (contact->toTime - contact->fromTime);
+		graph->owlt[i] = owlt;
+		graph->cxref[i] = sm_rbt_data(ionwm, elt);
+		graph->contactsCount++;
+	}
 
-				continue;
-			}
+	graph->firstContact[graph->nodesCount] = graph->contactsCount;
 
-			/*	Allow for possible additional latency
-			 *	due to the movement of the receiving
-			 *	node during the propagation of signal
-			 *	from the sending node.			*/
+	/*	Now link each contact to the contacts from its "to"
+	 *	node, i.e., its possible next-hop contacts.		*/
 
-			owltMargin = ((MAX_SPEED_MPH / 3600) * range->owlt)
-					/ 186282;
-			owlt = range->owlt + owltMargin;
+	for (i = 0; i < graph->contactsCount; i++)
+	{
+		graph->toNodeIdx[i] = findGraphNode(graph, graph->toNode[i]);
+	}
 
-			/*	Compute cost of choosing this edge:
-			 *	earliest bundle arrival time.		*/
-#if CGRDEBUG
-printf("currentWork->arrival time %lu, contact->fromTime %lu, owlt %u.\n",
-currentWork->arrivalTime, contact->fromTime, owlt);
-#endif
-			if (contact->fromTime < currentWork->arrivalTime)
-			{
-				transmitTime = currentWork->arrivalTime;
-			}
-			else
-			{
-				transmitTime = contact->fromTime;
-			}
+	return graph;
+}
 
-			arrivalTime = transmitTime + owlt;
-#if CGRDEBUG
-printf("Computed arrival time %lu, work->arrivalTime %lu, \
-earliestDeliveryTime %lu.\n", arrivalTime, work->arrivalTime,
-earliestDeliveryTime);
-#endif
-			if (arrivalTime < work->arrivalTime)
-			{
-				work->arrivalTime = arrivalTime;
-				work->predecessor = current;
+static CgrGraph	*_cgrgraph(CgrVdb *vdb)
+{
+	static CgrGraph	*graph = NULL;
 
-				/*	Note contact if could be final.	*/
+	if (vdb == NULL)		/*	Terminating.		*/
+	{
+		destroyGraph(graph);
+		graph = NULL;
+		return graph;
+	}
+
+	/*	The snapshot is private to this process, so it is
+	 *	rebuilt whenever any process has noted a change in
+	 *	the contact plan since the snapshot was built.		*/
+
+	if (graph && graph->version != vdb->graphVersion)
+	{
+		destroyGraph(graph);
+		graph = NULL;
+	}
+
+	if (graph == NULL)
+	{
+		graph = buildGraph(vdb->graphVersion);
+	}
+
+	return graph;
+}
+
+/*		Functions for managing Dijkstra work areas.		*/
+
+static void	releaseSearch(CgrSearch *search)
+{
+	free(search->predecessor);
+	free(search->arrivalTime);
+	free(search->visited);
+	free(search->suppressed);
+	free(search->hops);
+	free(search->heap.entries);
+	memset((char *) search, 0, sizeof(CgrSearch));
+}
+
+static int	sizeSearch(CgrSearch *search, CgrGraph *graph)
+{
+	int	capacity = graph->contactsCount;
+
+	/*	Make sure the work areas can accommodate every contact
+	 *	in the graph.						*/
+
+	if (search->heap.entries && search->capacity >= capacity)
+	{
+		return 0;
+	}
+
+	releaseSearch(search);
+	if (capacity == 0)
+	{
+		capacity = 1;	/*	Avoid zero-length allocations.	*/
+	}
+
+	search->predecessor = (int *) calloc(capacity, sizeof(int));
+	search->arrivalTime = (time_t *) calloc(capacity, sizeof(time_t));
+	search->visited = (unsigned char *) calloc(capacity, 1);
+	search->suppressed = (unsigned char *) calloc(capacity, 1);
+	search->hops = (int *) calloc(capacity, sizeof(int));
+	search->heap.capacity = 64;
+	search->heap.entries = (CgrHeapEntry *) calloc(search->heap.capacity,
+			sizeof(CgrHeapEntry));
+	if (search->predecessor == NULL || search->arrivalTime == NULL
+	|| search->visited == NULL || search->suppressed == NULL
+	|| search->hops == NULL
+	|| search->heap.entries == NULL)
+	{
+		releaseSearch(search);
+		putErrmsg("Can't create CGR search work areas.",
+				itoa(capacity));
+		return -1;
+	}
+
+	search->capacity = capacity;
+	return 0;
+}
+
+static void	clearSearch(CgrSearch *search, CgrGraph *graph)
+{
+	int	i;
+
+	for (i = 0; i < graph->contactsCount; i++)
+	{
+		search->arrivalTime[i] = MAX_TIME;
+	}
+
+	for (i = 0; i < graph->contactsCount; i++)
+	{
+		search->predecessor[i] = -1;
+	}
+
+	memset(search->visited, 0, graph->contactsCount);
+}
+
+/*		Functions for managing the Dijkstra search heap.	*/
+
+static int	heapEntryPrecedes(CgrHeapEntry *a, CgrHeapEntry *b)
+{
+	if (a->arrivalTime != b->arrivalTime)
+	{
+		return (a->arrivalTime < b->arrivalTime);
+	}
+
+	/*	Break ties in contact index order, so that the search
+	 *	visits contacts in the same order regardless of the
+	 *	order in which they were reached.			*/
+
+	return (a->contact < b->contact);
+}
+
+static int	heapInsert(CgrHeap *heap, int contact, time_t arrivalTime)
+{
+	CgrHeapEntry	*entries;
+	CgrHeapEntry	entry;
+	int		i;
+	int		parent;
+
+	if (heap->count == heap->capacity)
+	{
+		entries = (CgrHeapEntry *) realloc(heap->entries,
+				heap->capacity * 2 * sizeof(CgrHeapEntry));
+		if (entries == NULL)
+		{
+			putErrmsg("Can't expand CGR search heap.",
+					itoa(heap->capacity));
+			return -1;
+		}
+
+		heap->entries = entries;
+		heap->capacity *= 2;
+	}
+
+	entry.arrivalTime = arrivalTime;
+	entry.contact = contact;
+	for (i = heap->count; i > 0; i = parent)
+	{
+		parent = (i - 1) / 2;
+		if (!heapEntryPrecedes(&entry, heap->entries + parent))
+		{
+			break;
+		}
+
+		heap->entries[i] = heap->entries[parent];
+	}
+
+	heap->entries[i] = entry;
+	heap->count++;
+	return 0;
+}
+
+static void	heapRemoveFirst(CgrHeap *heap)
+{
+	CgrHeapEntry	last;
+	int		i;
+	int		child;
+
+	heap->count--;
+	last = heap->entries[heap->count];
+	for (i = 0; (child = (2 * i) + 1) < heap->count; i = child)
+	{
+		if (child + 1 < heap->count
+		&& heapEntryPrecedes(heap->entries + child + 1,
+				heap->entries + child))
+		{
+			child++;
+		}
+
+		if (!heapEntryPrecedes(heap->entries + child, &last))
+		{
+			break;
+		}
+
+		heap->entries[i] = heap->entries[child];
+	}
+
+	heap->entries[i] = last;
+}
+
+/*		Functions for loading the routing table.		*/
+
+static int	searchGraph(CgrGraph *graph, CgrSearch *search,
+			int rootContact, time_t rootArrivalTime,
+			uvast stationNodeNbr, int payloadClass,
+			int *finalContact)
+{
+	uvast		capacityFloor = _minCapacity(payloadClass);
+	CgrHeap		*heap = &search->heap;
+	int		current;
+	time_t		currentArrivalTime;
+	int		nodeIdx;
+	int		contact;
+	int		lastContact;
+	time_t		transmitTime;
+	time_t		arrivalTime;
+	time_t		earliestDeliveryTime = MAX_TIME;
+	int		nextContact;
+
+	/*	This is an implementation of Dijkstra's Algorithm,
+	 *	using a binary heap to select the next contact to
+	 *	visit.  The search is rooted at the indicated contact,
+	 *	at the indicated time of arrival of data during that
+	 *	contact; a root contact of -1 is a notional contact
+	 *	from the local node to itself.				*/
 
-				if (contact->toNode == stationNode->nodeNbr)
-				{
-					if (work->arrivalTime
-						< earliestDeliveryTime)
-					{
-						earliestDeliveryTime
-							= work->arrivalTime;
-						finalContact = contact;
 #if CGRDEBUG
-printf("Updated earliest delivery time.\n");
+printf("\nSeeking a class %d route to node " UVAST_FIELDSPEC
+" at time %u.\n", payloadClass, stationNodeNbr,
+(unsigned int) rootArrivalTime);
 #endif
-					}
-				}
-			}
-		}
+	*finalContact = -1;
+	heap->count = 0;
+	current = rootContact;
+	currentArrivalTime = rootArrivalTime;
+	if (current < 0)
+	{
+		nodeIdx = findGraphNode(graph, getOwnNodeNbr());
+	}
+	else
+	{
+		nodeIdx = graph->toNodeIdx[current];
+	}
 
-		currentWork->visited = 1;
+	while (1)
+	{
+		/*	Consider all unvisited neighbors (i.e., next-
+		 *	hop contacts) of the current contact.		*/
 
-		/*	Select next contact to consider, if any.	*/
+		if (nodeIdx < 0)
+		{
+			contact = lastContact = 0;
+		}
+		else
+		{
+			contact = graph->firstContact[nodeIdx];
+			lastContact = graph->firstContact[nodeIdx + 1];
+		}
 
-		nextContact = NULL;
-		earliestArrivalTime = MAX_TIME;
-		for (elt = sm_rbt_first(ionwm, ionvdb->contactIndex); elt;
-				elt = sm_rbt_next(ionwm, elt))
+		for (; contact < lastContact; contact++)
 		{
-			contact = (IonCXref *) psp(ionwm, sm_rbt_data(ionwm,
-					elt));
-			CHKERR(contact);
-			work = (CgrContactNote *) psp(ionwm,
-					contact->routingObject);
-			CHKERR(work);
-			if (work->suppressed || work->visited)
+#if CGRDEBUG
+printf("Examining contact from node " UVAST_FIELDSPEC " to node "
+UVAST_FIELDSPEC " starting at %u.\n", graph->fromNode[contact],
+graph->toNode[contact], (unsigned int) (graph->fromTime[contact]));
+#endif
+			/*	Can't be a next-hop contact if
+			 *	transmission has stopped by the time
+			 *	of arrival of data during the current
+			 *	contact, if it is suppressed or already
+			 *	visited, or if its capacity is less
+			 *	than the floor for this payload class.	*/
+
+			if (graph->toTime[contact] <= currentArrivalTime
+			|| search->suppressed[contact]
+			|| search->visited[contact]
+			|| graph->capacity[contact] < capacityFloor)
 			{
-				continue;	/*	Ineligible.	*/
+				continue;
 			}
 
-			if (work->arrivalTime > earliestDeliveryTime)
+			/*	Compute cost of choosing this edge:
+			 *	earliest bundle arrival time.		*/
+
+			if (graph->fromTime[contact] < currentArrivalTime)
+			{
+				transmitTime = currentArrivalTime;
+			}
+			else
 			{
-				/*	Not on optimal path; ignore.	*/
+				transmitTime = graph->fromTime[contact];
+			}
 
+			arrivalTime = transmitTime + graph->owlt[contact];
+			if (arrivalTime >= search->arrivalTime[contact])
+			{
 				continue;
 			}
 
-			if (work->arrivalTime < earliestArrivalTime)
+			search->arrivalTime[contact] = arrivalTime;
+			search->predecessor[contact] = current;
+			if (heapInsert(heap, contact, arrivalTime) < 0)
+			{
+				return -1;
+			}
+
+			/*	Note contact if could be final.		*/
+
+			if (graph->toNode[contact] == stationNodeNbr
+			&& arrivalTime < earliestDeliveryTime)
+			{
+				earliestDeliveryTime = arrivalTime;
+				*finalContact = contact;
+#if CGRDEBUG
+printf("Updated earliest delivery time %lu.\n", earliestDeliveryTime);
+#endif
+			}
+		}
+
+		if (current >= 0)
+		{
+			search->visited[current] = 1;
+		}
+
+		/*	Select next contact to consider, if any: the
+		 *	unvisited contact with the earliest arrival
+		 *	time, discarding stale heap entries.		*/
+
+		nextContact = -1;
+		while (heap->count > 0)
+		{
+			contact = heap->entries[0].contact;
+			arrivalTime = heap->entries[0].arrivalTime;
+			if (search->visited[contact]
+			|| arrivalTime != search->arrivalTime[contact])
+			{
+				heapRemoveFirst(heap);
+				continue;	/*	Stale entry.	*/
+			}
+
+			if (arrivalTime <= earliestDeliveryTime)
 			{
+				heapRemoveFirst(heap);
 				nextContact = contact;
-				earliestArrivalTime = work->arrivalTime;
 			}
+
+			/*	Otherwise no remaining contact is on
+			 *	an optimal path.			*/
+
+			break;
 		}
 
 		/*	If search is complete, stop.  Else repeat,
 		 *	with new value of "current".			*/
 
-		if (nextContact == NULL)
+		if (nextContact < 0)
 		{
 #if CGRDEBUG
 printf("Dijkstra search has ended.\n");
 #endif
 			/*	End of search.				*/
 
-			break;
+			return 0;
 		}
 
 		current = nextContact;
+		currentArrivalTime = search->arrivalTime[current];
+		nodeIdx = graph->toNodeIdx[current];
 #if CGRDEBUG
-printf("Now continuing from node " UVAST_FIELDSPEC ".\n", current->toNode);
+printf("Now continuing from node " UVAST_FIELDSPEC ".\n",
+graph->toNode[current]);
 #endif
-		currentWork = (CgrContactNote *)
-				psp(ionwm, nextContact->routingObject);
 	}
+}
 
-	/*	Have finished Dijkstra search of contact graph,
-	 *	excluding those contacts that were suppressed.		*/
-
-	if (finalContact)	/*	Found a route to station node.	*/
-	{
-		route->deliveryTime = earliestDeliveryTime;
-
-		/*	Load the entire route into the "hops" list,
-		 *	backtracking to root, and compute the time
-		 *	at which the route will become unusable.	*/
-
-		earliestEndTime = MAX_TIME;
-		maxCapacity = (uvast) -1;
-		for (contact = finalContact; contact != rootContact;
-				contact = work->predecessor)
-		{
-			if (contact->toTime < earliestEndTime)
-			{
-				earliestEndTime = contact->toTime;
-			}
-
-			work = (CgrContactNote *) psp(ionwm,
-					contact->routingObject);
-			if (work->capacity < maxCapacity)
-			{
-				maxCapacity = work->capacity;
-			}
+static int	extractPath(CgrSearch *search, int rootContact,
+			int finalContact, int *hops)
+{
+	int	hopsCount = 0;
+	int	contact;
+	int	i;
 
-			addr = psa(ionwm, contact);
-			if (sm_list_insert_first(ionwm, route->hops, addr) == 0)
-			{
-				putErrmsg("Can't insert contact into route.",
-						NULL);
-				return -1;
-			}
-		}
+	/*	Load into "hops" the contacts on the path found by the
+	 *	last search, following the root contact, in order of
+	 *	traversal.  Returns the number of contacts loaded.	*/
 
-		/*	Now use the first contact in the route to
-		 *	characterize the route.				*/
+	for (contact = finalContact; contact != rootContact;
+			contact = search->predecessor[contact])
+	{
+		hopsCount++;
+	}
 
-		addr = sm_list_data(ionwm, sm_list_first(ionwm, route->hops));
-		contact = (IonCXref *) psp(ionwm, addr);
-		route->toNodeNbr = contact->toNode;
-		route->fromTime = contact->fromTime;
-		route->toTime = earliestEndTime;
-		route->maxCapacity = maxCapacity;
-		route->payloadClass = payloadClass;
+	i = hopsCount;
+	for (contact = finalContact; contact != rootContact;
+			contact = search->predecessor[contact])
+	{
+		i--;
+		hops[i] = contact;
 	}
 
-	return 0;
+	return hopsCount;
 }
 
-static int	findNextBestRoute(PsmPartition ionwm, IonCXref *rootContact,
-			CgrContactNote *rootWork, IonNode *stationNode,
-			int payloadClass, PsmAddress *routeAddr)
+static int	createRoute(PsmPartition ionwm, CgrGraph *graph, int *hops,
+			int hopsCount, time_t deliveryTime, int payloadClass,
+			PsmAddress *routeAddr)
 {
 	PsmAddress	addr;
 	CgrRoute	*route;
+	int		i;
+	int		contact;
 
 	*routeAddr = 0;		/*	Default.			*/
 	addr = psm_zalloc(ionwm, sizeof(CgrRoute));
@@ -571,16 +1138,78 @@ static int	findNextBestRoute(PsmPartition ionwm, IonCXref *rootContact,
 		return -1;
 	}
 
+	route->citations = sm_list_create(ionwm);
+	if (route->citations == 0)
+	{
+		discardRoute(ionwm, addr);
+		putErrmsg("Can't create CGR route citations list.", NULL);
+		return -1;
+	}
+
+	/*	Load the entire path into the "hops" list and compute
+	 *	the time at which the route will become unusable.	*/
+
+	route->deliveryTime = deliveryTime;
+	route->toTime = MAX_TIME;
+	route->maxCapacity = (uvast) -1;
+	for (i = 0; i < hopsCount; i++)
+	{
+		contact = hops[i];
+		if (graph->toTime[contact] < route->toTime)
+		{
+			route->toTime = graph->toTime[contact];
+		}
+
+		if (graph->capacity[contact] < route->maxCapacity)
+		{
+			route->maxCapacity = graph->capacity[contact];
+		}
+
+		if (sm_list_insert_last(ionwm, route->hops,
+				graph->cxref[contact]) == 0)
+		{
+			discardRoute(ionwm, addr);
+			putErrmsg("Can't insert contact into route.", NULL);
+			return -1;
+		}
+	}
+
+	/*	Now use the first contact in the route to characterize
+	 *	the route.						*/
+
+	route->toNodeNbr = graph->toNode[hops[0]];
+	route->fromTime = graph->fromTime[hops[0]];
+	route->payloadClass = payloadClass;
+#if CGRDEBUG
+printf("----Found class-%d route via node " UVAST_FIELDSPEC
+": start @ %lu, deliver @ %lu.\n", payloadClass, route->toNodeNbr,
+route->fromTime, route->deliveryTime);
+#endif
+	*routeAddr = addr;
+	return 0;
+}
+
+static int	findNextBestRoute(PsmPartition ionwm, CgrGraph *graph,
+			CgrSearch *search, time_t currentTime,
+			IonNode *stationNode, int payloadClass,
+			PsmAddress *routeAddr)
+{
+	int	finalContact;
+	int	hopsCount;
+
+	*routeAddr = 0;		/*	Default.			*/
+
 	/*	Run Dijkstra search.					*/
 
-	if (computeDistanceToStation(rootContact, rootWork, stationNode,
-			payloadClass, route) < 0)
+	clearSearch(search, graph);
+	if (searchGraph(graph, search, -1, currentTime, stationNode->nodeNbr,
+			payloadClass, &finalContact) < 0)
 	{
 		putErrmsg("Can't finish Dijstra search.", NULL);
 		return -1;
 	}
 
-	if (route->toNodeNbr == 0)
+	if (finalContact < 0)
 	{
 #if CGRDEBUG
 printf("----No more class-%d routes to node " UVAST_FIELDSPEC ".\n",
@@ -588,306 +1217,1377 @@ payloadClass, stationNode->nodeNbr);
 #endif
 		/*	No more routes found in graph.			*/
 
-		sm_list_destroy(ionwm, route->hops, NULL, NULL);
-		psm_free(ionwm, addr);
-		*routeAddr = 0;
+		return 0;
 	}
-	else
+
+	/*	Found best route, given current exclusions.		*/
+
+	hopsCount = extractPath(search, -1, finalContact, search->hops);
+	return createRoute(ionwm, graph, search->hops, hopsCount,
+			search->arrivalTime[finalContact], payloadClass,
+			routeAddr);
+}
+
+static void	suppressLeadContact(CgrGraph *graph, CgrSearch *search,
+			CgrRoute *route)
+{
+	int	contact;
+
+	contact = findGraphContact(graph, getOwnNodeNbr(), route->toNodeNbr,
+			route->fromTime);
+	if (contact >= 0)
 	{
-#if CGRDEBUG
-printf("----Found class-%d route via node " UVAST_FIELDSPEC
-": start @ %lu, deliver @ %lu.\n", payloadClass, route->toNodeNbr,
-route->fromTime, route->deliveryTime);
-#endif
-		/*	Found best route, given current exclusions.	*/
+		search->suppressed[contact] = 1;
+	}
+
+	/*	Otherwise this is an old route, for a contact that is
+	 *	already ended, but the route hasn't been purged yet
+	 *	because it hasn't been used recently.  Ignore it.	*/
+}
+
+static void	releasePaths(CgrPath *paths, int pathsCount)
+{
+	int	i;
+
+	for (i = 0; i < pathsCount; i++)
+	{
+		free(paths[i].hops);
+	}
+
+	free(paths);
+}
+
+static int	samePath(CgrPath *a, CgrPath *b)
+{
+	return (a->hopsCount == b->hopsCount
+		&& memcmp((char *) a->hops, (char *) b->hops,
+			a->hopsCount * sizeof(int)) == 0);
+}
+
+static time_t	prefixArrivalTime(CgrGraph *graph, int *hops, int hopsCount,
+			time_t currentTime)
+{
+	time_t	arrivalTime = currentTime;
+	int	i;
+
+	for (i = 0; i < hopsCount; i++)
+	{
+		if (graph->fromTime[hops[i]] > arrivalTime)
+		{
+			arrivalTime = graph->fromTime[hops[i]];
+		}
+
+		arrivalTime += graph->owlt[hops[i]];
+	}
+
+	return arrivalTime;
+}
+
+static int	addCandidate(CgrPath **candidates, int *candidatesCount,
+			int *candidatesCapacity, CgrPath *path)
+{
+	CgrPath	*larger;
+	int	i;
+
+	for (i = 0; i < *candidatesCount; i++)
+	{
+		if (samePath((*candidates) + i, path))
+		{
+			free(path->hops);
+			return 0;	/*	Already a candidate.	*/
+		}
+	}
+
+	if (*candidatesCount == *candidatesCapacity)
+	{
+		larger = (CgrPath *) realloc(*candidates,
+				2 * *candidatesCapacity * sizeof(CgrPath));
+		if (larger == NULL)
+		{
+			free(path->hops);
+			putErrmsg("Can't expand CGR candidate paths.", NULL);
+			return -1;
+		}
+
+		*candidates = larger;
+		*candidatesCapacity *= 2;
+	}
+
+	(*candidates)[*candidatesCount] = *path;
+	(*candidatesCount)++;
+	return 0;
+}
+
+static int	findSpurPaths(CgrSeries *series, CgrSearch *search,
+			CgrPath *paths, int pathsCount, CgrPath **candidates,
+			int *candidatesCount, int *candidatesCapacity)
+{
+	CgrGraph	*graph = series->graph;
+	CgrPath		*prevPath = paths + (pathsCount - 1);
+	uvast		ownNodeNbr = getOwnNodeNbr();
+	int		spurIdx;
+	int		rootContact;
+	time_t		rootArrivalTime;
+	int		contact;
+	int		i;
+	int		finalContact;
+	int		spurHopsCount;
+	CgrPath		path;
+
+	/*	Each candidate path is a deviation from the most
+	 *	recently accepted path: it follows some prefix (the
+	 *	"root path") of that path and then departs from it
+	 *	at the "spur" contact, the last contact of the root
+	 *	path.  Spur paths departing before the point at which
+	 *	the most recently accepted path itself departed from
+	 *	its own predecessor were already found while that
+	 *	path was a candidate, so only the remaining spurs
+	 *	need to be searched.					*/
+
+	for (spurIdx = prevPath->spurIdx; spurIdx < prevPath->hopsCount;
+			spurIdx++)
+	{
+		if (spurIdx == 0)
+		{
+			rootContact = -1;
+		}
+		else
+		{
+			rootContact = prevPath->hops[spurIdx - 1];
+		}
+
+		rootArrivalTime = prefixArrivalTime(graph, prevPath->hops,
+				spurIdx, series->currentTime);
+
+		/*	Suppress the next contact of every accepted
+		 *	path that shares this root path, so that the
+		 *	spur path deviates from all of them, and also
+		 *	suppress every contact to a node of the root
+		 *	path (the local node, the spur node, and every
+		 *	node in between) so that the spur path can't
+		 *	loop back into it.				*/
+
+		memset(search->suppressed, 0, graph->contactsCount);
+		for (i = 0; i < pathsCount; i++)
+		{
+			if (paths[i].hopsCount > spurIdx
+			&& memcmp((char *) paths[i].hops,
+				(char *) prevPath->hops,
+				spurIdx * sizeof(int)) == 0)
+			{
+				search->suppressed[paths[i].hops[spurIdx]] = 1;
+			}
+		}
+
+		for (contact = 0; contact < graph->contactsCount; contact++)
+		{
+			if (graph->toNode[contact] == ownNodeNbr)
+			{
+				search->suppressed[contact] = 1;
+				continue;
+			}
+
+			for (i = 0; i < spurIdx; i++)
+			{
+				if (graph->toNode[contact]
+					== graph->toNode[prevPath->hops[i]])
+				{
+					search->suppressed[contact] = 1;
+					break;
+				}
+			}
+		}
+
+		clearSearch(search, graph);
+		if (searchGraph(graph, search, rootContact, rootArrivalTime,
+				series->stationNode->nodeNbr,
+				series->payloadClass, &finalContact) < 0)
+		{
+			putErrmsg("Can't finish Dijstra search.", NULL);
+			return -1;
+		}
+
+		if (finalContact < 0)
+		{
+			continue;	/*	No spur path.		*/
+		}
+
+		/*	Candidate is the root path followed by the
+		 *	spur path.					*/
+
+		spurHopsCount = extractPath(search, rootContact, finalContact,
+				search->hops);
+		path.hopsCount = spurIdx + spurHopsCount;
+		path.hops = (int *) malloc(path.hopsCount * sizeof(int));
+		if (path.hops == NULL)
+		{
+			putErrmsg("Can't create CGR candidate path.", NULL);
+			return -1;
+		}
+
+		memcpy((char *) path.hops, (char *) prevPath->hops,
+				spurIdx * sizeof(int));
+		memcpy((char *) (path.hops + spurIdx), (char *) search->hops,
+				spurHopsCount * sizeof(int));
+		path.deliveryTime = search->arrivalTime[finalContact];
+		path.spurIdx = spurIdx;
+		if (addCandidate(candidates, candidatesCount,
+				candidatesCapacity, &path) < 0)
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int	computeYenSeries(CgrSeries *series, CgrSearch *search)
+{
+	PsmPartition	ionwm = getIonwm();
+	CgrGraph	*graph = series->graph;
+	CgrPath		*paths;
+	int		pathsCount = 0;
+	CgrPath		*candidates;
+	int		candidatesCount = 0;
+	int		candidatesCapacity = series->maxRoutes;
+	int		finalContact;
+	int		best;
+	int		i;
+	int		result = 0;
+	PsmAddress	routeAddr;
+
+	/*	Run one series of Dijkstra searches implementing Yen's
+	 *	algorithm: compute the k best routes to the station
+	 *	node, regardless of leading contact.  The first route
+	 *	is the best route overall; each subsequent route is
+	 *	the best of all candidate routes that deviate from
+	 *	the routes already accepted.				*/
+
+	if (sizeSearch(search, graph) < 0)
+	{
+		return -1;
+	}
+
+	paths = (CgrPath *) malloc(series->maxRoutes * sizeof(CgrPath));
+	candidates = (CgrPath *) malloc(candidatesCapacity * sizeof(CgrPath));
+	if (paths == NULL || candidates == NULL)
+	{
+		free(paths);
+		free(candidates);
+		putErrmsg("Can't create CGR path lists.", NULL);
+		return -1;
+	}
+
+	memset(search->suppressed, 0, graph->contactsCount);
+	clearSearch(search, graph);
+	if (searchGraph(graph, search, -1, series->currentTime,
+			series->stationNode->nodeNbr, series->payloadClass,
+			&finalContact) < 0)
+	{
+		putErrmsg("Can't finish Dijstra search.", NULL);
+		result = -1;
+	}
+	else if (finalContact >= 0)
+	{
+		paths[0].hopsCount = extractPath(search, -1, finalContact,
+				search->hops);
+		paths[0].hops = (int *) malloc(paths[0].hopsCount
+				* sizeof(int));
+		if (paths[0].hops == NULL)
+		{
+			putErrmsg("Can't create CGR path.", NULL);
+			result = -1;
+		}
+		else
+		{
+			memcpy((char *) paths[0].hops, (char *) search->hops,
+					paths[0].hopsCount * sizeof(int));
+			paths[0].deliveryTime =
+					search->arrivalTime[finalContact];
+			paths[0].spurIdx = 0;
+			pathsCount = 1;
+		}
+	}
+
+	while (result == 0 && pathsCount > 0 && pathsCount < series->maxRoutes)
+	{
+		if (findSpurPaths(series, search, paths, pathsCount,
+				&candidates, &candidatesCount,
+				&candidatesCapacity) < 0)
+		{
+			result = -1;
+			break;
+		}
+
+		if (candidatesCount == 0)
+		{
+			break;		/*	No more routes.		*/
+		}
+
+		/*	Accept the best candidate: earliest delivery
+		 *	time, then fewest hops.				*/
+
+		best = 0;
+		for (i = 1; i < candidatesCount; i++)
+		{
+			if (candidates[i].deliveryTime
+					< candidates[best].deliveryTime
+			|| (candidates[i].deliveryTime
+					== candidates[best].deliveryTime
+				&& candidates[i].hopsCount
+					< candidates[best].hopsCount))
+			{
+				best = i;
+			}
+		}
+
+		paths[pathsCount] = candidates[best];
+		pathsCount++;
+		candidatesCount--;
+		candidates[best] = candidates[candidatesCount];
+	}
+
+	/*	Note in the series' own list a route for each path
+	 *	accepted, in order of acceptance.			*/
+
+	for (i = 0; result == 0 && i < pathsCount; i++)
+	{
+		if (createRoute(ionwm, graph, paths[i].hops,
+				paths[i].hopsCount, paths[i].deliveryTime,
+				series->payloadClass, &routeAddr) < 0)
+		{
+			result = -1;
+			break;
+		}
+
+		if (sm_list_insert_last(ionwm, series->routes, routeAddr) == 0)
+		{
+			discardRoute(ionwm, routeAddr);
+			putErrmsg("Can't note CGR route.", NULL);
+			result = -1;
+		}
+	}
+
+	releasePaths(paths, pathsCount);
+	releasePaths(candidates, candidatesCount);
+	return result;
+}
+
+static int	computeLeadSeries(CgrSeries *series, CgrSearch *search)
+{
+	PsmPartition	ionwm = getIonwm();
+	PsmAddress	routeAddr;
+
+	/*	Run one series of Dijkstra searches, noting in the
+	 *	series' own list each route found.  Each time we
+	 *	search, we exclude from consideration the first
+	 *	contact in every previously computed route.		*/
+
+	if (sizeSearch(search, series->graph) < 0)
+	{
+		return -1;
+	}
+
+	memset(search->suppressed, 0, series->graph->contactsCount);
+	while (1)
+	{
+		if (findNextBestRoute(ionwm, series->graph, search,
+				series->currentTime, series->stationNode,
+				series->payloadClass, &routeAddr) < 0)
+		{
+			return -1;
+		}
+
+		if (routeAddr == 0)
+		{
+			return 0;	/*	No more routes.		*/
+		}
+
+		if (sm_list_insert_last(ionwm, series->routes, routeAddr)
+				== 0)
+		{
+			discardRoute(ionwm, routeAddr);
+			putErrmsg("Can't note CGR route.", NULL);
+			return -1;
+		}
+
+		suppressLeadContact(series->graph, search,
+				(CgrRoute *) psp(ionwm, routeAddr));
+	}
+}
+
+static int	computeRouteSeries(CgrSeries *series, CgrSearch *search)
+{
+	if (series->maxRoutes > 0)
+	{
+		return computeYenSeries(series, search);
+	}
+
+	return computeLeadSeries(series, search);
+}
+
+/*		Functions for managing the CGR thread pool.		*/
+
+static CgrPool	*_cgrpool(int stop);
+
+static void	*runPoolThread(void *parm)
+{
+	CgrSearch	*search = (CgrSearch *) parm;
+	CgrPool		*pool = _cgrpool(0);
+	CgrSeries	*series;
+
+	/*	Repeatedly take the next unassigned series, if any,
+	 *	and run it; otherwise wait for more work.		*/
+
+	oK(pthread_mutex_lock(&pool->mutex));
+	while (!pool->stopping)
+	{
+		if (pool->nextSeries >= pool->seriesCount)
+		{
+			oK(pthread_cond_wait(&pool->workAvailable,
+					&pool->mutex));
+			continue;
+		}
+
+		series = pool->series + pool->nextSeries;
+		pool->nextSeries++;
+		oK(pthread_mutex_unlock(&pool->mutex));
+		series->result = computeRouteSeries(series, search);
+		oK(pthread_mutex_lock(&pool->mutex));
+		pool->unfinished--;
+		if (pool->unfinished == 0)
+		{
+			oK(pthread_cond_signal(&pool->workFinished));
+		}
+	}
+
+	oK(pthread_mutex_unlock(&pool->mutex));
+	return NULL;
+}
+
+static CgrPool	*_cgrpool(int stop)
+{
+	static CgrPool	pool;
+	static int	started = 0;
+	int		i;
+
+	if (stop)
+	{
+		if (started)
+		{
+			oK(pthread_mutex_lock(&pool.mutex));
+			pool.stopping = 1;
+			oK(pthread_cond_broadcast(&pool.workAvailable));
+			oK(pthread_mutex_unlock(&pool.mutex));
+			for (i = 0; i < pool.threadsCount; i++)
+			{
+				oK(pthread_join(pool.threads[i], NULL));
+			}
+
+			for (i = 0; i <= CGR_THREADS; i++)
+			{
+				releaseSearch(pool.searches + i);
+			}
+
+			oK(pthread_cond_destroy(&pool.workFinished));
+			oK(pthread_cond_destroy(&pool.workAvailable));
+			oK(pthread_mutex_destroy(&pool.mutex));
+			started = 0;
+		}
+
+		return NULL;
+	}
+
+	if (started)
+	{
+		return &pool;
+	}
+
+	/*	Start the pool.  Should any worker thread fail to
+	 *	start, the calling thread simply runs more of the
+	 *	series itself.						*/
+
+	memset((char *) &pool, 0, sizeof pool);
+	if (pthread_mutex_init(&pool.mutex, NULL)
+	|| pthread_cond_init(&pool.workAvailable, NULL)
+	|| pthread_cond_init(&pool.workFinished, NULL))
+	{
+		putSysErrmsg("Can't initialize CGR thread pool", NULL);
+		return NULL;
+	}
+
+	started = 1;
+	for (i = 0; i < CGR_THREADS; i++)
+	{
+		if (pthread_begin(pool.threads + i, NULL, runPoolThread,
+				pool.searches + i))
+		{
+			putSysErrmsg("Can't start CGR pool thread", itoa(i));
+			break;
+		}
+
+		pool.threadsCount++;
+	}
+
+	return &pool;
+}
+
+static int	runSeries(CgrSeries *series, int seriesCount)
+{
+	CgrPool		*pool;
+	CgrSeries	*mySeries;
+	int		result = 0;
+	int		i;
+
+	pool = _cgrpool(0);
+	if (pool == NULL)
+	{
+		putErrmsg("Can't get CGR thread pool.", NULL);
+		return -1;
+	}
+
+	/*	Offer the series to the worker threads, and run as
+	 *	many of them as possible in this thread as well.	*/
+
+	oK(pthread_mutex_lock(&pool->mutex));
+	pool->series = series;
+	pool->seriesCount = seriesCount;
+	pool->nextSeries = 0;
+	pool->unfinished = seriesCount;
+	oK(pthread_cond_broadcast(&pool->workAvailable));
+	while (pool->nextSeries < pool->seriesCount)
+	{
+		mySeries = pool->series + pool->nextSeries;
+		pool->nextSeries++;
+		oK(pthread_mutex_unlock(&pool->mutex));
+		mySeries->result = computeRouteSeries(mySeries,
+				pool->searches + CGR_THREADS);
+		oK(pthread_mutex_lock(&pool->mutex));
+		pool->unfinished--;
+	}
+
+	while (pool->unfinished > 0)
+	{
+		oK(pthread_cond_wait(&pool->workFinished, &pool->mutex));
+	}
+
+	pool->series = NULL;
+	pool->seriesCount = 0;
+	pool->nextSeries = 0;
+	oK(pthread_mutex_unlock(&pool->mutex));
+	for (i = 0; i < seriesCount; i++)
+	{
+		if (series[i].result < 0)
+		{
+			result = -1;
+		}
+	}
+
+	return result;
+}
+
+static int	getMaxRoutes()
+{
+	Sdr	sdr = getIonsdr();
+	Object	iondbObj = getIonDbObject();
+	IonDB	iondb;
+	int	maxRoutes;
+
+	/*	The maximum number of routes of each payload class
+	 *	that are computed to each destination node by Yen's
+	 *	k-shortest-paths algorithm, as set by ionadmin.  If
+	 *	zero, one route is instead computed via each leading
+	 *	contact: the best route that begins with that contact.	*/
+
+	sdr_read(sdr, (char *) &maxRoutes, iondbObj
+			+ FLD_OFFSET(&iondb.maxRoutes, &iondb), sizeof(int));
+	return maxRoutes;
+}
+
+static int	loadRouteLists(IonNode **stationNodes, int nodesCount,
+			time_t currentTime)
+{
+	PsmPartition	ionwm = getIonwm();
+	CgrVdb		*cgrvdb = _cgrvdb(NULL);
+	CgrGraph	*graph;
+	int		maxRoutes = getMaxRoutes();
+	CgrSeries	series[CGR_PRECOMPUTE_BATCH * PAYLOAD_CLASSES];
+	int		seriesCount = 0;
+	int		result = 0;
+	IonNode		*stationNode;
+	PsmAddress	elt;
+	PsmAddress	routeAddr;
+	CgrRoute	*route;
+	int		i;
+	int		j;
+
+	CHKERR(cgrvdb);
+	CHKERR(nodesCount > 0 && nodesCount <= CGR_PRECOMPUTE_BATCH);
+	graph = _cgrgraph(cgrvdb);
+	if (graph == NULL)
+	{
+		putErrmsg("Can't get CGR contact graph.", NULL);
+		return -1;
+	}
+
+	/*	First create route list for each destination node,
+	 *	unless the node's existing list is merely being
+	 *	refilled.						*/
+
+	for (i = 0; i < nodesCount; i++)
+	{
+		stationNode = stationNodes[i];
+#if CGRDEBUG
+printf(">>>Computing all routes from node " UVAST_FIELDSPEC " to \
+node " UVAST_FIELDSPEC ".\n", getOwnNodeNbr(), stationNode->nodeNbr);
+#endif
+		if (stationNode->routingObject)
+		{
+			continue;
+		}
+
+		stationNode->routingObject = sm_list_create(ionwm);
+		if (stationNode->routingObject == 0)
+		{
+			putErrmsg("Can't create CGR route list.", NULL);
+			return -1;
+		}
+
+		oK(sm_list_user_data_set(ionwm, stationNode->routingObject,
+				psa(ionwm, stationNode)));
+		if (sm_list_insert_last(ionwm, cgrvdb->routeLists,
+				stationNode->routingObject) == 0)
+		{
+			putErrmsg("Can't note CGR route list.", NULL);
+			return -1;
+		}
+	}
+
+	/*	Now note the best routes (transmission sequences,
+	 *	paths, itineraries) from the local node that can
+	 *	result in delivery at each remote node.  To do this,
+	 *	we run multiple series of Dijkstra searches (one
+	 *	series per payload class per node) through the
+	 *	contact graph, rooted at a dummy contact from the
+	 *	local node to itself and terminating in the "final
+	 *	contact" (which is the station node's contact with
+	 *	itself).  All of these series are independent, so
+	 *	they are run in parallel.				*/
+
+	for (i = 0; i < nodesCount && result == 0; i++)
+	{
+		for (j = 0; j < PAYLOAD_CLASSES; j++)
+		{
+			series[seriesCount].graph = graph;
+			series[seriesCount].stationNode = stationNodes[i];
+			series[seriesCount].currentTime = currentTime;
+			series[seriesCount].payloadClass = j;
+			series[seriesCount].maxRoutes = maxRoutes;
+			series[seriesCount].result = 0;
+			series[seriesCount].routes = sm_list_create(ionwm);
+			if (series[seriesCount].routes == 0)
+			{
+				putErrmsg("Can't create CGR series.", NULL);
+				result = -1;
+				break;
+			}
+
+			seriesCount++;
+		}
+	}
+
+	if (result == 0 && runSeries(series, seriesCount) < 0)
+	{
+		putErrmsg("Can't compute CGR routes.", NULL);
+		result = -1;
+	}
+
+	/*	Finally, cite the contacts of every route found and
+	 *	append it to its station node's list of routes, in
+	 *	order of payload class.  On any failure, discard all
+	 *	remaining routes.					*/
+
+	for (i = 0; i < seriesCount; i++)
+	{
+		stationNode = series[i].stationNode;
+		while ((elt = sm_list_first(ionwm, series[i].routes)) != 0)
+		{
+			routeAddr = sm_list_data(ionwm, elt);
+			sm_list_delete(ionwm, elt, NULL, NULL);
+			if (result < 0)
+			{
+				discardRoute(ionwm, routeAddr);
+				continue;
+			}
+
+			route = (CgrRoute *) psp(ionwm, routeAddr);
+			route->routeElt = sm_list_insert_last(ionwm,
+					stationNode->routingObject, routeAddr);
+			if (route->routeElt == 0
+			|| citeContacts(ionwm, routeAddr) < 0)
+			{
+				discardRoute(ionwm, routeAddr);
+				putErrmsg("Can't add route to list.", NULL);
+				result = -1;
+			}
+		}
+
+		sm_list_destroy(ionwm, series[i].routes, NULL, NULL);
+	}
+
+#if CGRDEBUG
+for (i = 0; i < nodesCount; i++)
+printf("<<<Computed all routes from node " UVAST_FIELDSPEC " to node "
+UVAST_FIELDSPEC ".\n\n", getOwnNodeNbr(), stationNodes[i]->nodeNbr);
+#endif
+	return result;
+}
+
+static PsmAddress	loadRouteList(IonNode *stationNode, time_t currentTime)
+{
+	if (loadRouteLists(&stationNode, 1, currentTime) < 0)
+	{
+		return 0;
+	}
+
+	return stationNode->routingObject;
+}
+
+/*		Functions for revising computed routes.			*/
+
+static int	computeAdditionalRoute(IonNode *stationNode,
+			time_t currentTime, int payloadClass)
+{
+	PsmPartition	ionwm = getIonwm();
+	CgrGraph	*graph;
+	CgrPool		*pool;
+	CgrSearch	*search;
+	PsmAddress	routes;
+	PsmAddress	elt;
+	CgrRoute	*route;
+	PsmAddress	routeAddr;
+	CgrRoute	*newRoute;
+
+	graph = _cgrgraph(_cgrvdb(NULL));
+	pool = _cgrpool(0);
+	if (graph == NULL || pool == NULL)
+	{
+		putErrmsg("Can't get CGR contact graph.", NULL);
+		return -1;
+	}
+
+	search = pool->searches + CGR_THREADS;	/*	This thread's.	*/
+	if (sizeSearch(search, graph) < 0)
+	{
+		putErrmsg("Can't get CGR search work areas.", NULL);
+		return -1;
+	}
+
+	/*	Compute the best route of this payload class whose
+	 *	leading contact is not the leading contact of any
+	 *	route of this class that is already in stationNode's
+	 *	list of routes.  First suppress from consideration
+	 *	as lead contact every contact that is already the
+	 *	leading contact of any remaining route of this class.	*/
+
+	routes = stationNode->routingObject;
+	memset(search->suppressed, 0, graph->contactsCount);
+	for (elt = sm_list_first(ionwm, routes); elt; elt =
+			sm_list_next(ionwm, elt))
+	{
+		route = (CgrRoute *) psp(ionwm, sm_list_data(ionwm, elt));
+		if (route->payloadClass == payloadClass)
+		{
+			suppressLeadContact(graph, search, route);
+		}
+	}
+
+	/*	Next invoke findNextBestRoute to produce a new route
+	 *	starting at some unsuppressed contact.			*/
+
+	if (findNextBestRoute(ionwm, graph, search, currentTime, stationNode,
+			payloadClass, &routeAddr) < 0)
+	{
+		putErrmsg("Can't recompute route.", NULL);
+		return -1;
+	}
+
+	if (routeAddr == 0)		/*	No route computed.	*/
+	{
+		return 0;
+	}
+
+	if (citeContacts(ionwm, routeAddr) < 0)
+	{
+		discardRoute(ionwm, routeAddr);
+		putErrmsg("Can't cite contacts of CGR route.", NULL);
+		return -1;
+	}
+
+	/*	Finally, insert that route into the stationNode's
+	 *	list of routes in deliveryTime order.			*/
+
+	newRoute = (CgrRoute *) psp(ionwm, routeAddr);
+	for (elt = sm_list_first(ionwm, routes); elt; elt =
+			sm_list_next(ionwm, elt))
+	{
+		route = (CgrRoute *) psp(ionwm, sm_list_data(ionwm, elt));
+		if (route->deliveryTime <= newRoute->deliveryTime)
+		{
+			continue;
+		}
+
+		break;		/*	Insert before this route.	*/
+	}
+
+	if (elt)
+	{
+		newRoute->routeElt = sm_list_insert_before(ionwm, elt,
+				routeAddr);
+	}
+	else
+	{
+		newRoute->routeElt = sm_list_insert_last(ionwm, routes,
+				routeAddr);
+	}
+
+	if (newRoute->routeElt == 0)
+	{
+		discardRoute(ionwm, routeAddr);
+		putErrmsg("Can't add route to list.", NULL);
+		return -1;
+	}
+
+	return 1;
+}
+
+static int	recomputeRouteForContact(uvast contactToNodeNbr,
+			time_t contactFromTime, IonNode *stationNode,
+			time_t currentTime, int payloadClass)
+{
+	PsmPartition	ionwm = getIonwm();
+	IonVdb		*vdb = getIonVdb();
+	IonCXref	arg;
+	PsmAddress	cxelt;
+	PsmAddress	nextElt;
+	IonCXref	*contact;
+
+	arg.fromNode = getOwnNodeNbr();
+	arg.toNode = contactToNodeNbr;
+	arg.fromTime = contactFromTime;
+	cxelt = sm_rbt_search(ionwm, vdb->contactIndex, rfx_order_contacts,
+			&arg, &nextElt);
+	if (cxelt == 0)
+	{
+		return 0;	/*	Can't find the contact.		*/
+	}
+
+	contact = (IonCXref *) psp(ionwm, sm_rbt_data(ionwm, cxelt));
+	if (contact->toTime <= currentTime)
+	{
+		return 0;	/*	Contact is expired.		*/
+	}
+
+	/*	Recompute route through this leading contact.		*/
+
+	return computeAdditionalRoute(stationNode, currentTime, payloadClass);
+}
+
+static int	noteRevisedList(PsmPartition ionwm, CgrVdb *vdb,
+			PsmAddress routes)
+{
+	PsmAddress	elt;
+
+	for (elt = sm_list_first(ionwm, vdb->revisedLists); elt;
+			elt = sm_list_next(ionwm, elt))
+	{
+		if (sm_list_data(ionwm, elt) == routes)
+		{
+			return 0;	/*	Already noted.		*/
+		}
+	}
+
+	if (sm_list_insert_last(ionwm, vdb->revisedLists, routes) == 0)
+	{
+		putErrmsg("Can't note revised CGR route list.", NULL);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int	applyContactRemoval(PsmPartition ionwm, CgrVdb *vdb,
+			IonContactEdit *edit)
+{
+	CgrCitation	*citation;
+	PsmAddress	routeAddr;
+	CgrRoute	*route;
+
+	/*	Every route that traverses the removed contact is
+	 *	no longer valid; discard all of them.  Discarding
+	 *	the last such route erases the citation itself.		*/
+
+	while ((citation = findCitation(ionwm, vdb, edit->fromNode,
+			edit->toNode, edit->fromTime)) != NULL)
+	{
+		routeAddr = sm_list_data(ionwm,
+				sm_list_first(ionwm, citation->routes));
+		route = (CgrRoute *) psp(ionwm, routeAddr);
+		if (noteRevisedList(ionwm, vdb,
+				sm_list_list(ionwm, route->routeElt)) < 0)
+		{
+			return -1;
+		}
+
+		discardRoute(ionwm, routeAddr);
+	}
+
+	return 0;
+}
+
+static int	reviseStationRoutes(PsmPartition ionwm, CgrVdb *vdb,
+			IonContactEdit *edit, uvast stationNodeNbr,
+			time_t arrivalTime)
+{
+	IonVdb		*ionvdb = getIonVdb();
+	IonNode		*stationNode;
+	PsmAddress	nextElt;
+	PsmAddress	elt;
+	PsmAddress	next;
+	CgrRoute	*route;
+
+	stationNode = findNode(ionvdb, stationNodeNbr, &nextElt);
+	if (stationNode == NULL || stationNode->routingObject == 0)
+	{
+		return 0;	/*	No routes computed yet.		*/
+	}
+
+	/*	Data can reach this station via the new contact at
+	 *	arrivalTime, so any route to it with a later delivery
+	 *	time might be improved.  Discard those routes and
+	 *	note that the list must be supplemented by additional
+	 *	searches.  (A new contact from the local node can
+	 *	only lead a new route; no existing route would loop
+	 *	back through the local node to use it.)			*/
+
+	if (edit->fromNode != getOwnNodeNbr())
+	{
+		for (elt = sm_list_first(ionwm, stationNode->routingObject);
+				elt; elt = next)
+		{
+			next = sm_list_next(ionwm, elt);
+			route = (CgrRoute *) psp(ionwm, sm_list_data(ionwm,
+					elt));
+			if (route->deliveryTime > arrivalTime)
+			{
+				discardRoute(ionwm, sm_list_data(ionwm, elt));
+			}
+		}
+	}
+
+	return noteRevisedList(ionwm, vdb, stationNode->routingObject);
+}
+
+static int	applyContactAddition(PsmPartition ionwm, CgrVdb *vdb,
+			IonContactEdit *edit, time_t currentTime)
+{
+	CgrGraph	*graph;
+	CgrPool		*pool;
+	CgrSearch	*search;
+	int		contact;
+	int		finalContact;
+	time_t		transmitTime;
+	time_t		arrivalTime;
+	int		i;
+
+	graph = _cgrgraph(vdb);
+	pool = _cgrpool(0);
+	if (graph == NULL || pool == NULL)
+	{
+		putErrmsg("Can't get CGR contact graph.", NULL);
+		return -1;
+	}
+
+	search = pool->searches + CGR_THREADS;	/*	This thread's.	*/
+	if (sizeSearch(search, graph) < 0)
+	{
+		putErrmsg("Can't get CGR search work areas.", NULL);
+		return -1;
+	}
+
+	/*	A new contact can't degrade any existing route, but
+	 *	it may improve a route to any station that can be
+	 *	reached via the contact, and it may make it possible
+	 *	to reach such a station via some leading contact that
+	 *	previously led to no route at all.  Only the route
+	 *	lists of those stations need revision.  A contact
+	 *	that is missing from the graph has since been removed
+	 *	or has no known range, so no route can use it.		*/
+
+	contact = findGraphContact(graph, edit->fromNode, edit->toNode,
+			edit->fromTime);
+	if (contact < 0 || graph->toTime[contact] <= currentTime
+	|| graph->capacity[contact] < _minCapacity(0))
+	{
+		return 0;
+	}
+
+	/*	First find the earliest time at which data can reach
+	 *	the contact's "from" node.  Class 0 has the lowest
+	 *	capacity floor, so no route of any class can reach
+	 *	the node any sooner.					*/
+
+	memset(search->suppressed, 0, graph->contactsCount);
+	if (edit->fromNode == getOwnNodeNbr())
+	{
+		transmitTime = currentTime;
+	}
+	else
+	{
+		clearSearch(search, graph);
+		if (searchGraph(graph, search, -1, currentTime,
+				edit->fromNode, 0, &finalContact) < 0)
+		{
+			putErrmsg("Can't finish Dijstra search.", NULL);
+			return -1;
+		}
+
+		if (finalContact < 0)
+		{
+			return 0;	/*	Contact is unreachable.	*/
+		}
+
+		transmitTime = search->arrivalTime[finalContact];
+	}
+
+	if (transmitTime >= graph->toTime[contact])
+	{
+		return 0;	/*	Contact is over by then.	*/
+	}
+
+	if (transmitTime < graph->fromTime[contact])
+	{
+		transmitTime = graph->fromTime[contact];
+	}
+
+	arrivalTime = transmitTime + graph->owlt[contact];
+
+	/*	Then find the earliest arrival time via the contact at
+	 *	every node that can be reached from its "to" node.
+	 *	No station is numbered 0, so the search is exhaustive.	*/
+
+	clearSearch(search, graph);
+	if (searchGraph(graph, search, contact, arrivalTime, 0, 0,
+			&finalContact) < 0)
+	{
+		putErrmsg("Can't finish Dijstra search.", NULL);
+		return -1;
+	}
+
+	if (reviseStationRoutes(ionwm, vdb, edit, edit->toNode, arrivalTime)
+			< 0)
+	{
+		return -1;
+	}
+
+	for (i = 0; i < graph->contactsCount; i++)
+	{
+		if (search->arrivalTime[i] == MAX_TIME)
+		{
+			continue;	/*	Not reached.		*/
+		}
+
+		if (reviseStationRoutes(ionwm, vdb, edit, graph->toNode[i],
+				search->arrivalTime[i]) < 0)
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int	applyContactEdits(CgrVdb *vdb, time_t currentTime)
+{
+	PsmPartition	ionwm = getIonwm();
+	IonVdb		*ionvdb = getIonVdb();
+	PsmAddress	elt;
+	IonContactEdit	*edit;
+	int		result = 0;
+
+	while ((elt = sm_list_first(ionwm, ionvdb->contactEdits)) != 0)
+	{
+		edit = (IonContactEdit *) psp(ionwm, sm_list_data(ionwm, elt));
+		if (edit->type == IonContactRemoved)
+		{
+			result = applyContactRemoval(ionwm, vdb, edit);
+		}
+		else
+		{
+			result = applyContactAddition(ionwm, vdb, edit,
+					currentTime);
+		}
+
+		sm_list_delete(ionwm, elt, rfx_erase_data, NULL);
+		if (result < 0)
+		{
+			putErrmsg("Can't apply contact plan edit.", NULL);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int	applyContactPlanChanges(IonVdb *ionvdb, CgrVdb *cgrvdb,
+			time_t currentTime)
+{
+	if (ionvdb->lastEditTime > cgrvdb->lastLoadTime)
+	{
+		/*	Contact plan has been modified in a way that
+		 *	affects routes generally (such as a change in
+		 *	range), so must discard all route lists and
+		 *	reconstruct them as needed.			*/
 
-		*routeAddr = addr;
+		discardRouteLists(cgrvdb);
+		cgrvdb->lastLoadTime = currentTime;
+		cgrvdb->graphVersion++;
+		return 0;
 	}
 
-	return 0;
+	/*	Revise only the routes affected by contacts inserted
+	 *	or removed since routes were last consulted.		*/
+
+	if (sm_list_length(getIonwm(), ionvdb->contactEdits) == 0)
+	{
+		return 0;
+	}
+
+	cgrvdb->graphVersion++;
+	return applyContactEdits(cgrvdb, currentTime);
 }
 
-static PsmAddress	loadRouteList(IonNode *stationNode, time_t currentTime)
+static int	reviseRouteList(IonNode *stationNode, time_t currentTime)
 {
 	PsmPartition	ionwm = getIonwm();
-	IonVdb		*ionvdb = getIonVdb();
-	CgrVdb		*cgrvdb = _cgrvdb(NULL);
-	int		payloadClass;
+	CgrVdb		*vdb = _cgrvdb(NULL);
 	PsmAddress	elt;
-	IonCXref	*contact;
-	CgrContactNote	*work;
-	IonCXref	rootContact;
-	CgrContactNote	rootWork;
-	PsmAddress	routeAddr;
+	PsmAddress	nextElt;
 	CgrRoute	*route;
-	IonCXref	*firstContact;
-
-	CHKZERO(ionvdb);
-	CHKZERO(cgrvdb);
-
-	/*	First create route list for this destination node.	*/
+	int		payloadClass;
+	int		result;
 
-	stationNode->routingObject = sm_list_create(ionwm);
-	if (stationNode->routingObject == 0)
+	for (elt = sm_list_first(ionwm, vdb->revisedLists); elt;
+			elt = sm_list_next(ionwm, elt))
 	{
-		putErrmsg("Can't create CGR route list.", NULL);
-		return 0;
+		if (sm_list_data(ionwm, elt) == stationNode->routingObject)
+		{
+			break;
+		}
 	}
 
-	oK(sm_list_user_data_set(ionwm, stationNode->routingObject,
-			psa(ionwm, stationNode)));
-	if (sm_list_insert_last(ionwm, cgrvdb->routeLists,
-			stationNode->routingObject) == 0)
+	if (elt == 0)
 	{
-		putErrmsg("Can't note CGR route list.", NULL);
-		return 0;
+		return 0;	/*	No revision needed.		*/
 	}
 
+	sm_list_delete(ionwm, elt, NULL, NULL);
 #if CGRDEBUG
-printf(">>>Computing all routes from node " UVAST_FIELDSPEC " to \
-node " UVAST_FIELDSPEC ".\n", getOwnNodeNbr(), stationNode->nodeNbr);
+printf(">>>Revising routes from node " UVAST_FIELDSPEC " to node "
+UVAST_FIELDSPEC ".\n", getOwnNodeNbr(), stationNode->nodeNbr);
 #endif
-	/*	Now note the best routes (transmission sequences,
-	 *	paths, itineraries) from the local node that can
-	 *	result in delivery at the remote node.  To do this,
-	 *	we run multiple series of Dijkstra searches (one
-	 *	series per payload class) through the contact
-	 *	graph, rooted at a dummy contact from the local node
-	 *	to itself and terminating in the "final contact"
-	 *	(which is the station node's contact with itself).
-	 *	Each time we search, we exclude from consideration
-	 *	the first contact in every previously computed route.	*/
-
-	rootContact.fromNode = getOwnNodeNbr();
-	rootContact.toNode = rootContact.fromNode;
-	rootWork.arrivalTime = currentTime;
-	for (payloadClass = 0; payloadClass < PAYLOAD_CLASSES; payloadClass++)
+	/*	A route whose delivery time has already passed was
+	 *	computed for departure at some earlier time, so it
+	 *	can't fairly be compared with the routes about to be
+	 *	computed.  Discard it, so that the route via its
+	 *	leading contact is recomputed as well.			*/
+
+	for (elt = sm_list_first(ionwm, stationNode->routingObject); elt;
+			elt = nextElt)
 	{
-		/*	For each series of searches, clear Dijkstra
-		 *	work areas for all contacts.			*/
-
-		for (elt = sm_rbt_first(ionwm, ionvdb->contactIndex); elt;
-				elt = sm_rbt_next(ionwm, elt))
+		nextElt = sm_list_next(ionwm, elt);
+		route = (CgrRoute *) psp(ionwm, sm_list_data(ionwm, elt));
+		if (route->deliveryTime < currentTime)
 		{
-			contact = (IonCXref *)
-					psp(ionwm, sm_rbt_data(ionwm, elt));
-			if ((work = (CgrContactNote *) psp(ionwm,
-					contact->routingObject)) == 0)
-			{
-				contact->routingObject = psm_zalloc(ionwm,
-						sizeof(CgrContactNote));
-				work = (CgrContactNote *) psp(ionwm,
-						contact->routingObject);
-				if (work == 0)
-				{
-					putErrmsg("Can't create contact note.",
-							NULL);
-					return 0;
-				}
-			}
-
-			memset((char *) work, 0, sizeof(CgrContactNote));
-			work->arrivalTime = MAX_TIME;
+			discardRoute(ionwm, sm_list_data(ionwm, elt));
 		}
+	}
 
-		while (1)
-		{
-			if (findNextBestRoute(ionwm, &rootContact, &rootWork,
-				stationNode, payloadClass, &routeAddr) < 0)
-			{
-				putErrmsg("Can't load routes list.", NULL);
-				return 0;
-			}
-
-			if (routeAddr == 0)
-			{
-				/*	No more routes for this class.	*/
-
-				break;	/*	Move on to next class.	*/
-			}
-
-			/*	Found optimal route, given exclusion
-			 *	of all contacts that are the initial
-			 *	contacts on previously discovered
-			 *	optimal routes.				*/
-
-			if (sm_list_insert_last(ionwm,
-				stationNode->routingObject, routeAddr) == 0)
-			{
-				putErrmsg("Can't add route to list.", NULL);
-				return 0;
-			}
-
-			/*	Now exclude the initial contact in this
-			 *	optimal route, re-clear, and try again.	*/
+	/*	Continue each series of Dijkstra searches from where
+	 *	it now stands: the leading contacts of all surviving
+	 *	routes are excluded, so each search finds the best
+	 *	route via some other leading contact, until there
+	 *	are no more routes to find.				*/
 
-			route = (CgrRoute *) psp(ionwm, routeAddr);
-			firstContact = (IonCXref *)
-					psp(ionwm, sm_list_data(ionwm,
-					sm_list_first(ionwm, route->hops)));
-			work = (CgrContactNote *)
-					psp(ionwm, firstContact->routingObject);
-			work->suppressed = 1;
-			for (elt = sm_rbt_first(ionwm, ionvdb->contactIndex);
-				       	elt; elt = sm_rbt_next(ionwm, elt))
+	for (payloadClass = 0; payloadClass < PAYLOAD_CLASSES; payloadClass++)
+	{
+		do
+		{
+			result = computeAdditionalRoute(stationNode,
+					currentTime, payloadClass);
+			if (result < 0)
 			{
-				contact = (IonCXref *)
-					psp(ionwm, sm_rbt_data(ionwm, elt));
-				work = (CgrContactNote *)
-					psp(ionwm, contact->routingObject);
-				work->arrivalTime = MAX_TIME;
-				work->predecessor = NULL;
-				work->visited = 0;
+				putErrmsg("Can't revise routes for node.",
+						utoa(stationNode->nodeNbr));
+				return -1;
 			}
-		}
+		} while (result > 0);
 	}
 
-#if CGRDEBUG
-printf("<<<Computed all routes from node " UVAST_FIELDSPEC " to node "
-UVAST_FIELDSPEC ".\n\n", getOwnNodeNbr(), stationNode->nodeNbr);
-#endif
-	return stationNode->routingObject;
+	return 0;
 }
 
-/*		Functions for identifying viable proximate nodes.	*/
-
-static int	recomputeRouteForContact(uvast contactToNodeNbr,
-			time_t contactFromTime, IonNode *stationNode,
-			time_t currentTime, int payloadClass)
+static int	refillRouteList(IonNode *stationNode, time_t currentTime)
 {
 	PsmPartition	ionwm = getIonwm();
-	IonVdb		*vdb = getIonVdb();
-	PsmAddress	routes;
-	IonCXref	arg;
-	PsmAddress	cxelt;
-	PsmAddress	nextElt;
-	IonCXref	*contact;
-	CgrContactNote	*work;
+	CgrVdb		*vdb = _cgrvdb(NULL);
 	PsmAddress	elt;
-	CgrRoute	*route;
-	IonCXref	rootContact;
-	CgrContactNote	rootWork;
-	PsmAddress	routeAddr;
-	CgrRoute	*newRoute;
 
-	routes = stationNode->routingObject;
-	arg.fromNode = getOwnNodeNbr();
-	arg.toNode = contactToNodeNbr;
-	arg.fromTime = contactFromTime;
-	cxelt = sm_rbt_search(ionwm, vdb->contactIndex, rfx_order_contacts,
-			&arg, &nextElt);
-	if (cxelt == 0)
+	/*	The routes computed by Yen's algorithm are mutually
+	 *	dependent: each is derived from routes accepted before
+	 *	it, so no one of them can be recomputed in isolation.
+	 *	Instead the list is emptied and all of its routes
+	 *	are computed again.					*/
+
+	for (elt = sm_list_first(ionwm, vdb->revisedLists); elt;
+			elt = sm_list_next(ionwm, elt))
 	{
-		return 0;	/*	Can't find the contact.		*/
+		if (sm_list_data(ionwm, elt) == stationNode->routingObject)
+		{
+			sm_list_delete(ionwm, elt, NULL, NULL);
+			break;
+		}
 	}
 
-	contact = (IonCXref *) psp(ionwm, sm_rbt_data(ionwm, cxelt));
-	if (contact->toTime <= currentTime)
+	while ((elt = sm_list_first(ionwm, stationNode->routingObject)) != 0)
 	{
-		return 0;	/*	Contact is expired.		*/
+		discardRoute(ionwm, sm_list_data(ionwm, elt));
 	}
 
-	/*	Recompute route through this leading contact.  First
-	 *	clear Dijkstra work areas for all contacts in the
-	 *	contactIndex.						*/
+	return loadRouteLists(&stationNode, 1, currentTime);
+}
+
+static int	routeListIsStale(IonNode *stationNode, time_t currentTime)
+{
+	PsmPartition	ionwm = getIonwm();
+	CgrVdb		*vdb = _cgrvdb(NULL);
+	PsmAddress	elt;
+	CgrRoute	*route;
 
-	for (cxelt = sm_rbt_first(ionwm, vdb->contactIndex); cxelt;
-			cxelt = sm_rbt_next(ionwm, cxelt))
+	for (elt = sm_list_first(ionwm, vdb->revisedLists); elt;
+			elt = sm_list_next(ionwm, elt))
 	{
-		contact = (IonCXref *) psp(ionwm, sm_rbt_data(ionwm, cxelt));
-		if ((work = (CgrContactNote *) psp(ionwm,
-				contact->routingObject)) == 0)
+		if (sm_list_data(ionwm, elt) == stationNode->routingObject)
 		{
-			contact->routingObject = psm_zalloc(ionwm,
-					sizeof(CgrContactNote));
-			work = (CgrContactNote *) psp(ionwm,
-					contact->routingObject);
-			if (work == 0)
-			{
-				putErrmsg("Can't create CGR contact note.",
-						NULL);
-				return -1;
-			}
+			return 1;	/*	Revision needed.	*/
 		}
-
-		memset((char *) work, 0, sizeof(CgrContactNote));
-		work->arrivalTime = MAX_TIME;
 	}
 
-	/*	Now suppress from consideration as lead contact
-	 *	every contact that is already the leading contact of
-	 *	any remaining route in stationNode's list of routes.	*/
-
-	for (elt = sm_list_first(ionwm, routes); elt; elt =
-			sm_list_next(ionwm, elt))
+	for (elt = sm_list_first(ionwm, stationNode->routingObject); elt;
+			elt = sm_list_next(ionwm, elt))
 	{
 		route = (CgrRoute *) psp(ionwm, sm_list_data(ionwm, elt));
-		arg.fromNode = getOwnNodeNbr();
-		arg.toNode = route->toNodeNbr;
-		arg.fromTime = route->fromTime;
-		cxelt = sm_rbt_search(ionwm, vdb->contactIndex,
-				rfx_order_contacts, &arg, &nextElt);
-		if (cxelt == 0)
-		{
-			/*	This is an old route, for a contact
-			 *	that is already ended, but the route
-			 *	hasn't been purged yet because it
-			 *	hasn't been used recently.  Ignore it.	*/
-
-			continue;
+		if (route->toTime < currentTime)
+		{
+			return 1;	/*	Route has expired.	*/
 		}
-
-		contact = (IonCXref *) psp(ionwm, sm_rbt_data(ionwm, cxelt));
-		work = (CgrContactNote *) psp(ionwm, contact->routingObject);
-		work->suppressed = 1;
 	}
 
-	/*	Next invoke findNextBestRoute to produce a new route
-	 *	starting at the subject contact.			*/
+	return 0;
+}
+
+static int	prepareRouteList(IonNode *stationNode, time_t currentTime)
+{
+	PsmPartition	ionwm = getIonwm();
+	PsmAddress	elt;
+	PsmAddress	nextElt;
+	PsmAddress	addr;
+	CgrRoute	*route;
+	uvast		contactToNodeNbr;
+	time_t		contactFromTime;
+	int		payloadClass;
 
-	rootContact.fromNode = getOwnNodeNbr();
-	rootContact.toNode = rootContact.fromNode;
-	rootWork.arrivalTime = currentTime;
-	if (findNextBestRoute(ionwm, &rootContact, &rootWork,
-			stationNode, payloadClass, &routeAddr) < 0)
+	/*	Bring the list of routes to this station node up to
+	 *	date as of the current time, computing it if it has
+	 *	not yet been computed.					*/
+
+	if (stationNode->routingObject == 0)
 	{
-		putErrmsg("Can't recompute route.", NULL);
-		return -1;
+		if (loadRouteList(stationNode, currentTime) == 0)
+		{
+			putErrmsg("Can't load routes for node.",
+					utoa(stationNode->nodeNbr));
+			return -1;
+		}
+
+		return 0;
 	}
 
-	if (routeAddr == 0)		/*	No route computed.	*/
+	if (getMaxRoutes() > 0)
 	{
+		if (routeListIsStale(stationNode, currentTime)
+		&& refillRouteList(stationNode, currentTime) < 0)
+		{
+			putErrmsg("Can't reload routes for node.",
+					utoa(stationNode->nodeNbr));
+			return -1;
+		}
+
 		return 0;
 	}
 
-	/*	Finally, insert that route into the stationNode's
-	 *	list of routes in deliveryTime order.			*/
-
-	newRoute = (CgrRoute *) psp(ionwm, routeAddr);
-	for (elt = sm_list_first(ionwm, routes); elt; elt =
-			sm_list_next(ionwm, elt))
+	for (elt = sm_list_first(ionwm, stationNode->routingObject); elt;
+			elt = nextElt)
 	{
-		route = (CgrRoute *) psp(ionwm, sm_list_data(ionwm, elt));
-		if (route->deliveryTime <= newRoute->deliveryTime)
+		nextElt = sm_list_next(ionwm, elt);
+		addr = sm_list_data(ionwm, elt);
+		route = (CgrRoute *) psp(ionwm, addr);
+		if (route->toTime >= currentTime)
 		{
 			continue;
 		}
 
-		break;		/*	Insert before this route.	*/
-	}
+		/*	This route includes a contact that has already
+		 *	ended; delete it.				*/
 
-	if (elt)
-	{
-		sm_list_insert_before(ionwm, elt, routeAddr);
+		contactToNodeNbr = route->toNodeNbr;
+		contactFromTime = route->fromTime;
+		payloadClass = route->payloadClass;
+		discardRoute(ionwm, addr);
+		switch (recomputeRouteForContact(contactToNodeNbr,
+				contactFromTime, stationNode, currentTime,
+				payloadClass))
+		{
+		case -1:
+			putErrmsg("Route recomputation failed.", NULL);
+			return -1;
+
+		case 0:
+			break;		/*	Lead contact defunct.	*/
+
+		default:
+			/*	Route through this lead contact has
+			 *	been recomputed and inserted into the
+			 *	list of routes.  Must start again from
+			 *	the beginning of the list.		*/
+
+			nextElt = sm_list_first(ionwm,
+					stationNode->routingObject);
+		}
 	}
-	else
+
+	if (reviseRouteList(stationNode, currentTime) < 0)
 	{
-		sm_list_insert_last(ionwm, routes, routeAddr);
+		putErrmsg("Can't revise routes for node.",
+				utoa(stationNode->nodeNbr));
+		return -1;
 	}
 
-	return 1;
+	return 0;
 }
 
+/*		Functions for identifying viable proximate nodes.	*/
+
 static int	isExcluded(uvast nodeNbr, Lyst excludedNodes)
 {
 	LystElt	elt;
@@ -1170,9 +2870,6 @@ static int	identifyProximateNodes(IonNode *stationNode, Bundle *bundle,
 	PsmAddress	nextElt;
 	PsmAddress	addr;
 	CgrRoute	*route;
-	uvast		contactToNodeNbr;
-	time_t		contactFromTime;
-	int		payloadClass;
 	unsigned long	radiationLatency;
 	PsmAddress	elt2;
 	IonCXref	*contact;
@@ -1191,17 +2888,14 @@ printf("In identifyProximateNodes for node " UVAST_FIELDSPEC ", deadline %u.\n",
 stationNode->nodeNbr, deadline);
 #endif
 	currentTime = getUTCTime();
-	routes = stationNode->routingObject;
-	if (routes == 0)
+	if (prepareRouteList(stationNode, currentTime) < 0)
 	{
-		if ((routes = loadRouteList(stationNode, currentTime)) == 0)
-		{
-			putErrmsg("Can't load routes for node.",
-					utoa(stationNode->nodeNbr));
-			return -1;
-		}
+		putErrmsg("Can't prepare routes for node.",
+				utoa(stationNode->nodeNbr));
+		return -1;
 	}
 
+	routes = stationNode->routingObject;
 	for (elt = sm_list_first(ionwm, routes); elt; elt = nextElt)
 	{
 		nextElt = sm_list_next(ionwm, elt);
@@ -1212,45 +2906,6 @@ printf("Checking class-%d route via node " UVAST_FIELDSPEC
 ": start @ %lu, deliver @ %lu.\n", route->payloadClass, route->toNodeNbr,
 route->fromTime, route->deliveryTime);
 #endif
-		if (route->toTime < currentTime)
-		{
-			/*	This route leads off with a contact
-			 *	that has already ended; delete it.	*/
-
-			contactToNodeNbr = route->toNodeNbr;
-			contactFromTime = route->fromTime;
-			payloadClass = route->payloadClass;
-			if (route->hops)
-			{
-				sm_list_destroy(ionwm, route->hops, NULL, NULL);
-			}
-
-			psm_free(ionwm, addr);
-			sm_list_delete(ionwm, elt, NULL, NULL);
-			switch (recomputeRouteForContact(contactToNodeNbr,
-					contactFromTime, stationNode,
-					currentTime, payloadClass))
-			{
-			case -1:
-				putErrmsg("Route recomputation failed.", NULL);
-				return -1;
-
-			case 0:
-				break;	/*	Lead contact defunct.	*/
-
-			default:
-				/*	Route through this lead contact
-				 *	has been recomputed and inserted
-				 *	into the list of routes.  Must
-				 *	start again from the beginning
-				 *	of the list.			*/
-
-				nextElt = sm_list_first(ionwm, routes);
-			}
-
-			continue;
-		}
-
 		if (route->deliveryTime > deadline)
 		{
 			/*	No more plausible routes.		*/
@@ -1511,13 +3166,10 @@ int	cgr_forward(Bundle *bundle, Object bundleObj, uvast stationNodeNbr,
 printf("\n\n\nCGR looking for a route to node " UVAST_FIELDSPEC " for bundle \
 of length %u.\n", stationNodeNbr, bundle->payload.length);
 #endif
-	if (ionvdb->lastEditTime > cgrvdb->lastLoadTime)
+	if (applyContactPlanChanges(ionvdb, cgrvdb, getUTCTime()) < 0)
 	{
-		/*	Contact plan has been modified, so must discard
-		 *	all route lists and reconstruct them as needed.	*/
-
-		discardRouteLists(cgrvdb);
-		cgrvdb->lastLoadTime = getUTCTime();
+		putErrmsg("Can't apply contact plan changes.", NULL);
+		return -1;
 	}
 
 	stationNode = findNode(ionvdb, stationNodeNbr, &nextNode);
@@ -1725,6 +3377,104 @@ printf("CGR found no route.\n");
 	return 0;
 }
 
+int	cgr_precompute()
+{
+	Sdr		sdr = getIonsdr();
+	PsmPartition	ionwm = getIonwm();
+	IonVdb		*ionvdb = getIonVdb();
+	CgrVdb		*cgrvdb = _cgrvdb(NULL);
+	uvast		ownNodeNbr = getOwnNodeNbr();
+	uvast		nodeNbr = 0;
+	time_t		currentTime;
+	PsmAddress	nextElt;
+	IonNode		*stationNode;
+	IonNode		*newLists[CGR_PRECOMPUTE_BATCH];
+	int		newListsCount;
+	int		nodesCount;
+	int		done = 0;
+
+	CHKERR(cgrvdb);
+
+	/*	Bring the route lists for all known nodes up to date,
+	 *	so that cgr_forward need only select among routes.
+	 *	Each batch of nodes is prepared in a separate
+	 *	transaction, so that forwarding is never blocked for
+	 *	longer than the preparation of a few route lists;
+	 *	since cgr_forward consults routes only within a
+	 *	transaction, it never sees a partially prepared list.
+	 *	Nodes are located by number in each transaction, as
+	 *	the node tree may change between transactions.		*/
+
+	while (1)
+	{
+		CHKERR(sdr_begin_xn(sdr));	/*	To lock memory.	*/
+		currentTime = getUTCTime();
+		if (applyContactPlanChanges(ionvdb, cgrvdb, currentTime) < 0)
+		{
+			sdr_exit_xn(sdr);
+			putErrmsg("Can't apply contact plan changes.", NULL);
+			return -1;
+		}
+
+		newListsCount = 0;
+		nodesCount = 0;
+		while (nodesCount < CGR_PRECOMPUTE_BATCH)
+		{
+			stationNode = findNode(ionvdb, nodeNbr + 1, &nextElt);
+			if (stationNode == NULL)
+			{
+				if (nextElt == 0)
+				{
+					done = 1;
+					break;
+				}
+
+				stationNode = (IonNode *) psp(ionwm,
+						sm_rbt_data(ionwm, nextElt));
+			}
+
+			nodeNbr = stationNode->nodeNbr;
+			if (nodeNbr == ownNodeNbr)
+			{
+				continue;
+			}
+
+			nodesCount++;
+			if (stationNode->routingObject == 0)
+			{
+				/*	Compute all new route lists in
+				 *	the batch at once, in parallel.	*/
+
+				newLists[newListsCount] = stationNode;
+				newListsCount++;
+				continue;
+			}
+
+			if (prepareRouteList(stationNode, currentTime) < 0)
+			{
+				sdr_exit_xn(sdr);
+				putErrmsg("Can't precompute routes for node.",
+						utoa(nodeNbr));
+				return -1;
+			}
+		}
+
+		if (newListsCount > 0
+		&& loadRouteLists(newLists, newListsCount, currentTime) < 0)
+		{
+			sdr_exit_xn(sdr);
+			putErrmsg("Can't precompute routes.", NULL);
+			return -1;
+		}
+
+		sdr_exit_xn(sdr);
+		if (done)
+		{
+			return 0;
+		}
+	}
+}
+
 void	cgr_start()
 {
 	char	*name = "cgrvdb";
@@ -1743,6 +3493,8 @@ void	cgr_stop()
 
 	/*Clear Route Caches*/
 	clearRoutingObjects(wm);
+	oK(_cgrpool(1));
+	oK(_cgrgraph(NULL));
 
 	/*Free volatile database*/
 	if (psm_locate(wm, name, &vdbAddress, &elt) < 0)
@@ -1755,6 +3507,8 @@ void	cgr_stop()
 	{
 		vdb = (CgrVdb *) psp(wm, vdbAddress);
 		sm_list_destroy(wm, vdb->routeLists, NULL, NULL);
+		sm_rbt_destroy(wm, vdb->citations, NULL, NULL);
+		sm_list_destroy(wm, vdb->revisedLists, NULL, NULL);
 		psm_free(wm, vdbAddress);
 		if (psm_uncatlg(wm, name) < 0)
 		{
@@ -38,6 +38,39 @@ static void	shutDown()	/*	Commands forwarder termination.	*/
 	sm_SemEnd(_ipnfwSemaphore(NULL));
 }
 
+typedef struct
+{
+	int		interval;	/*	Seconds between passes.	*/
+	volatile int	running;	/*	Boolean.		*/
+} PrecomputeParms;
+
+static void	*precomputeRoutes(void *parm)
+{
+	PrecomputeParms	*parms = (PrecomputeParms *) parm;
+	int		i;
+
+	/*	Periodically bring the computed routes to all nodes
+	 *	up to date, so that route computation is rarely
+	 *	deferred until a bundle must be forwarded.		*/
+
+	while (parms->running)
+	{
+		if (cgr_precompute() < 0)
+		{
+			putErrmsg("ipnfw can't precompute routes.", NULL);
+			break;
+		}
+
+		for (i = 0; i < parms->interval && parms->running; i++)
+		{
+			snooze(1);
+		}
+	}
+
+	writeErrmsgMemos();
+	return NULL;
+}
+
 static int	getDirective(uvast nodeNbr, Object plans, Bundle *bundle,
 			FwdDirective *directive)
 {
@@ -272,11 +305,15 @@ static int	enqueueBundle(Bundle *bundle, Object bundleObj)
 int	ipnfw(int a1, int a2, int a3, int a4, int a5,
 		int a6, int a7, int a8, int a9, int a10)
 {
+	int		interval = a1;
 #else
 int	main(int argc, char *argv[])
 {
+	int		interval = (argc > 1 ? atoi(argv[1]) : 0);
 #endif
 	int		running = 1;
+	PrecomputeParms	parms;
+	pthread_t	precomputeThread;
 	Sdr		sdr;
 	VScheme		*vscheme;
 	PsmAddress	vschemeElt;
@@ -313,6 +350,24 @@ int	main(int argc, char *argv[])
 	oK(_ipnfwSemaphore(&vscheme->semaphore));
 	isignal(SIGTERM, shutDown);
 
+	/*	Optionally start the route precomputation thread.	*/
+
+	parms.interval = interval;
+	parms.running = 0;
+	if (interval > 0)
+	{
+		parms.running = 1;
+		if (pthread_begin(&precomputeThread, NULL, precomputeRoutes,
+				&parms))
+		{
+			putSysErrmsg("ipnfw can't create precompute thread",
+					NULL);
+			writeErrmsgMemos();
+			ionDetach();
+			return 1;
+		}
+	}
+
 	/*	Main loop: wait until forwarding queue is non-empty,
 	 *	then drain it.						*/
 
@@ -368,6 +423,12 @@ int	main(int argc, char *argv[])
 		sm_TaskYield();
 	}
 
+	if (parms.running)
+	{
+		parms.running = 0;
+		pthread_join(precomputeThread, NULL);
+	}
+
 	writeErrmsgMemos();
 	writeMemo("[i] ipnfw forwarder has ended.");
 	ionDetach();
@@ -753,6 +753,11 @@ typedef struct
 	int		zcoBytesReceived;
 	int		bytesBuffered;
 	char		buffer[BP_MAX_BLOCK_SIZE];
+
+	/*	Acquisition batch state variables.			*/
+
+	int		batching;	/*	Boolean.		*/
+	int		batchRecvBytes;	/*	Awaiting rate control.	*/
 } AcqWorkArea;
 
 /*	Definitions supporting route computation.			*/
@@ -1220,6 +1225,51 @@ extern int		bpEndAcq(	AcqWorkArea *workArea);
 			 *	cycle of bundle acquisition just as
 			 *	if the return code had been 1.		*/
 
+extern int		bpBeginAcqBatch(AcqWorkArea *workArea);
+			/*	This function is invoked by a
+			 *	convergence-layer input adapter
+			 *	to initiate acquisition of a batch
+			 *	of bundles via the indicated
+			 *	workArea, all within a single SDR
+			 *	transaction.  The adapter then
+			 *	acquires each bundle of the batch
+			 *	in the usual way (bpBeginAcq, then
+			 *	bpLoadAcq or bpContinueAcq, then
+			 *	bpEndAcq) and concludes the batch
+			 *	by calling bpEndAcqBatch(); on any
+			 *	failure it must instead call
+			 *	bpCancelAcqBatch().  Reception
+			 *	rate control is applied to the
+			 *	batch as a whole, after the
+			 *	transaction has ended.
+			 *
+			 *	Returns 0 on success, -1 on any
+			 *	failure.				*/
+
+extern int		bpEndAcqBatch(AcqWorkArea *workArea);
+			/*	Concludes acquisition of a batch of
+			 *	bundles via the indicated workArea,
+			 *	ending the batch's transaction and
+			 *	then blocking until reception rate
+			 *	control permits acquisition of
+			 *	more bundles.
+			 *
+			 *	Returns 0 on success, -1 on any
+			 *	failure.				*/
+
+extern void		bpCancelAcqBatch(AcqWorkArea *workArea);
+			/*	Cancels acquisition of a batch of
+			 *	bundles via the indicated workArea,
+			 *	canceling the batch's transaction so
+			 *	that none of the bundles of the
+			 *	batch is acquired.			*/
+
+extern int		bpMaxAcqInHeap();
+			/*	Returns the length of the longest
+			 *	acquisition that bpContinueAcq()
+			 *	acquires into the SDR heap rather
+			 *	than into a file.			*/
+
 extern int		bpDestroyBundle(Object bundleToDestroy,
 					int expired);
 			/*	bpDestroyBundle destroys the bundle,
@@ -19,12 +19,38 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+
+/*	Route computed by CGR.  Exposed so that utilities such as
+ *	cgrbench can examine the routes that have been computed.	*/
+
+typedef struct
+{
+	/*	Contact that forms the initial hop of the route.	*/
+
+	uvast		toNodeNbr;	/*	Initial-hop neighbor.	*/
+	time_t		fromTime;	/*	As from time(2).	*/
+	time_t		toTime;		/*	As from time(2).	*/
+
+	/*	Details of the route.					*/
+
+	time_t		deliveryTime;	/*	As from time(2).	*/
+	PsmAddress	hops;		/*	SM list: IonCXref addr	*/
+	uvast		maxCapacity;
+	int		payloadClass;
+
+	/*	Details of the route's place in the CGR database.	*/
+
+	PsmAddress	routeElt;	/*	In IonNode's list.	*/
+	PsmAddress	citations;	/*	SM list: elt in routes	*/
+} CgrRoute;		/*	IonNode routingObject is list of these.	*/
+
 typedef int		(*CgrLookupFn)(uvast nodeNbr, Object plans,
 				Bundle *bundle, FwdDirective *directive);
 extern void		cgr_start();
 extern int		cgr_forward(Bundle *bundle, Object bundleObj,
 				uvast stationNodeNbr, Object plans,
 				CgrLookupFn callback);
+extern int		cgr_precompute();
 extern void		cgr_stop();
 #ifdef __cplusplus
 }
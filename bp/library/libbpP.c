@@ -6548,13 +6548,40 @@ int	bpLoadAcq(AcqWorkArea *work, Object zco)
 	return 0;
 }
 
+int	bpMaxAcqInHeap()
+{
+	static int	maxAcqInHeap = 0;
+	Sdr		sdr = getIonsdr();
+	BpDB		bpdb;
+
+	if (maxAcqInHeap == 0)
+	{
+		/*	Initialize threshold for acquiring bundle
+		 *	into a file rather than directly into the
+		 *	heap.  Minimum threshold is the amount of
+		 *	heap space that would be occupied by a ZCO
+		 *	file reference object anyway, even if the
+		 *	bundle were entirely acquired into a file.	*/
+
+		CHKERR(sdr_begin_xn(sdr));	/*	Just to lock.	*/
+		sdr_read(sdr, (char *) &bpdb, getBpDbObject(), sizeof(BpDB));
+		sdr_exit_xn(sdr);
+		maxAcqInHeap = 560;
+		if (bpdb.maxAcqInHeap > maxAcqInHeap)
+		{
+			maxAcqInHeap = bpdb.maxAcqInHeap;
+		}
+	}
+
+	return maxAcqInHeap;
+}
+
 int	bpContinueAcq(AcqWorkArea *work, char *bytes, int length)
 {
 	static unsigned int	acqCount = 0;
-	static int		maxAcqInHeap = 0;
+	int			maxAcqInHeap;
 	Sdr			sdr = getIonsdr();
 	BpDB			*bpConstants = _bpConstants();
-	BpDB			bpdb;
 	Object			extentObj;
 	char			cwd[200];
 	char			fileName[SDRSTRING_BUFSZ];
@@ -6569,24 +6596,9 @@ int	bpContinueAcq(AcqWorkArea *work, char *bytes, int length)
 		return 0;	/*	No ZCO space; append no more.	*/
 	}
 
+	maxAcqInHeap = bpMaxAcqInHeap();
+	CHKERR(maxAcqInHeap > 0);
 	CHKERR(sdr_begin_xn(sdr));
-	if (maxAcqInHeap == 0)
-	{
-		/*	Initialize threshold for acquiring bundle
-		 *	into a file rather than directly into the
-		 *	heap.  Minimum threshold is the amount of
-		 *	heap space that would be occupied by a ZCO
-		 *	file reference object anyway, even if the
-		 *	bundle were entirely acquired into a file.	*/
-
-		maxAcqInHeap = 560;
-		sdr_read(sdr, (char *) &bpdb, getBpDbObject(), sizeof(BpDB));
-		if (bpdb.maxAcqInHeap > maxAcqInHeap)
-		{
-			maxAcqInHeap = bpdb.maxAcqInHeap;
-		}
-	}
-
 	if (work->zco == 0)	/*	First extent of acquisition.	*/
 	{
 		work->zco = zco_create(sdr, ZcoSdrSource, 0, 0, 0);
@@ -6763,28 +6775,10 @@ int	computeECCC(int bundleSize, ClProtocol *protocol)
 	return bundleSize + (protocol->overheadPerFrame * framesNeeded);
 }
 
-static int	applyRecvRateControl(AcqWorkArea *work)
+static int	takeRecvCapacity(Sdr bpSdr, Throttle *throttle, int recvLength)
 {
-	Sdr		bpSdr = getIonsdr();
-	Bundle		*bundle = &(work->bundle);
-			OBJ_POINTER(Induct, induct);
-			OBJ_POINTER(ClProtocol, protocol);
-	Throttle	*throttle;
-	int		recvLength;
-
-	CHKERR(sdr_begin_xn(bpSdr));	/*	Just to lock memory.	*/
-	GET_OBJ_POINTER(bpSdr, Induct, induct, sdr_list_data(bpSdr,
-			work->vduct->inductElt));
-	throttle = &(work->vduct->acqThrottle);
-	if (throttle->nominalRate < 0)	/*	No rate control.	*/
-	{
-		sdr_exit_xn(bpSdr);
-		return 0;
-	}
+	/*	Must be called within a transaction, which it exits.	*/
 
-	GET_OBJ_POINTER(bpSdr, ClProtocol, protocol, induct->protocol);
-	recvLength = computeECCC(bundle->payload.length
-			+ NOMINAL_PRIMARY_BLKSIZE, protocol);
 	while (throttle->capacity <= 0)
 	{
 		sdr_exit_xn(bpSdr);
@@ -6813,6 +6807,44 @@ static int	applyRecvRateControl(AcqWorkArea *work)
 	return 0;
 }
 
+static int	applyRecvRateControl(AcqWorkArea *work)
+{
+	Sdr		bpSdr = getIonsdr();
+	Bundle		*bundle = &(work->bundle);
+			OBJ_POINTER(Induct, induct);
+			OBJ_POINTER(ClProtocol, protocol);
+	Throttle	*throttle;
+	int		recvLength;
+
+	CHKERR(sdr_begin_xn(bpSdr));	/*	Just to lock memory.	*/
+	GET_OBJ_POINTER(bpSdr, Induct, induct, sdr_list_data(bpSdr,
+			work->vduct->inductElt));
+	throttle = &(work->vduct->acqThrottle);
+	if (throttle->nominalRate < 0)	/*	No rate control.	*/
+	{
+		sdr_exit_xn(bpSdr);
+		return 0;
+	}
+
+	GET_OBJ_POINTER(bpSdr, ClProtocol, protocol, induct->protocol);
+	recvLength = computeECCC(bundle->payload.length
+			+ NOMINAL_PRIMARY_BLKSIZE, protocol);
+	if (work->batching)
+	{
+		/*	Can't wait for reception capacity while the
+		 *	batch's transaction is in progress, because
+		 *	bpclock can't replenish it until the batch
+		 *	is ended.  The capacity consumed by the whole
+		 *	batch is taken by bpEndAcqBatch instead.	*/
+
+		work->batchRecvBytes += recvLength;
+		sdr_exit_xn(bpSdr);
+		return 0;
+	}
+
+	return takeRecvCapacity(bpSdr, throttle, recvLength);
+}
+
 static int	advanceWorkBuffer(AcqWorkArea *work, int bytesParsed)
 {
 	int	bytesRemaining = work->zcoLength - work->zcoBytesReceived;
@@ -8011,6 +8043,55 @@ int	bpEndAcq(AcqWorkArea *work)
 	return eraseWorkZco(work);
 }
 
+int	bpBeginAcqBatch(AcqWorkArea *work)
+{
+	CHKERR(work);
+	CHKERR(work->batching == 0);
+	CHKERR(sdr_begin_xn(getIonsdr()));
+	work->batching = 1;
+	work->batchRecvBytes = 0;
+	return 0;
+}
+
+int	bpEndAcqBatch(AcqWorkArea *work)
+{
+	Sdr	bpSdr = getIonsdr();
+	int	recvLength;
+
+	CHKERR(work);
+	CHKERR(work->batching);
+	recvLength = work->batchRecvBytes;
+	work->batching = 0;
+	work->batchRecvBytes = 0;
+	if (sdr_end_xn(bpSdr) < 0)
+	{
+		putErrmsg("Can't acquire bundle batch.", NULL);
+		return -1;
+	}
+
+	/*	Now that the batch's transaction has ended, apply
+	 *	reception rate control to the batch as a whole.	*/
+
+	if (recvLength == 0)
+	{
+		return 0;	/*	No rate control.		*/
+	}
+
+	CHKERR(sdr_begin_xn(bpSdr));	/*	Just to lock memory.	*/
+	return takeRecvCapacity(bpSdr, &(work->vduct->acqThrottle),
+			recvLength);
+}
+
+void	bpCancelAcqBatch(AcqWorkArea *work)
+{
+	CHKVOID(work);
+	CHKVOID(work->batching);
+	bpCancelAcq(work);
+	work->batching = 0;
+	work->batchRecvBytes = 0;
+	sdr_cancel_xn(getIonsdr());
+}
+
 /*	*	*	Administrative payload functions	*	*/
 
 static int	constructCtSignal(BpCtSignal *csig, Object *zco)
@@ -0,0 +1,650 @@
+/*
+	libshmcla.c:	common functions for shared-memory convergence
+			layer adapter modules.
+
+									*/
+#include "shmcla.h"
+
+#ifdef SHMCLA_SUPPORTED
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/*	*	*	Ring signaling functions	*	*	*/
+
+static void	futexWait(int *word, int value)
+{
+	struct timespec	timeout;
+
+	/*	Returns when *word is no longer value, on any signal,
+	 *	or after SHMCLA_RETRY_INTERVAL seconds at most.		*/
+
+	timeout.tv_sec = SHMCLA_RETRY_INTERVAL;
+	timeout.tv_nsec = 0;
+	oK(syscall(SYS_futex, word, FUTEX_WAIT, value, &timeout, NULL, 0));
+}
+
+static void	futexWake(int *word)
+{
+	oK(syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0));
+}
+
+static void	signalWaiter(int *word, int *waiting)
+{
+	__sync_synchronize();
+	oK(__sync_fetch_and_add(word, 1));
+	if (*waiting)
+	{
+		futexWake(word);
+	}
+}
+
+typedef struct
+{
+	int	beat;
+	time_t	lastChange;
+} PeerWatch;
+
+static void	startWatch(PeerWatch *watch, int beat)
+{
+	watch->beat = beat;
+	watch->lastChange = getUTCTime();
+}
+
+static int	peerIsDead(PeerWatch *watch, int beat)
+{
+	time_t	currentTime = getUTCTime();
+
+	if (beat != watch->beat)
+	{
+		watch->beat = beat;
+		watch->lastChange = currentTime;
+		return 0;
+	}
+
+	return (currentTime - watch->lastChange > SHMCLA_PEER_TIMEOUT);
+}
+
+/*	*	*	Ring management functions	*	*	*/
+
+static int	mapRing(char *ductName, int create, ShmRing *ring)
+{
+	int		fd;
+	struct stat	stats;
+
+	if (strlen(ductName) > SHMCLA_NAME_LEN || strchr(ductName, '/'))
+	{
+		putErrmsg("Invalid shm duct name.", ductName);
+		return -1;
+	}
+
+	memset((char *) ring, 0, sizeof(ShmRing));
+	isprintf(ring->objName, sizeof ring->objName, "/ion.shmcla.%s",
+			ductName);
+	if (create)
+	{
+		/*	Only the node's own user (and group) may
+		 *	write into the ring.  A ring left behind by
+		 *	a shmcli that crashed keeps the mode it was
+		 *	created with, so the mode is imposed again;
+		 *	this fails if the ring isn't ours.		*/
+
+		fd = shm_open(ring->objName, O_RDWR | O_CREAT, 0660);
+		if (fd < 0)
+		{
+			putSysErrmsg("Can't create shared memory ring",
+					ring->objName);
+			return -1;
+		}
+
+		if (fchmod(fd, 0660) < 0)
+		{
+			close(fd);
+			putSysErrmsg("Can't restrict shared memory ring",
+					ring->objName);
+			return -1;
+		}
+
+		ring->mapLength = SHMCLA_HDR_SPACE + SHMCLA_RING_SIZE;
+		if (ftruncate(fd, ring->mapLength) < 0)
+		{
+			close(fd);
+			putSysErrmsg("Can't size shared memory ring",
+					ring->objName);
+			return -1;
+		}
+	}
+	else
+	{
+		fd = shm_open(ring->objName, O_RDWR, 0);
+		if (fd < 0)
+		{
+			if (errno == ENOENT)	/*	No CLI yet.	*/
+			{
+				return 0;
+			}
+
+			putSysErrmsg("Can't open shared memory ring",
+					ring->objName);
+			return -1;
+		}
+
+		if (fstat(fd, &stats) < 0)
+		{
+			close(fd);
+			putSysErrmsg("Can't stat shared memory ring",
+					ring->objName);
+			return -1;
+		}
+
+		if (stats.st_size <= SHMCLA_HDR_SPACE)
+		{
+			close(fd);	/*	Not yet initialized.	*/
+			return 0;
+		}
+
+		ring->mapLength = stats.st_size;
+	}
+
+	ring->header = (ShmRingHeader *) mmap(NULL, ring->mapLength,
+			PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ring->header == (ShmRingHeader *) MAP_FAILED)
+	{
+		ring->header = NULL;
+		putSysErrmsg("Can't map shared memory ring", ring->objName);
+		return -1;
+	}
+
+	ring->data = ((char *) (ring->header)) + SHMCLA_HDR_SPACE;
+	return 1;
+}
+
+int	shmRingCreate(char *ductName, ShmRing *ring)
+{
+	ShmRingHeader	*header;
+
+	CHKERR(ductName && ring);
+	if (mapRing(ductName, 1, ring) < 0)
+	{
+		return -1;
+	}
+
+	/*	A ring left behind by a shmcli that crashed may still
+	 *	contain bundles, which are acquired as usual.		*/
+
+	header = ring->header;
+	if (header->magic != SHMCLA_MAGIC
+	|| header->ringSize != SHMCLA_RING_SIZE)
+	{
+		memset((char *) header, 0, sizeof(ShmRingHeader));
+		header->ringSize = SHMCLA_RING_SIZE;
+		header->magic = SHMCLA_MAGIC;
+	}
+
+	header->consumerWaiting = 0;
+	__sync_synchronize();
+	header->consumerRunning = 1;
+	return 0;
+}
+
+void	shmRingDestroy(ShmRing *ring)
+{
+	CHKVOID(ring);
+	if (ring->header == NULL)
+	{
+		return;
+	}
+
+	ring->header->consumerRunning = 0;
+	futexWake(&(ring->header->spaceSignal));
+	oK(shm_unlink(ring->objName));
+	shmRingDetach(ring);
+}
+
+int	shmRingAttach(char *ductName, ShmRing *ring)
+{
+	ShmRingHeader	*header;
+
+	CHKERR(ductName && ring);
+	switch (mapRing(ductName, 0, ring))
+	{
+	case -1:
+		return -1;
+
+	case 0:
+		return 0;
+
+	default:
+		break;
+	}
+
+	header = ring->header;
+	if (header->magic != SHMCLA_MAGIC || header->consumerRunning == 0
+	|| ring->mapLength != SHMCLA_HDR_SPACE + header->ringSize)
+	{
+		shmRingDetach(ring);	/*	CLI not yet running.	*/
+		return 0;
+	}
+
+	return 1;
+}
+
+void	shmRingDetach(ShmRing *ring)
+{
+	CHKVOID(ring);
+	if (ring->header)
+	{
+		oK(munmap((char *) (ring->header), ring->mapLength));
+		ring->header = NULL;
+		ring->data = NULL;
+	}
+}
+
+void	shmRingWake(ShmRing *ring)
+{
+	CHKVOID(ring);
+	if (ring->header)
+	{
+		oK(__sync_fetch_and_add(&(ring->header->dataSignal), 1));
+		futexWake(&(ring->header->dataSignal));
+	}
+}
+
+/*	*	*	Producer functions	*	*	*	*/
+
+static int	lockRing(ShmRingHeader *header)
+{
+	int		self = getpid();
+	int		*lock = &(header->producerLock);
+	int		holder;
+	PeerWatch	watch;
+
+	/*	Returns 1 when the ring is locked by this shmclo, 0 if
+	 *	the ring's consumer has stopped.  A lock whose holder
+	 *	hasn't shown a heartbeat for SHMCLA_PEER_TIMEOUT
+	 *	seconds was abandoned by a shmclo that died.		*/
+
+	startWatch(&watch, header->producerBeat);
+	while (1)
+	{
+		if (header->consumerRunning == 0)
+		{
+			return 0;
+		}
+
+		holder = *lock;
+		if (holder == 0)
+		{
+			if (__sync_bool_compare_and_swap(lock, 0, self))
+			{
+				break;
+			}
+
+			continue;
+		}
+
+		if (peerIsDead(&watch, header->producerBeat))
+		{
+			if (__sync_bool_compare_and_swap(lock, holder, self))
+			{
+				writeMemoNote("[?] Took over abandoned shm \
+ring lock from shmclo", itoa(holder));
+				break;
+			}
+
+			continue;
+		}
+
+		futexWait(lock, holder);
+	}
+
+	header->producerBeat++;
+	return 1;
+}
+
+static void	unlockRing(ShmRingHeader *header)
+{
+	header->producerBeat++;
+	__sync_synchronize();
+	header->producerLock = 0;
+	futexWake(&(header->producerLock));
+}
+
+static int	awaitSpace(ShmRingHeader *header, unsigned int length)
+{
+	PeerWatch	watch;
+	int		signalCount;
+
+	/*	Returns 1 when there are at least length bytes of
+	 *	space in the ring, 0 if the consumer has stopped.	*/
+
+	startWatch(&watch, header->consumerBeat);
+	while (1)
+	{
+		signalCount = header->spaceSignal;
+		header->producerWaiting = 1;
+		__sync_synchronize();
+		if (header->ringSize - (header->head - header->tail) >= length)
+		{
+			header->producerWaiting = 0;
+			__sync_synchronize();
+			return 1;
+		}
+
+		if (header->consumerRunning == 0
+		|| peerIsDead(&watch, header->consumerBeat))
+		{
+			header->producerWaiting = 0;
+			return 0;
+		}
+
+		futexWait(&(header->spaceSignal), signalCount);
+		header->producerBeat++;
+	}
+}
+
+static int	reserveRecord(ShmRing *ring, unsigned int length,
+			ShmRecord **record)
+{
+	ShmRingHeader	*header = ring->header;
+	unsigned int	offset = header->head & (header->ringSize - 1);
+	unsigned int	room = header->ringSize - offset;
+	ShmRecord	*pad;
+
+	/*	Returns 1 when the record has been reserved at the
+	 *	head of the ring, 0 if the consumer has stopped.	*/
+
+	if (room < length)
+	{
+		/*	Record would wrap around the end of the ring;
+		 *	pad out the end of the ring instead.		*/
+
+		if (awaitSpace(header, room) == 0)
+		{
+			return 0;
+		}
+
+		pad = (ShmRecord *) (ring->data + offset);
+		pad->length = room - sizeof(ShmRecord);
+		pad->flags = SHMCLA_PAD;
+		__sync_synchronize();
+		header->head += room;
+		offset = 0;
+	}
+
+	if (awaitSpace(header, length) == 0)
+	{
+		return 0;
+	}
+
+	*record = (ShmRecord *) (ring->data + offset);
+	return 1;
+}
+
+static int	writeBundle(ShmRing *ring, unsigned int bundleLength,
+			Object bundleZco)
+{
+	Sdr		sdr = getIonsdr();
+	ShmRingHeader	*header = ring->header;
+	ZcoReader	reader;
+	unsigned int	flags = SHMCLA_FIRST;
+	unsigned int	bytesRemaining = bundleLength;
+	unsigned int	chunkLength;
+	unsigned int	recordLength;
+	ShmRecord	*record;
+	int		bytesCopied;
+
+	/*	Copies the bundle from its ZCO straight into records
+	 *	in the ring.  Returns 1 on success, 0 if the consumer
+	 *	has stopped, -1 on any system error.			*/
+
+	zco_start_transmitting(bundleZco, &reader);
+	zco_track_file_offset(&reader);
+	while (bytesRemaining > 0)
+	{
+		chunkLength = bytesRemaining;
+		if (chunkLength > SHMCLA_CHUNK_MAX)
+		{
+			chunkLength = SHMCLA_CHUNK_MAX;
+		}
+
+		recordLength = SHMCLA_ALIGN(sizeof(ShmRecord) + chunkLength);
+		if (reserveRecord(ring, recordLength, &record) == 0)
+		{
+			return 0;
+		}
+
+		CHKERR(sdr_begin_xn(sdr));
+		bytesCopied = zco_transmit(sdr, &reader, chunkLength,
+				(char *) (record + 1));
+		if (sdr_end_xn(sdr) < 0 || bytesCopied != chunkLength)
+		{
+			putErrmsg("Can't issue from ZCO.", NULL);
+			return -1;
+		}
+
+		bytesRemaining -= chunkLength;
+		if (bytesRemaining == 0)
+		{
+			flags |= SHMCLA_LAST;
+		}
+
+		record->length = chunkLength;
+		record->flags = flags;
+		flags = 0;
+		__sync_synchronize();
+		header->head += recordLength;
+		header->producerBeat++;
+		signalWaiter(&(header->dataSignal), &(header->consumerWaiting));
+	}
+
+	return 1;
+}
+
+int	sendBundleByShm(ShmRing *ring, unsigned int bundleLength,
+		Object bundleZco)
+{
+	Sdr	sdr = getIonsdr();
+	int	result = 0;
+
+	CHKERR(ring && ring->header);
+	if (lockRing(ring->header))
+	{
+		result = writeBundle(ring, bundleLength, bundleZco);
+		unlockRing(ring->header);
+		if (result < 0)
+		{
+			putErrmsg("Failed to send by shm.", NULL);
+			return -1;
+		}
+	}
+
+	if (result == 0)
+	{
+		/*	Consumer has stopped; treat as a transient
+		 *	anomaly, note the incomplete transmission.	*/
+
+		writeMemoNote("[?] Lost shm ring consumer; bundle not sent",
+				ring->objName);
+		shmRingDetach(ring);
+		if (bpHandleXmitFailure(bundleZco) < 0)
+		{
+			putErrmsg("Can't handle shm xmit failure.", NULL);
+			return -1;
+		}
+	}
+	else
+	{
+		if (bpHandleXmitSuccess(bundleZco, 0) < 0)
+		{
+			putErrmsg("Can't handle xmit success.", NULL);
+			return -1;
+		}
+	}
+
+	CHKERR(sdr_begin_xn(sdr));
+	zco_destroy(sdr, bundleZco);
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't destroy bundle ZCO.", NULL);
+		return -1;
+	}
+
+	return result;
+}
+
+/*	*	*	Consumer functions	*	*	*	*/
+
+static ShmRecord	*awaitRecord(ShmRing *ring, int *running)
+{
+	ShmRingHeader	*header = ring->header;
+	int		signalCount;
+
+	/*	Returns the record at the tail of the ring, or NULL
+	 *	if *running was cleared while waiting.  The ring's
+	 *	size is taken from the mapping rather than from the
+	 *	shared header, which any producer can write.		*/
+
+	while (1)
+	{
+		signalCount = header->dataSignal;
+		header->consumerWaiting = 1;
+		__sync_synchronize();
+		if (header->head != header->tail)
+		{
+			header->consumerWaiting = 0;
+			__sync_synchronize();
+			return (ShmRecord *) (ring->data
+				+ (header->tail & (SHMCLA_RING_SIZE - 1)));
+		}
+
+		if (*running == 0)
+		{
+			header->consumerWaiting = 0;
+			return NULL;
+		}
+
+		futexWait(&(header->dataSignal), signalCount);
+		header->consumerBeat++;
+	}
+}
+
+static void	consumeRecord(ShmRing *ring, unsigned int length)
+{
+	ShmRingHeader	*header = ring->header;
+
+	header->tail += SHMCLA_ALIGN(sizeof(ShmRecord) + length);
+	header->consumerBeat++;
+	signalWaiter(&(header->spaceSignal), &(header->producerWaiting));
+}
+
+static void	discardRing(ShmRing *ring)
+{
+	ShmRingHeader	*header = ring->header;
+
+	header->tail = header->head;
+	header->consumerBeat++;
+	signalWaiter(&(header->spaceSignal), &(header->producerWaiting));
+}
+
+int	receiveBundleByShm(ShmRing *ring, AcqWorkArea *work, int *running)
+{
+	ShmRecord	*record;
+	unsigned int	length;
+	unsigned int	offset;
+	int		acquiring = 0;
+
+	CHKERR(ring && ring->header && work && running);
+	while (1)
+	{
+		record = awaitRecord(ring, running);
+		if (record == NULL)
+		{
+			if (acquiring)
+			{
+				bpCancelAcq(work);
+			}
+
+			return 0;
+		}
+
+		/*	The record's length is read just once, and a
+		 *	record that would extend past the end of the
+		 *	ring is corrupt: the ring is stale or has been
+		 *	written by something other than shmclo.  All
+		 *	of its content is discarded.			*/
+
+		length = record->length;
+		offset = (char *) record - ring->data;
+		if (length > SHMCLA_RING_SIZE - offset - sizeof(ShmRecord))
+		{
+			writeMemoNote("[?] shmcli discarding corrupt ring \
+record; length", utoa(length));
+			if (acquiring)
+			{
+				bpCancelAcq(work);
+				acquiring = 0;
+			}
+
+			discardRing(ring);
+			continue;
+		}
+
+		if (record->flags & SHMCLA_PAD)
+		{
+			consumeRecord(ring, length);
+			continue;
+		}
+
+		if (record->flags & SHMCLA_FIRST)
+		{
+			/*	Any bundle in progress was abandoned
+			 *	by a shmclo that died.			*/
+
+			if (acquiring)
+			{
+				bpCancelAcq(work);
+			}
+
+			if (bpBeginAcq(work, 0, NULL) < 0)
+			{
+				putErrmsg("Can't begin acquisition of bundle.",
+						NULL);
+				return -1;
+			}
+
+			acquiring = 1;
+		}
+
+		if (!acquiring)	/*	Remnant of abandoned bundle.	*/
+		{
+			consumeRecord(ring, length);
+			continue;
+		}
+
+		if (bpContinueAcq(work, (char *) (record + 1), length) < 0)
+		{
+			putErrmsg("Can't continue bundle acquisition.", NULL);
+			return -1;
+		}
+
+		if (record->flags & SHMCLA_LAST)
+		{
+			consumeRecord(ring, length);
+			if (bpEndAcq(work) < 0)
+			{
+				putErrmsg("Can't end acquisition of bundle.",
+						NULL);
+				return -1;
+			}
+
+			return 1;
+		}
+
+		consumeRecord(ring, length);
+	}
+}
+
+#endif	/*	SHMCLA_SUPPORTED					*/
@@ -0,0 +1,139 @@
+/*
+ 	shmcla.h:	common definitions for shared-memory convergence
+			layer adapter modules.
+ 									*/
+#ifndef _SHMCLA_H_
+#define _SHMCLA_H_
+
+#include "bpP.h"
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*	The shared-memory convergence layer conveys bundles between
+ *	ION nodes that are running on the same host.  Each shmcli
+ *	induct owns a ring buffer in a POSIX shared memory object
+ *	named for the induct; a shmclo outduct whose duct name is
+ *	that of the induct writes each bundle into the ring, directly
+ *	from the bundle's ZCO, and shmcli acquires the bundle directly
+ *	from the ring.  Bundles are written into the ring as records,
+ *	each of which is a ShmRecord header followed by up to
+ *	SHMCLA_CHUNK_MAX bytes of the bundle; a longer bundle is
+ *	conveyed in multiple records.  No record ever wraps around
+ *	the end of the ring; a pad record fills any space at the end
+ *	of the ring that is too small for the next record.
+ *
+ *	Any number of shmclo daemons may write into the same ring,
+ *	one bundle at a time.  Waiting for data, for space, and for
+ *	the producer lock is by futex on words in the ring header.
+ *	The daemons are only available under Linux.			*/
+
+#ifdef linux
+#define	SHMCLA_SUPPORTED
+#endif
+
+#define	DEFAULT_SHM_RATE	1250000000
+
+/*	SHMCLA_RING_SIZE must be a power of 2.				*/
+
+#ifndef SHMCLA_RING_SIZE
+#define	SHMCLA_RING_SIZE	(4 * 1024 * 1024)
+#endif
+
+#define	SHMCLA_CHUNK_MAX	(SHMCLA_RING_SIZE / 4)
+#define	SHMCLA_NAME_LEN		(32)
+#define	SHMCLA_MAGIC		(0x494f4e52)
+#define	SHMCLA_HDR_SPACE	(64)
+
+/*	A daemon blocked waiting on its peer checks once per second
+ *	that the peer is still running, and it concludes that the
+ *	peer has died if the peer's heartbeat doesn't change for
+ *	SHMCLA_PEER_TIMEOUT seconds.					*/
+
+#ifndef SHMCLA_PEER_TIMEOUT
+#define	SHMCLA_PEER_TIMEOUT	(30)
+#endif
+
+#define	SHMCLA_RETRY_INTERVAL	(1)
+
+typedef struct
+{
+	unsigned int	magic;
+	unsigned int	ringSize;
+	int		consumerRunning;
+	int		consumerBeat;
+	int		producerLock;	/*	Pid of writing shmclo.	*/
+	int		producerBeat;
+	unsigned int	head;		/*	Bytes ever written.	*/
+	unsigned int	tail;		/*	Bytes ever consumed.	*/
+	int		dataSignal;	/*	Futex word.		*/
+	int		spaceSignal;	/*	Futex word.		*/
+	int		consumerWaiting;
+	int		producerWaiting;
+} ShmRingHeader;
+
+#define	SHMCLA_FIRST		(1)
+#define	SHMCLA_LAST		(2)
+#define	SHMCLA_PAD		(4)
+
+typedef struct
+{
+	unsigned int	length;		/*	Of bundle bytes.	*/
+	unsigned int	flags;
+} ShmRecord;
+
+#define	SHMCLA_ALIGN(x)		(((x) + 7) & ~7)
+
+typedef struct
+{
+	char		objName[SHMCLA_NAME_LEN + 16];
+	ShmRingHeader	*header;
+	char		*data;
+	size_t		mapLength;
+} ShmRing;
+
+extern int	shmRingCreate(char *ductName, ShmRing *ring);
+			/*	Creates the ring for the named induct,
+			 *	or resumes consuming from the ring
+			 *	left behind by a shmcli that crashed.
+			 *	Returns 0 on success, -1 on failure.	*/
+
+extern void	shmRingDestroy(ShmRing *ring);
+			/*	Marks the ring's consumer stopped and
+			 *	removes the ring.			*/
+
+extern int	shmRingAttach(char *ductName, ShmRing *ring);
+			/*	Maps the ring of the named induct.
+			 *	Returns 1 on success, 0 if the ring
+			 *	doesn't exist or has no consumer, -1
+			 *	on any system error.			*/
+
+extern void	shmRingDetach(ShmRing *ring);
+
+extern void	shmRingWake(ShmRing *ring);
+			/*	Wakes up the ring's consumer, e.g.,
+			 *	to notice that it has been stopped.	*/
+
+extern int	sendBundleByShm(ShmRing *ring, unsigned int bundleLength,
+			Object bundleZco);
+			/*	Writes the bundle into the ring.
+			 *	Returns 1 on success, 0 if the ring's
+			 *	consumer has stopped (in which case
+			 *	the ring is detached and the bundle
+			 *	is handled as a transmission failure),
+			 *	-1 on any system error.			*/
+
+extern int	receiveBundleByShm(ShmRing *ring, AcqWorkArea *work,
+			int *running);
+			/*	Acquires the next bundle from the ring.
+			 *	Returns 1 on success, 0 if *running
+			 *	was cleared while waiting, -1 on any
+			 *	system error.				*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* _SHMCLA_H_ */
@@ -0,0 +1,199 @@
+/*
+	shmcli.c:	BP shared-memory convergence-layer input
+			daemon, designed to serve as an input duct
+			for bundles sent by shmclo daemons of other
+			ION nodes on the same host.
+
+									*/
+#include "shmcla.h"
+
+#ifdef SHMCLA_SUPPORTED
+
+static void	interruptThread()
+{
+	isignal(SIGTERM, interruptThread);
+	ionKillMainThread("shmcli");
+}
+
+/*	*	*	Receiver thread functions	*	*	*/
+
+typedef struct
+{
+	VInduct		*vduct;
+	ShmRing		*ring;
+	int		running;
+} ReceiverThreadParms;
+
+static void	*handleBundles(void *parm)
+{
+	/*	Main loop for bundle reception from the ring.		*/
+
+	ReceiverThreadParms	*rtp = (ReceiverThreadParms *) parm;
+	char			*procName = "shmcli";
+	AcqWorkArea		*work;
+
+	snooze(1);	/*	Let main thread become interruptable.	*/
+	work = bpGetAcqArea(rtp->vduct);
+	if (work == NULL)
+	{
+		putErrmsg("shmcli can't get acquisition work area.", NULL);
+		ionKillMainThread(procName);
+		return NULL;
+	}
+
+	/*	Can now start receiving bundles.  On failure, take
+	 *	down the CLI.						*/
+
+	while (rtp->running)
+	{
+		switch (receiveBundleByShm(rtp->ring, work, &(rtp->running)))
+		{
+		case -1:
+			putErrmsg("Can't acquire bundle.", NULL);
+			ionKillMainThread(procName);
+
+			/*	Intentional fall-through to next case.	*/
+
+		case 0:				/*	Normal stop.	*/
+			rtp->running = 0;
+			continue;
+
+		default:
+			break;			/*	Out of switch.	*/
+		}
+
+		/*	Make sure other tasks have a chance to run.	*/
+
+		sm_TaskYield();
+	}
+
+	writeErrmsgMemos();
+	writeMemo("[i] shmcli receiver thread has ended.");
+
+	/*	Free resources.						*/
+
+	bpReleaseAcqArea(work);
+	return NULL;
+}
+
+/*	*	*	Main thread functions	*	*	*	*/
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	shmcli(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	char	*ductName = (char *) a1;
+#else
+int	main(int argc, char *argv[])
+{
+	char	*ductName = (argc > 1 ? argv[1] : NULL);
+#endif
+	VInduct			*vduct;
+	PsmAddress		vductElt;
+	Sdr			sdr;
+	Induct			duct;
+	ClProtocol		protocol;
+	ShmRing			ring;
+	ReceiverThreadParms	rtp;
+	pthread_t		receiverThread;
+
+	if (ductName == NULL)
+	{
+		PUTS("Usage: shmcli <local induct name>");
+		return 0;
+	}
+
+	if (bpAttach() < 0)
+	{
+		putErrmsg("shmcli can't attach to BP.", NULL);
+		return -1;
+	}
+
+	findInduct("shm", ductName, &vduct, &vductElt);
+	if (vductElt == 0)
+	{
+		putErrmsg("No such shm duct.", ductName);
+		return -1;
+	}
+
+	if (vduct->cliPid != ERROR && vduct->cliPid != sm_TaskIdSelf())
+	{
+		putErrmsg("CLI task is already started for this duct.",
+				itoa(vduct->cliPid));
+		return -1;
+	}
+
+	/*	All command-line arguments are now validated.		*/
+
+	sdr = getIonsdr();
+	CHKZERO(sdr_begin_xn(sdr));
+	sdr_read(sdr, (char *) &duct, sdr_list_data(sdr, vduct->inductElt),
+			sizeof(Induct));
+	sdr_read(sdr, (char *) &protocol, duct.protocol, sizeof(ClProtocol));
+	sdr_exit_xn(sdr);
+	if (protocol.nominalRate == 0)
+	{
+		vduct->acqThrottle.nominalRate = DEFAULT_SHM_RATE;
+	}
+	else
+	{
+		vduct->acqThrottle.nominalRate = protocol.nominalRate;
+	}
+
+	if (shmRingCreate(ductName, &ring) < 0)
+	{
+		putErrmsg("shmcli can't create ring.", ductName);
+		return -1;
+	}
+
+	/*	Set up signal handling; SIGTERM is shutdown signal.	*/
+
+	ionNoteMainThread("shmcli");
+	isignal(SIGTERM, interruptThread);
+
+	/*	Start the receiver thread.				*/
+
+	rtp.vduct = vduct;
+	rtp.ring = &ring;
+	rtp.running = 1;
+	if (pthread_begin(&receiverThread, NULL, handleBundles, &rtp))
+	{
+		shmRingDestroy(&ring);
+		putSysErrmsg("shmcli can't create receiver thread", NULL);
+		return -1;
+	}
+
+	/*	Now sleep until interrupted by SIGTERM, at which point
+	 *	it's time to stop the induct.				*/
+
+	writeMemoNote("[i] shmcli is running, induct", ductName);
+	ionPauseMainThread(-1);
+
+	/*	Time to shut down.					*/
+
+	rtp.running = 0;
+	shmRingWake(&ring);
+	pthread_join(receiverThread, NULL);
+	shmRingDestroy(&ring);
+	writeErrmsgMemos();
+	writeMemo("[i] shmcli duct has ended.");
+	ionDetach();
+	return 0;
+}
+
+#else	/*	SHMCLA_SUPPORTED					*/
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	shmcli(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+#else
+int	main(int argc, char *argv[])
+{
+#endif
+	putErrmsg("shmcli is only available under Linux.", NULL);
+	writeErrmsgMemos();
+	return 0;
+}
+
+#endif	/*	SHMCLA_SUPPORTED					*/
@@ -0,0 +1,204 @@
+/*
+	shmclo.c:	BP shared-memory convergence-layer output
+			daemon, for conveying bundles to the shmcli
+			induct of another ION node on the same host.
+			The duct name is the name of that induct.
+
+									*/
+#include "shmcla.h"
+
+#ifdef SHMCLA_SUPPORTED
+
+static sm_SemId		shmcloSemaphore(sm_SemId *semid)
+{
+	static sm_SemId	semaphore = -1;
+
+	if (semid)
+	{
+		semaphore = *semid;
+	}
+
+	return semaphore;
+}
+
+static void	shutDownClo()	/*	Commands CLO termination.	*/
+{
+	sm_SemEnd(shmcloSemaphore(NULL));
+}
+
+/*	*	*	Main thread functions	*	*	*	*/
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	shmclo(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	char	*ductName = (char *) a1;
+#else
+int	main(int argc, char *argv[])
+{
+	char	*ductName = (argc > 1 ? argv[1] : NULL);
+#endif
+	VOutduct	*vduct;
+	PsmAddress	vductElt;
+	Sdr		sdr;
+	Outduct		duct;
+	ClProtocol	protocol;
+	Outflow		outflows[3];
+	int		i;
+	ShmRing		ring;
+	int		attached = 0;
+	int		waiting = 0;
+	Object		bundleZco;
+	BpExtendedCOS	extendedCOS;
+	char		destDuctName[MAX_CL_DUCT_NAME_LEN + 1];
+	unsigned int	bundleLength;
+
+	if (ductName == NULL)
+	{
+		PUTS("Usage: shmclo <remote induct name>");
+		return 0;
+	}
+
+	if (bpAttach() < 0)
+	{
+		putErrmsg("shmclo can't attach to BP.", NULL);
+		return -1;
+	}
+
+	findOutduct("shm", ductName, &vduct, &vductElt);
+	if (vductElt == 0)
+	{
+		putErrmsg("No such shm duct.", ductName);
+		return -1;
+	}
+
+	if (vduct->cloPid != ERROR && vduct->cloPid != sm_TaskIdSelf())
+	{
+		putErrmsg("CLO task is already started for this duct.",
+				itoa(vduct->cloPid));
+		return -1;
+	}
+
+	/*	All command-line arguments are now validated.		*/
+
+	sdr = getIonsdr();
+	CHKERR(sdr_begin_xn(sdr));
+	sdr_read(sdr, (char *) &duct, sdr_list_data(sdr, vduct->outductElt),
+			sizeof(Outduct));
+	sdr_read(sdr, (char *) &protocol, duct.protocol, sizeof(ClProtocol));
+	sdr_exit_xn(sdr);
+	if (protocol.nominalRate == 0)
+	{
+		vduct->xmitThrottle.nominalRate = DEFAULT_SHM_RATE;
+	}
+	else
+	{
+		vduct->xmitThrottle.nominalRate = protocol.nominalRate;
+	}
+
+	memset((char *) outflows, 0, sizeof outflows);
+	outflows[0].outboundBundles = duct.bulkQueue;
+	outflows[1].outboundBundles = duct.stdQueue;
+	outflows[2].outboundBundles = duct.urgentQueue;
+	for (i = 0; i < 3; i++)
+	{
+		outflows[i].svcFactor = 1 << i;
+	}
+
+	memset((char *) &ring, 0, sizeof(ShmRing));
+
+	/*	Set up signal handling.  SIGTERM is shutdown signal.	*/
+
+	oK(shmcloSemaphore(&(vduct->semaphore)));
+	isignal(SIGTERM, shutDownClo);
+
+	/*	Can now begin transmitting to remote duct.		*/
+
+	writeMemoNote("[i] shmclo is running, induct", ductName);
+	while (!(sm_SemEnded(shmcloSemaphore(NULL))))
+	{
+		/*	Bundles wait in the outduct's queues for as
+		 *	long as the remote induct isn't running.	*/
+
+		if (!attached)
+		{
+			switch (shmRingAttach(ductName, &ring))
+			{
+			case -1:
+				sm_SemEnd(shmcloSemaphore(NULL));
+				continue;
+
+			case 0:
+				if (!waiting)
+				{
+					writeMemoNote("[i] shmclo waiting for \
+induct", ductName);
+					waiting = 1;
+				}
+
+				snooze(SHMCLA_RETRY_INTERVAL);
+				continue;
+
+			default:
+				attached = 1;
+				waiting = 0;
+			}
+		}
+
+		if (bpDequeue(vduct, outflows, &bundleZco, &extendedCOS,
+				destDuctName, 0, -1) < 0)
+		{
+			sm_SemEnd(shmcloSemaphore(NULL));
+			continue;
+		}
+
+		if (bundleZco == 0)	/*	Interrupted.		*/
+		{
+			continue;
+		}
+
+		CHKZERO(sdr_begin_xn(sdr));
+		bundleLength = zco_length(sdr, bundleZco);
+		sdr_exit_xn(sdr);
+		switch (sendBundleByShm(&ring, bundleLength, bundleZco))
+		{
+		case -1:			/*	System error.	*/
+			sm_SemEnd(shmcloSemaphore(NULL));
+			continue;
+
+		case 0:				/*	Lost induct.	*/
+			attached = 0;
+			continue;
+
+		default:
+			break;
+		}
+
+		/*	Make sure other tasks have a chance to run.	*/
+
+		sm_TaskYield();
+	}
+
+	shmRingDetach(&ring);
+	writeErrmsgMemos();
+	writeMemo("[i] shmclo duct has ended.");
+	ionDetach();
+	return 0;
+}
+
+#else	/*	SHMCLA_SUPPORTED					*/
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	shmclo(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+#else
+int	main(int argc, char *argv[])
+{
+#endif
+	putErrmsg("shmclo is only available under Linux.", NULL);
+	writeErrmsgMemos();
+	return 0;
+}
+
+#endif	/*	SHMCLA_SUPPORTED					*/
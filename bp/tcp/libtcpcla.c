@@ -14,6 +14,7 @@
 int	tcpDelayEnabled = 0;
 int	tcpDelayNsecPerByte = 0;
 int 	tcpDesiredKeepAlivePeriod = 0;
+int	tcpclContactFlags = TCPCLA_FLAGS;
 
 typedef struct
 {
@@ -163,14 +164,50 @@ int	connectToCLI(struct sockaddr *sn, int *sock)
 	return 0;
 }
 
-int	sendBytesByTCP(int *bundleSocket, char *from, int length,
-		struct sockaddr *sn)
+static int	awaitSendSpace(int bundleSocket)
+{
+	fd_set		writeSet;
+	struct timeval	timeout;
+
+	/*	Waits until the send buffer of a non-blocking socket
+	 *	can accept more bytes.  Returns 1 when it can, 0 if
+	 *	it still can't after TCPCLA_SEND_TIMEOUT seconds.	*/
+
+	while (1)
+	{
+		FD_ZERO(&writeSet);
+		FD_SET(bundleSocket, &writeSet);
+		timeout.tv_sec = TCPCLA_SEND_TIMEOUT;
+		timeout.tv_usec = 0;
+		switch (select(bundleSocket + 1, NULL, &writeSet, NULL,
+				&timeout))
+		{
+		case -1:
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			putSysErrmsg("Can't wait to write to socket", NULL);
+			return -1;
+
+		case 0:
+			return 0;
+
+		default:
+			return 1;
+		}
+	}
+}
+
+static int	sendBytes(int *bundleSocket, char *from, int length,
+			int flags)
 {
 	int	bytesWritten;
 
 	while (1)	/*	Continue until not interrupted.		*/
 	{
-		bytesWritten = isend(*bundleSocket, from, length, 0);
+		bytesWritten = isend(*bundleSocket, from, length, flags);
 		if (bytesWritten < 0)
 		{
 			switch (errno)
@@ -178,6 +215,26 @@ int	sendBytesByTCP(int *bundleSocket, char *from, int length,
 			case EINTR:	/*	Interrupted; retry.	*/
 				continue;
 
+			case EAGAIN:	/*	Send buffer is full.	*/
+#if EWOULDBLOCK != EAGAIN
+			case EWOULDBLOCK:
+#endif
+				switch (awaitSendSpace(*bundleSocket))
+				{
+				case 1:
+					continue;
+
+				case 0:
+					putErrmsg("Timed out writing to \
+socket.", itoa(TCPCLA_SEND_TIMEOUT));
+					break;
+
+				default:
+					break;
+				}
+
+				return -1;
+
 			case EPIPE:	/*	Lost connection.	*/
 			case EBADF:
 			case ETIMEDOUT:
@@ -194,76 +251,350 @@ int	sendBytesByTCP(int *bundleSocket, char *from, int length,
 	}
 }
 
-static int	sendZcoByTCP(int *bundleSocket, unsigned int bundleLength,
-			Object bundleZco, unsigned char *buffer, unsigned int
-			tcpclSegmentHeaderLength, struct sockaddr *sn)
+int	sendBytesByTCP(int *bundleSocket, char *from, int length,
+		struct sockaddr *sn)
+{
+	return sendBytes(bundleSocket, from, length, 0);
+}
+
+static int	sendBufferByTCP(int *bundleSocket, char *from, int length,
+			int moreToSend)
+{
+	int	flags = 0;
+	int	totalBytesSent = 0;
+	int	bytesSent;
+
+#ifdef MSG_MORE
+	/*	Let TCP coalesce these bytes with the ones that will
+	 *	follow them, e.g., the content of a file.		*/
+
+	if (moreToSend)
+	{
+		flags = MSG_MORE;
+	}
+#endif
+	while (length > 0)
+	{
+		bytesSent = sendBytes(bundleSocket, from, length, flags);
+		if (bytesSent < 0)
+		{
+			return -1;
+		}
+
+		if (*bundleSocket == -1)
+		{
+			return 0;	/*	Lost connection.	*/
+		}
+
+		totalBytesSent += bytesSent;
+		from += bytesSent;
+		length -= bytesSent;
+	}
+
+	return totalBytesSent;
+}
+
+static int	sendFillByTCP(int *bundleSocket, vast length,
+			unsigned char *buffer)
 {
-	Sdr		sdr = getIonsdr();
-	int		totalBytesSent = 0;
-	unsigned int	bytesRemaining = bundleLength;
-	unsigned int	bytesBuffered = tcpclSegmentHeaderLength;
-	ZcoReader	reader;
-	int		bytesToLoad;
-	int		bytesLoaded;
-	int		bytesToSend;
-	char		*from;
-	int		bytesSent;
+	int	bytesToSend;
+
+	/*	As in zco_transmit, content that can't be read from
+	 *	the file of a ZCO extent (because the file has been
+	 *	removed or truncated) is replaced by fill.		*/
+
+	memset((char *) buffer, ZCO_FILE_FILL_CHAR,
+			length < TCPCLA_BUFSZ ? length : TCPCLA_BUFSZ);
+	while (length > 0)
+	{
+		bytesToSend = TCPCLA_BUFSZ;
+		if (bytesToSend > length)
+		{
+			bytesToSend = length;
+		}
+
+		length -= bytesToSend;
+		if (sendBufferByTCP(bundleSocket, (char *) buffer, bytesToSend,
+				length > 0) < 0)
+		{
+			return -1;
+		}
+
+		if (*bundleSocket == -1)
+		{
+			return 0;	/*	Lost connection.	*/
+		}
+	}
+
+	return 0;
+}
+
+static int	copyFileToTCP(int *bundleSocket, ZcoExtentDescriptor *extent,
+			vast bytesCopied, unsigned char *buffer)
+{
+	vast	bytesRemaining = extent->length - bytesCopied;
+	int	bytesToRead;
+	int	bytesRead;
+
+	if (lseek(extent->fd, extent->offset + bytesCopied, SEEK_SET) < 0)
+	{
+		return sendFillByTCP(bundleSocket, bytesRemaining, buffer);
+	}
 
-	zco_start_transmitting(bundleZco, &reader);
-	zco_track_file_offset(&reader);
 	while (bytesRemaining > 0)
 	{
-		bytesToLoad = TCPCLA_BUFSZ - bytesBuffered;
-		if (bytesToLoad > bytesRemaining)
+		bytesToRead = TCPCLA_BUFSZ;
+		if (bytesToRead > bytesRemaining)
 		{
-			bytesToLoad = bytesRemaining;
+			bytesToRead = bytesRemaining;
 		}
 
-		CHKERR(sdr_begin_xn(sdr));
-		bytesLoaded = zco_transmit(sdr, &reader, bytesToLoad,
-				(char *) buffer + bytesBuffered);
-		if (sdr_end_xn(sdr) < 0 || bytesLoaded != bytesToLoad)
+		bytesRead = read(extent->fd, (char *) buffer, bytesToRead);
+		if (bytesRead <= 0)
+		{
+			return sendFillByTCP(bundleSocket, bytesRemaining,
+					buffer);
+		}
+
+		bytesRemaining -= bytesRead;
+		if (sendBufferByTCP(bundleSocket, (char *) buffer, bytesRead,
+				bytesRemaining > 0) < 0)
 		{
-			putErrmsg("ZCO length error.", NULL);
 			return -1;
 		}
 
-		bytesToSend = bytesBuffered + bytesLoaded;
-		bytesRemaining -= bytesLoaded;
-		from = (char *) buffer;
-		while (bytesToSend > 0)
+		if (*bundleSocket == -1)
+		{
+			return 0;	/*	Lost connection.	*/
+		}
+	}
+
+	return 0;
+}
+
+static int	sendFileByTCP(int *bundleSocket, ZcoExtentDescriptor *extent,
+			unsigned char *buffer)
+{
+#ifdef TCPCLA_SENDFILE
+	off_t	offset = extent->offset;
+	vast	bytesCopied = 0;
+	size_t	bytesToSend;
+	ssize_t	bytesSent;
+
+	while (bytesCopied < extent->length)
+	{
+		bytesToSend = extent->length - bytesCopied;
+		if (bytesToSend > TCPCLA_SENDFILE_MAX)
 		{
-			bytesSent = sendBytesByTCP(bundleSocket, from,
-					bytesToSend, sn);
-			if (bytesSent < 0)
+			bytesToSend = TCPCLA_SENDFILE_MAX;
+		}
+
+		bytesSent = sendfile(*bundleSocket, extent->fd, &offset,
+				bytesToSend);
+		if (bytesSent < 0)
+		{
+			switch (errno)
 			{
-				/*	Big problem; shut down.		*/
+			case EINTR:	/*	Interrupted; retry.	*/
+				continue;
 
-				putErrmsg("Failed to send by TCP.", NULL);
-				return -1;
+			case EINVAL:	/*	Can't sendfile.		*/
+			case ENOSYS:
+			case EIO:	/*	Can't read file.	*/
+				return copyFileToTCP(bundleSocket, extent,
+						bytesCopied, buffer);
+
+			case EPIPE:	/*	Lost connection.	*/
+			case ETIMEDOUT:
+			case ECONNRESET:
+				closesocket(*bundleSocket);
+				*bundleSocket = -1;
+				return 0;
+			}
+
+			putSysErrmsg("sendfile() error on socket", NULL);
+			return -1;
+		}
+
+		if (bytesSent == 0)	/*	File is truncated.	*/
+		{
+			return sendFillByTCP(bundleSocket,
+					extent->length - bytesCopied, buffer);
+		}
+
+		bytesCopied += bytesSent;
+	}
+
+	return 0;
+#else
+	return copyFileToTCP(bundleSocket, extent, 0, buffer);
+#endif
+}
+
+static int	sendIovByTCP(int *bundleSocket, struct iovec *iov,
+			int iovCount, int moreToSend)
+{
+#ifdef mingw
+	int	i;
+
+	for (i = 0; i < iovCount; i++)
+	{
+		if (sendBufferByTCP(bundleSocket, (char *) iov[i].iov_base,
+				iov[i].iov_len, moreToSend || i < iovCount - 1)
+				< 0)
+		{
+			return -1;
+		}
+
+		if (*bundleSocket == -1)
+		{
+			return 0;	/*	Lost connection.	*/
+		}
+	}
+
+	return 0;
+#else
+	struct msghdr	msg;
+	int		flags = 0;
+	int		bytesSent;
+
+#ifdef MSG_MORE
+	if (moreToSend)
+	{
+		flags = MSG_MORE;
+	}
+#endif
+	memset((char *) &msg, 0, sizeof msg);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovCount;
+	while (msg.msg_iovlen > 0)
+	{
+		bytesSent = sendmsg(*bundleSocket, &msg, flags);
+		if (bytesSent < 0)
+		{
+			switch (errno)
+			{
+			case EINTR:	/*	Interrupted; retry.	*/
+				continue;
+
+			case EPIPE:	/*	Lost connection.	*/
+			case EBADF:
+			case ETIMEDOUT:
+			case ECONNRESET:
+				closesocket(*bundleSocket);
+				*bundleSocket = -1;
+				return 0;
+			}
+
+			putSysErrmsg("sendmsg() error on socket", NULL);
+			return -1;
+		}
+
+		/*	Skip over whatever was sent.			*/
+
+		while (msg.msg_iovlen > 0 && bytesSent >= msg.msg_iov->iov_len)
+		{
+			bytesSent -= msg.msg_iov->iov_len;
+			msg.msg_iov++;
+			msg.msg_iovlen--;
+		}
+
+		if (bytesSent > 0)
+		{
+			msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base
+					+ bytesSent;
+			msg.msg_iov->iov_len -= bytesSent;
+		}
+	}
+
+	return 0;
+#endif
+}
+
+static int	sendZcoByTCP(int *bundleSocket, ZcoReader *reader,
+			unsigned int length, unsigned char *buffer,
+			unsigned int tcpclSegmentHeaderLength)
+{
+	Sdr			sdr = getIonsdr();
+	unsigned int		bytesRemaining = length;
+	int			bytesBuffered = tcpclSegmentHeaderLength;
+	struct iovec		iov[TCPCLA_IOV_MAX];
+	int			iovCount;
+	ZcoExtentDescriptor	fileExtent;
+	vast			bytesLoaded;
+	int			result;
+
+	/*	Bytes in the SDR heap are copied into the buffer,
+	 *	as the transaction can't be held open while sendmsg()
+	 *	blocks, and sent by sendmsg(); the content of a
+	 *	file-backed extent is sent directly from the file.
+	 *	Any TCPCL segment header is already in the buffer.	*/
+
+	iov[0].iov_base = (char *) buffer;
+	iov[0].iov_len = bytesBuffered;
+	while (bytesRemaining > 0)
+	{
+		iovCount = TCPCLA_IOV_MAX - 1;
+		CHKERR(sdr_begin_xn(sdr));
+		bytesLoaded = zco_transmit_iov(sdr, reader, bytesRemaining,
+				iov + 1, &iovCount, (char *) buffer
+				+ bytesBuffered, TCPCLA_BUFSZ - bytesBuffered,
+				&fileExtent);
+		if (sdr_end_xn(sdr) < 0 || bytesLoaded <= 0)
+		{
+			if (fileExtent.fd >= 0)
+			{
+				close(fileExtent.fd);
 			}
 
-			if (*bundleSocket == -1)
+			putErrmsg("ZCO length error.", NULL);
+			return -1;
+		}
+
+		bytesRemaining -= bytesLoaded;
+		if (bytesBuffered > 0)
+		{
+			result = sendIovByTCP(bundleSocket, iov, iovCount + 1,
+					bytesRemaining > 0 || fileExtent.fd >= 0);
+			bytesBuffered = 0;
+		}
+		else
+		{
+			result = sendIovByTCP(bundleSocket, iov + 1, iovCount,
+					bytesRemaining > 0 || fileExtent.fd >= 0);
+		}
+
+		if (fileExtent.fd >= 0)
+		{
+			if (result == 0 && *bundleSocket != -1)
 			{
-				/*	Just lost connection; treat
-				 *	as a transient anomaly, note
-				 *	the incomplete transmission.	*/
-
-				writeMemo("[?] Disconnected from CLI.");
-				totalBytesSent = 0;
-				bytesRemaining = 0;
-				break;		/*	Out of loop.	*/
+				result = sendFileByTCP(bundleSocket,
+						&fileExtent, buffer);
 			}
 
-			totalBytesSent += bytesSent;
-			from += bytesSent;
-			bytesToSend -= bytesSent;
+			close(fileExtent.fd);
+		}
+
+		if (result < 0)
+		{
+			/*	Big problem; shut down.			*/
+
+			putErrmsg("Failed to send by TCP.", NULL);
+			return -1;
 		}
 
-		bytesBuffered = 0;
+		if (*bundleSocket == -1)
+		{
+			/*	Just lost connection; treat as a
+			 *	transient anomaly, note the incomplete
+			 *	transmission.				*/
+
+			writeMemo("[?] Disconnected from CLI.");
+			return 0;
+		}
 	}
 
-	return totalBytesSent;
+	return length;
 }
 
 static int	handleTcpFailure(struct sockaddr *sn, Object bundleZco)
@@ -320,6 +651,7 @@ int	sendBundleByTCP(struct sockaddr *socketName, int *bundleSocket,
 	char		*from;
 	int		bytesSent;
 	Sdr		sdr = getIonsdr();
+	ZcoReader	reader;
 	int		result;
 
 	/*	Connect to CLI as necessary.				*/
@@ -372,8 +704,9 @@ int	sendBundleByTCP(struct sockaddr *socketName, int *bundleSocket,
 
 	/*	Send the bundle itself.					*/
 
-	result = sendZcoByTCP(bundleSocket, bundleLength, bundleZco, buffer, 0,
-			socketName);
+	zco_start_transmitting(bundleZco, &reader);
+	zco_track_file_offset(&reader);
+	result = sendZcoByTCP(bundleSocket, &reader, bundleLength, buffer, 0);
 	if (result < 0)		/*	Big problem; shut down.		*/
 	{
 		putErrmsg("Failed to send by TCP.", NULL);
@@ -418,6 +751,7 @@ int	sendBundleByTCPCL(struct sockaddr *socketName, int *bundleSocket,
 	Sdnv 		lengthField;
 	int		tempBundleSocket;
 	Sdr		sdr = getIonsdr();
+	ZcoReader	reader;
 	int		result;
 
 	/*	Connect to CLI as necessary.				*/
@@ -445,7 +779,7 @@ int	sendBundleByTCPCL(struct sockaddr *socketName, int *bundleSocket,
 			}
 
 			if (receiveContactHeader(&tempBundleSocket, buffer,
-					keepalivePeriod) < 0)
+					keepalivePeriod, NULL) < 0)
 			{
 				closesocket(tempBundleSocket);
 				tempBundleSocket = -1;
@@ -499,8 +833,10 @@ not sent.");
 	
 	/*	Send the bundle itself.					*/
 
-	result = sendZcoByTCP(bundleSocket, bundleLength, bundleZco, buffer,
-			bytesToSend, socketName);
+	zco_start_transmitting(bundleZco, &reader);
+	zco_track_file_offset(&reader);
+	result = sendZcoByTCP(bundleSocket, &reader, bundleLength, buffer,
+			bytesToSend);
 	if(result < 0)
 	{
 		putErrmsg("Failed to send by TCP.", NULL);
@@ -781,25 +1117,16 @@ int receiveSegmentByTcpCL(int bundleSocket,AcqWorkArea *work,char *buffer,uvast
 
 
 /*	*	* Creates and sends the contact header	*	*	*/
-int	sendContactHeader(int *bundleSocket, unsigned char *buffer,
-		struct sockaddr *socketName)
+static int	transmitContactHeader(int *bundleSocket, unsigned char *buffer,
+			char *adminEidString, struct sockaddr *socketName)
 {
 	int bytesToSend = 0;
 	int bytesSent;
 	uint16_t keepaliveIntervalNBO = htons(tcpDesiredKeepAlivePeriod);
 	uvast	val;
 	Sdnv eidLength;
-	int	adminEidStringLen;
-	char    *adminEidString;
 	int     adminEidLength;
-	char    hostNameBuf[MAXHOSTNAMELEN + 1];
 
-        getNameOfHost(hostNameBuf, MAXHOSTNAMELEN);
-	adminEidStringLen = strlen(hostNameBuf) + 11;
-	adminEidString = MTAKE(adminEidStringLen);
-	CHKERR(adminEidString);
-	isprintf(adminEidString, adminEidStringLen, "dtn://%.60s.dtn",
-			hostNameBuf);
 	adminEidLength = strlen(adminEidString);
 	if(TCPCLA_BUFSZ < (18 + (adminEidLength)))
 	{
@@ -812,7 +1139,7 @@ int	sendContactHeader(int *bundleSocket, unsigned char *buffer,
 	bytesToSend = TCPCLA_MAGIC_SIZE;
 	*(buffer + bytesToSend) =  TCPCLA_ID_VERSION;
 	bytesToSend++;
-	*(buffer + bytesToSend) = TCPCLA_FLAGS;
+	*(buffer + bytesToSend) = tcpclContactFlags;
 	bytesToSend++;
 	memcpy(buffer + bytesToSend,&keepaliveIntervalNBO,2);
 	bytesToSend +=2;
@@ -827,8 +1154,6 @@ int	sendContactHeader(int *bundleSocket, unsigned char *buffer,
 	memcpy(buffer + bytesToSend, adminEidString, adminEidLength);
 	bytesToSend += adminEidLength;
 
-	MRELEASE(adminEidString);
-
 	while(bytesToSend > 0)
 	{
 		bytesSent = sendBytesByTCP(bundleSocket, (char*) buffer,
@@ -855,8 +1180,21 @@ connectivity is restored.", NULL);
 	return 0;
 }
 
+int	sendContactHeader(int *bundleSocket, unsigned char *buffer,
+		struct sockaddr *socketName)
+{
+	char	hostNameBuf[MAXHOSTNAMELEN + 1];
+	char	adminEidString[MAXHOSTNAMELEN + 11];
+
+	getNameOfHost(hostNameBuf, MAXHOSTNAMELEN);
+	isprintf(adminEidString, sizeof adminEidString, "dtn://%.60s.dtn",
+			hostNameBuf);
+	return transmitContactHeader(bundleSocket, buffer, adminEidString,
+			socketName);
+}
+
 /*	*	*Receives Contact Header	*	*	*	*/
-int receiveContactHeader(int *bundleSocket, unsigned char *buffer, int *keepalivePeriod)
+int receiveContactHeader(int *bundleSocket, unsigned char *buffer, int *keepalivePeriod, int *flags)
 {
 	uint16_t requestedKeepAlive;
 	uvast remoteEidLength;
@@ -893,8 +1231,8 @@ int receiveContactHeader(int *bundleSocket, unsigned char *buffer, int *keepaliv
 		putErrmsg("Lower version than current version.",NULL);
 		return -1;
 	}
-	/*checking the flags*/
-	switch(buffer[1])
+	/*checking the flags, other than ION's own resumption flag*/
+	switch(buffer[1] & ~TCPCLA_FLAG_RESUME)
 	{
 		
 		case 0x00:
@@ -921,6 +1259,12 @@ int receiveContactHeader(int *bundleSocket, unsigned char *buffer, int *keepaliv
 			putErrmsg("Incorrect flags have been set in the header.",NULL);
 		
 	}
+	/*	A session option is in effect only if both ends of
+	 *	the session asked for it.				*/
+	if(flags)
+	{
+		*flags = buffer[1] & tcpclContactFlags;
+	}
 	memcpy(&requestedKeepAlive, &buffer[2],2);
 	requestedKeepAlive = ntohs(requestedKeepAlive);
 	*keepalivePeriod = MIN(requestedKeepAlive,tcpDesiredKeepAlivePeriod);
@@ -1065,3 +1409,636 @@ Shutdown message", NULL);
 }
 	
 
+/*	*	*	TCPCL session functions	*	*	*	*/
+
+int	tcpclInitSession(TcpclSession *session, struct sockaddr *socketName,
+		int connectionNbr, unsigned int segmentSize)
+{
+	memset((char *) session, 0, sizeof(TcpclSession));
+	session->socketName = socketName;
+	session->connectionNbr = connectionNbr;
+	session->bundleSocket = -1;
+	session->segmentSize = segmentSize;
+	if (session->segmentSize == 0)
+	{
+		session->segmentSize = TCPCLA_SEGMENT_SIZE;
+	}
+
+	if (pthread_mutex_init(&session->mutex, NULL))
+	{
+		putSysErrmsg("Can't initialize TCPCL session mutex", NULL);
+		return -1;
+	}
+
+	if (pthread_cond_init(&session->ackArrived, NULL))
+	{
+		pthread_mutex_destroy(&session->mutex);
+		putSysErrmsg("Can't initialize TCPCL session cond", NULL);
+		return -1;
+	}
+
+	return 0;
+}
+
+void	tcpclCloseSession(TcpclSession *session)
+{
+	/*	The caller must hold the session's mutex.  Shutting
+	 *	the socket down, rather than merely closing it, ends
+	 *	any recv() on the socket in the receiving thread; the
+	 *	broadcast ends any wait for an acknowledgment.		*/
+
+	if (session->bundleSocket != -1)
+	{
+#ifdef mingw
+		shutdown(session->bundleSocket, SD_BOTH);
+#else
+		shutdown(session->bundleSocket, SHUT_RDWR);
+#endif
+		closesocket(session->bundleSocket);
+		session->bundleSocket = -1;
+	}
+
+	pthread_cond_broadcast(&session->ackArrived);
+}
+
+void	tcpclDestroySession(TcpclSession *session)
+{
+	pthread_cond_destroy(&session->ackArrived);
+	pthread_mutex_destroy(&session->mutex);
+}
+
+static int	connectSession(TcpclSession *session, unsigned char *buffer)
+{
+	int	sock;
+	char	hostNameBuf[MAXHOSTNAMELEN + 1];
+	char	adminEidString[MAXHOSTNAMELEN + 32];
+
+	/*	Returns 1 on success, 0 if no session could be
+	 *	established.						*/
+
+	if (connectToCLI(session->socketName, &sock) < 0)
+	{
+		if (session->keepalivePeriod == 0)
+		{
+			session->keepalivePeriod = KEEPALIVE_PERIOD;
+		}
+
+		return 0;
+	}
+
+	/*	Each session identifies itself by a distinct EID, so
+	 *	that the remote CLI can tell which session's bundle
+	 *	to resume when a bundle is resumed on a new
+	 *	connection.						*/
+
+	getNameOfHost(hostNameBuf, MAXHOSTNAMELEN);
+	isprintf(adminEidString, sizeof adminEidString,
+			"dtn://%.60s.dtn/%d.%d", hostNameBuf, sm_TaskIdSelf(),
+			session->connectionNbr);
+	if (transmitContactHeader(&sock, buffer, adminEidString,
+			session->socketName) < 0
+	|| receiveContactHeader(&sock, buffer, &session->keepalivePeriod,
+			&session->flags) < 0)
+	{
+		if (sock != -1)
+		{
+			closesocket(sock);
+		}
+
+		putErrmsg("Could not exchange contact headers.", NULL);
+		return 0;
+	}
+
+	session->bundleSocket = sock;
+	return 1;
+}
+
+static int	awaitReceiver(TcpclSession *session, unsigned int bytesAcked)
+{
+	struct timeval	workTime;
+	struct timespec	deadline;
+	unsigned int	progress = session->bytesAcked;
+	int		result;
+
+	/*	Waits, with the session's mutex released, until the
+	 *	receiving thread has noted acknowledgment of at least
+	 *	the indicated number of bytes of the bundle in transit
+	 *	or, if that number is zero, a reply to a request to
+	 *	resume the bundle.  The deadline is extended whenever
+	 *	acknowledgment advances.  Returns 1 on success, 0 if
+	 *	the connection is lost or the reply is overdue.		*/
+
+	getCurrentTime(&workTime);
+	deadline.tv_sec = workTime.tv_sec + TCPCLA_ACK_TIMEOUT;
+	deadline.tv_nsec = workTime.tv_usec * 1000;
+	while (bytesAcked == 0 ? session->resumeReply == -1
+			: session->bytesAcked < bytesAcked)
+	{
+		if (session->bundleSocket == -1)
+		{
+			return 0;
+		}
+
+		if (session->bytesAcked > progress)
+		{
+			progress = session->bytesAcked;
+			getCurrentTime(&workTime);
+			deadline.tv_sec = workTime.tv_sec + TCPCLA_ACK_TIMEOUT;
+			deadline.tv_nsec = workTime.tv_usec * 1000;
+		}
+
+		result = pthread_cond_timedwait(&session->ackArrived,
+				&session->mutex, &deadline);
+		if (result == ETIMEDOUT)
+		{
+			writeMemo("[?] TCPCL acknowledgment is overdue.");
+			tcpclCloseSession(session);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int	transmitBundle(TcpclSession *session, unsigned char *buffer)
+{
+	Sdr		sdr = getIonsdr();
+	ZcoReader	reader;
+	unsigned int	window = TCPCLA_ACK_WINDOW * session->segmentSize;
+	unsigned int	bytesToSend;
+	Sdnv		lengthField;
+	int		result;
+
+	/*	Sends the bundle in transit, or the unacknowledged
+	 *	remainder of it, in one or more data segments.  The
+	 *	caller holds the session's mutex.  Returns 1 when the
+	 *	bundle has been sent (and, if segment acknowledgment
+	 *	is in effect, fully acknowledged), 0 if the connection
+	 *	was lost first, -1 on any system failure.		*/
+
+	if (session->bundleSocket == -1)
+	{
+		if (connectSession(session, buffer) == 0)
+		{
+			return 0;
+		}
+	}
+
+	if (session->bytesSent > 0)
+	{
+		/*	Resuming an interrupted bundle.  A zero-length
+		 *	data segment that doesn't start a bundle asks
+		 *	the remote CLI to resume the bundle it was
+		 *	receiving from this session; it replies with an
+		 *	acknowledgment of all bytes of that bundle that
+		 *	it has acquired, or by refusing the bundle, in
+		 *	which case the bundle is sent again in full.	*/
+
+		if ((session->flags & (TCPCLA_FLAG_ACK | TCPCLA_FLAG_RESUME))
+				!= (TCPCLA_FLAG_ACK | TCPCLA_FLAG_RESUME))
+		{
+			session->bytesAcked = 0;
+		}
+		else
+		{
+			session->resumeReply = -1;
+			buffer[0] = TCPCLA_TYPE_DATA << 4;
+			buffer[1] = 0;
+			if (sendBufferByTCP(&session->bundleSocket,
+					(char *) buffer, 2, 0) < 0)
+			{
+				return -1;
+			}
+
+			if (awaitReceiver(session, 0) == 0)
+			{
+				return 0;
+			}
+
+			if (session->resumeReply == TCPCLA_TYPE_ACK)
+			{
+				writeMemoNote("[i] Resuming TCPCL bundle \
+transmission at byte", utoa(session->bytesAcked));
+			}
+			else
+			{
+				session->bytesAcked = 0;
+			}
+
+			session->resumeReply = 0;
+		}
+	}
+
+	session->bytesSent = session->bytesAcked;
+	zco_start_transmitting(session->bundleZco, &reader);
+	zco_track_file_offset(&reader);
+	if (session->bytesSent > 0)
+	{
+		CHKERR(sdr_begin_xn(sdr));
+		oK(zco_transmit(sdr, &reader, session->bytesSent, NULL));
+		if (sdr_end_xn(sdr) < 0)
+		{
+			putErrmsg("Can't skip acknowledged bytes.", NULL);
+			return -1;
+		}
+	}
+
+	while (session->bytesSent < session->bundleLength)
+	{
+		bytesToSend = session->bundleLength - session->bytesSent;
+		if (bytesToSend > session->segmentSize)
+		{
+			bytesToSend = session->segmentSize;
+		}
+
+		/*	Pipelining: segments are sent without waiting
+		 *	for acknowledgment of prior segments, so long
+		 *	as the unacknowledged bytes fit in the window.	*/
+
+		if ((session->flags & TCPCLA_FLAG_ACK)
+		&& session->bytesSent + bytesToSend > window)
+		{
+			if (awaitReceiver(session, (session->bytesSent
+					+ bytesToSend) - window) == 0)
+			{
+				return 0;
+			}
+		}
+
+		buffer[0] = TCPCLA_TYPE_DATA << 4;
+		if (session->bytesSent == 0)
+		{
+			buffer[0] |= TCPCLA_SEG_START;
+		}
+
+		if (session->bytesSent + bytesToSend == session->bundleLength)
+		{
+			buffer[0] |= TCPCLA_SEG_END;
+		}
+
+		encodeSdnv(&lengthField, bytesToSend);
+		memcpy(buffer + 1, lengthField.text, lengthField.length);
+		result = sendZcoByTCP(&session->bundleSocket, &reader,
+				bytesToSend, buffer, 1 + lengthField.length);
+		if (result < 0)
+		{
+			return -1;
+		}
+
+		if (session->bundleSocket == -1)
+		{
+			return 0;
+		}
+
+		session->bytesSent += bytesToSend;
+	}
+
+	if (session->flags & TCPCLA_FLAG_ACK)
+	{
+		return awaitReceiver(session, session->bundleLength);
+	}
+
+	return 1;
+}
+
+int	sendBundleByTcpclSession(TcpclSession *session,
+		unsigned int bundleLength, Object bundleZco,
+		unsigned char *buffer)
+{
+	Sdr	sdr = getIonsdr();
+	int	resumptions = 0;
+	int	bytesSent;
+	int	result;
+
+	pthread_mutex_lock(&session->mutex);
+	if (bundleLength == 0)		/*	Just a keep-alive.	*/
+	{
+		if (session->bundleSocket == -1
+		&& connectSession(session, buffer) == 0)
+		{
+			pthread_mutex_unlock(&session->mutex);
+			return handleTcpFailure(session->socketName, 0);
+		}
+
+		buffer[0] = TCPCLA_TYPE_KEEP_AL << 4;
+		bytesSent = sendBytesByTCP(&session->bundleSocket,
+				(char *) buffer, 1, session->socketName);
+		pthread_mutex_unlock(&session->mutex);
+		if (bytesSent < 0)
+		{
+			putErrmsg("Failed to send by TCP.", NULL);
+			return -1;
+		}
+
+		if (session->bundleSocket == -1)
+		{
+			writeMemo("[?] Lost connection to CLI; keep-alive \
+not sent.");
+			return handleTcpFailure(session->socketName, 0);
+		}
+
+		return 1;	/*	Impossible length; means "OK".	*/
+	}
+
+	session->bundleZco = bundleZco;
+	session->bundleLength = bundleLength;
+	session->bytesSent = 0;
+	session->bytesAcked = 0;
+	session->resumeReply = 0;
+	while (1)
+	{
+		result = transmitBundle(session, buffer);
+		if (result != 0)
+		{
+			break;
+		}
+
+		/*	Connection lost.  Resume the bundle on a new
+		 *	connection if some of it was sent and the
+		 *	remote CLI can resume it.			*/
+
+		if (session->bytesSent == 0
+		|| resumptions == TCPCLA_RESUME_LIMIT
+		|| (session->flags & TCPCLA_FLAG_RESUME) == 0)
+		{
+			break;
+		}
+
+		resumptions++;
+		pthread_mutex_unlock(&session->mutex);
+		snooze(1);
+		pthread_mutex_lock(&session->mutex);
+	}
+
+	session->bundleZco = 0;
+	pthread_mutex_unlock(&session->mutex);
+	if (result < 0)
+	{
+		putErrmsg("Failed to send by TCP.", NULL);
+		return -1;
+	}
+
+	if (result == 0)
+	{
+		writeMemo("[?] Lost connection to CLI; bundle not sent.");
+		return handleTcpFailure(session->socketName, bundleZco);
+	}
+
+	if (bpHandleXmitSuccess(bundleZco, 0) < 0)
+	{
+		putErrmsg("Can't handle xmit success.", NULL);
+		return -1;
+	}
+
+	CHKERR(sdr_begin_xn(sdr));
+	zco_destroy(sdr, bundleZco);
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't destroy bundle ZCO.", NULL);
+		return -1;
+	}
+
+	return bundleLength;
+}
+
+int	sendAckSegment(int *bundleSocket, uvast bytesAcquired)
+{
+	char	buffer[1 + sizeof(uvast) + 3];
+	Sdnv	lengthField;
+
+	buffer[0] = TCPCLA_TYPE_ACK << 4;
+	encodeSdnv(&lengthField, bytesAcquired);
+	memcpy(buffer + 1, lengthField.text, lengthField.length);
+	return sendBufferByTCP(bundleSocket, buffer, 1 + lengthField.length,
+			0);
+}
+
+static int	receiveSdnvByTCP(int bundleSocket, uvast *value)
+{
+	unsigned char	field[10];
+	int		length = 0;
+	int		result;
+
+	do
+	{
+		if (length == sizeof field)
+		{
+			putErrmsg("TCPCL SDNV is too long.", NULL);
+			return -1;
+		}
+
+		result = receiveBytesByTCP(bundleSocket, (char *) field
+				+ length, 1);
+		if (result < 1)
+		{
+			return result;
+		}
+
+		length++;
+	} while (field[length - 1] & 0x80);
+
+	if (decodeSdnv(value, field) == 0)
+	{
+		putErrmsg("The Sdnv doesn't fit into a 64-bit variable.", NULL);
+		return -1;
+	}
+
+	return 1;
+}
+
+static int	replyToSession(TcpclSession *session, int bundleSocket,
+			int segmentType, uvast bytesAcquired)
+{
+	int	result = 0;
+	char	refusal = TCPCLA_TYPE_REF_BUN << 4;
+
+	pthread_mutex_lock(&session->mutex);
+	if (session->bundleSocket == bundleSocket)
+	{
+		if (segmentType == TCPCLA_TYPE_ACK)
+		{
+			result = sendAckSegment(&session->bundleSocket,
+					bytesAcquired);
+		}
+		else
+		{
+			result = sendBufferByTCP(&session->bundleSocket,
+					&refusal, 1, 0);
+		}
+	}
+
+	pthread_mutex_unlock(&session->mutex);
+	return result;
+}
+
+static void	noteReply(TcpclSession *session, int segmentType,
+			uvast bytesAcked)
+{
+	pthread_mutex_lock(&session->mutex);
+	if (session->bundleZco != 0)
+	{
+		if (bytesAcked > session->bundleLength)
+		{
+			bytesAcked = session->bundleLength;
+		}
+
+		if (session->resumeReply == -1)
+		{
+			session->resumeReply = segmentType;
+			if (segmentType == TCPCLA_TYPE_ACK)
+			{
+				session->bytesAcked = bytesAcked;
+			}
+		}
+		else if (segmentType == TCPCLA_TYPE_ACK
+		&& bytesAcked > session->bytesAcked)
+		{
+			session->bytesAcked = bytesAcked;
+		}
+
+		pthread_cond_broadcast(&session->ackArrived);
+	}
+
+	pthread_mutex_unlock(&session->mutex);
+}
+
+int	receiveBundleByTcpclSession(TcpclSession *session, AcqWorkArea *work,
+		char *buffer)
+{
+	int		bundleSocket = session->bundleSocket;
+	unsigned char	header;
+	int		segmentType;
+	int		flags;
+	uvast		segmentLength;
+	uvast		bytesAcquired = 0;
+	int		acquiring = 0;
+	int		bytesToReceive;
+	int		result;
+
+	/*	Returns the length of the bundle acquired, 0 if the
+	 *	connection was closed or the remote CLI shut the
+	 *	session down, -1 on any error.  Acknowledgments of
+	 *	segments sent on this session are noted as they
+	 *	arrive.							*/
+
+	while (1)
+	{
+		result = receiveBytesByTCP(bundleSocket, (char *) &header, 1);
+		if (result < 1)
+		{
+			return result;
+		}
+
+		segmentType = (header & 0xf0) >> 4;
+		flags = header & 0x0f;
+		switch (segmentType)
+		{
+		case TCPCLA_TYPE_DATA:
+			result = receiveSdnvByTCP(bundleSocket, &segmentLength);
+			if (result < 1)
+			{
+				return result;
+			}
+
+			if (flags & TCPCLA_SEG_START)
+			{
+				if (acquiring)
+				{
+					putErrmsg("Flags are not set correctly.",
+							NULL);
+					return -1;
+				}
+
+				acquiring = 1;
+			}
+			else if (!acquiring)
+			{
+				/*	A request to resume a bundle.  No
+				 *	partially received bundle is kept
+				 *	by a session, so it is refused.	*/
+
+				if (segmentLength != 0)
+				{
+					putErrmsg("Flags are not set correctly.",
+							NULL);
+					return -1;
+				}
+
+				if (replyToSession(session, bundleSocket,
+						TCPCLA_TYPE_REF_BUN, 0) < 0)
+				{
+					return -1;
+				}
+
+				continue;
+			}
+
+			while (segmentLength > 0)
+			{
+				bytesToReceive = TCPCLA_BUFSZ;
+				if (bytesToReceive > segmentLength)
+				{
+					bytesToReceive = segmentLength;
+				}
+
+				result = receiveBytesByTCP(bundleSocket,
+						buffer, bytesToReceive);
+				if (result < 1)
+				{
+					return result;
+				}
+
+				if (bpContinueAcq(work, buffer, result) < 0)
+				{
+					return -1;
+				}
+
+				segmentLength -= result;
+				bytesAcquired += result;
+			}
+
+			if (session->flags & TCPCLA_FLAG_ACK)
+			{
+				if (replyToSession(session, bundleSocket,
+						TCPCLA_TYPE_ACK, bytesAcquired)
+						< 0)
+				{
+					return -1;
+				}
+			}
+
+			if (flags & TCPCLA_SEG_END)
+			{
+				return bytesAcquired;
+			}
+
+			continue;
+
+		case TCPCLA_TYPE_ACK:
+			result = receiveSdnvByTCP(bundleSocket, &segmentLength);
+			if (result < 1)
+			{
+				return result;
+			}
+
+			noteReply(session, TCPCLA_TYPE_ACK, segmentLength);
+			continue;
+
+		case TCPCLA_TYPE_REF_BUN:
+			noteReply(session, TCPCLA_TYPE_REF_BUN, 0);
+			continue;
+
+		case TCPCLA_TYPE_KEEP_AL:
+			continue;
+
+		case TCPCLA_TYPE_SHUT_DN:
+			writeMemo("[i] TCPCL Received Shutdown message.");
+			return 0;
+
+		default:
+			putErrmsg("Unknown TCPCL segment type.",
+					itoa(segmentType));
+			return -1;
+		}
+	}
+}
@@ -31,6 +31,23 @@ extern "C" {
 #define TCPCLA_BUFSZ		(1024 * 1024)
 #endif
 #define TCPCLA_BUFSZ		(64 * 1024)
+
+/*	Where sendfile() is available, file-backed ZCO extents are
+ *	sent directly from the file to the socket, without being
+ *	copied into user space.						*/
+
+#if defined (linux) && !defined (TCPCLA_NO_SENDFILE)
+#include <sys/sendfile.h>
+#define	TCPCLA_SENDFILE
+#endif
+
+#ifndef TCPCLA_IOV_MAX
+#define	TCPCLA_IOV_MAX		(16)
+#endif
+
+#ifndef TCPCLA_SENDFILE_MAX
+#define	TCPCLA_SENDFILE_MAX	(1024 * 1024 * 1024)
+#endif
 #define BpTcpDefaultPortNbr	4556
 
 #define	DEFAULT_TCP_RATE	-1
@@ -40,6 +57,10 @@ extern "C" {
 #define TCPCLA_MAGIC_SIZE	4
 #define TCPCLA_ID_VERSION	0x03
 #define TCPCLA_FLAGS		0x00
+#define TCPCLA_FLAG_ACK		0x01
+#define TCPCLA_FLAG_RESUME	0x80	/*	ION-specific.		*/
+#define TCPCLA_SEG_START	0x02
+#define TCPCLA_SEG_END		0x01
 #define TCPCLA_TYPE_DATA	0x01
 #define TCPCLA_TYPE_ACK		0x02
 #define TCPCLA_TYPE_REF_BUN	0x03
@@ -62,9 +83,67 @@ extern "C" {
 #define KEEPALIVE_PERIOD	(15)
 #endif
 
+/*	A TCPCL session sends each bundle in data segments of at most
+ *	TCPCLA_SEGMENT_SIZE bytes.  When both ends of the session ask
+ *	for segment acknowledgment, the sender keeps sending segments
+ *	until TCPCLA_ACK_WINDOW segments of the bundle are
+ *	unacknowledged and infers loss of the connection if no
+ *	acknowledgment arrives within TCPCLA_ACK_TIMEOUT seconds.
+ *	When both ends also set TCPCLA_FLAG_RESUME, a bit of the
+ *	contact header flags that RFC 7242 reserves and only ION
+ *	sets, a bundle whose transmission is cut off by loss of the
+ *	connection is resumed from the last byte the receiver
+ *	reports having acquired, on up to TCPCLA_RESUME_LIMIT
+ *	successive new connections.  The resumption exchange is not
+ *	part of TCPCL, so it is never negotiated by the RFC 7242
+ *	reactive fragmentation flag.					*/
+
+#ifndef TCPCLA_SEGMENT_SIZE
+#define	TCPCLA_SEGMENT_SIZE	(256 * 1024)
+#endif
+
+#ifndef TCPCLA_ACK_WINDOW
+#define	TCPCLA_ACK_WINDOW	(8)
+#endif
+
+#ifndef TCPCLA_ACK_TIMEOUT
+#define	TCPCLA_ACK_TIMEOUT	(30)
+#endif
+
+#ifndef TCPCLA_RESUME_LIMIT
+#define	TCPCLA_RESUME_LIMIT	(3)
+#endif
+
+/*	When a non-blocking socket's send buffer is full, as when an
+ *	induct acknowledges segments or shuts down a connection on
+ *	which the peer isn't reading, writing is retried for up to
+ *	TCPCLA_SEND_TIMEOUT seconds before the write fails.		*/
+
+#ifndef TCPCLA_SEND_TIMEOUT
+#define	TCPCLA_SEND_TIMEOUT	(30)
+#endif
+
+typedef struct
+{
+	struct sockaddr	*socketName;
+	int		connectionNbr;
+	int		bundleSocket;
+	int		keepalivePeriod;
+	int		flags;		/*	Negotiated contact flags.	*/
+	unsigned int	segmentSize;
+	pthread_mutex_t	mutex;		/*	Serializes transmission.*/
+	pthread_cond_t	ackArrived;
+	Object		bundleZco;	/*	In transit, if any.	*/
+	unsigned int	bundleLength;
+	unsigned int	bytesSent;	/*	Of bundle in transit.	*/
+	unsigned int	bytesAcked;	/*	Of bundle in transit.	*/
+	int		resumeReply;	/*	Segment type, or 0.	*/
+} TcpclSession;
+
 extern int	tcpDelayEnabled;
 extern int	tcpDelayNsecPerByte;
 extern int	tcpDesiredKeepAlivePeriod;
+extern int	tcpclContactFlags;
 
 extern int	_tcpOutductId(struct sockaddr *sn, char *protocolName,
 			char *ductName);
@@ -79,6 +158,17 @@ extern int	sendBundleByTCPCL(struct sockaddr *socketName,
 			int *bundleSocket, unsigned int bundleLength,
 			Object bundleZco, unsigned char *buffer,
 			int *keepalivePeriod);
+extern int	tcpclInitSession(TcpclSession *session,
+			struct sockaddr *socketName, int connectionNbr,
+			unsigned int segmentSize);
+extern void	tcpclCloseSession(TcpclSession *session);
+extern void	tcpclDestroySession(TcpclSession *session);
+extern int	sendBundleByTcpclSession(TcpclSession *session,
+			unsigned int bundleLength, Object bundleZco,
+			unsigned char *buffer);
+extern int	receiveBundleByTcpclSession(TcpclSession *session,
+			AcqWorkArea *work, char *buffer);
+extern int	sendAckSegment(int *bundleSocket, uvast bytesAcquired);
 extern int	receiveBytesByTCP(int bundleSocket, char *into, int length);
 extern int	receiveBundleByTcp(int bundleSocket, AcqWorkArea *work,
 			char *buffer);
@@ -87,7 +177,7 @@ extern int 	receiveSegmentByTcpCL(int bundleSocket,AcqWorkArea *work,char *buffe
 extern int 	sendContactHeader(int *bundleSocket, unsigned char *buffer,
 			struct sockaddr *socketName);
 extern int	receiveContactHeader(int *bundleSocket, unsigned char *buffer,
-			int *keepalivePeriod);
+			int *keepalivePeriod, int *flags);
 extern void	findVInduct(VInduct **vduct, char *protocolName);
 extern int 	sendShutDownMessage(int *bundleSocket, int reason, int delay,
 			struct sockaddr *socketName);
@@ -12,12 +12,47 @@
 									*/
 #include "tcpcla.h"
 
+/*	On Linux, tcpcli services all connections in a single thread
+ *	that multiplexes them by epoll, rather than in a receiver
+ *	thread (and a keepalive thread) per connection.  Compile with
+ *	-DTCPCLI_THREADED to retain the thread-per-connection design.	*/
+
+#if defined (linux) && !defined (TCPCLI_THREADED)
+#define	TCPCLI_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#ifndef TCPCLI_MAX_EVENTS
+#define	TCPCLI_MAX_EVENTS	(64)
+#endif
+
+/*	When reception of a bundle from a tcpclo session that offers
+ *	ION's bundle resumption is interrupted by loss of the
+ *	connection, the partially acquired bundle is retained for
+ *	TCPCLI_RESUME_INTERVAL seconds, in case the session resumes
+ *	the bundle on a new connection.					*/
+
+#ifndef TCPCLI_RESUME_INTERVAL
+#define	TCPCLI_RESUME_INTERVAL	(60)
+#endif
+
 static void	interruptThread()
 {
 	isignal(SIGTERM, interruptThread);
 	ionKillMainThread("tcpcli");
 }
 
+typedef struct
+{
+	VInduct			*vduct;
+	struct sockaddr		socketName;
+	struct sockaddr_in	*inetName;
+	int			ductSocket;
+	int			running;
+} AccessThreadParms;
+
+#ifndef TCPCLI_EPOLL
+
 /*	*	*	Keepalive thread function	*	*	*/
 
 typedef struct
@@ -209,7 +244,7 @@ static void	*receiveBundles(void *parm)
 
 	pthread_mutex_unlock(parms->mutex);
 	if (receiveContactHeader(&parms->bundleSocket, (unsigned char *) buffer,
-			&kparms->keepalivePeriod) < 0)
+			&kparms->keepalivePeriod, NULL) < 0)
 	{
 		putErrmsg("tcpcli couldn't receive contact header", NULL);
 		MRELEASE(buffer);
@@ -313,15 +348,6 @@ keepalives", NULL);
 
 /*	*	*	Access thread functions	*	*	*	*/
 
-typedef struct
-{
-	VInduct			*vduct;
-	struct sockaddr		socketName;
-	struct sockaddr_in	*inetName;
-	int			ductSocket;
-	int			running;
-} AccessThreadParms;
-
 static void	*spawnReceivers(void *parm)
 {
 	/*	Main loop for acceptance of connections and
@@ -464,6 +490,871 @@ thread", NULL);
 	return NULL;
 }
 
+#else	/*	Event-driven reception.				*/
+
+/*	*	*	Connection functions	*	*	*	*/
+
+typedef enum
+{
+	TcpclContactHeader = 0,
+	TcpclEidLength,
+	TcpclEid,
+	TcpclSegmentType,
+	TcpclSegmentLength,
+	TcpclSegmentData
+} TcpclParseState;
+
+typedef struct
+{
+	int		bundleSocket;
+	struct sockaddr	cloSocketName;
+	char		senderEidBuffer[SDRSTRING_BUFSZ];
+	char		*senderEid;
+	char		peerEid[SDRSTRING_BUFSZ];
+	int		peerEidLength;
+	AcqWorkArea	*work;
+	int		acquiring;	/*	Boolean			*/
+	int		resuming;	/*	Boolean			*/
+	uvast		bytesAcquired;	/*	Of current bundle.	*/
+	TcpclParseState	state;
+	unsigned char	field[10];	/*	Partial header field.	*/
+	int		fieldLength;
+	int		flags;		/*	Negotiated.		*/
+	int		segmentType;
+	int		segmentFlags;
+	uvast		bytesRemaining;	/*	Of EID or segment.	*/
+	int		keepalivePeriod;
+	time_t		lastKeepalive;
+	LystElt		elt;
+} TcpclConnection;
+
+typedef struct
+{
+	char		peerEid[SDRSTRING_BUFSZ];
+	AcqWorkArea	*work;
+	uvast		bytesAcquired;
+	time_t		suspendTime;
+} TcpclSuspension;
+
+typedef struct
+{
+	VInduct		*vduct;
+	int		ductSocket;
+	int		*cliRunning;
+	int		epollFd;
+	Lyst		connections;
+	Lyst		suspensions;
+	char		*buffer;
+} ServiceParms;
+
+/*	*	*	Suspension functions	*	*	*	*/
+
+static void	endSuspension(LystElt elt, int cancel)
+{
+	TcpclSuspension	*susp = (TcpclSuspension *) lyst_data(elt);
+
+	if (cancel)
+	{
+		bpCancelAcq(susp->work);
+		bpReleaseAcqArea(susp->work);
+	}
+
+	lyst_delete(elt);
+	MRELEASE(susp);
+}
+
+static LystElt	findSuspension(ServiceParms *sp, char *peerEid)
+{
+	LystElt		elt;
+	TcpclSuspension	*susp;
+
+	for (elt = lyst_first(sp->suspensions); elt; elt = lyst_next(elt))
+	{
+		susp = (TcpclSuspension *) lyst_data(elt);
+		if (strcmp(susp->peerEid, peerEid) == 0)
+		{
+			return elt;
+		}
+	}
+
+	return NULL;
+}
+
+static int	suspendAcquisition(ServiceParms *sp, TcpclConnection *conn)
+{
+	TcpclSuspension	*susp;
+	LystElt		elt;
+
+	/*	Only the latest interrupted bundle from any single
+	 *	session is retained.					*/
+
+	elt = findSuspension(sp, conn->peerEid);
+	if (elt)
+	{
+		endSuspension(elt, 1);
+	}
+
+	susp = (TcpclSuspension *) MTAKE(sizeof(TcpclSuspension));
+	if (susp == NULL)
+	{
+		return -1;
+	}
+
+	istrcpy(susp->peerEid, conn->peerEid, sizeof susp->peerEid);
+	susp->work = conn->work;
+	susp->bytesAcquired = conn->bytesAcquired;
+	susp->suspendTime = getUTCTime();
+	if (lyst_insert_last(sp->suspensions, susp) == NULL)
+	{
+		MRELEASE(susp);
+		return -1;
+	}
+
+	conn->work = NULL;
+	conn->acquiring = 0;
+	writeMemoNote("[i] tcpcli suspended acquisition of bundle at byte",
+			utoa(susp->bytesAcquired));
+	return 0;
+}
+
+static void	expireSuspensions(ServiceParms *sp)
+{
+	time_t		currentTime = getUTCTime();
+	LystElt		elt;
+	LystElt		nextElt;
+	TcpclSuspension	*susp;
+
+	for (elt = lyst_first(sp->suspensions); elt; elt = nextElt)
+	{
+		nextElt = lyst_next(elt);
+		susp = (TcpclSuspension *) lyst_data(elt);
+		if (currentTime - susp->suspendTime > TCPCLI_RESUME_INTERVAL)
+		{
+			writeMemo("[?] tcpcli discarded interrupted bundle.");
+			endSuspension(elt, 1);
+		}
+	}
+}
+
+static int	resumeAcquisition(ServiceParms *sp, TcpclConnection *conn)
+{
+	LystElt		elt;
+	TcpclSuspension	*susp;
+	char		refusal = TCPCLA_TYPE_REF_BUN << 4;
+
+	/*	The remote CLO asks to resume the bundle it was
+	 *	sending when its prior connection was lost.  The
+	 *	reply is an acknowledgment of all bytes of that
+	 *	bundle acquired so far or, if the bundle wasn't
+	 *	retained, refusal of the bundle.			*/
+
+	conn->resuming = 0;
+	elt = findSuspension(sp, conn->peerEid);
+	if (elt == NULL)
+	{
+		if (sendBytesByTCP(&conn->bundleSocket, &refusal, 1, NULL)
+				< 1)
+		{
+			putErrmsg("tcpcli can't refuse bundle.", NULL);
+			return -1;
+		}
+
+		return 0;
+	}
+
+	susp = (TcpclSuspension *) lyst_data(elt);
+	bpReleaseAcqArea(conn->work);
+	conn->work = susp->work;
+	conn->bytesAcquired = susp->bytesAcquired;
+	conn->acquiring = 1;
+	endSuspension(elt, 0);
+	writeMemoNote("[i] tcpcli resuming acquisition of bundle at byte",
+			utoa(conn->bytesAcquired));
+	if (sendAckSegment(&conn->bundleSocket, conn->bytesAcquired) < 1)
+	{
+		return -1;
+	}
+
+	return 0;
+}
+
+static void	closeConnection(ServiceParms *sp, TcpclConnection *conn,
+			int sendShutdown)
+{
+	if (sendShutdown)
+	{
+		if (sendShutDownMessage(&conn->bundleSocket, SHUT_DN_NO, -1,
+				NULL) < 0)
+		{
+			putErrmsg("Sending Shutdown message failed!!", NULL);
+		}
+	}
+
+	if (conn->bundleSocket != -1)
+	{
+		oK(epoll_ctl(sp->epollFd, EPOLL_CTL_DEL, conn->bundleSocket,
+				NULL));
+		closesocket(conn->bundleSocket);
+	}
+
+	if (conn->acquiring)
+	{
+		if ((conn->flags & TCPCLA_FLAG_RESUME) == 0
+		|| conn->bytesAcquired == 0 || conn->peerEidLength == 0
+		|| suspendAcquisition(sp, conn) < 0)
+		{
+			bpCancelAcq(conn->work);
+		}
+	}
+
+	if (conn->work)
+	{
+		bpReleaseAcqArea(conn->work);
+	}
+
+	lyst_delete(conn->elt);
+	MRELEASE(conn);
+	writeErrmsgMemos();
+	writeMemo("[i] tcpcli connection closed.");
+}
+
+static int	openConnection(ServiceParms *sp, int newSocket,
+			struct sockaddr *cloSocketName)
+{
+	TcpclConnection		*conn;
+	struct sockaddr_in	*fromAddr;
+	unsigned int		hostNbr;
+	char			hostName[MAXHOSTNAMELEN + 1];
+	struct epoll_event	event;
+
+	conn = (TcpclConnection *) MTAKE(sizeof(TcpclConnection));
+	if (conn == NULL)
+	{
+		closesocket(newSocket);
+		putErrmsg("tcpcli can't allocate for new connection", NULL);
+		return -1;
+	}
+
+	memset((char *) conn, 0, sizeof(TcpclConnection));
+	conn->bundleSocket = newSocket;
+	conn->cloSocketName = *cloSocketName;
+	fromAddr = (struct sockaddr_in *) cloSocketName;
+	memcpy((char *) &hostNbr, (char *) &(fromAddr->sin_addr.s_addr), 4);
+	hostNbr = ntohl(hostNbr);
+	printDottedString(hostNbr, hostName);
+	conn->senderEid = conn->senderEidBuffer;
+	getSenderEid(&(conn->senderEid), hostName);
+	conn->work = bpGetAcqArea(sp->vduct);
+	if (conn->work == NULL)
+	{
+		closesocket(newSocket);
+		MRELEASE(conn);
+		putErrmsg("tcpcli can't get acquisition work area", NULL);
+		return -1;
+	}
+
+	conn->elt = lyst_insert_last(sp->connections, conn);
+	if (conn->elt == NULL)
+	{
+		closesocket(newSocket);
+		bpReleaseAcqArea(conn->work);
+		MRELEASE(conn);
+		putErrmsg("tcpcli can't allocate lyst element for new \
+connection", NULL);
+		return -1;
+	}
+
+	/*	The contact header is sent while the socket is still
+	 *	blocking; thereafter all reception is non-blocking.	*/
+
+	if (sendContactHeader(&conn->bundleSocket,
+			(unsigned char *) sp->buffer, NULL) < 0)
+	{
+		putErrmsg("tcpcli couldn't send contact header", NULL);
+		closeConnection(sp, conn, 0);
+		return 0;		/*	Not a CLI failure.	*/
+	}
+
+	event.events = EPOLLIN;
+	event.data.ptr = conn;
+	if (fcntl(newSocket, F_SETFL, fcntl(newSocket, F_GETFL) | O_NONBLOCK)
+			< 0
+	|| epoll_ctl(sp->epollFd, EPOLL_CTL_ADD, newSocket, &event) < 0)
+	{
+		putSysErrmsg("tcpcli can't poll new connection", NULL);
+		closeConnection(sp, conn, 0);
+		return -1;
+	}
+
+	conn->lastKeepalive = getUTCTime();
+	return 0;
+}
+
+static int	parseField(TcpclConnection *conn, unsigned char byte,
+			uvast *value)
+{
+	/*	Accumulates the bytes of an SDNV, returning 1 when
+	 *	the SDNV is complete, 0 if it is not yet complete.	*/
+
+	if (conn->fieldLength == sizeof conn->field)
+	{
+		putErrmsg("TCPCL SDNV is too long.", NULL);
+		return -1;
+	}
+
+	conn->field[conn->fieldLength] = byte;
+	conn->fieldLength++;
+	if (byte & 0x80)
+	{
+		return 0;		/*	More bytes to come.	*/
+	}
+
+	conn->fieldLength = 0;
+	if (decodeSdnv(value, conn->field) == 0)
+	{
+		putErrmsg("The Sdnv doesn't fit into a 64-bit variable.", NULL);
+		return -1;
+	}
+
+	return 1;
+}
+
+static int	parseContactHeader(TcpclConnection *conn)
+{
+	uint16_t	requestedKeepalive;
+
+	if (memcmp(conn->field, TCPCLA_MAGIC, TCPCLA_MAGIC_SIZE) != 0)
+	{
+		putErrmsg("Didnt receive contact header magic.", NULL);
+		return -1;
+	}
+
+	if (conn->field[4] < TCPCLA_ID_VERSION)
+	{
+		putErrmsg("Lower version than current version.", NULL);
+		return -1;
+	}
+
+	conn->flags = conn->field[5] & tcpclContactFlags;
+	memcpy((char *) &requestedKeepalive, conn->field + 6, 2);
+	requestedKeepalive = ntohs(requestedKeepalive);
+	conn->keepalivePeriod = MIN(requestedKeepalive,
+			tcpDesiredKeepAlivePeriod);
+	conn->fieldLength = 0;
+	conn->state = TcpclEidLength;
+	return 0;
+}
+
+static int	parseSegmentType(ServiceParms *sp, TcpclConnection *conn,
+			unsigned char byte)
+{
+	LystElt	elt;
+
+	conn->segmentType = (byte & 0xf0) >> 4;
+	conn->segmentFlags = byte & 0x0f;
+	switch (conn->segmentType)
+	{
+	case TCPCLA_TYPE_DATA:
+		if (conn->segmentFlags & TCPCLA_SEG_START)
+		{
+			if (conn->acquiring)
+			{
+				putErrmsg("Flags are not set correctly.", NULL);
+				return -1;
+			}
+
+			/*	A new bundle from a session abandons
+			 *	any bundle it was sending before.	*/
+
+			if (conn->peerEidLength > 0
+			&& (elt = findSuspension(sp, conn->peerEid)) != NULL)
+			{
+				endSuspension(elt, 1);
+			}
+
+			if (bpBeginAcq(conn->work, 0, conn->senderEid) < 0)
+			{
+				putErrmsg("Can't begin acquisition of bundle.",
+						NULL);
+				return -2;
+			}
+
+			conn->acquiring = 1;
+			conn->bytesAcquired = 0;
+		}
+		else if (!conn->acquiring)
+		{
+			if ((conn->flags & TCPCLA_FLAG_RESUME) == 0)
+			{
+				putErrmsg("Flags are not set correctly.", NULL);
+				return -1;
+			}
+
+			conn->resuming = 1;
+		}
+
+		conn->state = TcpclSegmentLength;
+		return 0;
+
+	case TCPCLA_TYPE_ACK:
+		putErrmsg("Received ACK_SEGMENT. Unexpected Segment.", NULL);
+		conn->state = TcpclSegmentLength;
+		return 0;
+
+	case TCPCLA_TYPE_REF_BUN:
+		putErrmsg("Received Refuse Bundle.", NULL);
+		return 0;
+
+	case TCPCLA_TYPE_KEEP_AL:
+		return 0;
+
+	case TCPCLA_TYPE_SHUT_DN:
+		writeMemo("[i] TCPCL Received Shutdown message.");
+		return 1;
+
+	default:
+		putErrmsg("Unknown TCPCL segment type.",
+				itoa(conn->segmentType));
+		return -1;
+	}
+}
+
+static int	endSegment(TcpclConnection *conn)
+{
+	conn->state = TcpclSegmentType;
+	if (conn->segmentType == TCPCLA_TYPE_DATA
+	&& (conn->flags & TCPCLA_FLAG_ACK))
+	{
+		if (sendAckSegment(&conn->bundleSocket, conn->bytesAcquired)
+				< 1)
+		{
+			putErrmsg("tcpcli can't acknowledge segment.", NULL);
+			return -1;
+		}
+	}
+
+	if (conn->segmentType == TCPCLA_TYPE_DATA
+	&& (conn->segmentFlags & TCPCLA_SEG_END))
+	{
+		conn->acquiring = 0;
+		if (bpEndAcq(conn->work) < 0)
+		{
+			putErrmsg("Can't end acquisition of bundle.", NULL);
+			return -2;
+		}
+	}
+
+	return 0;
+}
+
+static int	acquireBytes(ServiceParms *sp, TcpclConnection *conn,
+			char *bytes, int length)
+{
+	unsigned char	byte;
+	int		result;
+	int		bytesToAcquire;
+
+	/*	Returns 0 normally, 1 on receiving a shutdown message,
+	 *	-1 if the connection must be closed because of an
+	 *	error, -2 on any failure that must stop the CLI.	*/
+
+	while (length > 0)
+	{
+		if (conn->state == TcpclSegmentData || conn->state == TcpclEid)
+		{
+			bytesToAcquire = length;
+			if (bytesToAcquire > conn->bytesRemaining)
+			{
+				bytesToAcquire = conn->bytesRemaining;
+			}
+
+			if (conn->state == TcpclSegmentData
+			&& conn->segmentType == TCPCLA_TYPE_DATA)
+			{
+				if (bpContinueAcq(conn->work, bytes,
+						bytesToAcquire) < 0)
+				{
+					putErrmsg("Can't acquire bundle.",
+							NULL);
+					return -1;
+				}
+
+				conn->bytesAcquired += bytesToAcquire;
+			}
+			else if (conn->state == TcpclEid)
+			{
+				/*	Retain as much of the EID as
+				 *	fits, to identify the session.	*/
+
+				if (bytesToAcquire < sizeof conn->peerEid
+						- conn->peerEidLength)
+				{
+					memcpy(conn->peerEid
+						+ conn->peerEidLength,
+						bytes, bytesToAcquire);
+					conn->peerEidLength += bytesToAcquire;
+				}
+			}
+
+			bytes += bytesToAcquire;
+			length -= bytesToAcquire;
+			conn->bytesRemaining -= bytesToAcquire;
+			if (conn->bytesRemaining > 0)
+			{
+				continue;
+			}
+
+			if (conn->state == TcpclEid)
+			{
+				conn->state = TcpclSegmentType;
+				continue;
+			}
+
+			result = endSegment(conn);
+			if (result < 0)
+			{
+				return result;
+			}
+
+			continue;
+		}
+
+		byte = *((unsigned char *) bytes);
+		bytes++;
+		length--;
+		switch (conn->state)
+		{
+		case TcpclContactHeader:
+			conn->field[conn->fieldLength] = byte;
+			conn->fieldLength++;
+			if (conn->fieldLength == TCPCLA_MAGIC_SIZE + 4)
+			{
+				if (parseContactHeader(conn) < 0)
+				{
+					return -1;
+				}
+			}
+
+			continue;
+
+		case TcpclEidLength:
+			result = parseField(conn, byte, &conn->bytesRemaining);
+			if (result < 0)
+			{
+				return -1;
+			}
+
+			if (result > 0)
+			{
+				conn->state = (conn->bytesRemaining > 0 ?
+					TcpclEid : TcpclSegmentType);
+			}
+
+			continue;
+
+		case TcpclSegmentType:
+			result = parseSegmentType(sp, conn, byte);
+			if (result != 0)
+			{
+				return result;
+			}
+
+			continue;
+
+		case TcpclSegmentLength:
+			result = parseField(conn, byte, &conn->bytesRemaining);
+			if (result < 0)
+			{
+				return -1;
+			}
+
+			if (result == 0)
+			{
+				continue;
+			}
+
+			if (conn->segmentType != TCPCLA_TYPE_DATA)
+			{
+				/*	Only acknowledged length.	*/
+
+				conn->state = TcpclSegmentType;
+				continue;
+			}
+
+			if (conn->resuming)
+			{
+				if (conn->bytesRemaining != 0)
+				{
+					putErrmsg("Flags are not set correctly.",
+							NULL);
+					return -1;
+				}
+
+				conn->state = TcpclSegmentType;
+				if (resumeAcquisition(sp, conn) < 0)
+				{
+					return -1;
+				}
+
+				continue;
+			}
+
+			conn->state = TcpclSegmentData;
+			if (conn->bytesRemaining == 0)
+			{
+				result = endSegment(conn);
+				if (result < 0)
+				{
+					return result;
+				}
+			}
+
+			continue;
+
+		default:
+			putErrmsg("Invalid TCPCL parse state.",
+					itoa(conn->state));
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int	receiveFromConnection(ServiceParms *sp, TcpclConnection *conn)
+{
+	int	bytesReceived;
+
+	bytesReceived = irecv(conn->bundleSocket, sp->buffer, TCPCLA_BUFSZ, 0);
+	if (bytesReceived < 0)
+	{
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+		{
+			return 0;	/*	Nothing to read yet.	*/
+		}
+
+		putSysErrmsg("TCPCL read() error on socket", NULL);
+		closeConnection(sp, conn, 0);
+		return 0;
+	}
+
+	if (bytesReceived == 0)		/*	Connection closed.	*/
+	{
+		closeConnection(sp, conn, 0);
+		return 0;
+	}
+
+	switch (acquireBytes(sp, conn, sp->buffer, bytesReceived))
+	{
+	case -2:
+		closeConnection(sp, conn, 0);
+		return -1;		/*	Must stop the CLI.	*/
+
+	case -1:
+	case 1:
+		closeConnection(sp, conn, 0);
+
+		/*	Intentional fall-through to next case.		*/
+
+	default:
+		return 0;
+	}
+}
+
+static void	sendKeepalives(ServiceParms *sp)
+{
+	time_t		currentTime = getUTCTime();
+	LystElt		elt;
+	LystElt		nextElt;
+	TcpclConnection	*conn;
+	char		keepalive = TCPCLA_TYPE_KEEP_AL << 4;
+
+	/*	A keepalive is sent on each connection whose contact
+	 *	header has been received, whenever the negotiated
+	 *	keepalive period has elapsed since the last one.	*/
+
+	for (elt = lyst_first(sp->connections); elt; elt = nextElt)
+	{
+		nextElt = lyst_next(elt);
+		conn = (TcpclConnection *) lyst_data(elt);
+		if (conn->state == TcpclContactHeader
+		|| conn->keepalivePeriod <= 0
+		|| currentTime - conn->lastKeepalive < conn->keepalivePeriod)
+		{
+			continue;
+		}
+
+		conn->lastKeepalive = currentTime;
+		if (isend(conn->bundleSocket, &keepalive, 1, 0) < 0
+		&& errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		{
+			writeMemo("[?] Lost connection to CLO; keep-alive \
+not sent.");
+			closeConnection(sp, conn, 0);
+		}
+	}
+}
+
+static void	*serviceConnections(void *parm)
+{
+	/*	Main loop for acceptance of connections and reception
+	 *	of bundles on all of them.				*/
+
+	AccessThreadParms	*atp = (AccessThreadParms *) parm;
+	char			*procName = "tcpcli";
+	ServiceParms		sp;
+	struct epoll_event	events[TCPCLI_MAX_EVENTS];
+	struct epoll_event	event;
+	int			eventCount;
+	int			newSocket;
+	struct sockaddr		cloSocketName;
+	socklen_t		nameLength;
+	time_t			lastTick = 0;
+	LystElt			elt;
+	int			i;
+
+	snooze(1);	/*	Let main thread become interruptable.	*/
+	memset((char *) &sp, 0, sizeof sp);
+	sp.vduct = atp->vduct;
+	sp.ductSocket = atp->ductSocket;
+	sp.cliRunning = &(atp->running);
+	sp.buffer = MTAKE(TCPCLA_BUFSZ);
+	sp.connections = lyst_create_using(getIonMemoryMgr());
+	sp.suspensions = lyst_create_using(getIonMemoryMgr());
+	sp.epollFd = epoll_create(TCPCLI_MAX_EVENTS);
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;		/*	Identifies duct socket.	*/
+	if (sp.buffer == NULL || sp.connections == NULL
+	|| sp.suspensions == NULL || sp.epollFd < 0
+	|| epoll_ctl(sp.epollFd, EPOLL_CTL_ADD, sp.ductSocket, &event) < 0)
+	{
+		putSysErrmsg("tcpcli can't start servicing connections", NULL);
+		ionKillMainThread(procName);
+		atp->running = 0;
+	}
+
+	/*	Can now begin accepting connections from remote
+	 *	contacts and receiving bundles on them.  On failure,
+	 *	take down the whole CLI.				*/
+
+	while (atp->running)
+	{
+		eventCount = epoll_wait(sp.epollFd, events, TCPCLI_MAX_EVENTS,
+				1000);
+		if (eventCount < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			putSysErrmsg("tcpcli epoll_wait() failed", NULL);
+			ionKillMainThread(procName);
+			atp->running = 0;
+			continue;
+		}
+
+		if (atp->running == 0)
+		{
+			break;	/*	Main thread has shut down.	*/
+		}
+
+		for (i = 0; i < eventCount && atp->running; i++)
+		{
+			if (events[i].data.ptr != NULL)
+			{
+				if (receiveFromConnection(&sp,
+						(TcpclConnection *)
+						events[i].data.ptr) < 0)
+				{
+					ionKillMainThread(procName);
+					atp->running = 0;
+				}
+
+				continue;
+			}
+
+			nameLength = sizeof(struct sockaddr);
+			newSocket = accept(sp.ductSocket, &cloSocketName,
+					&nameLength);
+			if (newSocket < 0)
+			{
+				putSysErrmsg("tcpcli accept() failed", NULL);
+				ionKillMainThread(procName);
+				atp->running = 0;
+				continue;
+			}
+
+			if (atp->running == 0)
+			{
+				closesocket(newSocket);
+				break;	/*	Main thread has shut down.	*/
+			}
+
+			if (openConnection(&sp, newSocket, &cloSocketName) < 0)
+			{
+				ionKillMainThread(procName);
+				atp->running = 0;
+			}
+		}
+
+		/*	Keepalives are driven by a one-second timer.	*/
+
+		if (getUTCTime() != lastTick)
+		{
+			lastTick = getUTCTime();
+			sendKeepalives(&sp);
+			expireSuspensions(&sp);
+		}
+
+		/*	Make sure other tasks have a chance to run.	*/
+
+		sm_TaskYield();
+	}
+
+	closesocket(atp->ductSocket);
+	writeErrmsgMemos();
+
+	/*	Shut down all current connections cleanly.		*/
+
+	if (sp.connections)
+	{
+		while ((elt = lyst_first(sp.connections)) != NULL)
+		{
+			closeConnection(&sp, (TcpclConnection *)
+					lyst_data(elt), 1);
+		}
+
+		lyst_destroy(sp.connections);
+	}
+
+	if (sp.suspensions)
+	{
+		while ((elt = lyst_first(sp.suspensions)) != NULL)
+		{
+			endSuspension(elt, 1);
+		}
+
+		lyst_destroy(sp.suspensions);
+	}
+
+	if (sp.epollFd >= 0)
+	{
+		close(sp.epollFd);
+	}
+
+	if (sp.buffer)
+	{
+		MRELEASE(sp.buffer);
+	}
+
+	writeErrmsgMemos();
+	writeMemo("[i] tcpcli access thread has ended.");
+	return NULL;
+}
+
+#endif	/*	TCPCLI_EPOLL					*/
+
 /*	*	*	Main thread functions	*	*	*	*/
 
 #if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
@@ -559,6 +1450,9 @@ int	main(int argc, char *argv[])
 	 * keep alive period it is 0	*/
 
 	tcpDesiredKeepAlivePeriod = KEEPALIVE_PERIOD;
+#ifdef TCPCLI_EPOLL
+	tcpclContactFlags = TCPCLA_FLAG_ACK | TCPCLA_FLAG_RESUME;
+#endif
 
 	if (atp.ductSocket < 0)
 	{
@@ -609,7 +1503,11 @@ int	main(int argc, char *argv[])
 	/*	Start the access thread.				*/
 
 	atp.running = 1;
+#ifdef TCPCLI_EPOLL
+	if (pthread_begin(&accessThread, NULL, serviceConnections, &atp))
+#else
 	if (pthread_begin(&accessThread, NULL, spawnReceivers, &atp))
+#endif
 	{
 		closesocket(atp.ductSocket);
 		putSysErrmsg("tcpcli can't create access thread", NULL);
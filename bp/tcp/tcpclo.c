@@ -3,8 +3,11 @@
 			daemon.  Note that this convergence-layer
 			output daemon is a "dedicated" CLO daemon
 			suitable only for a limited number of paths,
-			because it manages just a single TCP
-			connection.
+			because it manages only the TCP connections
+			to a single remote induct.  Bundles may be
+			sent on several such connections in parallel,
+			to fill a path whose bandwidth-delay product
+			exceeds a single TCP connection's window.
 
 			Promiscuous CLO daemons need to be based on
 			UDP, Dgr, etc.
@@ -21,6 +24,10 @@
 									*/
 #include "tcpcla.h"
 
+#ifndef TCPCLO_MAX_CONNECTIONS
+#define	TCPCLO_MAX_CONNECTIONS	(16)
+#endif
+
 static sm_SemId		tcpcloSemaphore(sm_SemId *semid)
 {
 	long		temp;
@@ -49,20 +56,27 @@ static void	shutDownClo()	/*	Commands CLO termination.	*/
 	sm_SemEnd(tcpcloSemaphore(NULL));
 }
 
-/*	*	*	Keepalive thread functions	*	*	*/
+/*	*	*	Connection structure	*	*	*	*/
 
 typedef struct
 {
 	int		*cloRunning;
-	pthread_mutex_t	*mutex;
-	struct sockaddr	*socketName;
-	int		*ductSocket;
-	int		*keepalivePeriod;
-} KeepaliveThreadParms;
+	VOutduct	*vduct;
+	Outflow		*outflows;
+	VInduct		*viduct;
+	TcpclSession	session;
+	pthread_t	keepaliveThread;
+	pthread_t	receiverThread;
+	pthread_t	senderThread;
+	int		threadsStarted;
+} CloConnection;
+
+/*	*	*	Keepalive thread functions	*	*	*/
 
 static void	*sendKeepalives(void *parm)
 {
-	KeepaliveThreadParms	*parms = (KeepaliveThreadParms *) parm;
+	CloConnection		*conn = (CloConnection *) parm;
+	TcpclSession		*session = &conn->session;
 	int			keepaliveTimer = 0;
 	int			bytesSent;
 	int			backoffTimer = BACKOFF_TIMER_START;
@@ -77,18 +91,18 @@ static void	*sendKeepalives(void *parm)
 	}
 
 	iblock(SIGTERM);
-	while (*(parms->cloRunning))
+	while (*(conn->cloRunning))
 	{
 		snooze(1);
 		keepaliveTimer++;
-		if (keepaliveTimer < *(parms->keepalivePeriod))
+		if (keepaliveTimer < session->keepalivePeriod)
 		{
 			continue;
 		}
 
 		// If the negotiated keep alive interval is 0, then
 		// keep alives will not be sent.
-		if(*(parms->keepalivePeriod) == 0)
+		if(session->keepalivePeriod == 0)
 		{
 			continue;
 		}
@@ -101,20 +115,17 @@ static void	*sendKeepalives(void *parm)
 		 *	attempt will not succeed (e.g., 3 seconds).	*/
 
 		keepaliveTimer = 0;
-		pthread_mutex_lock(parms->mutex);
-		bytesSent = sendBundleByTCPCL(parms->socketName,
-				parms->ductSocket, 0, 0, buffer, parms->keepalivePeriod);
-		pthread_mutex_unlock(parms->mutex);
+		bytesSent = sendBundleByTcpclSession(session, 0, 0, buffer);
 		/*	if the node is unable to establish a TCP connection,
  		 * 	the connection should be tried only after some delay.
  		 *								*/
 		if(bytesSent == 0)
 		{	
-			while((backoffTimerCount < backoffTimer) && (*(parms->ductSocket) < 0))
+			while((backoffTimerCount < backoffTimer) && (session->bundleSocket < 0))
 			{
 				snooze(1);
 				backoffTimerCount++;
-				if(!(*(parms->cloRunning)))
+				if(!(*(conn->cloRunning)))
 				{
 					break;
 				}
@@ -125,7 +136,7 @@ static void	*sendKeepalives(void *parm)
 			 *	That way at the end of backoff period a 
 			 *	keepalive is sent
 			 *							*/
-			keepaliveTimer = *(parms->keepalivePeriod);
+			keepaliveTimer = session->keepalivePeriod;
 
 			if(backoffTimer < BACKOFF_TIMER_LIMIT)
 			{
@@ -145,20 +156,13 @@ static void	*sendKeepalives(void *parm)
 }
 
 /*	*	*	Receiver thread functions	*	*	*/
-typedef struct
-{
-	int		*cloRunning;
-	pthread_mutex_t	*mutex;
-	int		*bundleSocket;
-	VInduct		*vduct;
-} ReceiveThreadParms;
-
 
 static void	*receiveBundles(void *parm)
 {
 	/*	Main loop for bundle reception thread	*/
 
-	ReceiveThreadParms	*parms = (ReceiveThreadParms *) parm;
+	CloConnection		*conn = (CloConnection *) parm;
+	TcpclSession		*session = &conn->session;
 	int			threadRunning = 1;
 	AcqWorkArea		*work;
 	char			*buffer;
@@ -170,7 +174,7 @@ static void	*receiveBundles(void *parm)
 		return NULL;
 	}
 
-	work = bpGetAcqArea(parms->vduct);
+	work = bpGetAcqArea(conn->viduct);
 	if (work == NULL)
 	{
 		putErrmsg("tcpclo receiver can't get acquisition work area",
@@ -180,12 +184,12 @@ static void	*receiveBundles(void *parm)
 	}
 
 	iblock(SIGTERM);
-	while (threadRunning && *(parms->cloRunning))
+	while (threadRunning && *(conn->cloRunning))
 	{
-		snooze(1);
-		if(*(parms->bundleSocket) < 0)
+		if(session->bundleSocket < 0)
 		{
 			/*Retry later*/
+			snooze(1);
 			continue;
 		}
 
@@ -196,24 +200,24 @@ static void	*receiveBundles(void *parm)
 			continue;
 		}
 	
-		switch (receiveBundleByTcpCL(*(parms->bundleSocket), work,
-					buffer))
+		/*	Segment acknowledgments for bundles sent on
+		 *	this connection are received here as well.
+		 *	When the connection is lost or shut down, wait
+		 *	for a new one: the session may be re-established
+		 *	by the sending or keepalive thread.		*/
+
+		switch (receiveBundleByTcpclSession(session, work, buffer))
 		{
 		case -1:
 			putErrmsg("Can't acquire bundle.", NULL);
-			pthread_mutex_lock(parms->mutex);
-			closesocket(*(parms->bundleSocket));
-			*(parms->bundleSocket) = -1;
-			pthread_mutex_unlock(parms->mutex);
-			continue;
+
+			/*	Intentional fall-through to next case.	*/
 
 		case 0:			/*	Shutdown message	*/	
-			/*	Go back to the start of the while loop	*/
-			pthread_mutex_lock(parms->mutex);
-			closesocket(*(parms->bundleSocket));
-			*(parms->bundleSocket) = -1;
-			pthread_mutex_unlock(parms->mutex);			
-			threadRunning = 0;
+			bpCancelAcq(work);
+			pthread_mutex_lock(&session->mutex);
+			tcpclCloseSession(session);
+			pthread_mutex_unlock(&session->mutex);
 			continue;
 
 		default:
@@ -238,19 +242,156 @@ static void	*receiveBundles(void *parm)
 	return NULL;
 }
 
+/*	*	*	Sender thread functions	*	*	*/
+
+static void	*sendBundles(void *parm)
+{
+	/*	Main loop for bundle transmission on one connection;
+	 *	all connections dequeue bundles from the same outduct.	*/
+
+	CloConnection		*conn = (CloConnection *) parm;
+	Sdr			sdr = getIonsdr();
+	unsigned char		*buffer;
+	Object			bundleZco;
+	BpExtendedCOS		extendedCOS;
+	char			destDuctName[MAX_CL_DUCT_NAME_LEN + 1];
+	unsigned int		bundleLength;
+	int			bytesSent;
+
+	buffer = MTAKE(TCPCLA_BUFSZ);
+	if (buffer == NULL)
+	{
+		putErrmsg("No memory for TCP buffer in tcpclo.", NULL);
+		*(conn->cloRunning) = 0;
+		return NULL;
+	}
+
+	while (*(conn->cloRunning) && !(sm_SemEnded(conn->vduct->semaphore)))
+	{
+		if (bpDequeue(conn->vduct, conn->outflows, &bundleZco,
+				&extendedCOS, destDuctName, 0, -1) < 0)
+		{
+			*(conn->cloRunning) = 0;	/*	Terminate CLO.	*/
+			continue;
+		}
+
+		if (bundleZco == 0)	/*	Interrupted.		*/
+		{
+			continue;
+		}
+
+		CHKNULL(sdr_begin_xn(sdr));
+		bundleLength = zco_length(sdr, bundleZco);
+		sdr_exit_xn(sdr);
+		bytesSent = sendBundleByTcpclSession(&conn->session,
+				bundleLength, bundleZco, buffer);
+		if(bytesSent < 0)
+		{
+			*(conn->cloRunning) = 0;	/*	Terminate CLO.	*/
+		}
+
+		/*	Make sure other tasks have a chance to run.	*/
+
+		sm_TaskYield();
+	}
+
+	MRELEASE(buffer);
+	return NULL;
+}
+
+static void	*runSenderThread(void *parm)
+{
+	iblock(SIGTERM);
+	oK(sendBundles(parm));
+	shutDownClo();
+	return NULL;
+}
+
+static int	startConnection(CloConnection *conn)
+{
+	if (pthread_begin(&conn->keepaliveThread, NULL, sendKeepalives, conn))
+	{
+		putSysErrmsg("tcpclo can't create keepalive thread", NULL);
+		return -1;
+	}
+
+	conn->threadsStarted++;
+	if (pthread_begin(&conn->receiverThread, NULL, receiveBundles, conn))
+	{
+		putSysErrmsg("tcpclo can't create receive thread", NULL);
+		return -1;
+	}
+
+	conn->threadsStarted++;
+	if (conn->session.connectionNbr == 0)
+	{
+		return 0;	/*	Main thread sends.		*/
+	}
+
+	if (pthread_begin(&conn->senderThread, NULL, runSenderThread, conn))
+	{
+		putSysErrmsg("tcpclo can't create sender thread", NULL);
+		return -1;
+	}
+
+	conn->threadsStarted++;
+	return 0;
+}
+
+static void	stopConnection(CloConnection *conn)
+{
+	TcpclSession	*session = &conn->session;
+
+	pthread_mutex_lock(&session->mutex);
+	if (session->bundleSocket != -1)
+	{
+		if (sendShutDownMessage(&session->bundleSocket, SHUT_DN_NO, -1,
+				session->socketName) < 0)
+		{
+			putErrmsg("Sending Shutdown message failed!!",NULL);
+		}
+	}
+
+	tcpclCloseSession(session);
+	pthread_mutex_unlock(&session->mutex);
+	if (conn->threadsStarted > 2)
+	{
+		sm_SemEnd(conn->vduct->semaphore);
+		pthread_join(conn->senderThread, NULL);
+	}
+
+	if (conn->threadsStarted > 0)
+	{
+		pthread_join(conn->keepaliveThread, NULL);
+	}
+
+	if (conn->threadsStarted > 1)
+	{
+		pthread_join(conn->receiverThread, NULL);
+	}
+
+	tcpclDestroySession(session);
+}
+
 /*	*	*	Main thread functions	*	*	*	*/
 
 #if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
 int	tcpclo(int a1, int a2, int a3, int a4, int a5,
 		int a6, int a7, int a8, int a9, int a10)
 {
-	char	*ductName = (char *) a1;
+	char	*arg1 = (char *) a1;
+	char	*arg2 = (char *) a2;
+	char	*arg3 = (char *) a3;
 #else
 int	main(int argc, char *argv[])
 {
-	char	*ductName = (argc > 1 ? argv[1] : NULL);
+	char	*arg1 = (argc > 1 ? argv[1] : NULL);
+	char	*arg2 = (argc > 2 ? argv[2] : NULL);
+	char	*arg3 = (argc > 3 ? argv[3] : NULL);
 #endif
-	unsigned char		*buffer;
+	char			*ductName = arg1;
+	int			connectionsCount = 1;
+	unsigned int		segmentSize = 0;
 	VOutduct		*vduct;
 	PsmAddress		vductElt;
 	Sdr			sdr;
@@ -264,36 +405,34 @@ int	main(int argc, char *argv[])
 	struct sockaddr		socketName;
 	struct sockaddr_in	*inetName;
 	int			running = 1;
-	pthread_mutex_t		mutex;
-	KeepaliveThreadParms	parms;
-	ReceiveThreadParms	rparms;
-	pthread_t		keepaliveThread;
-	pthread_t		receiverThread;
-	Object			bundleZco;
-	BpExtendedCOS		extendedCOS;
-	char			destDuctName[MAX_CL_DUCT_NAME_LEN + 1];
-	unsigned int		bundleLength;
-	int			ductSocket = -1;
-	int			bytesSent;
-	int 			keepalivePeriod = 0;
+	CloConnection		*connections;
 	VInduct			*viduct;
 
-	if (ductName == NULL)
+	/*	The duct name, appended to the CLO command by bpadmin,
+	 *	is always the last argument.				*/
+
+	if (arg2)
 	{
-		PUTS("Usage: tcpclo <remote host name>[:<port number>]");
-		return 0;
+		connectionsCount = atoi(arg1);
+		ductName = arg2;
+		if (arg3)
+		{
+			segmentSize = strtoul(arg2, NULL, 0);
+			ductName = arg3;
+		}
 	}
 
-	if (bpAttach() < 0)
+	if (ductName == NULL || connectionsCount < 1
+	|| connectionsCount > TCPCLO_MAX_CONNECTIONS)
 	{
-		putErrmsg("tcpclo can't attach to BP", NULL);
-		return 1;
+		PUTS("Usage: tcpclo [<number of connections> [<segment size>]] \
+<remote host name>[:<port number>]");
+		return 0;
 	}
 
-	buffer = MTAKE(TCPCLA_BUFSZ);
-	if (buffer == NULL)
+	if (bpAttach() < 0)
 	{
-		putErrmsg("No memory for TCP buffer in tcpclo.", NULL);
+		putErrmsg("tcpclo can't attach to BP", NULL);
 		return 1;
 	}
 
@@ -301,7 +440,6 @@ int	main(int argc, char *argv[])
 	if (vductElt == 0)
 	{
 		putErrmsg("No such tcp duct.", ductName);
-		MRELEASE(buffer);
 		return 1;
 	}
 
@@ -309,7 +447,6 @@ int	main(int argc, char *argv[])
 	{
 		putErrmsg("CLO task is already started for this duct.",
 				itoa(vduct->cloPid));
-		MRELEASE(buffer);
 		return 1;
 	}
 
@@ -350,7 +487,6 @@ int	main(int argc, char *argv[])
 	if (hostNbr == 0)
 	{
 		putErrmsg("Can't get IP address for host.", hostName);
-		MRELEASE(buffer);
 		return 1;
 	}
 
@@ -363,35 +499,9 @@ int	main(int argc, char *argv[])
 	if (_tcpOutductId(&socketName, "tcp", ductName) < 0)
 	{
 		putErrmsg("Can't record TCP Outduct ID for connection.", NULL);
-		MRELEASE(buffer);
 		return -1;
 	}
 
-	/*	Set up signal handling.  SIGTERM is shutdown signal.	*/
-
-	oK(tcpcloSemaphore(&(vduct->semaphore)));
-	isignal(SIGTERM, shutDownClo);
-#ifndef mingw
-	isignal(SIGPIPE, handleConnectionLoss);
-#endif
-
-	/*	Start the keepalive thread for the eventual connection.	*/
-	
-	tcpDesiredKeepAlivePeriod = KEEPALIVE_PERIOD;
-	parms.cloRunning = &running;
-	pthread_mutex_init(&mutex, NULL);
-	parms.mutex = &mutex;
-	parms.socketName = &socketName;
-	parms.ductSocket = &ductSocket;
-	parms.keepalivePeriod = &keepalivePeriod;
-	if (pthread_begin(&keepaliveThread, NULL, sendKeepalives, &parms))
-	{
-		putSysErrmsg("tcpclo can't create keepalive thread", NULL);
-		MRELEASE(buffer);
-		pthread_mutex_destroy(&mutex);
-		return 1;
-	}
-
 	// Returns the VInduct Object of first induct with same protocol
 	// as the outduct. The VInduct is required to create an acq area.
 	// The Acq Area inturn uses the throttle information from VInduct
@@ -403,91 +513,88 @@ int	main(int argc, char *argv[])
 	if(viduct == NULL)
 	{
 		putErrmsg("tcpclo can't get VInduct", NULL);
-		MRELEASE(buffer);
-		pthread_mutex_destroy(&mutex);
 		return 1;
 	
 	}
 
-	rparms.vduct =  viduct;
-	rparms.bundleSocket = &ductSocket;
-	rparms.mutex = &mutex;
-	rparms.cloRunning = &running;
-	if (pthread_begin(&receiverThread, NULL, receiveBundles, &rparms))
+	connections = (CloConnection *)
+			MTAKE(connectionsCount * sizeof(CloConnection));
+	if (connections == NULL)
 	{
-		putSysErrmsg("tcpclo can't create receive thread", NULL);
-		MRELEASE(buffer);
-		pthread_mutex_destroy(&mutex);
+		putErrmsg("No memory for TCP connections in tcpclo.", NULL);
 		return 1;
 	}
 
-	/*	Can now begin transmitting to remote duct.		*/
-
-	{
-		char	txt[500];
-
-		isprintf(txt, sizeof(txt),
-			"[i] tcpclo is running, spec=[%s:%d].", 
-			inet_ntoa(inetName->sin_addr),
-			ntohs(inetName->sin_port));
-		writeMemo(txt);
-	}
-
-	while (running && !(sm_SemEnded(tcpcloSemaphore(NULL))))
+	memset((char *) connections, 0,
+			connectionsCount * sizeof(CloConnection));
+	for (i = 0; i < connectionsCount; i++)
 	{
-		if (bpDequeue(vduct, outflows, &bundleZco, &extendedCOS,
-				destDuctName, 0, -1) < 0)
+		connections[i].cloRunning = &running;
+		connections[i].vduct = vduct;
+		connections[i].outflows = outflows;
+		connections[i].viduct = viduct;
+		if (tcpclInitSession(&connections[i].session, &socketName, i,
+				segmentSize) < 0)
 		{
-			running = 0;	/*	Terminate CLO.		*/
-			continue;
+			putErrmsg("tcpclo can't initialize TCPCL session",
+					itoa(i));
+			connectionsCount = i;
+			running = 0;
+			break;
 		}
+	}
 
-		if (bundleZco == 0)	/*	Interrupted.		*/
-		{
-			continue;
-		}
+	/*	Set up signal handling.  SIGTERM is shutdown signal.	*/
 
-		CHKZERO(sdr_begin_xn(sdr));
-		bundleLength = zco_length(sdr, bundleZco);
-		sdr_exit_xn(sdr);
-		pthread_mutex_lock(&mutex);
-		bytesSent = sendBundleByTCPCL(&socketName, &ductSocket,
-			bundleLength, bundleZco, buffer, &keepalivePeriod);
-		pthread_mutex_unlock(&mutex);
-		if(bytesSent < 0)
+	oK(tcpcloSemaphore(&(vduct->semaphore)));
+	isignal(SIGTERM, shutDownClo);
+#ifndef mingw
+	isignal(SIGPIPE, handleConnectionLoss);
+#endif
+
+	/*	Start the keepalive and receiver threads for each
+	 *	eventual connection, and a sender thread for each
+	 *	connection but the first, whose bundles are sent by
+	 *	the main thread.  Segment acknowledgment and the
+	 *	resumption of interrupted bundles are requested of
+	 *	the remote induct.					*/
+	
+	tcpDesiredKeepAlivePeriod = KEEPALIVE_PERIOD;
+	tcpclContactFlags = TCPCLA_FLAG_ACK | TCPCLA_FLAG_RESUME;
+	for (i = 0; running && i < connectionsCount; i++)
+	{
+		if (startConnection(connections + i) < 0)
 		{
-			running = 0;	/*	Terminate CLO.		*/
+			running = 0;
 		}
-
-		/*	Make sure other tasks have a chance to run.	*/
-
-		sm_TaskYield();
 	}
-	writeMemo("[i] tcpclo done sending");
 
-	if (sendShutDownMessage(&ductSocket, SHUT_DN_NO, -1, &socketName) < 0)
-	{
-		putErrmsg("Sending Shutdown message failed!!",NULL);
-	}
+	/*	Can now begin transmitting to remote duct.		*/
 
-	if (ductSocket != -1)
+	if (running)
 	{
-		closesocket(ductSocket);
-		ductSocket=-1;
+		char	txt[500];
+
+		isprintf(txt, sizeof(txt),
+			"[i] tcpclo is running, spec=[%s:%d], %d connection(s).", 
+			inet_ntoa(inetName->sin_addr),
+			ntohs(inetName->sin_port), connectionsCount);
+		writeMemo(txt);
+		oK(sendBundles(connections));
 	}
 
+	writeMemo("[i] tcpclo done sending");
 	running = 0;
-	pthread_join(keepaliveThread, NULL);
-	writeMemo("[i] tcpclo keepalive thread killed");
-
-	pthread_join(receiverThread, NULL);
-	writeMemo("[i] tcpclo receiver thread killed");
+	for (i = 0; i < connectionsCount; i++)
+	{
+		stopConnection(connections + i);
+	}
 
+	writeMemo("[i] tcpclo connection threads killed");
 	writeErrmsgMemos();
 	writeMemo("[i] tcpclo duct has ended.");
 	oK(_tcpOutductId(&socketName, NULL, NULL));
-	MRELEASE(buffer);
-	pthread_mutex_destroy(&mutex);
+	MRELEASE(connections);
 	bp_detach();
 	return 0;
 }
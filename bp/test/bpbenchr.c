@@ -0,0 +1,384 @@
+/*
+	bpbenchr.c:	receiver for convergence-layer benchmark.
+			Receives the bundles sent by bpbenchs and
+			prints throughput, end-to-end latency
+			percentiles, and SDR transaction and CPU
+			overhead figures.
+
+			The payload of each bundle begins with the
+			16-byte header described in bpbenchs.c.
+									*/
+/*									*/
+/*	Copyright (c) 2026, California Institute of Technology.		*/
+/*	All rights reserved.						*/
+/*									*/
+
+#include "bpP.h"
+
+#define	BPBENCH_HDR_LEN		(16)
+
+static BpSAP	_bpsap(BpSAP *newSap)
+{
+	static BpSAP	sap = NULL;
+
+	if (newSap)
+	{
+		sap = *newSap;
+	}
+
+	return sap;
+}
+
+static int	_running(int *newState)
+{
+	static int	state = 1;
+
+	if (newState)
+	{
+		state = *newState;
+	}
+
+	return state;
+}
+
+static int	_idleLimit(int *newLimit)
+{
+	static int	limit = 10;
+
+	if (newLimit)
+	{
+		limit = *newLimit;
+	}
+
+	return limit;
+}
+
+static int	_secondsIdle(int increment)
+{
+	static int	count = 0;
+
+	if (increment)
+	{
+		count += increment;
+	}
+	else
+	{
+		count = 0;
+	}
+
+	return count;
+}
+
+static void	handleQuit()
+{
+	int	stop = 0;
+
+	isignal(SIGINT, handleQuit);
+	oK(_running(&stop));
+	bp_interrupt(_bpsap(NULL));
+}
+
+static int	checkIdle(void *userData)
+{
+	/*	Stop if nothing has been received for the idle limit,
+	 *	e.g., because some bundles were lost by an unreliable
+	 *	convergence layer.					*/
+
+	if (_secondsIdle(1) > _idleLimit(NULL))
+	{
+		handleQuit();
+	}
+
+	return 0;
+}
+
+static double	elapsedUsec(struct timeval *from, struct timeval *to)
+{
+	return ((to->tv_sec - from->tv_sec) * 1000000.0)
+			+ (to->tv_usec - from->tv_usec);
+}
+
+static double	cpuUsec()
+{
+#if defined (VXWORKS) || defined (RTEMS) || defined (mingw)
+	return -1.0;
+#else
+	struct rusage	usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) < 0)
+	{
+		return -1.0;
+	}
+
+	return ((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000.0)
+			+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+static int	compareLatencies(const void *a, const void *b)
+{
+	double	la = *((const double *) a);
+	double	lb = *((const double *) b);
+
+	return (la < lb ? -1 : (la > lb ? 1 : 0));
+}
+
+typedef struct
+{
+	int		bundlesExpected;
+	int		bundlesReceived;
+	double		bytesReceived;
+	double		*latencies;	/*	In microseconds.	*/
+	struct timeval	startTime;
+	struct timeval	firstSendTime;
+	struct timeval	lastArrivalTime;
+} BenchState;
+
+static int	noteBundle(BenchState *bench, Object adu,
+			struct timeval *arrivalTime)
+{
+	Sdr		sdr = getIonsdr();
+	ZcoReader	reader;
+	unsigned char	hdr[BPBENCH_HDR_LEN];
+	vast		aduLength;
+	vast		len;
+	unsigned int	fields[4];
+	int		i;
+	struct timeval	sendTime;
+
+	CHKERR(sdr_begin_xn(sdr));
+	aduLength = zco_length(sdr, adu);
+	zco_start_receiving(adu, &reader);
+	len = zco_receive_source(sdr, &reader, BPBENCH_HDR_LEN, (char *) hdr);
+	sdr_exit_xn(sdr);
+	if (len != BPBENCH_HDR_LEN)
+	{
+		return 0;		/*	Not a bpbenchs bundle.	*/
+	}
+
+	for (i = 0; i < 4; i++)
+	{
+		memcpy((char *) (fields + i), hdr + (i * 4), 4);
+		fields[i] = ntohl(fields[i]);
+	}
+
+	if (fields[1] <= BPBENCH_HDR_LEN)
+	{
+		return 0;		/*	Not a bpbenchs bundle.	*/
+	}
+
+	sendTime.tv_sec = fields[2];
+	sendTime.tv_usec = fields[3];
+	if (elapsedUsec(&sendTime, &bench->startTime) > 0.0)
+	{
+		return 0;		/*	From an earlier run.	*/
+	}
+
+	if (bench->bundlesReceived == 0
+	|| elapsedUsec(&sendTime, &bench->firstSendTime) > 0.0)
+	{
+		bench->firstSendTime.tv_sec = sendTime.tv_sec;
+		bench->firstSendTime.tv_usec = sendTime.tv_usec;
+	}
+
+	if (bench->bundlesReceived < bench->bundlesExpected)
+	{
+		bench->latencies[bench->bundlesReceived] =
+				elapsedUsec(&sendTime, arrivalTime);
+	}
+
+	bench->bundlesReceived++;
+	bench->bytesReceived += aduLength;
+	bench->lastArrivalTime = *arrivalTime;
+	return 1;
+}
+
+static void	printPercentile(char *label, double *latencies, int count,
+			int percentile)
+{
+	int	i;
+	char	buf[64];
+
+	i = ((count * percentile) + 99) / 100;
+	if (i > 0)
+	{
+		i--;
+	}
+
+	isprintf(buf, sizeof buf, "%.3f", latencies[i] / 1000.0);
+	PUTMEMO(label, buf);
+}
+
+static void	printResults(BenchState *bench, unsigned long xnCount,
+			double cpu)
+{
+	int	count;
+	double	usec;
+	char	buf[128];
+
+	PUTMEMO("Bundles received", itoa(bench->bundlesReceived));
+	isprintf(buf, sizeof buf, "%.0f", bench->bytesReceived);
+	PUTMEMO("Bytes received", buf);
+	if (bench->bundlesReceived == 0)
+	{
+		return;
+	}
+
+	usec = elapsedUsec(&bench->firstSendTime, &bench->lastArrivalTime);
+	isprintf(buf, sizeof buf, "%.3f", usec / 1000000.0);
+	PUTMEMO("Elapsed time (seconds)", buf);
+	if (usec > 0.0)
+	{
+		isprintf(buf, sizeof buf, "%.1f",
+				(bench->bundlesReceived * 1000000.0) / usec);
+		PUTMEMO("Throughput (bundles/s)", buf);
+		isprintf(buf, sizeof buf, "%.3f", bench->bytesReceived / usec);
+		PUTMEMO("Goodput (MB/s)", buf);
+	}
+
+	count = bench->bundlesReceived;
+	if (count > bench->bundlesExpected)
+	{
+		count = bench->bundlesExpected;
+	}
+
+	qsort(bench->latencies, count, sizeof(double), compareLatencies);
+	printPercentile("Latency p50 (msec)", bench->latencies, count, 50);
+	printPercentile("Latency p90 (msec)", bench->latencies, count, 90);
+	printPercentile("Latency p99 (msec)", bench->latencies, count, 99);
+	printPercentile("Latency max (msec)", bench->latencies, count, 100);
+	isprintf(buf, sizeof buf, "%.2f",
+			((double) xnCount) / bench->bundlesReceived);
+	PUTMEMO("SDR transactions per bundle (receiver)", buf);
+	if (cpu >= 0.0)
+	{
+		isprintf(buf, sizeof buf, "%.3f", cpu / 1000000.0);
+		PUTMEMO("bpbenchr CPU (seconds)", buf);
+	}
+}
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	bpbenchr(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	char		*ownEid = (char *) a1;
+	int		bundleCount = a2;
+	int		idleLimit = a3;
+#else
+int	main(int argc, char **argv)
+{
+	char		*ownEid = (argc > 1 ? argv[1] : NULL);
+	int		bundleCount = (argc > 2 ? strtol(argv[2], NULL, 0) : 0);
+	int		idleLimit = (argc > 3 ? strtol(argv[3], NULL, 0) : 0);
+#endif
+	Sdr		sdr;
+	BpSAP		sap;
+	IonAlarm	alarm = { 1, 0, checkIdle, NULL };
+	pthread_t	alarmThread;
+	BenchState	bench;
+	BpDelivery	dlv;
+	struct timeval	arrivalTime;
+	unsigned long	startXnCount = 0;
+	double		startCpu = 0.0;
+	double		cpu;
+
+	if (ownEid == NULL || bundleCount < 1)
+	{
+		PUTS("Usage: bpbenchr <own endpoint ID> <number of bundles> \
+[<idle limit, in seconds>]");
+		PUTS("  Idle limit defaults to 10 seconds.");
+		PUTS("");
+		PUTS("  Expected source (sending) application is bpbenchs.");
+		return 0;
+	}
+
+	if (idleLimit > 0)
+	{
+		oK(_idleLimit(&idleLimit));
+	}
+
+	memset((char *) &bench, 0, sizeof(BenchState));
+	bench.bundlesExpected = bundleCount;
+	bench.latencies = (double *) malloc(bundleCount * sizeof(double));
+	if (bench.latencies == NULL)
+	{
+		putErrmsg("bpbenchr can't allocate latency table.",
+				itoa(bundleCount));
+		return 1;
+	}
+
+	if (bp_attach() < 0)
+	{
+		putErrmsg("bpbenchr can't attach to BP.", NULL);
+		free(bench.latencies);
+		return 1;
+	}
+
+	if (bp_open(ownEid, &sap) < 0)
+	{
+		putErrmsg("bpbenchr can't open own endpoint.", ownEid);
+		free(bench.latencies);
+		return 1;
+	}
+
+	oK(_bpsap(&sap));
+	sdr = bp_get_sdr();
+	isignal(SIGINT, handleQuit);
+	getCurrentTime(&bench.startTime);
+	ionSetAlarm(&alarm, &alarmThread);
+	while (_running(NULL) && bench.bundlesReceived < bench.bundlesExpected)
+	{
+		if (bp_receive(sap, &dlv, BP_BLOCKING) < 0)
+		{
+			putErrmsg("bpbenchr bundle reception failed.", NULL);
+			break;
+		}
+
+		getCurrentTime(&arrivalTime);
+		switch (dlv.result)
+		{
+		case BpPayloadPresent:
+			oK(_secondsIdle(0));
+
+			/*	Transaction and CPU overhead are
+			 *	measured from the first delivery.	*/
+
+			if (bench.bundlesReceived == 0)
+			{
+				startXnCount = sdr_xn_count(sdr);
+				startCpu = cpuUsec();
+			}
+
+			oK(noteBundle(&bench, dlv.adu, &arrivalTime));
+			break;
+
+		case BpEndpointStopped:
+			handleQuit();
+			break;
+
+		default:
+			break;
+		}
+
+		bp_release_delivery(&dlv, 1);
+	}
+
+	ionCancelAlarm(alarmThread);
+	cpu = cpuUsec();
+	if (cpu >= 0.0 && startCpu >= 0.0)
+	{
+		cpu -= startCpu;
+	}
+	else
+	{
+		cpu = -1.0;
+	}
+
+	writeErrmsgMemos();
+	printResults(&bench, sdr_xn_count(sdr) - startXnCount, cpu);
+	fflush(stdout);
+	free(bench.latencies);
+	bp_close(sap);
+	bp_detach();
+	return (bench.bundlesReceived < bench.bundlesExpected ? 1 : 0);
+}
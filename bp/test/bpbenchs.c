@@ -0,0 +1,490 @@
+/*
+	bpbenchs.c:	sender for convergence-layer benchmark.  Sends
+			a number of bundles of fixed payload length to
+			a remote bpbenchr, from one or more concurrent
+			sender threads, waits for all of those bundles
+			to be transmitted, and prints performance
+			statistics.
+
+			The first 16 bytes of each payload are a header
+			comprising four 32-bit unsigned integers in
+			network byte order: the number of the bundle
+			(counting from 1 for each sender thread), the
+			length of the payload including the header,
+			and the seconds and microseconds of the time
+			at which it was passed to bp_send.  This
+			enables bpbenchr to compute end-to-end latency,
+			since both nodes run on the same computer.
+									*/
+/*									*/
+/*	Copyright (c) 2026, California Institute of Technology.		*/
+/*	All rights reserved.						*/
+/*									*/
+
+#include "bpP.h"
+
+#define	BPBENCH_HDR_LEN		(16)
+#define	BPBENCH_MAX_THREADS	(64)
+#define	BPBENCH_DRAIN_LIMIT	(60)
+#define	DEFAULT_TTL		(3600)
+
+typedef struct
+{
+	char		destEid[MAX_EID_LEN + 1];
+	int		ttl;
+	Object		fileRef;
+	int		payloadLength;
+	int		bundleCount;
+	int		bundlesSent;
+	int		zcoControl;
+	BpSAP		sap;		/*	Shared by all threads.	*/
+	int		started;
+	pthread_t	thread;
+} SenderThreadParms;
+
+static SenderThreadParms	*_senders(SenderThreadParms *newSenders,
+					int *newCount, int *count)
+{
+	static SenderThreadParms	*senders = NULL;
+	static int			senderCount = 0;
+
+	if (newSenders)
+	{
+		senders = newSenders;
+		senderCount = *newCount;
+	}
+
+	if (count)
+	{
+		*count = senderCount;
+	}
+
+	return senders;
+}
+
+static int	_running(int *newState)
+{
+	static int	state = 1;
+
+	if (newState)
+	{
+		state = *newState;
+	}
+
+	return state;
+}
+
+static void	handleQuit()
+{
+	int			stop = 0;
+	SenderThreadParms	*senders;
+	int			count;
+	int			i;
+
+	isignal(SIGINT, handleQuit);
+	oK(_running(&stop));
+	senders = _senders(NULL, NULL, &count);
+	for (i = 0; i < count; i++)
+	{
+		ionCancelZcoSpaceRequest(&(senders[i].zcoControl));
+	}
+}
+
+static double	elapsedUsec(struct timeval *from, struct timeval *to)
+{
+	return ((to->tv_sec - from->tv_sec) * 1000000.0)
+			+ (to->tv_usec - from->tv_usec);
+}
+
+static double	cpuUsec()
+{
+#if defined (VXWORKS) || defined (RTEMS) || defined (mingw)
+	return -1.0;
+#else
+	struct rusage	usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) < 0)
+	{
+		return -1.0;
+	}
+
+	return ((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000.0)
+			+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+static void	encodeHeader(unsigned char *hdr, unsigned int bundleNbr,
+			unsigned int payloadLength, struct timeval *sendTime)
+{
+	unsigned int	fields[4];
+	int		i;
+
+	fields[0] = htonl(bundleNbr);
+	fields[1] = htonl(payloadLength);
+	fields[2] = htonl((unsigned int) sendTime->tv_sec);
+	fields[3] = htonl((unsigned int) sendTime->tv_usec);
+	for (i = 0; i < 4; i++)
+	{
+		memcpy(hdr + (i * 4), (char *) (fields + i), 4);
+	}
+}
+
+static int	bundlesPending(Sdr sdr)
+{
+	BpDB	bpdb;
+	int	count;
+
+	/*	Every bundle resident in the node has an expiration
+	 *	event in the timeline, until the bundle is destroyed
+	 *	upon transmission (or delivery).			*/
+
+	CHKERR(sdr_begin_xn(sdr));
+	sdr_read(sdr, (char *) &bpdb, getBpDbObject(), sizeof(BpDB));
+	count = sdr_list_length(sdr, bpdb.timeline);
+	sdr_exit_xn(sdr);
+	return count;
+}
+
+static void	*sendBundles(void *parm)
+{
+	SenderThreadParms	*stp = (SenderThreadParms *) parm;
+	Sdr			sdr = getIonsdr();
+	Object			zco;
+	Object			newBundle;
+	unsigned char		hdr[BPBENCH_HDR_LEN];
+	struct timeval		sendTime;
+
+	while (_running(NULL) && stp->bundlesSent < stp->bundleCount)
+	{
+		zco = ionCreateZco(ZcoFileSource, stp->fileRef, 0,
+				stp->payloadLength - BPBENCH_HDR_LEN,
+				&(stp->zcoControl));
+		if (zco == 0)
+		{
+			if (_running(NULL))
+			{
+				putErrmsg("bpbenchs can't create ZCO.", NULL);
+			}
+
+			break;
+		}
+
+		getCurrentTime(&sendTime);
+		encodeHeader(hdr, stp->bundlesSent + 1, stp->payloadLength,
+				&sendTime);
+		CHKNULL(sdr_begin_xn(sdr));
+		oK(zco_prepend_header(sdr, zco, (char *) hdr,
+				BPBENCH_HDR_LEN));
+		oK(zco_bond(sdr, zco));
+		if (sdr_end_xn(sdr) < 0)
+		{
+			putErrmsg("bpbenchs can't prepend header.", NULL);
+			break;
+		}
+
+		if (bp_send(stp->sap, stp->destEid, NULL, stp->ttl,
+				BP_STD_PRIORITY, NoCustodyRequested, 0, 0,
+				NULL, zco, &newBundle) < 1)
+		{
+			putErrmsg("bpbenchs can't send bundle.",
+					itoa(stp->payloadLength));
+			break;
+		}
+
+		stp->bundlesSent++;
+	}
+
+	return NULL;
+}
+
+static int	run_bpbenchs(char *ownEid, char *destEid, int bundleCount,
+			int payloadLength, int threadCount, int ttl)
+{
+	static char		buffer[4096];
+	Sdr			sdr;
+	BpSAP			sap;
+	SenderThreadParms	*senders;
+	int			aduFile;
+	int			bytesRemaining;
+	int			bytesToWrite;
+	Object			fileRef;
+	int			baseline;
+	int			pending;
+	int			ticksWaited = 0;
+	int			polls = 0;
+	int			bundlesSent = 0;
+	int			i;
+	unsigned long		startXnCount;
+	unsigned long		sendXnCount;
+	unsigned long		endXnCount;
+	double			startCpu;
+	double			cpu;
+	struct timeval		startTime;
+	struct timeval		sendEndTime;
+	struct timeval		endTime;
+	double			usec;
+	char			buf[128];
+
+	if (ownEid == NULL || destEid == NULL || bundleCount < 1
+	|| payloadLength <= BPBENCH_HDR_LEN
+	|| threadCount < 1 || threadCount > BPBENCH_MAX_THREADS)
+	{
+		PUTS("Usage: bpbenchs <own endpoint ID> <destination endpoint \
+ID> <number of bundles> <payload length> [<number of threads> [<TTL>]]");
+		PUTS("  Payload length must exceed 16 bytes.");
+		PUTS("  Number of threads defaults to 1, may not exceed 64;");
+		PUTS("  each thread sends the indicated number of bundles.");
+		PUTS("  Bundle TTL defaults to 3600 seconds.");
+		PUTS("");
+		PUTS("  Expected destination (receiving) application is");
+		PUTS("  bpbenchr.");
+		return 0;
+	}
+
+	if (bp_attach() < 0)
+	{
+		putErrmsg("bpbenchs can't attach to BP.", NULL);
+		return 1;
+	}
+
+	if (bp_open(ownEid, &sap) < 0)
+	{
+		putErrmsg("bpbenchs can't open own endpoint.", ownEid);
+		return 1;
+	}
+
+	senders = (SenderThreadParms *) MTAKE(threadCount
+			* sizeof(SenderThreadParms));
+	if (senders == NULL)
+	{
+		putErrmsg("bpbenchs can't allocate sender threads.", NULL);
+		bp_close(sap);
+		return 1;
+	}
+
+	memset((char *) senders, 0, threadCount * sizeof(SenderThreadParms));
+
+	sdr = getIonsdr();
+	aduFile = iopen("bpbenchsAduFile", O_WRONLY | O_CREAT | O_TRUNC,
+			0666);
+	if (aduFile < 0)
+	{
+		putSysErrmsg("Can't create ADU file", NULL);
+		fileRef = 0;
+	}
+	else
+	{
+		memset(buffer, 'x', sizeof buffer);
+		bytesRemaining = payloadLength - BPBENCH_HDR_LEN;
+		while (bytesRemaining > 0)
+		{
+			bytesToWrite = bytesRemaining;
+			if (bytesToWrite > sizeof buffer)
+			{
+				bytesToWrite = sizeof buffer;
+			}
+
+			if (write(aduFile, buffer, bytesToWrite) < 0)
+			{
+				putSysErrmsg("Error writing to ADU file", NULL);
+				break;
+			}
+
+			bytesRemaining -= bytesToWrite;
+		}
+
+		close(aduFile);
+		CHKZERO(sdr_begin_xn(sdr));
+		fileRef = zco_create_file_ref(sdr, "bpbenchsAduFile", NULL);
+		if (sdr_end_xn(sdr) < 0 || bytesRemaining > 0)
+		{
+			fileRef = 0;
+		}
+	}
+
+	if (fileRef == 0)
+	{
+		putErrmsg("bpbenchs can't create file ref.", NULL);
+		MRELEASE(senders);
+		bp_close(sap);
+		return 1;
+	}
+
+	if (ttl <= 0)
+	{
+		ttl = DEFAULT_TTL;
+	}
+
+	oK(_senders(senders, &threadCount, NULL));
+	isignal(SIGINT, handleQuit);
+	baseline = bundlesPending(sdr);
+	startXnCount = sdr_xn_count(sdr);
+	startCpu = cpuUsec();
+	getCurrentTime(&startTime);
+	for (i = 0; i < threadCount; i++)
+	{
+		/*	bp_send parses the destination EID in place,
+		 *	so each thread needs its own copy.		*/
+
+		istrcpy(senders[i].destEid, destEid,
+				sizeof senders[i].destEid);
+		senders[i].ttl = ttl;
+		senders[i].fileRef = fileRef;
+		senders[i].payloadLength = payloadLength;
+		senders[i].bundleCount = bundleCount;
+		senders[i].sap = sap;
+		if (pthread_begin(&(senders[i].thread), NULL, sendBundles,
+				senders + i))
+		{
+			putSysErrmsg("bpbenchs can't create sender thread",
+					itoa(i));
+			handleQuit();
+			continue;
+		}
+
+		senders[i].started = 1;
+	}
+
+	for (i = 0; i < threadCount; i++)
+	{
+		if (senders[i].started)
+		{
+			pthread_join(senders[i].thread, NULL);
+		}
+
+		bundlesSent += senders[i].bundlesSent;
+	}
+
+	getCurrentTime(&sendEndTime);
+	sendXnCount = sdr_xn_count(sdr);
+
+	/*	Now wait until all bundles have been transmitted, i.e.,
+	 *	the number of bundles resident in the node has fallen
+	 *	back to what it was before the benchmark began.		*/
+
+	while (_running(NULL))
+	{
+		pending = bundlesPending(sdr);
+		polls++;
+		if (pending < 0 || pending <= baseline)
+		{
+			break;
+		}
+
+		if (ticksWaited > BPBENCH_DRAIN_LIMIT * 100)
+		{
+			writeMemoNote("[?] bpbenchs gave up waiting for \
+transmission of bundles", itoa(pending - baseline));
+			break;
+		}
+
+		microsnooze(10000);	/*	One tick.		*/
+		ticksWaited++;
+	}
+
+	/*	Each poll of the pending bundle count is itself an SDR
+	 *	transaction; don't charge those to the bundles.		*/
+
+	getCurrentTime(&endTime);
+	endXnCount = sdr_xn_count(sdr) - polls;
+	cpu = cpuUsec();
+	writeErrmsgMemos();
+	PUTMEMO("Sender threads", itoa(threadCount));
+	PUTMEMO("Bundles sent", itoa(bundlesSent));
+	PUTMEMO("Payload length (bytes)", itoa(payloadLength));
+	usec = elapsedUsec(&startTime, &sendEndTime);
+	isprintf(buf, sizeof buf, "%.3f", usec / 1000000.0);
+	PUTMEMO("Send time (seconds)", buf);
+	if (usec > 0.0)
+	{
+		isprintf(buf, sizeof buf, "%.3f", (((double) bundlesSent)
+				* payloadLength) / usec);
+		PUTMEMO("Offered load (MB/s)", buf);
+	}
+
+	usec = elapsedUsec(&startTime, &endTime);
+	isprintf(buf, sizeof buf, "%.3f", usec / 1000000.0);
+	PUTMEMO("Time to transmit (seconds)", buf);
+	if (bundlesSent > 0)
+	{
+		isprintf(buf, sizeof buf, "%.2f",
+				((double) (sendXnCount - startXnCount))
+				/ bundlesSent);
+		PUTMEMO("SDR transactions per bundle (bp_send)", buf);
+		isprintf(buf, sizeof buf, "%.2f",
+				((double) (endXnCount - startXnCount))
+				/ bundlesSent);
+		PUTMEMO("SDR transactions per bundle (sender)", buf);
+	}
+
+	if (startCpu >= 0.0 && cpu >= 0.0)
+	{
+		isprintf(buf, sizeof buf, "%.3f",
+				(cpu - startCpu) / 1000000.0);
+		PUTMEMO("bpbenchs CPU (seconds)", buf);
+	}
+
+	fflush(stdout);
+	threadCount = 0;
+	oK(_senders(senders, &threadCount, NULL));
+	MRELEASE(senders);
+	bp_close(sap);
+	CHKZERO(sdr_begin_xn(sdr));
+	zco_destroy_file_ref(sdr, fileRef);
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("bpbenchs can't destroy file reference.", NULL);
+	}
+
+	bp_detach();
+	return 0;
+}
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	bpbenchs(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	char	*ownEid = (char *) a1;
+	char	*destEid = (char *) a2;
+	int	bundleCount = a3;
+	int	payloadLength = a4;
+	int	threadCount = (a5 == 0 ? 1 : a5);
+	int	ttl = a6;
+#else
+int	main(int argc, char **argv)
+{
+	char	*ownEid = NULL;
+	char	*destEid = NULL;
+	int	bundleCount = 0;
+	int	payloadLength = 0;
+	int	threadCount = 1;
+	int	ttl = 0;
+
+	if (argc > 7) argc = 7;
+	switch (argc)
+	{
+	case 7:
+		ttl = strtol(argv[6], NULL, 0);
+
+	case 6:
+		threadCount = strtol(argv[5], NULL, 0);
+
+	case 5:
+		payloadLength = strtol(argv[4], NULL, 0);
+
+	case 4:
+		bundleCount = strtol(argv[3], NULL, 0);
+
+	case 3:
+		destEid = argv[2];
+
+	case 2:
+		ownEid = argv[1];
+
+	default:
+		break;
+	}
+#endif
+	return run_bpbenchs(ownEid, destEid, bundleCount, payloadLength,
+			threadCount, ttl);
+}
@@ -0,0 +1,523 @@
+/*
+	cgrbench.c:	benchmark for contact graph routing.  Generates
+			a synthetic contact plan of the specified size,
+			contact density, horizon, and transmission rate
+			distribution, loads it into the contact plan of
+			the local (scratch) ION node, and then times
+			cgr_forward for cold route lists, for warm route
+			lists, after a contact plan edit, and for a
+			stream of bundles, reporting the sizes of the
+			route lists and the amount of ION working memory
+			they occupy.
+
+			Bundles are routed but never enqueued: the
+			forwarding directive lookup function passed to
+			cgr_forward always reports that no directive
+			applies, so only the cost of routing itself is
+			measured.
+									*/
+
+#include "cgr.h"
+
+#define	CGRBENCH_OWLT		(1)
+#define	CGRBENCH_BUNDLE_LEN	(1000)
+
+typedef struct
+{
+	int		nodesCount;
+	int		contactsPerNode;
+	int		horizon;		/*	Seconds.	*/
+	unsigned int	minRate;		/*	Bytes/second.	*/
+	unsigned int	maxRate;		/*	Bytes/second.	*/
+	int		bundlesCount;
+	unsigned int	seed;
+} CgrBenchParms;
+
+typedef struct
+{
+	int		listsCount;
+	long		routesCount;
+	int		maxRoutesCount;
+	long		loopingRoutesCount;
+} CgrBenchRoutes;
+
+static unsigned long	_lookups(int increment)
+{
+	static unsigned long	count = 0;
+
+	count += increment;
+	return count;
+}
+
+static int	lookupDirective(uvast nodeNbr, Object plans, Bundle *bundle,
+			FwdDirective *directive)
+{
+	/*	Note that a candidate route was found, but report
+	 *	that there is no way to forward the bundle to its
+	 *	proximate node, so that the bundle is never queued.	*/
+
+	oK(_lookups(1));
+	return 0;
+}
+
+static double	elapsedUsec(struct timeval *from, struct timeval *to)
+{
+	return ((to->tv_sec - from->tv_sec) * 1000000.0)
+			+ (to->tv_usec - from->tv_usec);
+}
+
+static unsigned long	wmAllocated()
+{
+	PsmUsageSummary	usage;
+
+	psm_usage(getIonwm(), &usage);
+	return usage.smallPoolAllocated + usage.largePoolAllocated;
+}
+
+static uvast	benchNode(int nodeIdx)
+{
+	/*	Node 0 of the synthetic network is the local node.	*/
+
+	return getOwnNodeNbr() + nodeIdx;
+}
+
+static int	generatePlan(CgrBenchParms *parms, time_t startTime,
+			int *contactsLoaded, int *rangesLoaded)
+{
+	int		nodesCount = parms->nodesCount;
+	int		slotLength = parms->horizon / parms->contactsPerNode;
+	int		contactsCount = nodesCount * parms->contactsPerNode;
+	IonContact	*contacts;
+	unsigned char	*pairs;
+	IonContact	*contact;
+	int		i;
+	int		j;
+	int		k;
+	int		pairIdx;
+
+	contacts = (IonContact *) malloc(contactsCount * sizeof(IonContact));
+	pairs = (unsigned char *) malloc(((nodesCount * nodesCount) / 8) + 1);
+	if (contacts == NULL || pairs == NULL)
+	{
+		if (contacts) free(contacts);
+		if (pairs) free(pairs);
+		putErrmsg("Can't allocate synthetic contact plan.",
+				itoa(contactsCount));
+		return -1;
+	}
+
+	/*	Each node's horizon is divided into one slot per
+	 *	contact, so no two contacts from the same node ever
+	 *	overlap.  Each contact is to a randomly selected
+	 *	other node and lasts for half of its slot, starting
+	 *	at a random time in the first half of the slot.		*/
+
+	memset((char *) pairs, 0, ((nodesCount * nodesCount) / 8) + 1);
+	contact = contacts;
+	for (i = 0; i < nodesCount; i++)
+	{
+		for (k = 0; k < parms->contactsPerNode; k++)
+		{
+			j = rand() % (nodesCount - 1);
+			if (j >= i)
+			{
+				j++;
+			}
+
+			contact->fromTime = startTime + (k * slotLength)
+					+ (rand() % ((slotLength / 2) + 1));
+			contact->toTime = contact->fromTime
+					+ (slotLength / 2) + 1;
+			contact->fromNode = benchNode(i);
+			contact->toNode = benchNode(j);
+			contact->xmitRate = parms->minRate
+					+ (rand() % ((parms->maxRate
+					- parms->minRate) + 1));
+			contact++;
+
+			/*	Note the pair of nodes, for ranging.	*/
+
+			if (i < j)
+			{
+				pairIdx = (i * nodesCount) + j;
+			}
+			else
+			{
+				pairIdx = (j * nodesCount) + i;
+			}
+
+			pairs[pairIdx >> 3] |= (1 << (pairIdx & 7));
+		}
+	}
+
+	/*	Every pair of nodes that are ever in contact are at
+	 *	constant range throughout the plan.			*/
+
+	*rangesLoaded = 0;
+	for (i = 0; i < nodesCount; i++)
+	{
+		for (j = i + 1; j < nodesCount; j++)
+		{
+			pairIdx = (i * nodesCount) + j;
+			if ((pairs[pairIdx >> 3] & (1 << (pairIdx & 7))) == 0)
+			{
+				continue;
+			}
+
+			if (rfx_insert_range(startTime, startTime
+					+ parms->horizon + slotLength,
+					benchNode(i), benchNode(j),
+					CGRBENCH_OWLT) == 0)
+			{
+				free(pairs);
+				free(contacts);
+				putErrmsg("Can't insert synthetic range.",
+						NULL);
+				return -1;
+			}
+
+			(*rangesLoaded)++;
+		}
+	}
+
+	free(pairs);
+	*contactsLoaded = rfx_insert_contacts(contacts, contactsCount);
+	free(contacts);
+	if (*contactsLoaded < 0)
+	{
+		putErrmsg("Can't insert synthetic contacts.", NULL);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int	routeBundle(Bundle *bundle, uvast stationNodeNbr)
+{
+	Sdr	sdr = getIonsdr();
+
+	/*	Neither the bundle object nor the plans list is ever
+	 *	referenced, since no bundle is ever enqueued, but
+	 *	cgr_forward requires that both be non-zero.		*/
+
+	bundle->destination.c.nodeNbr = stationNodeNbr;
+	CHKERR(sdr_begin_xn(sdr));
+	if (cgr_forward(bundle, (Object) 1, stationNodeNbr, (Object) 1,
+			lookupDirective) < 0)
+	{
+		sdr_cancel_xn(sdr);
+		putErrmsg("Can't route bundle.", utoa(stationNodeNbr));
+		return -1;
+	}
+
+	return sdr_end_xn(sdr);
+}
+
+static double	routeToAllNodes(CgrBenchParms *parms, Bundle *bundle)
+{
+	struct timeval	startTime;
+	struct timeval	endTime;
+	int		i;
+
+	getCurrentTime(&startTime);
+	for (i = 1; i < parms->nodesCount; i++)
+	{
+		if (routeBundle(bundle, benchNode(i)) < 0)
+		{
+			return -1.0;
+		}
+	}
+
+	getCurrentTime(&endTime);
+	return elapsedUsec(&startTime, &endTime);
+}
+
+static int	routeLoops(PsmPartition ionwm, CgrRoute *route)
+{
+	PsmAddress	elt;
+	PsmAddress	elt2;
+	IonCXref	*contact;
+	IonCXref	*prevContact;
+
+	/*	A route loops if any of its contacts is to the local
+	 *	node or to the node reached by an earlier contact.	*/
+
+	for (elt = sm_list_first(ionwm, route->hops); elt;
+			elt = sm_list_next(ionwm, elt))
+	{
+		contact = (IonCXref *) psp(ionwm, sm_list_data(ionwm, elt));
+		if (contact->toNode == getOwnNodeNbr())
+		{
+			return 1;
+		}
+
+		for (elt2 = sm_list_first(ionwm, route->hops); elt2 != elt;
+				elt2 = sm_list_next(ionwm, elt2))
+		{
+			prevContact = (IonCXref *) psp(ionwm,
+					sm_list_data(ionwm, elt2));
+			if (prevContact->toNode == contact->toNode)
+			{
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void	countRoutes(CgrBenchRoutes *routes)
+{
+	Sdr		sdr = getIonsdr();
+	PsmPartition	ionwm = getIonwm();
+	IonVdb		*ionvdb = getIonVdb();
+	PsmAddress	elt;
+	IonNode		*node;
+	int		routesCount;
+	PsmAddress	elt2;
+
+	memset((char *) routes, 0, sizeof(CgrBenchRoutes));
+	oK(sdr_begin_xn(sdr));		/*	Just to lock memory.	*/
+	for (elt = sm_rbt_first(ionwm, ionvdb->nodes); elt;
+			elt = sm_rbt_next(ionwm, elt))
+	{
+		node = (IonNode *) psp(ionwm, sm_rbt_data(ionwm, elt));
+		if (node->routingObject == 0)
+		{
+			continue;
+		}
+
+		routesCount = sm_list_length(ionwm, node->routingObject);
+		routes->listsCount++;
+		routes->routesCount += routesCount;
+		if (routesCount > routes->maxRoutesCount)
+		{
+			routes->maxRoutesCount = routesCount;
+		}
+
+		for (elt2 = sm_list_first(ionwm, node->routingObject); elt2;
+				elt2 = sm_list_next(ionwm, elt2))
+		{
+			routes->loopingRoutesCount += routeLoops(ionwm,
+					(CgrRoute *) psp(ionwm,
+					sm_list_data(ionwm, elt2)));
+		}
+	}
+
+	sdr_exit_xn(sdr);
+}
+
+static void	reportPass(char *name, double usec, int passLength)
+{
+	char	label[64];
+	char	buf[64];
+
+	isprintf(label, sizeof label, "%s routing, total (msec)", name);
+	isprintf(buf, sizeof buf, "%.3f", usec / 1000.0);
+	PUTMEMO(label, buf);
+	isprintf(label, sizeof label, "%s routing, per node (usec)", name);
+	isprintf(buf, sizeof buf, "%.1f", usec / passLength);
+	PUTMEMO(label, buf);
+}
+
+static int	run_cgrbench(CgrBenchParms *parms)
+{
+	time_t		startTime;
+	int		contactsLoaded;
+	int		rangesLoaded;
+	unsigned long	wmBefore;
+	unsigned long	wmPlan;
+	Bundle		bundle;
+	CgrBenchRoutes	routes;
+	double		usec;
+	time_t		editTime;
+	struct timeval	streamStart;
+	struct timeval	streamEnd;
+	int		i;
+	char		buf[64];
+
+	if (parms->nodesCount < 2 || parms->contactsPerNode < 1
+	|| parms->horizon < parms->contactsPerNode * 2
+	|| parms->minRate < 1 || parms->maxRate < parms->minRate
+	|| parms->bundlesCount < 0)
+	{
+		PUTS("Usage: cgrbench <number of nodes> <contacts per node> \
+<horizon (seconds)> <minimum rate> <maximum rate> [<number of bundles> \
+[<random seed>]]");
+		PUTS("  Horizon must be at least twice contacts per node.");
+		PUTS("  Rates are in bytes per second.");
+		PUTS("  Number of bundles defaults to 10000.");
+		PUTS("");
+		PUTS("  Use only on a scratch node: the synthetic contact");
+		PUTS("  plan is added to the node's contact plan.");
+		return 0;
+	}
+
+	if (ionAttach() < 0)
+	{
+		putErrmsg("cgrbench can't attach to ION.", NULL);
+		return 1;
+	}
+
+	cgr_start();
+	srand(parms->seed);
+	wmBefore = wmAllocated();
+	startTime = getUTCTime();
+	if (generatePlan(parms, startTime, &contactsLoaded, &rangesLoaded) < 0)
+	{
+		putErrmsg("cgrbench can't load synthetic contact plan.", NULL);
+		ionDetach();
+		return 1;
+	}
+
+	wmPlan = wmAllocated();
+	PUTMEMO("Nodes", itoa(parms->nodesCount));
+	PUTMEMO("Contacts loaded", itoa(contactsLoaded));
+	PUTMEMO("Ranges loaded", itoa(rangesLoaded));
+	isprintf(buf, sizeof buf, "%lu", wmPlan - wmBefore);
+	PUTMEMO("Contact plan memory (bytes)", buf);
+
+	/*	Route one bundle to every node, first with no route
+	 *	lists computed and then with all route lists already
+	 *	computed.  The bundle won't expire before the end of
+	 *	the contact plan.					*/
+
+	memset((char *) &bundle, 0, sizeof(Bundle));
+	bundle.destination.cbhe = 1;
+	bundle.destination.c.serviceNbr = 1;
+	bundle.expirationTime = (startTime + (2 * parms->horizon))
+			- EPOCH_2000_SEC;
+	bundle.payload.length = CGRBENCH_BUNDLE_LEN;
+	usec = routeToAllNodes(parms, &bundle);
+	if (usec < 0.0)
+	{
+		putErrmsg("cgrbench failed.", NULL);
+		ionDetach();
+		return 1;
+	}
+
+	reportPass("Cold", usec, parms->nodesCount - 1);
+	countRoutes(&routes);
+	PUTMEMO("Route lists", itoa(routes.listsCount));
+	isprintf(buf, sizeof buf, "%ld", routes.routesCount);
+	PUTMEMO("Routes", buf);
+	PUTMEMO("Maximum routes per list", itoa(routes.maxRoutesCount));
+	isprintf(buf, sizeof buf, "%ld", routes.loopingRoutesCount);
+	PUTMEMO("Looping routes", buf);
+	isprintf(buf, sizeof buf, "%lu", wmAllocated() - wmPlan);
+	PUTMEMO("Route list memory (bytes)", buf);
+	isprintf(buf, sizeof buf, "%lu", _lookups(0));
+	PUTMEMO("Candidate routes found", buf);
+	usec = routeToAllNodes(parms, &bundle);
+	if (usec < 0.0)
+	{
+		putErrmsg("cgrbench failed.", NULL);
+		ionDetach();
+		return 1;
+	}
+
+	reportPass("Warm", usec, parms->nodesCount - 1);
+
+	/*	Edit the contact plan, adding a contact from the
+	 *	local node after the end of the plan, and route
+	 *	a bundle to every node again.				*/
+
+	editTime = startTime + parms->horizon + 1;
+	if (rfx_insert_contact(editTime, editTime + 1, benchNode(0),
+			benchNode(1), parms->minRate) == 0)
+	{
+		putErrmsg("cgrbench can't edit contact plan.", NULL);
+		ionDetach();
+		return 1;
+	}
+
+	usec = routeToAllNodes(parms, &bundle);
+	oK(rfx_remove_contact(editTime, benchNode(0), benchNode(1)));
+	if (usec < 0.0)
+	{
+		putErrmsg("cgrbench failed.", NULL);
+		ionDetach();
+		return 1;
+	}
+
+	reportPass("Edited", usec, parms->nodesCount - 1);
+
+	/*	Finally, route a stream of bundles to randomly
+	 *	selected nodes.						*/
+
+	getCurrentTime(&streamStart);
+	for (i = 0; i < parms->bundlesCount; i++)
+	{
+		if (routeBundle(&bundle,
+			benchNode(1 + (rand() % (parms->nodesCount - 1)))) < 0)
+		{
+			putErrmsg("cgrbench failed.", NULL);
+			break;
+		}
+	}
+
+	getCurrentTime(&streamEnd);
+	usec = elapsedUsec(&streamStart, &streamEnd);
+	PUTMEMO("Bundles routed", itoa(i));
+	if (usec > 0.0)
+	{
+		isprintf(buf, sizeof buf, "%.1f", (i * 1000000.0) / usec);
+		PUTMEMO("Bundles routed per second", buf);
+	}
+
+	fflush(stdout);
+	writeErrmsgMemos();
+	ionDetach();
+	return 0;
+}
+
+#if defined (VXWORKS) || defined (RTEMS)
+int	cgrbench(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	CgrBenchParms	parms;
+
+	parms.nodesCount = a1;
+	parms.contactsPerNode = a2;
+	parms.horizon = a3;
+	parms.minRate = a4;
+	parms.maxRate = a5;
+	parms.bundlesCount = (a6 ? a6 : 10000);
+	parms.seed = a7;
+#else
+int	main(int argc, char **argv)
+{
+	CgrBenchParms	parms;
+
+	memset((char *) &parms, 0, sizeof parms);
+	parms.bundlesCount = 10000;
+	if (argc > 8) argc = 8;
+	switch (argc)
+	{
+	case 8:
+		parms.seed = strtoul(argv[7], NULL, 0);
+
+	case 7:
+		parms.bundlesCount = strtol(argv[6], NULL, 0);
+
+	case 6:
+		parms.maxRate = strtoul(argv[5], NULL, 0);
+
+	case 5:
+		parms.minRate = strtoul(argv[4], NULL, 0);
+
+	case 4:
+		parms.horizon = strtol(argv[3], NULL, 0);
+
+	case 3:
+		parms.contactsPerNode = strtol(argv[2], NULL, 0);
+
+	case 2:
+		parms.nodesCount = strtol(argv[1], NULL, 0);
+
+	default:
+		break;
+	}
+#endif
+	return run_cgrbench(&parms);
+}
@@ -60,12 +60,75 @@ int	sendBytesByUDP(int *bundleSocket, char *from, int length,
 	}
 }
 
+int	sendIovByUDP(int *bundleSocket, struct iovec *iov, int iovCount,
+		struct sockaddr *socketName)
+{
+#ifdef mingw
+	char	buffer[UDPCLA_BUFSZ];
+	int	length = 0;
+	int	i;
+
+	/*	No sendmsg() on Windows, so flatten the iovecs.		*/
+
+	CHKERR(iov);
+	for (i = 0; i < iovCount; i++)
+	{
+		if (length + iov[i].iov_len > sizeof buffer)
+		{
+			putErrmsg("Datagram is too big for UDP CLA.",
+					itoa(length + iov[i].iov_len));
+			return -1;
+		}
+
+		memcpy(buffer + length, iov[i].iov_base, iov[i].iov_len);
+		length += iov[i].iov_len;
+	}
+
+	return sendBytesByUDP(bundleSocket, buffer, length, socketName);
+#else
+	struct msghdr	msg;
+	int		bytesWritten;
+
+	CHKERR(socketName && bundleSocket && iov);
+	memset((char *) &msg, 0, sizeof msg);
+	msg.msg_name = socketName;
+	msg.msg_namelen = sizeof(struct sockaddr);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovCount;
+	while (1)	/*	Continue until not interrupted.		*/
+	{
+		bytesWritten = sendmsg(*bundleSocket, &msg, 0);
+		if (bytesWritten < 0)
+		{
+			switch (errno)
+			{
+			case EINTR:	/*	Interrupted; retry.	*/
+				continue;
+
+			case EPIPE:	/*	Lost connection.	*/
+			case EBADF:
+			case ETIMEDOUT:
+			case ECONNRESET:
+				closesocket(*bundleSocket);
+				*bundleSocket = -1;
+			}
+
+			putSysErrmsg("CLO sendmsg() error on socket", NULL);
+		}
+
+		return bytesWritten;
+	}
+#endif
+}
+
 int	sendBundleByUDP(struct sockaddr *socketName, int *bundleSocket,
 		unsigned int bundleLength, Object bundleZco,
 		unsigned char *buffer)
 {
 	Sdr		sdr;
 	ZcoReader	reader;
+	struct iovec	iov[UDPCLA_IOV_MAX];
+	int		iovCount = UDPCLA_IOV_MAX;
 	int		bytesToSend;
 	int		bytesSent;
 
@@ -89,21 +152,44 @@ int	sendBundleByUDP(struct sockaddr *socketName, int *bundleSocket,
 		}
 	}
 
-	/*	Send the bundle in a single UDP datagram.		*/
+	/*	Send the bundle in a single UDP datagram, gathered
+	 *	directly from the SDR heap where possible.  The
+	 *	iovecs may then point into the heap, so the datagram
+	 *	must be sent before the transaction ends.		*/
 
 	sdr = getIonsdr();
 	zco_start_transmitting(bundleZco, &reader);
 	zco_track_file_offset(&reader);
+	zco_gather_in_place(&reader);
 	CHKERR(sdr_begin_xn(sdr));
-	bytesToSend = zco_transmit(sdr, &reader, UDPCLA_BUFSZ, (char *) buffer);
-	if (sdr_end_xn(sdr) < 0 || bytesToSend < 0)
+	bytesToSend = zco_transmit_iov(sdr, &reader, bundleLength, iov,
+			&iovCount, (char *) buffer, UDPCLA_BUFSZ, NULL);
+	if (bytesToSend >= 0 && bytesToSend < bundleLength)
+	{
+		/*	Too many discontiguous pieces for the iovec
+		 *	array; copy all of the bundle into the buffer.	*/
+
+		zco_start_transmitting(bundleZco, &reader);
+		iovCount = UDPCLA_IOV_MAX;
+		bytesToSend = zco_transmit_iov(sdr, &reader, bundleLength,
+				iov, &iovCount, (char *) buffer, UDPCLA_BUFSZ,
+				NULL);
+	}
+
+	if (bytesToSend < 0)
+	{
+		sdr_cancel_xn(sdr);
+		putErrmsg("Can't issue from ZCO.", NULL);
+		return -1;
+	}
+
+	bytesSent = sendIovByUDP(bundleSocket, iov, iovCount, socketName);
+	if (sdr_end_xn(sdr) < 0)
 	{
 		putErrmsg("Can't issue from ZCO.", NULL);
 		return -1;
 	}
 
-	bytesSent = sendBytesByUDP(bundleSocket, (char *) buffer, bytesToSend,
-			socketName);
 	if (bytesSent < 0)
 	{
 		if (bpHandleXmitFailure(bundleZco))
@@ -142,6 +228,318 @@ when connectivity is restored.");
 	return bytesSent;
 }
 
+static int	gatherBundle(UdpBatch *batch, unsigned int bundleLength,
+			Object bundleZco)
+{
+	Sdr		sdr = getIonsdr();
+	struct iovec	*iov = batch->iov[batch->count];
+	int		iovCount = UDPCLA_IOV_MAX;
+	ZcoReader	reader;
+	int		bytesGathered;
+
+	/*	Gathers the bundle into the next message of the batch,
+	 *	copying it into the unused remainder of the batch's
+	 *	buffer: the batch is sent after the transaction in
+	 *	which the bundle was gathered has ended, so its bytes
+	 *	can't be sent from the SDR heap in place.  Returns
+	 *	the number of bytes gathered, which is less than the
+	 *	length of the bundle if the buffer space ran out, or
+	 *	-1 on any error.					*/
+
+	zco_start_transmitting(bundleZco, &reader);
+	zco_track_file_offset(&reader);
+	CHKERR(sdr_begin_xn(sdr));
+	bytesGathered = zco_transmit_iov(sdr, &reader, bundleLength, iov,
+			&iovCount, (char *) batch->buffer + batch->bufferUsed,
+			UDPCLA_BUFSZ - batch->bufferUsed, NULL);
+	if (sdr_end_xn(sdr) < 0 || bytesGathered < 0)
+	{
+		return -1;
+	}
+
+	if (bytesGathered < bundleLength)
+	{
+		return bytesGathered;
+	}
+
+	batch->iovCounts[batch->count] = iovCount;
+	batch->bufferUsed += bytesGathered;
+	return bytesGathered;
+}
+
+int	batchBundleByUDP(UdpBatch *batch, int *bundleSocket,
+		struct sockaddr *socketName, unsigned int bundleLength,
+		Object bundleZco)
+{
+	int		bytesGathered;
+
+	CHKERR(batch && bundleSocket && socketName);
+	if (bundleLength > UDPCLA_BUFSZ)
+	{
+		putErrmsg("Bundle is too big for UDP CLA.", itoa(bundleLength));
+		return -1;
+	}
+
+	if (batch->count == UDPCLA_BATCH_SIZE)
+	{
+		if (sendBatchByUDP(batch, bundleSocket) < 0)
+		{
+			return -1;
+		}
+	}
+
+	bytesGathered = gatherBundle(batch, bundleLength, bundleZco);
+	if (bytesGathered >= 0 && bytesGathered < bundleLength
+	&& batch->count > 0)
+	{
+		/*	Out of buffer space for this bundle; send
+		 *	the bundles already batched, then try again
+		 *	with the whole buffer.				*/
+
+		if (sendBatchByUDP(batch, bundleSocket) < 0)
+		{
+			return -1;
+		}
+
+		bytesGathered = gatherBundle(batch, bundleLength,
+				bundleZco);
+	}
+
+	if (bytesGathered < 0 || bytesGathered < (int) bundleLength)
+	{
+		putErrmsg("Can't issue from ZCO.", NULL);
+		return -1;
+	}
+
+	batch->bundleZcos[batch->count] = bundleZco;
+	batch->bundleLengths[batch->count] = bundleLength;
+	memcpy((char *) &(batch->socketNames[batch->count]),
+			(char *) socketName, sizeof(struct sockaddr));
+	batch->count++;
+	return 0;
+}
+
+#ifdef UDPCLA_MMSG
+static int	sendMessages(UdpBatch *batch, int *bundleSocket)
+{
+	static int	gsoAvailable = 1;
+	struct mmsghdr	msgs[UDPCLA_BATCH_SIZE];
+	struct iovec	iov[UDPCLA_BATCH_SIZE * UDPCLA_IOV_MAX];
+	union
+	{
+		char		buf[CMSG_SPACE(sizeof(uint16_t))];
+		struct cmsghdr	align;
+	}		control[UDPCLA_BATCH_SIZE];
+	int		bundlesInMsg[UDPCLA_BATCH_SIZE];
+	struct msghdr	*msg;
+#ifdef UDP_SEGMENT
+	struct cmsghdr	*cmsg;
+#endif
+	int		msgCount;
+	int		iovCount;
+	int		bundlesSent = 0;
+	int		first;
+	int		i;
+	int		j;
+	unsigned int	segmentSize;
+	unsigned int	gsoLength;
+	int		msgsSent;
+
+	/*	Sends the batch's bundles in as few system calls as
+	 *	possible.  Returns the number of bundles sent.		*/
+
+#ifndef UDP_SEGMENT
+	gsoAvailable = 0;
+#endif
+	while (bundlesSent < batch->count)
+	{
+		memset((char *) msgs, 0, sizeof msgs);
+		msgCount = 0;
+		iovCount = 0;
+		i = bundlesSent;
+		while (i < batch->count)
+		{
+			msg = &(msgs[msgCount].msg_hdr);
+			msg->msg_name = &(batch->socketNames[i]);
+			msg->msg_namelen = sizeof(struct sockaddr);
+			msg->msg_iov = iov + iovCount;
+			first = i;
+			segmentSize = batch->bundleLengths[i];
+			gsoLength = 0;
+			while (i < batch->count)
+			{
+				/*	A GSO send is a series of
+				 *	datagrams to the same induct,
+				 *	all of the same length except
+				 *	that the last may be shorter.	*/
+
+				if (i > first && (!gsoAvailable
+				|| segmentSize > UDPCLA_GSO_SEGMENT_MAX
+				|| i - first == 64
+				|| batch->bundleLengths[i] > segmentSize
+				|| batch->bundleLengths[i - 1] < segmentSize
+				|| gsoLength + batch->bundleLengths[i]
+						> UDPCLA_GSO_MAX
+				|| memcmp((char *) &(batch->socketNames[i]),
+					(char *) &(batch->socketNames[first]),
+					sizeof(struct sockaddr)) != 0))
+				{
+					break;
+				}
+
+				for (j = 0; j < batch->iovCounts[i]; j++)
+				{
+					iov[iovCount] = batch->iov[i][j];
+					iovCount++;
+				}
+
+				gsoLength += batch->bundleLengths[i];
+				i++;
+			}
+
+			msg->msg_iovlen = (iov + iovCount) - msg->msg_iov;
+#ifdef UDP_SEGMENT
+			if (i - first > 1)
+			{
+				msg->msg_control = control[msgCount].buf;
+				msg->msg_controllen =
+					sizeof control[msgCount].buf;
+				cmsg = CMSG_FIRSTHDR(msg);
+				cmsg->cmsg_level = SOL_UDP;
+				cmsg->cmsg_type = UDP_SEGMENT;
+				cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+				*((uint16_t *) CMSG_DATA(cmsg)) = segmentSize;
+			}
+#endif
+			bundlesInMsg[msgCount] = i - first;
+			msgCount++;
+		}
+
+		msgsSent = sendmmsg(*bundleSocket, msgs, msgCount, 0);
+		if (msgsSent < 0)
+		{
+			if (errno == EINTR)	/*	Interrupted.	*/
+			{
+				continue;
+			}
+
+			if (bundlesInMsg[0] > 1 && (errno == EIO
+			|| errno == EINVAL || errno == ENOPROTOOPT
+			|| errno == EOPNOTSUPP))
+			{
+				/*	No GSO support on this host or
+				 *	interface; stop trying to use it.*/
+
+				writeMemo("[i] UDP GSO is unavailable; udpclo \
+sends bundles in separate datagrams.");
+				gsoAvailable = 0;
+				continue;
+			}
+
+			switch (errno)
+			{
+			case EPIPE:	/*	Lost connection.	*/
+			case EBADF:
+			case ETIMEDOUT:
+			case ECONNRESET:
+				closesocket(*bundleSocket);
+				*bundleSocket = -1;
+			}
+
+			putSysErrmsg("CLO sendmmsg() error on socket", NULL);
+			break;
+		}
+
+		for (j = 0; j < msgsSent; j++)
+		{
+			bundlesSent += bundlesInMsg[j];
+		}
+	}
+
+	return bundlesSent;
+}
+#endif
+
+int	sendBatchByUDP(UdpBatch *batch, int *bundleSocket)
+{
+	Sdr	sdr = getIonsdr();
+	int	bundlesSent = 0;
+	int	result = 0;
+	int	i;
+
+	CHKERR(batch && bundleSocket);
+	if (batch->count == 0)
+	{
+		return 0;
+	}
+
+	/*	Connect to CLI as necessary.				*/
+
+	if (*bundleSocket >= 0 || openUdpSocket(bundleSocket) == 0)
+	{
+#ifdef UDPCLA_MMSG
+		bundlesSent = sendMessages(batch, bundleSocket);
+#else
+		while (bundlesSent < batch->count)
+		{
+			if (sendIovByUDP(bundleSocket,
+					batch->iov[bundlesSent],
+					batch->iovCounts[bundlesSent],
+					&(batch->socketNames[bundlesSent])) < 0)
+			{
+				break;
+			}
+
+			bundlesSent++;
+		}
+#endif
+	}
+
+	if (bundlesSent < batch->count)
+	{
+		for (i = bundlesSent; i < batch->count; i++)
+		{
+			if (bpHandleXmitFailure(batch->bundleZcos[i]))
+			{
+				putErrmsg("Can't handle xmit failure.", NULL);
+				return -1;
+			}
+		}
+
+		if (*bundleSocket == -1)
+		{
+			/*	Just lost connection; treat as a
+			 *	transient anomaly, note the incomplete
+			 *	transmission.				*/
+
+			writeMemo("[i] Lost UDP connection to CLI; restart CLO \
+when connectivity is restored.");
+		}
+		else
+		{
+			putErrmsg("Failed to send by UDP.", NULL);
+		}
+
+		result = -1;
+	}
+
+	CHKERR(sdr_begin_xn(sdr));
+	for (i = 0; i < batch->count; i++)
+	{
+		zco_destroy(sdr, batch->bundleZcos[i]);
+	}
+
+	batch->count = 0;
+	batch->bufferUsed = 0;
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't destroy bundle ZCOs.", NULL);
+		return -1;
+	}
+
+	return result;
+}
+
 /*	*	*	Receiver functions	*	*	*	*/
 
 int	receiveBytesByUDP(int bundleSocket, struct sockaddr_in *fromAddr,
@@ -167,3 +565,101 @@ int	receiveBytesByUDP(int bundleSocket, struct sockaddr_in *fromAddr,
 
 	return bytesRead;
 }
+
+int	receiveBatchByUDP(int bundleSocket, UdpRecvBatch *batch)
+{
+#ifdef UDPCLA_MMSG
+	struct mmsghdr	msgs[UDPCLA_BATCH_SIZE];
+	struct iovec	iov[UDPCLA_BATCH_SIZE];
+	union
+	{
+		char		buf[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr	align;
+	}		control[UDPCLA_BATCH_SIZE];
+	struct msghdr	*msg;
+#ifdef UDP_GRO
+	struct cmsghdr	*cmsg;
+#endif
+	int		count;
+	int		i;
+
+	CHKERR(batch && batch->buffers);
+	memset((char *) msgs, 0, sizeof msgs);
+	for (i = 0; i < UDPCLA_BATCH_SIZE; i++)
+	{
+		iov[i].iov_base = batch->buffers + (i * UDPCLA_BUFSZ);
+		iov[i].iov_len = UDPCLA_BUFSZ;
+		msg = &(msgs[i].msg_hdr);
+		msg->msg_name = &(batch->fromAddrs[i]);
+		msg->msg_namelen = sizeof(struct sockaddr_in);
+		msg->msg_iov = &(iov[i]);
+		msg->msg_iovlen = 1;
+		msg->msg_control = control[i].buf;
+		msg->msg_controllen = sizeof control[i].buf;
+	}
+
+	/*	Block until at least one datagram has arrived, then
+	 *	take all others that have already arrived, up to the
+	 *	size of the batch.					*/
+
+	while (1)
+	{
+		count = recvmmsg(bundleSocket, msgs, UDPCLA_BATCH_SIZE,
+				MSG_WAITFORONE, NULL);
+		if (count < 0)
+		{
+			if (errno == EINTR)	/*	Interrupted.	*/
+			{
+				continue;
+			}
+
+			if (errno == EBADF)	/*	Shutdown.	*/
+			{
+				return 0;
+			}
+
+			putSysErrmsg("CLI recvmmsg() error on socket", NULL);
+			return -1;
+		}
+
+		break;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		batch->lengths[i] = msgs[i].msg_len;
+		batch->segmentSizes[i] = 0;
+#ifdef UDP_GRO
+		for (cmsg = CMSG_FIRSTHDR(&(msgs[i].msg_hdr)); cmsg;
+				cmsg = CMSG_NXTHDR(&(msgs[i].msg_hdr), cmsg))
+		{
+			if (cmsg->cmsg_level == SOL_UDP
+			&& cmsg->cmsg_type == UDP_GRO)
+			{
+				memcpy((char *) &(batch->segmentSizes[i]),
+					CMSG_DATA(cmsg), sizeof(int));
+			}
+		}
+#endif
+	}
+
+	batch->count = count;
+	return count;
+#else
+	int	length;
+
+	CHKERR(batch && batch->buffers);
+	batch->count = 0;
+	length = receiveBytesByUDP(bundleSocket, &(batch->fromAddrs[0]),
+			batch->buffers, UDPCLA_BUFSZ);
+	if (length <= 0)
+	{
+		return length;
+	}
+
+	batch->lengths[0] = length;
+	batch->segmentSizes[0] = 0;
+	batch->count = 1;
+	return 1;
+#endif
+}
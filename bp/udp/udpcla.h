@@ -15,6 +15,10 @@
 #ifndef _UDPCLA_H_
 #define _UDPCLA_H_
 
+#if defined (linux) && !defined (_GNU_SOURCE)
+#define _GNU_SOURCE		/*	For sendmmsg and recvmmsg.	*/
+#endif
+
 #include "bpP.h"
 #include <pthread.h>
 
@@ -26,14 +30,84 @@ extern "C" {
 #define BpUdpDefaultPortNbr	4556
 #define	DEFAULT_UDP_RATE	125000000
 
+#ifndef UDPCLA_IOV_MAX
+#define	UDPCLA_IOV_MAX		(16)
+#endif
+
+/*	udpclo sends, and udpcli receives, up to UDPCLA_BATCH_SIZE
+ *	datagrams per system call where sendmmsg and recvmmsg are
+ *	available.  On Linux, consecutive bundles of equal length
+ *	that are bound for the same induct are further coalesced
+ *	into a single UDP generic segmentation offload (GSO) send
+ *	of up to UDPCLA_GSO_MAX bytes, provided the bundles are no
+ *	longer than UDPCLA_GSO_SEGMENT_MAX bytes (i.e., each fits
+ *	in an unfragmented IP packet), and udpcli asks the kernel
+ *	for generic receive offload (GRO) of inbound datagrams.	*/
+
+#if defined (linux) && !defined (UDPCLA_NO_MMSG)
+#define	UDPCLA_MMSG
+#endif
+
+#ifndef UDPCLA_BATCH_SIZE
+#define	UDPCLA_BATCH_SIZE	(8)
+#endif
+
+#ifdef UDPCLA_MMSG
+#define	UDPCLA_RECV_BATCH	UDPCLA_BATCH_SIZE
+#else
+#define	UDPCLA_RECV_BATCH	(1)
+#endif
+
+#ifndef UDPCLA_GSO_SEGMENT_MAX
+#define	UDPCLA_GSO_SEGMENT_MAX	(1472)
+#endif
+
+#ifndef UDPCLA_GSO_MAX
+#define	UDPCLA_GSO_MAX		(65000)
+#endif
+
+typedef struct
+{
+	int		count;
+	unsigned char	*buffer;	/*	UDPCLA_BUFSZ bytes.	*/
+	int		bufferUsed;
+	Object		bundleZcos[UDPCLA_BATCH_SIZE];
+	unsigned int	bundleLengths[UDPCLA_BATCH_SIZE];
+	struct sockaddr	socketNames[UDPCLA_BATCH_SIZE];
+	struct iovec	iov[UDPCLA_BATCH_SIZE][UDPCLA_IOV_MAX];
+	int		iovCounts[UDPCLA_BATCH_SIZE];
+} UdpBatch;
+
+/*	Each message received into a UdpRecvBatch is either a single
+ *	datagram (segmentSize zero) or, by GRO, a series of datagrams
+ *	from the same sender all of length segmentSize except that
+ *	the last may be shorter.					*/
+
+typedef struct
+{
+	int		count;		/*	Messages received.	*/
+	char		*buffers;	/*	UDPCLA_RECV_BATCH *
+					 *	UDPCLA_BUFSZ bytes.	*/
+	int		lengths[UDPCLA_BATCH_SIZE];
+	int		segmentSizes[UDPCLA_BATCH_SIZE];
+	struct sockaddr_in	fromAddrs[UDPCLA_BATCH_SIZE];
+} UdpRecvBatch;
+
 extern int	connectToCLI(int *sock);
 extern int	sendBytesByUDP(int *bundleSocket, char *from, int length,
 			struct sockaddr *socketName);
+extern int	sendIovByUDP(int *bundleSocket, struct iovec *iov,
+			int iovCount, struct sockaddr *socketName);
 extern int	sendBundleByUDP(struct sockaddr *socketName, int *bundleSocket,
 			unsigned int bundleLength, Object bundleZco,
 			unsigned char *buffer);
+extern int	batchBundleByUDP(UdpBatch *batch, int *bundleSocket,
+			struct sockaddr *socketName,
+			unsigned int bundleLength, Object bundleZco);
+extern int	sendBatchByUDP(UdpBatch *batch, int *bundleSocket);
 extern int	receiveBytesByUDP(int bundleSocket,
 			struct sockaddr_in *fromAddr,char *into, int length);
+extern int	receiveBatchByUDP(int bundleSocket, UdpRecvBatch *batch);
 
 #ifdef __cplusplus
 }
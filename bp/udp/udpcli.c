@@ -30,6 +30,164 @@ typedef struct
 	int		running;
 } ReceiverThreadParms;
 
+/*	A batch of messages received by GRO may comprise many more
+ *	datagrams than messages; the kernel coalesces no more than
+ *	64 datagrams into one message.					*/
+
+#define	UDPCLI_MAX_DATAGRAMS	(UDPCLA_RECV_BATCH * 64)
+
+typedef struct
+{
+	char			*bytes;
+	int			length;
+	struct sockaddr_in	*fromAddr;
+	Object			zco;
+} UdpDatagram;
+
+static int	acquireDatagram(AcqWorkArea *work, UdpDatagram *datagram)
+{
+	unsigned int	hostNbr;
+	char		hostName[MAXHOSTNAMELEN + 1];
+	char		senderEidBuffer[SDRSTRING_BUFSZ];
+	char		*senderEid;
+
+	memcpy((char *) &hostNbr,
+			(char *) &(datagram->fromAddr->sin_addr.s_addr), 4);
+	hostNbr = ntohl(hostNbr);
+	printDottedString(hostNbr, hostName);
+	senderEid = senderEidBuffer;
+	getSenderEid(&senderEid, hostName);
+	if (bpBeginAcq(work, 0, senderEid) < 0)
+	{
+		return -1;
+	}
+
+	if (datagram->zco)
+	{
+		if (bpLoadAcq(work, datagram->zco) < 0)
+		{
+			return -1;
+		}
+
+		datagram->zco = 0;	/*	Now the work area's.	*/
+	}
+	else
+	{
+		if (bpContinueAcq(work, datagram->bytes, datagram->length) < 0)
+		{
+			return -1;
+		}
+	}
+
+	return bpEndAcq(work);
+}
+
+static int	acquireDatagrams(AcqWorkArea *work, UdpRecvBatch *batch,
+			int maxAcqInHeap, UdpDatagram *datagrams)
+{
+	Sdr		sdr = getIonsdr();
+	int		count = 0;
+	int		stopping = 0;
+	char		*bytes;
+	int		segmentSize;
+	int		offset;
+	Object		extentObj;
+	int		i;
+
+	/*	Returns 1 on receiving the shutdown datagram, after
+	 *	acquiring all datagrams received ahead of it; 0 after
+	 *	acquiring all datagrams; -1 on any failure.		*/
+
+	for (i = 0; i < batch->count; i++)
+	{
+		if (batch->lengths[i] == 1)	/*	Normal stop.	*/
+		{
+			stopping = 1;
+			break;
+		}
+
+		bytes = batch->buffers + (i * UDPCLA_BUFSZ);
+		segmentSize = batch->segmentSizes[i];
+		if (segmentSize <= 0)
+		{
+			segmentSize = batch->lengths[i];
+		}
+
+		for (offset = 0; offset < batch->lengths[i]
+				&& count < UDPCLI_MAX_DATAGRAMS;
+				offset += segmentSize)
+		{
+			datagrams[count].bytes = bytes + offset;
+			datagrams[count].length = MIN(segmentSize,
+					batch->lengths[i] - offset);
+			datagrams[count].fromAddr = &(batch->fromAddrs[i]);
+			datagrams[count].zco = 0;
+			count++;
+		}
+	}
+
+	/*	The whole batch is acquired in a single transaction.
+	 *	All datagrams that are to be acquired into the heap
+	 *	are first inserted as the ZCOs of inbound bundles;
+	 *	any datagram that must be acquired into a file, or
+	 *	for which there is currently no ZCO space, is instead
+	 *	acquired in the usual way.				*/
+
+	if (bpBeginAcqBatch(work) < 0)
+	{
+		putErrmsg("Can't begin acquisition batch.", NULL);
+		return -1;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (datagrams[i].length > maxAcqInHeap)
+		{
+			continue;
+		}
+
+		extentObj = sdr_insert(sdr, datagrams[i].bytes,
+				datagrams[i].length);
+		if (extentObj == 0)
+		{
+			break;
+		}
+
+		datagrams[i].zco = zco_create(sdr, ZcoSdrSource, extentObj, 0,
+				datagrams[i].length);
+		switch (datagrams[i].zco)
+		{
+		case (Object) ERROR:
+			putErrmsg("Can't create inbound bundle ZCO.", NULL);
+			bpCancelAcqBatch(work);
+			return -1;
+
+		case 0:
+			sdr_free(sdr, extentObj);
+		}
+	}
+
+	/*	Canceling the batch reverses the insertion of all
+	 *	of its ZCOs, whether or not already acquired.		*/
+
+	for (i = 0; i < count; i++)
+	{
+		if (acquireDatagram(work, datagrams + i) < 0)
+		{
+			bpCancelAcqBatch(work);
+			return -1;
+		}
+	}
+
+	if (bpEndAcqBatch(work) < 0)
+	{
+		putErrmsg("Can't end acquisition batch.", NULL);
+		return -1;
+	}
+
+	return stopping;
+}
+
 static void	*handleDatagrams(void *parm)
 {
 	/*	Main loop for UDP datagram reception and handling.	*/
@@ -37,13 +195,9 @@ static void	*handleDatagrams(void *parm)
 	ReceiverThreadParms	*rtp = (ReceiverThreadParms *) parm;
 	char			*procName = "udpcli";
 	AcqWorkArea		*work;
-	char			*buffer;
-	int			bundleLength;
-	struct sockaddr_in	fromAddr;
-	unsigned int		hostNbr;
-	char			hostName[MAXHOSTNAMELEN + 1];
-	char			senderEidBuffer[SDRSTRING_BUFSZ];
-	char			*senderEid;
+	UdpRecvBatch		batch;
+	UdpDatagram		*datagrams;
+	int			maxAcqInHeap;
 
 	snooze(1);	/*	Let main thread become interruptable.	*/
 	work = bpGetAcqArea(rtp->vduct);
@@ -54,31 +208,53 @@ static void	*handleDatagrams(void *parm)
 		return NULL;
 	}
 
-	buffer = MTAKE(UDPCLA_BUFSZ);
-	if (buffer == NULL)
+	/*	The batch buffers and datagram list are private to
+	 *	this thread, so they are in the process's own heap
+	 *	rather than in ION working memory.			*/
+
+	batch.buffers = malloc(UDPCLA_RECV_BATCH * UDPCLA_BUFSZ);
+	if (batch.buffers == NULL)
 	{
 		putErrmsg("udpcli can't get UDP buffer.", NULL);
 		ionKillMainThread(procName);
 		return NULL;
 	}
 
+	datagrams = (UdpDatagram *) malloc(UDPCLI_MAX_DATAGRAMS
+			* sizeof(UdpDatagram));
+	if (datagrams == NULL)
+	{
+		free(batch.buffers);
+		putErrmsg("udpcli can't get datagram list.", NULL);
+		ionKillMainThread(procName);
+		return NULL;
+	}
+
+	/*	As in bpContinueAcq, datagrams no longer than the
+	 *	node's maximum heap acquisition length are acquired
+	 *	into the heap.						*/
+
+	maxAcqInHeap = bpMaxAcqInHeap();
+	if (maxAcqInHeap < 0)
+	{
+		free(datagrams);
+		free(batch.buffers);
+		putErrmsg("udpcli can't get heap acquisition limit.", NULL);
+		ionKillMainThread(procName);
+		return NULL;
+	}
+
 	/*	Can now start receiving bundles.  On failure, take
 	 *	down the CLI.						*/
 
 	while (rtp->running)
 	{	
-		bundleLength = receiveBytesByUDP(rtp->ductSocket, &fromAddr,
-				buffer, UDPCLA_BUFSZ);
-		switch (bundleLength)
+		switch (receiveBatchByUDP(rtp->ductSocket, &batch))
 		{
 		case -1:
 		case 0:
 			putErrmsg("Can't acquire bundle.", NULL);
 			ionKillMainThread(procName);
-
-			/*	Intentional fall-through to next case.	*/
-
-		case 1:				/*	Normal stop.	*/
 			rtp->running = 0;
 			continue;
 
@@ -86,20 +262,21 @@ static void	*handleDatagrams(void *parm)
 			break;			/*	Out of switch.	*/
 		}
 
-		memcpy((char *) &hostNbr,
-				(char *) &(fromAddr.sin_addr.s_addr), 4);
-		hostNbr = ntohl(hostNbr);
-		printDottedString(hostNbr, hostName);
-		senderEid = senderEidBuffer;
-		getSenderEid(&senderEid, hostName);
-		if (bpBeginAcq(work, 0, senderEid) < 0
-		|| bpContinueAcq(work, buffer, bundleLength) < 0
-		|| bpEndAcq(work) < 0)
+		switch (acquireDatagrams(work, &batch, maxAcqInHeap,
+				datagrams))
 		{
+		case -1:
 			putErrmsg("Can't acquire bundle.", NULL);
 			ionKillMainThread(procName);
+
+			/*	Intentional fall-through to next case.	*/
+
+		case 1:				/*	Normal stop.	*/
 			rtp->running = 0;
 			continue;
+
+		default:
+			break;			/*	Out of switch.	*/
 		}
 
 		/*	Make sure other tasks have a chance to run.	*/
@@ -113,7 +290,8 @@ static void	*handleDatagrams(void *parm)
 	/*	Free resources.						*/
 
 	bpReleaseAcqArea(work);
-	MRELEASE(buffer);
+	free(datagrams);
+	free(batch.buffers);
 	return NULL;
 }
 
@@ -225,6 +403,18 @@ int	main(int argc, char *argv[])
 		return -1;
 	}
 
+#if defined (UDPCLA_MMSG) && defined (UDP_GRO)
+	/*	Ask for generic receive offload.  Without it, each
+	 *	datagram is simply received separately.			*/
+
+	{
+		int	on = 1;
+
+		oK(setsockopt(rtp.ductSocket, SOL_UDP, UDP_GRO, (char *) &on,
+				sizeof on));
+	}
+#endif
+
 	/*	Initialize sender endpoint ID lookup.			*/
 
 	ipnInit();
@@ -32,6 +32,18 @@ static void	shutDownClo()	/*	Commands CLO termination.	*/
 	sm_SemEnd(udpcloSemaphore(NULL));
 }
 
+static int	bundlesQueued(Sdr sdr, Outduct *outduct)
+{
+	int	count;
+
+	CHKZERO(sdr_begin_xn(sdr));	/*	Just to lock memory.	*/
+	count = sdr_list_length(sdr, outduct->urgentQueue)
+			+ sdr_list_length(sdr, outduct->stdQueue)
+			+ sdr_list_length(sdr, outduct->bulkQueue);
+	sdr_exit_xn(sdr);
+	return count;
+}
+
 /*	*	*	Main thread functions	*	*	*	*/
 
 #if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
@@ -59,7 +71,7 @@ int	main(int argc, char *argv[])
 	char			destDuctName[MAX_CL_DUCT_NAME_LEN + 1];
 	unsigned int		bundleLength;
 	int			ductSocket = -1;
-	int			bytesSent;
+	UdpBatch		batch;
 
 	if (bpAttach() < 0)
 	{
@@ -123,6 +135,8 @@ int	main(int argc, char *argv[])
 
 	/*	Can now begin transmitting to remote duct.		*/
 
+	memset((char *) &batch, 0, sizeof(UdpBatch));
+	batch.buffer = buffer;
 	writeMemo("[i] udpclo is running.");
 	while (!(sm_SemEnded(vduct->semaphore)))
 	{
@@ -170,9 +184,23 @@ int	main(int argc, char *argv[])
 		CHKZERO(sdr_begin_xn(sdr));
 		bundleLength = zco_length(sdr, bundleZco);
 		sdr_exit_xn(sdr);
-		bytesSent = sendBundleByUDP(&socketName, &ductSocket,
-				bundleLength, bundleZco, buffer);
-		if (bytesSent < bundleLength)
+		if (batchBundleByUDP(&batch, &ductSocket, &socketName,
+				bundleLength, bundleZco) < 0)
+		{
+			sm_SemEnd(udpcloSemaphore(NULL));/*	Stop.	*/
+			continue;
+		}
+
+		/*	Keep adding bundles to the batch for as long as
+		 *	more are ready to be dequeued without waiting.	*/
+
+		if (vduct->xmitThrottle.capacity > 0
+		&& bundlesQueued(sdr, &outduct) > 0)
+		{
+			continue;
+		}
+
+		if (sendBatchByUDP(&batch, &ductSocket) < 0)
 		{
 			sm_SemEnd(udpcloSemaphore(NULL));/*	Stop.	*/
 			continue;
@@ -183,6 +211,7 @@ int	main(int argc, char *argv[])
 		sm_TaskYield();
 	}
 
+	oK(sendBatchByUDP(&batch, &ductSocket));
 	if (ductSocket != -1)
 	{
 		closesocket(ductSocket);
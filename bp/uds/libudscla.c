@@ -0,0 +1,917 @@
+/*
+	libudscla.c:	common functions for Unix-domain socket
+			convergence layer adapter modules.
+
+									*/
+#include "udscla.h"
+
+#ifdef UDSCLA_SUPPORTED
+
+#ifdef linux
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#endif
+
+typedef union
+{
+	struct cmsghdr	header;
+	char		space[CMSG_SPACE(sizeof(int))];
+} UdsControl;
+
+int	udsSocketName(char *socketPath, struct sockaddr_un *socketName)
+{
+	CHKERR(socketPath);
+	CHKERR(socketName);
+	if (strlen(socketPath) >= sizeof socketName->sun_path)
+	{
+		putErrmsg("Unix-domain socket path name is too long.",
+				socketPath);
+		return -1;
+	}
+
+	memset((char *) socketName, 0, sizeof(struct sockaddr_un));
+	socketName->sun_family = AF_UNIX;
+	istrcpy(socketName->sun_path, socketPath,
+			sizeof socketName->sun_path);
+	return 0;
+}
+
+int	udsConnect(char *socketPath, int *sock)
+{
+	struct sockaddr_un	socketName;
+	int			errnum;
+
+	CHKERR(sock);
+	if (udsSocketName(socketPath, &socketName) < 0)
+	{
+		return -1;
+	}
+
+	*sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (*sock < 0)
+	{
+		putSysErrmsg("Can't open Unix-domain socket", socketPath);
+		return -1;
+	}
+
+	if (connect(*sock, (struct sockaddr *) &socketName,
+			sizeof(struct sockaddr_un)) < 0)
+	{
+		errnum = errno;
+		close(*sock);
+		*sock = -1;
+		switch (errnum)
+		{
+		case ENOENT:		/*	No induct yet.		*/
+		case ECONNREFUSED:	/*	Induct has stopped.	*/
+			return 0;
+		}
+
+		errno = errnum;
+		putSysErrmsg("Can't connect to Unix-domain socket",
+				socketPath);
+		return -1;
+	}
+
+	return 1;
+}
+
+/*	*	*	Sender functions	*	*	*	*/
+
+static int	sendIovByUds(int *sock, struct iovec *iov, int iovCount,
+			int fd)
+{
+	struct msghdr	msg;
+	UdsControl	control;
+	struct cmsghdr	*cmsg;
+	int		bytesSent;
+
+	memset((char *) &msg, 0, sizeof msg);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovCount;
+	if (fd >= 0)
+	{
+		/*	The descriptor is passed along with the first
+		 *	byte sent, i.e., with the segment header.	*/
+
+		memset((char *) &control, 0, sizeof control);
+		msg.msg_control = control.space;
+		msg.msg_controllen = sizeof control.space;
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), (char *) &fd, sizeof(int));
+	}
+
+	while (msg.msg_iovlen > 0)
+	{
+		bytesSent = sendmsg(*sock, &msg, 0);
+		if (bytesSent < 0)
+		{
+			switch (errno)
+			{
+			case EINTR:	/*	Interrupted; retry.	*/
+				continue;
+
+			case EPIPE:	/*	Lost connection.	*/
+			case EBADF:
+			case ENOTCONN:
+			case ECONNRESET:
+				close(*sock);
+				*sock = -1;
+				return 0;
+			}
+
+			putSysErrmsg("sendmsg() error on socket", NULL);
+			return -1;
+		}
+
+		msg.msg_control = NULL;
+		msg.msg_controllen = 0;
+
+		/*	Skip over whatever was sent.			*/
+
+		while (msg.msg_iovlen > 0 && bytesSent >= msg.msg_iov->iov_len)
+		{
+			bytesSent -= msg.msg_iov->iov_len;
+			msg.msg_iov++;
+			msg.msg_iovlen--;
+		}
+
+		if (bytesSent > 0)
+		{
+			msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base
+					+ bytesSent;
+			msg.msg_iov->iov_len -= bytesSent;
+		}
+	}
+
+	return 0;
+}
+
+static int	sendZcoByUds(int *sock, unsigned int bundleLength,
+			Object bundleZco, char *buffer)
+{
+	Sdr			sdr = getIonsdr();
+	unsigned int		bytesRemaining = bundleLength;
+	unsigned int		flags = UDSCLA_FIRST;
+	ZcoReader		reader;
+	UdsSegment		segment;
+	struct iovec		iov[UDSCLA_IOV_MAX];
+	int			iovCount;
+	ZcoExtentDescriptor	fileExtent;
+	vast			bytesLoaded;
+	unsigned int		inlineLength;
+	int			result;
+
+	/*	Bytes in the SDR heap are copied into the buffer and
+	 *	sent inline; the transaction can't be held open while
+	 *	the send blocks, as udscli needs it to acquire the
+	 *	bundle.  The content of a file-backed extent is not
+	 *	sent; the descriptor of the file is passed instead.
+	 *	If the file can't be read, zco_transmit_iov() gathers
+	 *	fill into the buffer in its place, which is then sent
+	 *	inline like any other bytes.				*/
+
+	zco_start_transmitting(bundleZco, &reader);
+	iov[0].iov_base = (char *) &segment;
+	iov[0].iov_len = sizeof(UdsSegment);
+	while (bytesRemaining > 0)
+	{
+		iovCount = UDSCLA_IOV_MAX - 1;
+		CHKERR(sdr_begin_xn(sdr));
+		bytesLoaded = zco_transmit_iov(sdr, &reader, bytesRemaining,
+				iov + 1, &iovCount, buffer, UDSCLA_BUFSZ,
+				&fileExtent);
+		if (sdr_end_xn(sdr) < 0 || bytesLoaded <= 0)
+		{
+			if (fileExtent.fd >= 0)
+			{
+				close(fileExtent.fd);
+			}
+
+			putErrmsg("ZCO length error.", NULL);
+			return -1;
+		}
+
+		bytesRemaining -= bytesLoaded;
+		inlineLength = bytesLoaded;
+		if (fileExtent.fd >= 0)
+		{
+			inlineLength -= fileExtent.length;
+		}
+
+		result = 0;
+		if (inlineLength > 0)
+		{
+			segment.flags = flags;
+			if (bytesRemaining == 0 && fileExtent.fd < 0)
+			{
+				segment.flags |= UDSCLA_LAST;
+			}
+
+			segment.length = inlineLength;
+			segment.offset = 0;
+			result = sendIovByUds(sock, iov, iovCount + 1, -1);
+			flags = 0;
+		}
+
+		if (fileExtent.fd >= 0)
+		{
+			if (result == 0 && *sock != -1)
+			{
+				segment.flags = flags | UDSCLA_FILE;
+				if (bytesRemaining == 0)
+				{
+					segment.flags |= UDSCLA_LAST;
+				}
+
+				segment.length = fileExtent.length;
+				segment.offset = fileExtent.offset;
+				result = sendIovByUds(sock, iov, 1,
+						fileExtent.fd);
+				flags = 0;
+			}
+
+			close(fileExtent.fd);
+		}
+
+		if (result < 0)
+		{
+			putErrmsg("Failed to send by Unix-domain socket.",
+					NULL);
+			return -1;
+		}
+
+		if (*sock == -1)
+		{
+			return 0;	/*	Lost connection.	*/
+		}
+	}
+
+	return 1;
+}
+
+int	sendBundleByUds(int *sock, unsigned int bundleLength,
+		Object bundleZco, char *buffer)
+{
+	Sdr	sdr = getIonsdr();
+	int	result;
+
+	CHKERR(sock);
+	CHKERR(*sock >= 0);
+	CHKERR(buffer);
+	result = sendZcoByUds(sock, bundleLength, bundleZco, buffer);
+	if (result < 0)
+	{
+		return -1;
+	}
+
+	if (result == 0)
+	{
+		/*	Just lost connection; treat as a transient
+		 *	anomaly, note the incomplete transmission.	*/
+
+		writeMemo("[?] Disconnected from udscli; bundle not sent.");
+		if (bpHandleXmitFailure(bundleZco) < 0)
+		{
+			putErrmsg("Can't handle uds xmit failure.", NULL);
+			return -1;
+		}
+	}
+	else
+	{
+		if (bpHandleXmitSuccess(bundleZco, 0) < 0)
+		{
+			putErrmsg("Can't handle xmit success.", NULL);
+			return -1;
+		}
+	}
+
+	CHKERR(sdr_begin_xn(sdr));
+	zco_destroy(sdr, bundleZco);
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't destroy bundle ZCO.", NULL);
+		return -1;
+	}
+
+	return result;
+}
+
+/*	*	*	Receiver functions	*	*	*	*/
+
+typedef struct
+{
+	Object	zco;
+	Object	fileRef;
+	int	fileRefFlagged;
+	int	fd;		/*	Open for writing to the file.	*/
+	vast	fileLength;
+	int	congestive;
+	int	unreadable;
+} UdsAcq;
+
+static int	receiveSegment(int sock, UdsSegment *segment, int *fd)
+{
+	char		*into = (char *) segment;
+	int		bytesRemaining = sizeof(UdsSegment);
+	struct msghdr	msg;
+	struct iovec	iov;
+	UdsControl	control;
+	struct cmsghdr	*cmsg;
+	int		bytesRead;
+	char		*passed;
+	int		fdCount;
+	int		passedFd;
+	int		i;
+
+	/*	Returns 1 on success, 0 if the connection was closed,
+	 *	reception was interrupted by SIGTERM, or ancillary data
+	 *	were lost, -1 on any system error.  *fd is any file
+	 *	descriptor that was passed along with the segment
+	 *	header; every other descriptor passed is closed.	*/
+
+	*fd = -1;
+	while (bytesRemaining > 0)
+	{
+		iov.iov_base = into;
+		iov.iov_len = bytesRemaining;
+		memset((char *) &msg, 0, sizeof msg);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.space;
+		msg.msg_controllen = sizeof control.space;
+		bytesRead = recvmsg(sock, &msg, 0);
+		if (bytesRead < 0 && errno != EINTR)
+		{
+			putSysErrmsg("recvmsg() error on socket", NULL);
+		}
+
+		if (bytesRead <= 0)
+		{
+			if (*fd >= 0)
+			{
+				close(*fd);
+				*fd = -1;
+			}
+
+			return (bytesRead == 0 || errno == EINTR) ? 0 : -1;
+		}
+
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+				cmsg = CMSG_NXTHDR(&msg, cmsg))
+		{
+			if (cmsg->cmsg_level != SOL_SOCKET
+			|| cmsg->cmsg_type != SCM_RIGHTS)
+			{
+				continue;
+			}
+
+			passed = (char *) CMSG_DATA(cmsg);
+			fdCount = (cmsg->cmsg_len - CMSG_LEN(0))
+					/ sizeof(int);
+			for (i = 0; i < fdCount; i++)
+			{
+				memcpy((char *) &passedFd, passed,
+						sizeof(int));
+				passed += sizeof(int);
+				if (*fd < 0)
+				{
+					*fd = passedFd;
+				}
+				else
+				{
+					close(passedFd);
+				}
+			}
+		}
+
+		/*	If the control data were truncated, a
+		 *	descriptor may have been lost, so the segment
+		 *	can't be trusted.				*/
+
+		if (msg.msg_flags & MSG_CTRUNC)
+		{
+			if (*fd >= 0)
+			{
+				close(*fd);
+				*fd = -1;
+			}
+
+			writeMemo("[?] udscli lost ancillary data; discarding \
+bundle.");
+			return 0;
+		}
+
+		into += bytesRead;
+		bytesRemaining -= bytesRead;
+	}
+
+	return 1;
+}
+
+static int	receiveBytes(int sock, char *into, int length)
+{
+	int	bytesRead;
+
+	while (length > 0)
+	{
+		bytesRead = irecv(sock, into, length, 0);
+		switch (bytesRead)
+		{
+		case -1:
+			if (errno == EINTR)	/*	Shutdown.	*/
+			{
+				return 0;
+			}
+
+			putSysErrmsg("read() error on socket", NULL);
+			return -1;
+
+		case 0:			/*	Connection closed.	*/
+			return 0;
+		}
+
+		into += bytesRead;
+		length -= bytesRead;
+	}
+
+	return 1;
+}
+
+static int	startAcqZco(Sdr sdr, UdsAcq *acq)
+{
+	if (acq->zco == 0)
+	{
+		acq->zco = zco_create(sdr, ZcoSdrSource, 0, 0, 0);
+		switch (acq->zco)
+		{
+		case (Object) ERROR:
+			putErrmsg("Can't start inbound bundle ZCO.", NULL);
+			return -1;
+
+		case 0:
+			acq->congestive = 1;	/*	No ZCO space.	*/
+		}
+	}
+
+	return 0;
+}
+
+static int	openAcqFile(Sdr sdr, UdsAcq *acq)
+{
+	static unsigned int	acqCount = 0;
+	char			cwd[200];
+	char			fileName[SDRSTRING_BUFSZ];
+
+	if (acq->fileRef)
+	{
+		return 0;	/*	Already acquiring into file.	*/
+	}
+
+	if (igetcwd(cwd, sizeof cwd) == NULL)
+	{
+		putErrmsg("Can't get CWD for acq file name.", NULL);
+		return -1;
+	}
+
+	acqCount++;
+	isprintf(fileName, sizeof fileName, "%s%cudsacq.%d.%u", cwd,
+			ION_PATH_DELIMITER, sm_TaskIdSelf(), acqCount);
+	acq->fd = iopen(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (acq->fd < 0)
+	{
+		putSysErrmsg("Can't create acq file", fileName);
+		return -1;
+	}
+
+	acq->fileLength = 0;
+	acq->fileRef = zco_create_file_ref(sdr, fileName, "");
+	if (acq->fileRef == 0)
+	{
+		putErrmsg("Can't create file ref.", NULL);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int	appendFileExtent(Sdr sdr, UdsAcq *acq, unsigned int length)
+{
+	switch (zco_append_extent(sdr, acq->zco, ZcoFileSource, acq->fileRef,
+			acq->fileLength, length))
+	{
+	case ERROR:
+		putErrmsg("Can't append file reference extent.", NULL);
+		return -1;
+
+	case 0:
+		acq->congestive = 1;
+	}
+
+	acq->fileLength += length;
+	if (!acq->fileRefFlagged)
+	{
+		/*	Flag file reference for deletion as soon as
+		 *	the last ZCO extent that references it is
+		 *	deleted.					*/
+
+		zco_destroy_file_ref(sdr, acq->fileRef);
+		acq->fileRefFlagged = 1;
+	}
+
+	return 0;
+}
+
+static int	acquireBytes(UdsAcq *acq, char *bytes, unsigned int length)
+{
+	Sdr	sdr = getIonsdr();
+	Object	extentObj;
+
+	/*	Inline bytes are acquired into the SDR heap until the
+	 *	ZCO reaches UDSCLA_MAX_IN_HEAP bytes, then into the
+	 *	bundle's acquisition file.				*/
+
+	CHKERR(sdr_begin_xn(sdr));
+	if (startAcqZco(sdr, acq) < 0)
+	{
+		sdr_cancel_xn(sdr);
+		return -1;
+	}
+
+	if (acq->congestive)
+	{
+		sdr_exit_xn(sdr);
+		return 0;
+	}
+
+	if (acq->fileRef == 0
+	&& length + zco_length(sdr, acq->zco) <= UDSCLA_MAX_IN_HEAP)
+	{
+		extentObj = sdr_insert(sdr, bytes, length);
+		if (extentObj)
+		{
+			switch (zco_append_extent(sdr, acq->zco, ZcoSdrSource,
+					extentObj, 0, length))
+			{
+			case ERROR:
+				putErrmsg("Can't append heap extent.", NULL);
+				sdr_cancel_xn(sdr);
+				return -1;
+
+			case 0:
+				sdr_free(sdr, extentObj);
+				acq->congestive = 1;
+			}
+		}
+	}
+	else
+	{
+		if (openAcqFile(sdr, acq) < 0)
+		{
+			sdr_cancel_xn(sdr);
+			return -1;
+		}
+
+		if (pwrite(acq->fd, bytes, length, acq->fileLength) < length)
+		{
+			putSysErrmsg("Can't append to acq file", NULL);
+			sdr_cancel_xn(sdr);
+			return -1;
+		}
+
+		if (appendFileExtent(sdr, acq, length) < 0)
+		{
+			sdr_cancel_xn(sdr);
+			return -1;
+		}
+	}
+
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't acquire inline bytes.", NULL);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int	acquireInlineSegment(int sock, UdsAcq *acq,
+			unsigned int length, char *buffer)
+{
+	unsigned int	chunkLength;
+	int		result;
+
+	while (length > 0)
+	{
+		chunkLength = length;
+		if (chunkLength > UDSCLA_BUFSZ)
+		{
+			chunkLength = UDSCLA_BUFSZ;
+		}
+
+		result = receiveBytes(sock, buffer, chunkLength);
+		if (result < 1)
+		{
+			return result;
+		}
+
+		if (acquireBytes(acq, buffer, chunkLength) < 0)
+		{
+			return -1;
+		}
+
+		length -= chunkLength;
+	}
+
+	return 1;
+}
+
+static int	copyExtent(int toFd, vast toOffset, int fromFd,
+			uvast fromOffset, unsigned int length, char *buffer)
+{
+	off_t	from = fromOffset;
+	off_t	to = toOffset;
+	int	bytesRead;
+#ifdef FICLONERANGE
+	struct file_clone_range	range;
+#endif
+#ifdef SYS_copy_file_range
+	long	bytesCopied;
+#endif
+
+	/*	Returns 1 on success, 0 if the file is too short to
+	 *	contain the extent, -1 on any system error.		*/
+
+#ifdef FICLONERANGE
+	/*	On a file system that supports reflinks, the extent's
+	 *	blocks are shared rather than copied.			*/
+
+	range.src_fd = fromFd;
+	range.src_offset = fromOffset;
+	range.src_length = length;
+	range.dest_offset = toOffset;
+	if (ioctl(toFd, FICLONERANGE, &range) == 0)
+	{
+		return 1;
+	}
+#endif
+#ifdef SYS_copy_file_range
+	/*	Otherwise the extent is copied within the kernel.	*/
+
+	while (length > 0)
+	{
+		bytesCopied = syscall(SYS_copy_file_range, fromFd, &from,
+				toFd, &to, (size_t) length, 0);
+		if (bytesCopied <= 0)
+		{
+			break;		/*	Fall back to read().	*/
+		}
+
+		length -= bytesCopied;
+	}
+#endif
+	while (length > 0)
+	{
+		bytesRead = pread(fromFd, buffer, length > UDSCLA_BUFSZ ?
+				UDSCLA_BUFSZ : length, from);
+		switch (bytesRead)
+		{
+		case -1:
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			putSysErrmsg("Can't read file extent", NULL);
+			return -1;
+
+		case 0:
+			return 0;
+		}
+
+		if (pwrite(toFd, buffer, bytesRead, to) < bytesRead)
+		{
+			putSysErrmsg("Can't append to acq file", NULL);
+			return -1;
+		}
+
+		from += bytesRead;
+		to += bytesRead;
+		length -= bytesRead;
+	}
+
+	return 1;
+}
+
+static int	acquireFileSegment(UdsAcq *acq, int fd, uvast offset,
+			unsigned int length, char *buffer)
+{
+	Sdr	sdr = getIonsdr();
+
+	/*	The extent is acquired into the bundle's own file,
+	 *	since the sender's file may be rewritten or deleted
+	 *	as soon as the sender has finished with the bundle.	*/
+
+	CHKERR(sdr_begin_xn(sdr));
+	if (startAcqZco(sdr, acq) < 0
+	|| (acq->congestive == 0 && openAcqFile(sdr, acq) < 0))
+	{
+		sdr_cancel_xn(sdr);
+		return -1;
+	}
+
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't start file extent acquisition.", NULL);
+		return -1;
+	}
+
+	if (acq->congestive || acq->unreadable)
+	{
+		return 0;
+	}
+
+	switch (copyExtent(acq->fd, acq->fileLength, fd, offset, length,
+			buffer))
+	{
+	case -1:
+		return -1;
+
+	case 0:
+		acq->unreadable = 1;
+		return 0;
+	}
+
+	CHKERR(sdr_begin_xn(sdr));
+	if (appendFileExtent(sdr, acq, length) < 0)
+	{
+		sdr_cancel_xn(sdr);
+		return -1;
+	}
+
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't acquire file extent.", NULL);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int	discardAcq(UdsAcq *acq)
+{
+	Sdr	sdr = getIonsdr();
+
+	if (acq->fd >= 0)
+	{
+		close(acq->fd);
+		acq->fd = -1;
+	}
+
+	CHKERR(sdr_begin_xn(sdr));
+	if (acq->fileRef && !acq->fileRefFlagged)
+	{
+		zco_destroy_file_ref(sdr, acq->fileRef);
+	}
+
+	if (acq->zco)
+	{
+		zco_destroy(sdr, acq->zco);
+	}
+
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't discard inbound bundle ZCO.", NULL);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int	endAcq(UdsAcq *acq, AcqWorkArea *work)
+{
+	if (acq->congestive || acq->unreadable)
+	{
+		if (acq->congestive)
+		{
+			writeMemo("[?] ZCO space is congested; discarding \
+bundle.");
+		}
+		else
+		{
+			writeMemo("[?] Can't read bundle's file extent; \
+discarding bundle.");
+		}
+
+		return (discardAcq(acq) < 0 ? -1 : 1);
+	}
+
+	if (acq->fd >= 0)
+	{
+		close(acq->fd);
+		acq->fd = -1;
+	}
+
+	if (bpBeginAcq(work, 0, NULL) < 0)
+	{
+		putErrmsg("Can't begin acquisition of bundle.", NULL);
+		return -1;
+	}
+
+	if (bpLoadAcq(work, acq->zco) < 0)
+	{
+		putErrmsg("Can't load bundle ZCO.", NULL);
+		return -1;
+	}
+
+	if (bpEndAcq(work) < 0)
+	{
+		putErrmsg("Can't end acquisition of bundle.", NULL);
+		return -1;
+	}
+
+	return 1;
+}
+
+int	receiveBundleByUds(int sock, AcqWorkArea *work, char *buffer)
+{
+	UdsAcq		acq;
+	UdsSegment	segment;
+	int		fd;
+	int		first = 1;
+	int		result;
+
+	CHKERR(work);
+	CHKERR(buffer);
+	memset((char *) &acq, 0, sizeof(UdsAcq));
+	acq.fd = -1;
+	while (1)
+	{
+		result = receiveSegment(sock, &segment, &fd);
+		if (result < 1)
+		{
+			break;
+		}
+
+		if (((segment.flags & UDSCLA_FIRST) != 0) != first)
+		{
+			writeMemo("[?] udscli lost segment synchronization.");
+			result = 0;
+		}
+		else if (segment.flags & UDSCLA_FILE)
+		{
+			if (fd < 0)
+			{
+				writeMemo("[?] udscli got no file descriptor.");
+				result = 0;
+			}
+			else if (acquireFileSegment(&acq, fd, segment.offset,
+					segment.length, buffer) < 0)
+			{
+				result = -1;
+			}
+		}
+		else
+		{
+			result = acquireInlineSegment(sock, &acq,
+					segment.length, buffer);
+		}
+
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+
+		if (result < 1)
+		{
+			break;
+		}
+
+		if (segment.flags & UDSCLA_LAST)
+		{
+			return endAcq(&acq, work);
+		}
+
+		first = 0;
+	}
+
+	/*	Connection lost in mid-bundle, or system error.		*/
+
+	if (result == 0)
+	{
+		return (discardAcq(&acq) < 0 ? -1 : 0);
+	}
+
+	if (acq.fd >= 0)
+	{
+		close(acq.fd);
+	}
+
+	return -1;
+}
+
+#endif	/*	UDSCLA_SUPPORTED					*/
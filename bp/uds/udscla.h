@@ -0,0 +1,103 @@
+/*
+ 	udscla.h:	common definitions for Unix-domain socket
+			convergence layer adapter modules.
+ 									*/
+#ifndef _UDSCLA_H_
+#define _UDSCLA_H_
+
+#include "bpP.h"
+#include <pthread.h>
+#ifndef mingw
+#include <sys/un.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*	The Unix-domain socket convergence layer conveys bundles
+ *	between ION nodes that are running on the same host.  Each
+ *	udscli induct listens on a stream socket in the AF_UNIX
+ *	domain; the duct name is the path name of that socket.  A
+ *	udsclo outduct whose duct name is that of the induct connects
+ *	to the socket and sends each bundle as a series of segments,
+ *	each of which is a UdsSegment header optionally followed by
+ *	bundle bytes.  Bytes that reside in the SDR heap are sent
+ *	inline, following the segment header.  Bytes that reside in
+ *	a file are not sent at all: the segment header conveys their
+ *	offset and length and an open descriptor for the file is
+ *	passed as SCM_RIGHTS ancillary data, and udscli acquires the
+ *	bytes into the inbound bundle's ZCO as a file reference
+ *	extent.  The daemons are not available under Windows.		*/
+
+#if !defined (mingw) && !defined (VXWORKS) && !defined (RTEMS)
+#define	UDSCLA_SUPPORTED
+#endif
+
+#define	DEFAULT_UDS_RATE	1250000000
+
+#ifndef UDSCLA_BUFSZ
+#define	UDSCLA_BUFSZ		(256 * 1024)
+#endif
+
+#define	UDSCLA_IOV_MAX		(16)
+
+/*	Inline bytes of an inbound bundle are acquired into the SDR
+ *	heap until the bundle's ZCO reaches UDSCLA_MAX_IN_HEAP bytes;
+ *	all subsequent inline bytes are acquired into a file.		*/
+
+#ifndef UDSCLA_MAX_IN_HEAP
+#define	UDSCLA_MAX_IN_HEAP	(64 * 1024)
+#endif
+
+#define	UDSCLA_RETRY_INTERVAL	(1)
+
+#define	UDSCLA_FIRST		(1)
+#define	UDSCLA_LAST		(2)
+#define	UDSCLA_FILE		(4)
+
+typedef struct
+{
+	unsigned int	flags;
+	unsigned int	length;		/*	Of bundle bytes.	*/
+	uvast		offset;		/*	Only if UDSCLA_FILE.	*/
+} UdsSegment;
+
+extern int	udsSocketName(char *socketPath,
+			struct sockaddr_un *socketName);
+			/*	Fills in the name of the socket whose
+			 *	path name is socketPath.  Returns 0
+			 *	on success, -1 if the path name is
+			 *	too long.				*/
+
+extern int	udsConnect(char *socketPath, int *sock);
+			/*	Connects to the socket of the named
+			 *	induct.  Returns 1 on success, 0 if
+			 *	no udscli is listening on the socket,
+			 *	-1 on any system error.			*/
+
+extern int	sendBundleByUds(int *sock, unsigned int bundleLength,
+			Object bundleZco, char *buffer);
+			/*	Sends the bundle on the connected
+			 *	socket, using a buffer of length
+			 *	UDSCLA_BUFSZ.  Returns 1 on success,
+			 *	0 if the connection was lost (in which
+			 *	case *sock is closed and set to -1
+			 *	and the bundle is handled as a
+			 *	transmission failure), -1 on any
+			 *	system error.				*/
+
+extern int	receiveBundleByUds(int sock, AcqWorkArea *work,
+			char *buffer);
+			/*	Acquires the next bundle from the
+			 *	connected socket, using a buffer of
+			 *	length UDSCLA_BUFSZ.  Returns 1 on
+			 *	success, 0 if the connection was
+			 *	closed or reception was interrupted,
+			 *	-1 on any system error.			*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* _UDSCLA_H_ */
@@ -0,0 +1,400 @@
+/*
+	udscli.c:	BP Unix-domain socket convergence-layer input
+			daemon, designed to serve as an input duct
+			for bundles sent by udsclo daemons of other
+			ION nodes on the same host.  The duct name
+			is the path name of the induct's socket.
+
+									*/
+#include "udscla.h"
+
+#ifdef UDSCLA_SUPPORTED
+
+static void	interruptThread()
+{
+	isignal(SIGTERM, interruptThread);
+	ionKillMainThread("udscli");
+}
+
+/*	*	*	Receiver thread functions	*	*	*/
+
+typedef struct
+{
+	VInduct		*vduct;
+	LystElt		elt;
+	pthread_mutex_t	*mutex;
+	int		bundleSocket;
+	pthread_t	thread;
+	int		*running;
+} ReceiverThreadParms;
+
+static void	terminateReceiverThread(ReceiverThreadParms *parms)
+{
+	writeErrmsgMemos();
+	writeMemo("[i] udscli receiver thread stopping.");
+	pthread_mutex_lock(parms->mutex);
+	if (parms->bundleSocket != -1)
+	{
+		close(parms->bundleSocket);
+		parms->bundleSocket = -1;
+	}
+
+	lyst_delete(parms->elt);
+	pthread_mutex_unlock(parms->mutex);
+	MRELEASE(parms);
+}
+
+static void	*receiveBundles(void *parm)
+{
+	/*	Main loop for bundle reception thread on one
+	 *	connection, terminating when connection is lost.	*/
+
+	ReceiverThreadParms	*parms = (ReceiverThreadParms *) parm;
+	char			*procName = "udscli";
+	AcqWorkArea		*work;
+	char			*buffer;
+	int			threadRunning = 1;
+
+	work = bpGetAcqArea(parms->vduct);
+	if (work == NULL)
+	{
+		putErrmsg("udscli can't get acquisition work area.", NULL);
+		ionKillMainThread(procName);
+		terminateReceiverThread(parms);
+		return NULL;
+	}
+
+	buffer = MTAKE(UDSCLA_BUFSZ);
+	if (buffer == NULL)
+	{
+		putErrmsg("udscli can't get buffer.", NULL);
+		bpReleaseAcqArea(work);
+		ionKillMainThread(procName);
+		terminateReceiverThread(parms);
+		return NULL;
+	}
+
+	/*	Now start receiving bundles.				*/
+
+	while (threadRunning && *(parms->running))
+	{
+		switch (receiveBundleByUds(parms->bundleSocket, work, buffer))
+		{
+		case -1:
+			putErrmsg("Can't acquire bundle.", NULL);
+			ionKillMainThread(procName);
+
+			/*	Intentional fall-through to next case.	*/
+
+		case 0:				/*	Normal stop.	*/
+			threadRunning = 0;
+			continue;
+
+		default:
+			break;			/*	Out of switch.	*/
+		}
+
+		/*	Make sure other tasks have a chance to run.	*/
+
+		sm_TaskYield();
+	}
+
+	/*	End of receiver thread; release resources.		*/
+
+	bpReleaseAcqArea(work);
+	MRELEASE(buffer);
+	terminateReceiverThread(parms);
+	return NULL;
+}
+
+/*	*	*	Access thread functions	*	*	*	*/
+
+typedef struct
+{
+	VInduct			*vduct;
+	struct sockaddr_un	socketName;
+	int			ductSocket;
+	int			running;
+} AccessThreadParms;
+
+static void	*spawnReceivers(void *parm)
+{
+	/*	Main loop for acceptance of connections and
+	 *	creation of receivers to service those connections.	*/
+
+	AccessThreadParms	*atp = (AccessThreadParms *) parm;
+	char			*procName = "udscli";
+	pthread_mutex_t		mutex;
+	Lyst			threads;
+	int			newSocket;
+	ReceiverThreadParms	*parms;
+	LystElt			elt;
+	pthread_t		thread;
+
+	snooze(1);	/*	Let main thread become interruptable.	*/
+	pthread_mutex_init(&mutex, NULL);
+	threads = lyst_create_using(getIonMemoryMgr());
+	if (threads == NULL)
+	{
+		putErrmsg("udscli can't create threads list.", NULL);
+		ionKillMainThread(procName);
+		pthread_mutex_destroy(&mutex);
+		return NULL;
+	}
+
+	/*	Can now begin accepting connections from udsclo
+	 *	daemons.  On failure, take down the whole CLI.		*/
+
+	while (atp->running)
+	{
+		newSocket = accept(atp->ductSocket, NULL, NULL);
+		if (newSocket < 0)
+		{
+			putSysErrmsg("udscli accept() failed", NULL);
+			ionKillMainThread(procName);
+			atp->running = 0;
+			continue;
+		}
+
+		if (atp->running == 0)
+		{
+			close(newSocket);
+			break;	/*	Main thread has shut down.	*/
+		}
+
+		parms = (ReceiverThreadParms *)
+				MTAKE(sizeof(ReceiverThreadParms));
+		if (parms == NULL)
+		{
+			putErrmsg("udscli can't allocate for thread.", NULL);
+			close(newSocket);
+			ionKillMainThread(procName);
+			atp->running = 0;
+			continue;
+		}
+
+		parms->vduct = atp->vduct;
+		pthread_mutex_lock(&mutex);
+		parms->elt = lyst_insert_last(threads, parms);
+		pthread_mutex_unlock(&mutex);
+		if (parms->elt == NULL)
+		{
+			putErrmsg("udscli can't allocate for thread.", NULL);
+			MRELEASE(parms);
+			close(newSocket);
+			ionKillMainThread(procName);
+			atp->running = 0;
+			continue;
+		}
+
+		parms->mutex = &mutex;
+		parms->bundleSocket = newSocket;
+		parms->running = &(atp->running);
+		if (pthread_begin(&(parms->thread), NULL, receiveBundles,
+					parms))
+		{
+			putSysErrmsg("udscli can't create new thread", NULL);
+			pthread_mutex_lock(&mutex);
+			lyst_delete(parms->elt);
+			pthread_mutex_unlock(&mutex);
+			MRELEASE(parms);
+			close(newSocket);
+			ionKillMainThread(procName);
+			atp->running = 0;
+			continue;
+		}
+
+		/*	Make sure other tasks have a chance to run.	*/
+
+		sm_TaskYield();
+	}
+
+	close(atp->ductSocket);
+	writeErrmsgMemos();
+
+	/*	Shut down all current CLI threads cleanly.		*/
+
+	while (1)
+	{
+		pthread_mutex_lock(&mutex);
+		elt = lyst_first(threads);
+		if (elt == NULL)	/*	All threads shut down.	*/
+		{
+			pthread_mutex_unlock(&mutex);
+			break;
+		}
+
+		/*	Trigger termination of thread.			*/
+
+		parms = (ReceiverThreadParms *) lyst_data(elt);
+		thread = parms->thread;
+		pthread_kill(thread, SIGTERM);
+		pthread_mutex_unlock(&mutex);
+		pthread_join(thread, NULL);
+	}
+
+	lyst_destroy(threads);
+	writeErrmsgMemos();
+	writeMemo("[i] udscli access thread has ended.");
+	pthread_mutex_destroy(&mutex);
+	return NULL;
+}
+
+/*	*	*	Main thread functions	*	*	*	*/
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	udscli(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	char	*ductName = (char *) a1;
+#else
+int	main(int argc, char *argv[])
+{
+	char	*ductName = (argc > 1 ? argv[1] : NULL);
+#endif
+	VInduct			*vduct;
+	PsmAddress		vductElt;
+	Sdr			sdr;
+	Induct			duct;
+	ClProtocol		protocol;
+	AccessThreadParms	atp;
+	struct stat		statbuf;
+	pthread_t		accessThread;
+	int			fd;
+
+	if (ductName == NULL)
+	{
+		PUTS("Usage: udscli <socket path name>");
+		return 0;
+	}
+
+	if (bpAttach() < 0)
+	{
+		putErrmsg("udscli can't attach to BP.", NULL);
+		return -1;
+	}
+
+	findInduct("uds", ductName, &vduct, &vductElt);
+	if (vductElt == 0)
+	{
+		putErrmsg("No such uds duct.", ductName);
+		return -1;
+	}
+
+	if (vduct->cliPid != ERROR && vduct->cliPid != sm_TaskIdSelf())
+	{
+		putErrmsg("CLI task is already started for this duct.",
+				itoa(vduct->cliPid));
+		return -1;
+	}
+
+	/*	All command-line arguments are now validated.		*/
+
+	sdr = getIonsdr();
+	CHKZERO(sdr_begin_xn(sdr));
+	sdr_read(sdr, (char *) &duct, sdr_list_data(sdr, vduct->inductElt),
+			sizeof(Induct));
+	sdr_read(sdr, (char *) &protocol, duct.protocol, sizeof(ClProtocol));
+	sdr_exit_xn(sdr);
+	if (protocol.nominalRate == 0)
+	{
+		vduct->acqThrottle.nominalRate = DEFAULT_UDS_RATE;
+	}
+	else
+	{
+		vduct->acqThrottle.nominalRate = protocol.nominalRate;
+	}
+
+	atp.vduct = vduct;
+	if (udsSocketName(ductName, &(atp.socketName)) < 0)
+	{
+		return -1;
+	}
+
+	/*	Remove the socket left behind by a udscli that
+	 *	crashed, but nothing other than a socket.		*/
+
+	if (lstat(ductName, &statbuf) == 0 && S_ISSOCK(statbuf.st_mode))
+	{
+		oK(unlink(ductName));
+	}
+
+	atp.ductSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (atp.ductSocket < 0)
+	{
+		putSysErrmsg("Can't open Unix-domain socket", NULL);
+		return 1;
+	}
+
+	if (bind(atp.ductSocket, (struct sockaddr *) &(atp.socketName),
+			sizeof(struct sockaddr_un)) < 0
+	|| listen(atp.ductSocket, 5) < 0)
+	{
+		close(atp.ductSocket);
+		putSysErrmsg("Can't initialize socket", ductName);
+		return 1;
+	}
+
+	/*	Set up signal handling: SIGTERM is shutdown signal.	*/
+
+	ionNoteMainThread("udscli");
+	isignal(SIGTERM, interruptThread);
+
+	/*	Start the access thread.				*/
+
+	atp.running = 1;
+	if (pthread_begin(&accessThread, NULL, spawnReceivers, &atp))
+	{
+		close(atp.ductSocket);
+		oK(unlink(ductName));
+		putSysErrmsg("udscli can't create access thread", NULL);
+		return 1;
+	}
+
+	/*	Now sleep until interrupted by SIGTERM, at which point
+	 *	it's time to stop the induct.				*/
+
+	writeMemoNote("[i] udscli is running, socket", ductName);
+	ionPauseMainThread(-1);
+
+	/*	Time to shut down.					*/
+
+	atp.running = 0;
+
+	/*	Wake up the access thread by connecting to it.		*/
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd >= 0)
+	{
+		oK(connect(fd, (struct sockaddr *) &(atp.socketName),
+				sizeof(struct sockaddr_un)));
+
+		/*	Immediately discard the connected socket.	*/
+
+		close(fd);
+	}
+
+	pthread_join(accessThread, NULL);
+	oK(unlink(ductName));
+	writeErrmsgMemos();
+	writeMemo("[i] udscli duct has ended.");
+	ionDetach();
+	return 0;
+}
+
+#else	/*	UDSCLA_SUPPORTED					*/
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	udscli(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+#else
+int	main(int argc, char *argv[])
+{
+#endif
+	putErrmsg("udscli is not available on this platform.", NULL);
+	writeErrmsgMemos();
+	return 0;
+}
+
+#endif	/*	UDSCLA_SUPPORTED					*/
@@ -0,0 +1,209 @@
+/*
+	udsclo.c:	BP Unix-domain socket convergence-layer output
+			daemon, for conveying bundles to the udscli
+			induct of another ION node on the same host.
+			The duct name is the path name of the socket
+			of that induct.
+
+									*/
+#include "udscla.h"
+
+#ifdef UDSCLA_SUPPORTED
+
+static sm_SemId		udscloSemaphore(sm_SemId *semid)
+{
+	static sm_SemId	semaphore = -1;
+
+	if (semid)
+	{
+		semaphore = *semid;
+	}
+
+	return semaphore;
+}
+
+static void	shutDownClo()	/*	Commands CLO termination.	*/
+{
+	sm_SemEnd(udscloSemaphore(NULL));
+}
+
+/*	*	*	Main thread functions	*	*	*	*/
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	udsclo(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	char	*ductName = (char *) a1;
+#else
+int	main(int argc, char *argv[])
+{
+	char	*ductName = (argc > 1 ? argv[1] : NULL);
+#endif
+	VOutduct	*vduct;
+	PsmAddress	vductElt;
+	Sdr		sdr;
+	Outduct		duct;
+	ClProtocol	protocol;
+	Outflow		outflows[3];
+	int		i;
+	char		*buffer;
+	int		sock = -1;
+	int		waiting = 0;
+	Object		bundleZco;
+	BpExtendedCOS	extendedCOS;
+	char		destDuctName[MAX_CL_DUCT_NAME_LEN + 1];
+	unsigned int	bundleLength;
+
+	if (ductName == NULL)
+	{
+		PUTS("Usage: udsclo <remote socket path name>");
+		return 0;
+	}
+
+	if (bpAttach() < 0)
+	{
+		putErrmsg("udsclo can't attach to BP.", NULL);
+		return -1;
+	}
+
+	findOutduct("uds", ductName, &vduct, &vductElt);
+	if (vductElt == 0)
+	{
+		putErrmsg("No such uds duct.", ductName);
+		return -1;
+	}
+
+	if (vduct->cloPid != ERROR && vduct->cloPid != sm_TaskIdSelf())
+	{
+		putErrmsg("CLO task is already started for this duct.",
+				itoa(vduct->cloPid));
+		return -1;
+	}
+
+	/*	All command-line arguments are now validated.		*/
+
+	buffer = MTAKE(UDSCLA_BUFSZ);
+	if (buffer == NULL)
+	{
+		putErrmsg("No memory for UDS buffer in udsclo.", NULL);
+		return -1;
+	}
+
+	sdr = getIonsdr();
+	CHKERR(sdr_begin_xn(sdr));
+	sdr_read(sdr, (char *) &duct, sdr_list_data(sdr, vduct->outductElt),
+			sizeof(Outduct));
+	sdr_read(sdr, (char *) &protocol, duct.protocol, sizeof(ClProtocol));
+	sdr_exit_xn(sdr);
+	if (protocol.nominalRate == 0)
+	{
+		vduct->xmitThrottle.nominalRate = DEFAULT_UDS_RATE;
+	}
+	else
+	{
+		vduct->xmitThrottle.nominalRate = protocol.nominalRate;
+	}
+
+	memset((char *) outflows, 0, sizeof outflows);
+	outflows[0].outboundBundles = duct.bulkQueue;
+	outflows[1].outboundBundles = duct.stdQueue;
+	outflows[2].outboundBundles = duct.urgentQueue;
+	for (i = 0; i < 3; i++)
+	{
+		outflows[i].svcFactor = 1 << i;
+	}
+
+	/*	Set up signal handling.  SIGTERM is shutdown signal;
+	 *	loss of connection is detected by EPIPE instead.	*/
+
+	oK(udscloSemaphore(&(vduct->semaphore)));
+	isignal(SIGTERM, shutDownClo);
+	isignal(SIGPIPE, SIG_IGN);
+
+	/*	Can now begin transmitting to remote duct.		*/
+
+	writeMemoNote("[i] udsclo is running, socket", ductName);
+	while (!(sm_SemEnded(udscloSemaphore(NULL))))
+	{
+		/*	Bundles wait in the outduct's queues for as
+		 *	long as the remote induct isn't running.	*/
+
+		if (sock == -1)
+		{
+			switch (udsConnect(ductName, &sock))
+			{
+			case -1:
+				sm_SemEnd(udscloSemaphore(NULL));
+				continue;
+
+			case 0:
+				if (!waiting)
+				{
+					writeMemoNote("[i] udsclo waiting for \
+induct", ductName);
+					waiting = 1;
+				}
+
+				snooze(UDSCLA_RETRY_INTERVAL);
+				continue;
+
+			default:
+				waiting = 0;
+			}
+		}
+
+		if (bpDequeue(vduct, outflows, &bundleZco, &extendedCOS,
+				destDuctName, 0, -1) < 0)
+		{
+			sm_SemEnd(udscloSemaphore(NULL));
+			continue;
+		}
+
+		if (bundleZco == 0)	/*	Interrupted.		*/
+		{
+			continue;
+		}
+
+		CHKZERO(sdr_begin_xn(sdr));
+		bundleLength = zco_length(sdr, bundleZco);
+		sdr_exit_xn(sdr);
+		if (sendBundleByUds(&sock, bundleLength, bundleZco, buffer)
+				< 0)
+		{
+			sm_SemEnd(udscloSemaphore(NULL));
+			continue;
+		}
+
+		/*	Make sure other tasks have a chance to run.	*/
+
+		sm_TaskYield();
+	}
+
+	if (sock != -1)
+	{
+		close(sock);
+	}
+
+	MRELEASE(buffer);
+	writeErrmsgMemos();
+	writeMemo("[i] udsclo duct has ended.");
+	ionDetach();
+	return 0;
+}
+
+#else	/*	UDSCLA_SUPPORTED					*/
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	udsclo(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+#else
+int	main(int argc, char *argv[])
+{
+#endif
+	putErrmsg("udsclo is not available on this platform.", NULL);
+	writeErrmsgMemos();
+	return 0;
+}
+
+#endif	/*	UDSCLA_SUPPORTED					*/
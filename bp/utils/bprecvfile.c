@@ -11,6 +11,7 @@
 #include <bp.h>
 
 #define	BPRECVBUFSZ	(65536)
+#define	BPRECVIOVMAX	(16)
 
 typedef struct
 {
@@ -47,6 +48,58 @@ static void	handleQuit()
 	state->running = 0;
 }
 
+static int	writeIov(int fd, struct iovec *iov, int iovCount)
+{
+	int	bytesWritten;
+#ifdef mingw
+	int	i;
+
+	/*	No writev() on Windows, so write each iovec.		*/
+
+	for (i = 0; i < iovCount; i++)
+	{
+		bytesWritten = write(fd, iov[i].iov_base, iov[i].iov_len);
+		if (bytesWritten < (int) iov[i].iov_len)
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+#else
+	while (iovCount > 0)
+	{
+		bytesWritten = writev(fd, iov, iovCount);
+		if (bytesWritten < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			return -1;
+		}
+
+		/*	Skip past whatever has been written.		*/
+
+		while (iovCount > 0 && bytesWritten >= (int) iov->iov_len)
+		{
+			bytesWritten -= iov->iov_len;
+			iov++;
+			iovCount--;
+		}
+
+		if (iovCount > 0)
+		{
+			iov->iov_base = (char *) iov->iov_base + bytesWritten;
+			iov->iov_len -= bytesWritten;
+		}
+	}
+
+	return 0;
+#endif
+}
+
 static int	receiveFile(Sdr sdr, BpDelivery *dlv)
 {
 	static char	buffer[BPRECVBUFSZ];
@@ -56,7 +109,9 @@ static int	receiveFile(Sdr sdr, BpDelivery *dlv)
 	char		fileName[64];
 	int		testFile = -1;
 	ZcoReader	reader;
-	int		recvLength;
+	struct iovec	iov[BPRECVIOVMAX];
+	int		iovCount;
+	vast		recvLength;
 	char		completionText[80];
 
 	fileCount++;
@@ -69,18 +124,20 @@ static int	receiveFile(Sdr sdr, BpDelivery *dlv)
 		return -1;
 	}
 
+	/*	The transaction is held open until all content has
+	 *	been written, so content in the SDR heap is written
+	 *	to the file directly from the heap.			*/
+
 	zco_start_receiving(dlv->adu, &reader);
+	zco_gather_in_place(&reader);
 	remainingLength = contentLength;
 	CHKERR(sdr_begin_xn(sdr));
 	while (remainingLength > 0)
 	{
-		recvLength = BPRECVBUFSZ;
-		if (remainingLength < recvLength)
-		{
-			recvLength = remainingLength;
-		}
-
-		if (zco_receive_source(sdr, &reader, recvLength, buffer) < 0)
+		iovCount = BPRECVIOVMAX;
+		recvLength = zco_receive_iov(sdr, &reader, remainingLength,
+				iov, &iovCount, buffer, BPRECVBUFSZ, NULL);
+		if (recvLength <= 0)
 		{
 			putErrmsg("bprecvfile: can't receive bundle content.",
 					fileName);
@@ -89,7 +146,7 @@ static int	receiveFile(Sdr sdr, BpDelivery *dlv)
 			return -1;
 		}
 
-		if (write(testFile, buffer, recvLength) < 1)
+		if (writeIov(testFile, iov, iovCount) < 0)
 		{
 			putSysErrmsg("bprecvfile: can't write to test file",
 					fileName);
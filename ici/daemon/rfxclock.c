@@ -10,6 +10,15 @@
 									*/
 #include "rfx.h"
 
+/*	Congestion is forecast whenever the local node's rate of
+ *	transmission to or reception from any neighbor changes.  To
+ *	track changes in occupancy that the contact plan doesn't
+ *	anticipate, it may additionally be forecast periodically.	*/
+
+#ifndef RFX_FORECAST_INTERVAL
+#define	RFX_FORECAST_INTERVAL	(0)	/*	Seconds; 0 = never.	*/
+#endif
+
 static long	_running(long *newValue)
 {
 	void	*value;
@@ -229,6 +238,13 @@ static int	dispatchEvent(IonVdb *vdb, IonEvent *event, int *forecastNeeded)
 					return -1;
 				}
 
+				if (cxref->fromNode != cxref->toNode
+				&& rfx_insert_rate_change(cxref->startRecv,
+						cxref->xmitRate) < 0)
+				{
+					return -1;
+				}
+
 				addr = psm_zalloc(ionwm, sizeof(IonEvent));
 				if (addr == 0)
 				{
@@ -248,6 +264,13 @@ static int	dispatchEvent(IonVdb *vdb, IonEvent *event, int *forecastNeeded)
 					return -1;
 				}
 
+				if (cxref->fromNode != cxref->toNode
+				&& rfx_insert_rate_change(cxref->stopRecv,
+						-((vast) cxref->xmitRate)) < 0)
+				{
+					return -1;
+				}
+
 				/*	Purge contact when reception
 				 *	is expected to stop.		*/
 
@@ -319,6 +342,7 @@ int	main(int argc, char *argv[])
 	int		destNodeNbr;
 	int		neighborNodeNbr;
 	int		forecastNeeded;
+	time_t		lastForecastTime;
 	IonEvent	*event;
 
 	if (ionAttach() < 0)
@@ -336,6 +360,7 @@ int	main(int argc, char *argv[])
 	 *	execute applicable events.				*/
 
 	oK(_running(&start));
+	lastForecastTime = getUTCTime();
 	writeMemo("[i] rfxclock is running.");
 	while (_running(NULL))
 	{
@@ -422,9 +447,16 @@ int	main(int argc, char *argv[])
 			return -1;
 		}
 
+		if (RFX_FORECAST_INTERVAL > 0 && currentTime
+				>= lastForecastTime + RFX_FORECAST_INTERVAL)
+		{
+			forecastNeeded = 1;
+		}
+
 		if (forecastNeeded)
 		{
 			oK(pseudoshell("ionwarn"));
+			lastForecastTime = currentTime;
 		}
 	}
 
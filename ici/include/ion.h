@@ -109,6 +109,7 @@ typedef struct
 	int		deltaFromUTC;	/*	In seconds.		*/
 	int		maxClockError;	/*	In seconds.		*/
 	char		clockIsSynchronized;	/*	Boolean.	*/
+	int		maxRoutes;	/*	Per CGR destination.	*/
 	char		workingDirectoryName[256];
         IonParms        parmcopy;       /*	Copy of the ion config
 						parms as asserted to
@@ -214,6 +215,34 @@ typedef struct
 	PsmAddress	routingObject;	/*	Routing-dependent.	*/
 } IonCXref;
 
+/*	Every insertion or removal of a contact is noted in the
+ *	IonVdb's list of contact edits, so that the routing module
+ *	can revise only those computed routes that are affected by
+ *	the change rather than discarding all routes.  If the routing
+ *	module falls too far behind, the list is simply cleared and
+ *	lastEditTime is advanced, signifying that all routes must be
+ *	recomputed.  (A change in a contact's data rate is effected
+ *	by removal of the contact followed by insertion of the
+ *	revised contact.)						*/
+
+#ifndef ION_MAX_CONTACT_EDITS
+#define	ION_MAX_CONTACT_EDITS	(1000)
+#endif
+
+typedef enum
+{
+	IonContactAdded = 1,
+	IonContactRemoved
+} IonContactEditType;
+
+typedef struct
+{
+	IonContactEditType type;
+	uvast		fromNode;	/*	Identifies contact.	*/
+	uvast		toNode;		/*	Identifies contact.	*/
+	time_t		fromTime;	/*	Identifies contact.	*/
+} IonContactEdit;
+
 typedef enum
 {
 	IonStopImputedRange = 0,
@@ -236,6 +265,19 @@ typedef struct
 	PsmAddress	ref;		/*	A CXref or RXref addr.	*/
 } IonEvent;
 
+/*	For congestion forecasting, each change in the local node's
+ *	net rate of growth in occupancy that results from the start
+ *	or end of transmission to or reception from a neighbor is
+ *	noted as a delta in an index of rate changes, ordered by
+ *	time.  All changes at the same time are aggregated.		*/
+
+typedef struct
+{
+	time_t		time;		/*	As from time(2).	*/
+	vast		netGrowthDelta;	/*	Bytes per second.	*/
+	int		eventsCount;	/*	Changes aggregated.	*/
+} IonRateChange;
+
 /*	The volatile database object encapsulates the current volatile
  *	state of the database.						*/
 
@@ -247,11 +289,13 @@ typedef struct
 	int		zcoClaimants;	/*	# of waiting tasks.	*/
 	int		zcoClaims;	/*	# of demands on ZCO.	*/
 	time_t		lastEditTime;	/*	Add/del contacts/ranges	*/
+	PsmAddress	contactEdits;	/*	SM list: IonContactEdit	*/
 	PsmAddress	nodes;		/*	SM RB tree: IonNode	*/
 	PsmAddress	neighbors;	/*	SM RB tree: IonNeighbor	*/
 	PsmAddress	contactIndex;	/*	SM RB tree: IonCXref	*/
 	PsmAddress	rangeIndex;	/*	SM RB tree: IonRXref	*/
 	PsmAddress	timeline;	/*	SM RB tree: IonEvent	*/
+	PsmAddress	rateChanges;	/*	SM RB tree: IonRateChange */
 	PsmAddress	probes;		/*	SM list: IonProbe	*/
 } IonVdb;
 
@@ -144,12 +144,18 @@ typedef unsigned long		n_long;	/*	long as rec'd from net	*/
 #define ECONNRESET		WSAECONNRESET
 #define EWOULDBLOCK		WSAEWOULDBLOCK
 #define	O_LARGEFILE		0
+struct iovec
+{
+	void	*iov_base;
+	size_t	iov_len;
+};
 #else				/****	not Windows		*********/
 #include <sys/times.h>
 #include <limits.h>
 #include <sys/wait.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
@@ -631,6 +637,58 @@ extern void			iblock(int);
 extern char			*igets(int, char *, int, int *);
 extern int			iputs(int, char *);
 
+/*	Asynchronous I/O rings.  An IoRing keeps up to "depth" socket
+ *	sends and receives and file reads and writes in flight from a
+ *	single thread: requests are queued, submitted in a batch by
+ *	ioRingSubmit, and their completions are reaped in a batch by
+ *	ioRingReap.  The ring also owns "bufferCount" buffers of
+ *	"bufferLength" bytes each; file reads and writes whose
+ *	buffers lie within one of these buffers use buffers that are
+ *	registered with the kernel.  Under Linux the ring is an
+ *	io_uring, unless ION_NO_IO_URING is defined or the kernel
+ *	doesn't support io_uring; otherwise each request is simply
+ *	performed synchronously when it is submitted.			*/
+
+#if defined (linux) && !defined (bionic) && !defined (uClibc) \
+	&& !defined (ION_NO_IO_URING) && defined (__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define	ION_IO_URING
+#endif
+#endif
+
+#if !defined (mingw) && !defined (VXWORKS)
+typedef struct IoRingStruct	*IoRing;
+
+typedef struct
+{
+	void		*userData;	/*	As passed in request.	*/
+	int		result;		/*	Byte count, or -errno.	*/
+} IoCompletion;
+
+extern IoRing			ioRingCreate(int depth, int bufferCount,
+					int bufferLength);
+extern int			ioRingIsAsync(IoRing ring);
+extern char			*ioRingBuffer(IoRing ring, int bufferNbr);
+extern int			ioRingSend(IoRing ring, int fd, char *buffer,
+					int length, struct sockaddr *destName,
+					socklen_t destNameLength,
+					void *userData);
+extern int			ioRingRecv(IoRing ring, int fd, char *buffer,
+					int length, void *userData);
+extern int			ioRingRead(IoRing ring, int fd, char *buffer,
+					int length, vast offset,
+					void *userData);
+extern int			ioRingWrite(IoRing ring, int fd, char *buffer,
+					int length, vast offset,
+					void *userData);
+extern int			ioRingSubmit(IoRing ring);
+extern int			ioRingReap(IoRing ring,
+					IoCompletion *completions,
+					int maxCompletions, int minCompletions);
+extern int			ioRingInFlight(IoRing ring);
+extern void			ioRingDestroy(IoRing ring);
+#endif	/*	end of #if !defined (mingw, VXWORKS)		*/
+
 extern void			findToken(char **cursorPtr, char **token);
 extern int			parseSocketSpec(char *socketSpec,
 					unsigned short *portNbr,
@@ -32,6 +32,9 @@ extern int	rfx_order_contacts(PsmPartition partition, PsmAddress nodeData,
 extern int	rfx_order_events(PsmPartition partition, PsmAddress nodeData,
 			void *dataBuffer);
 
+extern int	rfx_order_rate_changes(PsmPartition partition,
+			PsmAddress nodeData, void *dataBuffer);
+
 extern void	rfx_erase_data(PsmPartition partition, PsmAddress nodeData,
 			void *argument);
 
@@ -50,6 +53,20 @@ extern PsmAddress	rfx_insert_contact(time_t fromTime,
 
 				Returns zero on any error.		*/
 
+extern int		rfx_insert_contacts(IonContact *contacts,
+				int count);
+			/*	Inserts all of the contacts in the
+				array in a single transaction.  The
+				array is sorted in place.  Contacts
+				that are invalid, that are already
+				in the database, or that overlap any
+				pre-existing or other new contact are
+				noted and skipped, as they would be
+				by rfx_insert_contact.
+
+				Returns the number of contacts
+				inserted, or -1 on any error.		*/
+
 extern char		*rfx_print_contact(PsmAddress contact, char *buffer);
 			/*	Prints the indicated IonCXref
 				object into buffer, which must be
@@ -91,6 +108,95 @@ extern int		rfx_remove_range(time_t fromTime,
 				object from the time-ordered ranges
 				list in the ION database.		*/
 
+/*	*	Functions for maintaining the index of rate changes.	*/
+
+extern int		rfx_insert_rate_change(time_t time,
+				vast netGrowthDelta);
+			/*	Notes that the local node's net rate
+				of growth in occupancy will change
+				by netGrowthDelta bytes per second
+				at the indicated time, due to the
+				start or end of transmission or
+				reception in some contact.
+
+				Returns 0 on success, -1 on any
+				error.					*/
+
+extern void		rfx_remove_rate_change(time_t time,
+				vast netGrowthDelta);
+			/*	Reverses the effect of a prior call
+				to rfx_insert_rate_change with the
+				same arguments.				*/
+
+/*	*	Functions for loading binary contact plans.	*	*/
+
+/*	A binary contact plan is a header followed by an array of
+ *	contact records and then an array of range records.  All
+ *	integers are unsigned and in network byte order, except
+ *	that times are signed.
+ *
+ *	Header:	magic number	8 bytes, RFX_PLAN_MAGIC
+ *		version		4 bytes, RFX_PLAN_VERSION
+ *		contacts count	4 bytes
+ *		ranges count	4 bytes
+ *
+ *	Record:	from time	8 bytes
+ *		to time		8 bytes
+ *		from node	8 bytes
+ *		to node		8 bytes
+ *		value		4 bytes, xmit rate or OWLT
+ *		flags		4 bytes
+ *
+ *	A time is seconds since the epoch, unless flagged as an
+ *	offset from the time at which the plan is loaded.		*/
+
+#define	RFX_PLAN_MAGIC		"IONPLAN"
+#define	RFX_PLAN_VERSION	1
+#define	RFX_PLAN_HDR_LEN	20
+#define	RFX_PLAN_REC_LEN	40
+
+#define	RFX_PLAN_FROM_RELATIVE	(1)
+#define	RFX_PLAN_TO_RELATIVE	(2)
+
+typedef struct
+{
+	time_t		fromTime;
+	time_t		toTime;
+	uvast		fromNode;
+	uvast		toNode;
+	unsigned int	value;		/*	Xmit rate or OWLT.	*/
+	unsigned int	flags;
+} RfxPlanRecord;
+
+extern void		rfx_encode_plan_header(int contactsCount,
+				int rangesCount,
+				unsigned char *buffer);
+			/*	Writes a binary contact plan header
+				into buffer, which must be of length
+				no less than RFX_PLAN_HDR_LEN.		*/
+
+extern void		rfx_encode_plan_record(RfxPlanRecord *record,
+				unsigned char *buffer);
+			/*	Writes a binary contact plan record
+				into buffer, which must be of length
+				no less than RFX_PLAN_REC_LEN.		*/
+
+extern int		rfx_load_plan(char *fileName,
+				int *contactsLoaded,
+				int *rangesLoaded);
+			/*	Maps the indicated binary contact plan
+				file into memory and inserts all of
+				its ranges and then all of its
+				contacts, the latter in a single
+				transaction by rfx_insert_contacts.
+				Reports the numbers of contacts and
+				ranges actually inserted.  A plan
+				that is malformed or of an unknown
+				version is noted and not loaded.
+
+				Returns 0 on success, -1 on any
+				system error.				*/
+
 /*	*	Functions for controlling the rfxclock.			*/
 
 extern int		rfx_start();
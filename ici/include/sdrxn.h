@@ -190,6 +190,12 @@ extern int		sdr_heap_is_halted(Sdr sdr);	/*	Boolean	*/
 extern void		sdr_exit_xn(Sdr sdr);
 extern void		sdr_cancel_xn(Sdr sdr);
 extern int		sdr_end_xn(Sdr sdr);
+extern unsigned long	sdr_xn_count(Sdr sdr);
+			/*	Returns the number of (outermost)
+				transactions begun on this SDR by all
+				tasks since the SDR was loaded; the
+				difference between two readings is
+				a measure of transaction overhead.	*/
 
 /*		Low-level SDR I/O functions.				*/
 
@@ -73,12 +73,22 @@ typedef struct
 {
 	Object	zco;
 	int	trackFileOffset;		/*	Boolean control	*/
+	int	gatherInPlace;			/*	Boolean control	*/
 	vast	headersLengthCopied;		/*	within extents	*/
 	vast	sourceLengthCopied;		/*	within extents	*/
 	vast	trailersLengthCopied;		/*	within extents	*/
 	vast	lengthCopied;			/*	incl. capsules	*/
 } ZcoReader;
 
+typedef struct
+{
+	ZcoMedium	sourceMedium;		/*	File or SDR	*/
+	int		fd;			/*	if file		*/
+	vast		offset;			/*	within file	*/
+	Object		location;		/*	if SDR		*/
+	vast		length;
+} ZcoExtentDescriptor;
+
 /*	Commonly used functions for building, accessing, managing,
  	and destroying a ZCO.						*/
 
@@ -327,6 +337,12 @@ extern void	zco_track_file_offset(ZcoReader *reader);
 			/*	Turn on file offset tracking for this
 			 *	reader.					*/
 
+extern void	zco_gather_in_place(ZcoReader *reader);
+			/*	Permit zco_transmit_iov and
+			 *	zco_receive_iov to point this reader's
+			 *	iovecs directly at bytes in the SDR
+			 *	heap rather than copying them.		*/
+
 extern vast	zco_transmit(	Sdr sdr,
 				ZcoReader *reader,
 				vast length,
@@ -338,6 +354,72 @@ extern vast	zco_transmit(	Sdr sdr,
 			 *	this ZCO.  Returns the number of bytes
 			 *	copied, or -1 on any error.		*/
 
+extern vast	zco_transmit_extent(Sdr sdr,
+				ZcoReader *reader,
+				vast length,
+				ZcoExtentDescriptor *descriptor);
+			/*	Like zco_transmit, but rather than
+			 *	copying bytes into a buffer it
+			 *	describes the longest contiguous run
+			 *	of no more than "length" as-yet-
+			 *	uncopied bytes of the ZCO, so that
+			 *	they can be transmitted without being
+			 *	copied into user space.  If the bytes
+			 *	are in a file, the descriptor's
+			 *	sourceMedium is ZcoFileSource and fd
+			 *	is a newly opened read-only descriptor
+			 *	for that file, which the caller must
+			 *	close, while offset is the offset of
+			 *	the bytes within the file.  Otherwise
+			 *	sourceMedium is ZcoSdrSource, fd is
+			 *	-1, and location is the address of
+			 *	the bytes in the SDR heap.  If the
+			 *	file can't be read, sourceMedium is
+			 *	ZcoFileSource but fd is -1, and the
+			 *	caller must transmit length bytes of
+			 *	ZCO_FILE_FILL_CHAR instead.  Must be
+			 *	called within a transaction.  Returns
+			 *	the length of the run, 0 if the ZCO
+			 *	is exhausted, or -1 on any error.	*/
+
+extern vast	zco_transmit_iov(Sdr sdr,
+				ZcoReader *reader,
+				vast length,
+				struct iovec *iov,
+				int *iovCount,
+				char *buffer,
+				int bufferLength,
+				ZcoExtentDescriptor *fileExtent);
+			/*	Like zco_transmit, but rather than
+			 *	copying up to "length" as-yet-uncopied
+			 *	bytes of the ZCO into one contiguous
+			 *	buffer it populates the array of
+			 *	*iovCount iovecs to which "iov" points
+			 *	and sets *iovCount to the number of
+			 *	iovecs populated.  Bytes are copied
+			 *	into "buffer", which is of length
+			 *	"bufferLength", and the iovecs point
+			 *	into that buffer; but if the reader
+			 *	gathers in place and the SDR is in
+			 *	DRAM, each iovec for bytes in the SDR
+			 *	heap points directly at those bytes
+			 *	and the caller must finish sending
+			 *	them before ending the transaction.
+			 *	If "fileExtent" is NULL, the content
+			 *	of file extents is likewise copied
+			 *	into the buffer.  Otherwise gathering
+			 *	stops at the first file extent, which
+			 *	is described in *fileExtent as by
+			 *	zco_transmit_extent; the caller must
+			 *	transmit those bytes after the bytes
+			 *	in the iovecs and then close the file
+			 *	descriptor.  Unreadable file content
+			 *	is gathered as fill, as by
+			 *	zco_transmit.  Must be called within
+			 *	a transaction.  Returns the number of
+			 *	bytes gathered (in the iovecs and in
+			 *	*fileExtent), or -1 on any error.	*/
+
 extern void	zco_start_receiving(Object zco,
 				ZcoReader *reader);
 			/*	Used by overlying protocol layer to
@@ -391,6 +473,23 @@ extern vast	zco_receive_source(Sdr sdr,
 			 *	source data.  Returns number of bytes
 			 *	copied, or -1 on any error.		*/
 
+extern vast	zco_receive_iov(Sdr sdr,
+				ZcoReader *reader,
+				vast length,
+				struct iovec *iov,
+				int *iovCount,
+				char *buffer,
+				int bufferLength,
+				ZcoExtentDescriptor *fileExtent);
+			/*	Like zco_receive_source, but gathers
+			 *	up to "length" as-yet-unreceived bytes
+			 *	of the ZCO's source data into an array
+			 *	of iovecs as zco_transmit_iov does,
+			 *	for delivery by writev().  Must be
+			 *	called within a transaction.  Returns
+			 *	the number of bytes gathered, or -1
+			 *	on any error.				*/
+
 extern vast	zco_receive_trailers(Sdr sdr,
 				ZcoReader *reader,
 				vast length,
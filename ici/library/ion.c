@@ -276,7 +276,9 @@ static IonVdb	*_ionvdb(char **name)
 		|| (vdb->contactIndex = sm_rbt_create(ionwm)) == 0
 		|| (vdb->rangeIndex = sm_rbt_create(ionwm)) == 0
 		|| (vdb->timeline = sm_rbt_create(ionwm)) == 0
+		|| (vdb->rateChanges = sm_rbt_create(ionwm)) == 0
 		|| (vdb->probes = sm_list_create(ionwm)) == 0
+		|| (vdb->contactEdits = sm_list_create(ionwm)) == 0
 		|| psm_catlg(ionwm, *name, vdbAddress) < 0)
 		{
 			sdr_exit_xn(sdr);
@@ -951,12 +953,18 @@ static void	dropVdb(PsmPartition wm, PsmAddress vdbAddress)
 
 	sm_list_destroy(wm, vdb->probes, rfx_erase_data, NULL);
 
-	/*	Three of the red-black tables in the Vdb are
+	/*	As is the list of contact edits not yet applied to
+	 *	routes.							*/
+
+	sm_list_destroy(wm, vdb->contactEdits, rfx_erase_data, NULL);
+
+	/*	Four of the red-black tables in the Vdb are
 	 *	emptied and recreated by rfx_stop().  Destroy them.	*/
 
 	sm_rbt_destroy(wm, vdb->contactIndex, NULL, NULL);
 	sm_rbt_destroy(wm, vdb->rangeIndex, NULL, NULL);
 	sm_rbt_destroy(wm, vdb->timeline, NULL, NULL);
+	sm_rbt_destroy(wm, vdb->rateChanges, NULL, NULL);
 
 	/*	cgr_stop clears all routing objects, so nodes and
 	 *	neighbors themselves can now be deleted.		*/
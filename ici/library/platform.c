@@ -3062,3 +3062,659 @@ int	iputs(int fd, char *string)
 
 	return totalBytesWritten;
 }
+
+/*	*	*	Asynchronous I/O ring functions	*	*	*/
+
+#if !defined (mingw) && !defined (VXWORKS)
+
+#ifdef ION_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#define	IORING_SEND		(1)
+#define	IORING_RECV		(2)
+#define	IORING_READ		(3)
+#define	IORING_WRITE		(4)
+
+typedef struct
+{
+	int			op;
+	int			fd;
+	char			*buffer;
+	int			length;
+	vast			offset;
+	void			*userData;
+	struct msghdr		msg;
+	struct iovec		iov;
+	struct sockaddr_storage	name;
+} IoRequest;
+
+typedef struct IoRingStruct
+{
+	int			depth;
+	IoRequest		*requests;
+	int			*freeSlots;	/*	Stack.		*/
+	int			freeCount;
+	int			*queue;		/*	Unsubmitted.	*/
+	int			queueLength;
+	int			inFlight;
+	char			*buffers;
+	int			bufferCount;
+	int			bufferLength;
+	int			buffersRegistered;
+
+	/*	Completions of emulated requests, in order.		*/
+
+	int			*done;
+	int			doneLength;
+#ifdef ION_IO_URING
+	int			fd;		/*	io_uring.	*/
+	char			*sqRing;
+	size_t			sqRingSize;
+	char			*cqRing;
+	size_t			cqRingSize;
+	struct io_uring_sqe	*sqes;
+	size_t			sqesSize;
+	unsigned int		*sqTail;
+	unsigned int		sqMask;
+	unsigned int		*sqArray;
+	unsigned int		*cqHead;
+	unsigned int		*cqTail;
+	unsigned int		cqMask;
+	struct io_uring_cqe	*cqes;
+#endif
+} IoRingState;
+
+#ifdef ION_IO_URING
+
+static int	uringSetup(IoRingState *ring)
+{
+	struct io_uring_params	params;
+	struct iovec		*iovs;
+	int			i;
+
+	/*	Returns 0 if the kernel doesn't support io_uring, in
+	 *	which case requests are emulated.			*/
+
+	memset((char *) &params, 0, sizeof params);
+	ring->fd = syscall(__NR_io_uring_setup, ring->depth, &params);
+	if (ring->fd < 0)
+	{
+		return 0;
+	}
+
+	ring->sqRingSize = params.sq_off.array
+			+ params.sq_entries * sizeof(unsigned int);
+	ring->cqRingSize = params.cq_off.cqes
+			+ params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd,
+			IORING_OFF_SQ_RING);
+	ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd,
+			IORING_OFF_CQ_RING);
+	ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd,
+			IORING_OFF_SQES);
+	if (ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED
+	|| ring->sqes == MAP_FAILED)
+	{
+		putSysErrmsg("Can't map io_uring", NULL);
+		return -1;
+	}
+
+	ring->sqTail = (unsigned int *) (ring->sqRing + params.sq_off.tail);
+	ring->sqMask = *((unsigned int *) (ring->sqRing
+			+ params.sq_off.ring_mask));
+	ring->sqArray = (unsigned int *) (ring->sqRing + params.sq_off.array);
+	ring->cqHead = (unsigned int *) (ring->cqRing + params.cq_off.head);
+	ring->cqTail = (unsigned int *) (ring->cqRing + params.cq_off.tail);
+	ring->cqMask = *((unsigned int *) (ring->cqRing
+			+ params.cq_off.ring_mask));
+	ring->cqes = (struct io_uring_cqe *) (ring->cqRing
+			+ params.cq_off.cqes);
+
+	/*	Registration of the buffers may fail, e.g., for lack
+	 *	of locked memory allowance, in which case they are
+	 *	simply used as unregistered buffers.			*/
+
+	if (ring->bufferCount > 0)
+	{
+		iovs = (struct iovec *) malloc(ring->bufferCount
+				* sizeof(struct iovec));
+		if (iovs == NULL)
+		{
+			putErrmsg("Can't register I/O ring buffers.", NULL);
+			return -1;
+		}
+
+		for (i = 0; i < ring->bufferCount; i++)
+		{
+			iovs[i].iov_base = ring->buffers
+					+ (i * ring->bufferLength);
+			iovs[i].iov_len = ring->bufferLength;
+		}
+
+		if (syscall(__NR_io_uring_register, ring->fd,
+				IORING_REGISTER_BUFFERS, iovs,
+				ring->bufferCount) == 0)
+		{
+			ring->buffersRegistered = 1;
+		}
+
+		free(iovs);
+	}
+
+	return 1;
+}
+
+static void	uringTeardown(IoRingState *ring)
+{
+	if (ring->sqes && ring->sqes != MAP_FAILED)
+	{
+		munmap(ring->sqes, ring->sqesSize);
+	}
+
+	if (ring->cqRing && ring->cqRing != MAP_FAILED)
+	{
+		munmap(ring->cqRing, ring->cqRingSize);
+	}
+
+	if (ring->sqRing && ring->sqRing != MAP_FAILED)
+	{
+		munmap(ring->sqRing, ring->sqRingSize);
+	}
+
+	if (ring->fd >= 0)
+	{
+		close(ring->fd);
+	}
+}
+
+static int	registeredBuffer(IoRingState *ring, char *buffer, int length)
+{
+	int	bufferNbr;
+
+	if (!ring->buffersRegistered || buffer < ring->buffers)
+	{
+		return -1;
+	}
+
+	bufferNbr = (buffer - ring->buffers) / ring->bufferLength;
+	if (bufferNbr >= ring->bufferCount
+	|| buffer + length > ring->buffers
+			+ ((bufferNbr + 1) * ring->bufferLength))
+	{
+		return -1;
+	}
+
+	return bufferNbr;
+}
+
+static void	uringPrepare(IoRingState *ring, int slot)
+{
+	IoRequest		*req = ring->requests + slot;
+	unsigned int		tail = *(ring->sqTail) + ring->queueLength;
+	unsigned int		idx = tail & ring->sqMask;
+	struct io_uring_sqe	*sqe = ring->sqes + idx;
+	int			bufferNbr;
+
+	memset((char *) sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->fd = req->fd;
+	sqe->user_data = slot;
+	switch (req->op)
+	{
+	case IORING_SEND:
+		sqe->opcode = IORING_OP_SENDMSG;
+		sqe->addr = (unsigned long) &(req->msg);
+		sqe->len = 1;
+		sqe->msg_flags = MSG_NOSIGNAL;
+		break;
+
+	case IORING_RECV:
+		sqe->opcode = IORING_OP_RECVMSG;
+		sqe->addr = (unsigned long) &(req->msg);
+		sqe->len = 1;
+		break;
+
+	default:
+		sqe->off = req->offset;
+		bufferNbr = registeredBuffer(ring, req->buffer, req->length);
+		if (bufferNbr < 0)
+		{
+			sqe->opcode = (req->op == IORING_READ ?
+					IORING_OP_READV : IORING_OP_WRITEV);
+			sqe->addr = (unsigned long) &(req->iov);
+			sqe->len = 1;
+		}
+		else
+		{
+			sqe->opcode = (req->op == IORING_READ ?
+					IORING_OP_READ_FIXED :
+					IORING_OP_WRITE_FIXED);
+			sqe->addr = (unsigned long) req->buffer;
+			sqe->len = req->length;
+			sqe->buf_index = bufferNbr;
+		}
+	}
+
+	ring->sqArray[idx] = idx;
+}
+
+#endif	/*	end of #ifdef ION_IO_URING				*/
+
+IoRing	ioRingCreate(int depth, int bufferCount, int bufferLength)
+{
+	IoRingState	*ring;
+	int		i;
+
+	if (depth < 1 || bufferCount < 0
+	|| (bufferCount > 0 && bufferLength < 1))
+	{
+		ABORT_AS_REQD;
+		putErrmsg("Invalid argument(s) passed to ioRingCreate().",
+				NULL);
+		return NULL;
+	}
+
+	ring = (IoRingState *) calloc(1, sizeof(IoRingState));
+	if (ring == NULL)
+	{
+		putErrmsg("Can't allocate I/O ring.", NULL);
+		return NULL;
+	}
+
+#ifdef ION_IO_URING
+	ring->fd = -1;			/*	Not yet set up.	*/
+#endif
+	ring->depth = depth;
+	ring->bufferCount = bufferCount;
+	ring->bufferLength = bufferLength;
+	ring->requests = (IoRequest *) calloc(depth, sizeof(IoRequest));
+	ring->freeSlots = (int *) calloc(depth, sizeof(int));
+	ring->queue = (int *) calloc(depth, sizeof(int));
+	ring->done = (int *) calloc(depth, sizeof(int));
+	if (bufferCount > 0)
+	{
+		ring->buffers = (char *) calloc(bufferCount, bufferLength);
+	}
+
+	if (ring->requests == NULL || ring->freeSlots == NULL
+	|| ring->queue == NULL || ring->done == NULL
+	|| (bufferCount > 0 && ring->buffers == NULL))
+	{
+		putErrmsg("Can't allocate I/O ring.", NULL);
+		ioRingDestroy(ring);
+		return NULL;
+	}
+
+	for (i = 0; i < depth; i++)
+	{
+		ring->freeSlots[i] = depth - (i + 1);
+	}
+
+	ring->freeCount = depth;
+#ifdef ION_IO_URING
+	if (uringSetup(ring) < 0)
+	{
+		ioRingDestroy(ring);
+		return NULL;
+	}
+#endif
+	return ring;
+}
+
+int	ioRingIsAsync(IoRing ring)
+{
+	CHKZERO(ring);
+#ifdef ION_IO_URING
+	return (ring->fd >= 0);
+#else
+	return 0;
+#endif
+}
+
+char	*ioRingBuffer(IoRing ring, int bufferNbr)
+{
+	CHKNULL(ring);
+	CHKNULL(bufferNbr >= 0 && bufferNbr < ring->bufferCount);
+	return ring->buffers + (bufferNbr * ring->bufferLength);
+}
+
+static int	queueRequest(IoRingState *ring, int op, int fd, char *buffer,
+			int length, vast offset, void *userData)
+{
+	int		slot;
+	IoRequest	*req;
+
+	/*	Returns 1 if the request is queued, 0 if all of the
+	 *	ring's request slots are in use.			*/
+
+	if (ring->freeCount == 0)
+	{
+		return 0;
+	}
+
+	ring->freeCount--;
+	slot = ring->freeSlots[ring->freeCount];
+	req = ring->requests + slot;
+	req->op = op;
+	req->fd = fd;
+	req->buffer = buffer;
+	req->length = length;
+	req->offset = offset;
+	req->userData = userData;
+	req->iov.iov_base = buffer;
+	req->iov.iov_len = length;
+	memset((char *) &(req->msg), 0, sizeof(struct msghdr));
+	req->msg.msg_iov = &(req->iov);
+	req->msg.msg_iovlen = 1;
+#ifdef ION_IO_URING
+	if (ring->fd >= 0)
+	{
+		uringPrepare(ring, slot);
+	}
+#endif
+	ring->queue[ring->queueLength] = slot;
+	ring->queueLength++;
+	return 1;
+}
+
+int	ioRingSend(IoRing ring, int fd, char *buffer, int length,
+		struct sockaddr *destName, socklen_t destNameLength,
+		void *userData)
+{
+	IoRequest	*req;
+
+	CHKERR(ring);
+	CHKERR(fd >= 0);
+	CHKERR(buffer);
+	CHKERR(length >= 0);
+	CHKERR(destNameLength <= sizeof(struct sockaddr_storage));
+	if (queueRequest(ring, IORING_SEND, fd, buffer, length, 0, userData)
+			== 0)
+	{
+		return 0;
+	}
+
+	if (destName)
+	{
+		req = ring->requests + ring->queue[ring->queueLength - 1];
+		memcpy((char *) &(req->name), (char *) destName,
+				destNameLength);
+		req->msg.msg_name = &(req->name);
+		req->msg.msg_namelen = destNameLength;
+	}
+
+	return 1;
+}
+
+int	ioRingRecv(IoRing ring, int fd, char *buffer, int length,
+		void *userData)
+{
+	CHKERR(ring);
+	CHKERR(fd >= 0);
+	CHKERR(buffer);
+	CHKERR(length >= 0);
+	return queueRequest(ring, IORING_RECV, fd, buffer, length, 0,
+			userData);
+}
+
+int	ioRingRead(IoRing ring, int fd, char *buffer, int length,
+		vast offset, void *userData)
+{
+	CHKERR(ring);
+	CHKERR(fd >= 0);
+	CHKERR(buffer);
+	CHKERR(length >= 0);
+	CHKERR(offset >= 0);
+	return queueRequest(ring, IORING_READ, fd, buffer, length, offset,
+			userData);
+}
+
+int	ioRingWrite(IoRing ring, int fd, char *buffer, int length,
+		vast offset, void *userData)
+{
+	CHKERR(ring);
+	CHKERR(fd >= 0);
+	CHKERR(buffer);
+	CHKERR(length >= 0);
+	CHKERR(offset >= 0);
+	return queueRequest(ring, IORING_WRITE, fd, buffer, length, offset,
+			userData);
+}
+
+static int	performRequest(IoRequest *req)
+{
+	int	result;
+
+	while (1)
+	{
+		switch (req->op)
+		{
+		case IORING_SEND:
+#ifdef MSG_NOSIGNAL
+			result = sendmsg(req->fd, &(req->msg), MSG_NOSIGNAL);
+#else
+			result = sendmsg(req->fd, &(req->msg), 0);
+#endif
+			break;
+
+		case IORING_RECV:
+			result = recvmsg(req->fd, &(req->msg), 0);
+			break;
+
+		case IORING_READ:
+			result = pread(req->fd, req->buffer, req->length,
+					req->offset);
+			break;
+
+		default:
+			result = pwrite(req->fd, req->buffer, req->length,
+					req->offset);
+		}
+
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		return (result < 0 ? -errno : result);
+	}
+}
+
+int	ioRingSubmit(IoRing ring)
+{
+	int	submitted;
+	int	i;
+	int	slot;
+#ifdef ION_IO_URING
+	int	result;
+#endif
+
+	/*	Returns the number of requests submitted.		*/
+
+	CHKERR(ring);
+	if (ring->queueLength == 0)
+	{
+		return 0;
+	}
+
+#ifdef ION_IO_URING
+	if (ring->fd >= 0)
+	{
+		__atomic_store_n(ring->sqTail, *(ring->sqTail)
+				+ ring->queueLength, __ATOMIC_RELEASE);
+		submitted = 0;
+		while (submitted < ring->queueLength)
+		{
+			result = syscall(__NR_io_uring_enter, ring->fd,
+					ring->queueLength - submitted, 0, 0,
+					NULL, 0);
+			if (result < 0)
+			{
+				if (errno == EINTR || errno == EAGAIN)
+				{
+					continue;
+				}
+
+				putSysErrmsg("io_uring_enter() failed", NULL);
+				return -1;
+			}
+
+			submitted += result;
+		}
+
+		ring->inFlight += submitted;
+		ring->queueLength = 0;
+		return submitted;
+	}
+#endif
+	for (i = 0; i < ring->queueLength; i++)
+	{
+		slot = ring->queue[i];
+		ring->requests[slot].length =
+				performRequest(ring->requests + slot);
+		ring->done[ring->doneLength] = slot;
+		ring->doneLength++;
+	}
+
+	submitted = ring->queueLength;
+	ring->inFlight += submitted;
+	ring->queueLength = 0;
+	return submitted;
+}
+
+static void	completeRequest(IoRingState *ring, int slot, int result,
+			IoCompletion *completion)
+{
+	completion->userData = ring->requests[slot].userData;
+	completion->result = result;
+	ring->freeSlots[ring->freeCount] = slot;
+	ring->freeCount++;
+	ring->inFlight--;
+}
+
+int	ioRingReap(IoRing ring, IoCompletion *completions, int maxCompletions,
+		int minCompletions)
+{
+	int		count = 0;
+#ifdef ION_IO_URING
+	unsigned int	head;
+	unsigned int	tail;
+	int		result;
+#endif
+
+	/*	Returns the number of completions reaped, which may be
+	 *	less than minCompletions if interrupted by a signal.	*/
+
+	CHKERR(ring);
+	CHKERR(completions);
+	CHKERR(maxCompletions > 0);
+	if (minCompletions > ring->inFlight)
+	{
+		minCompletions = ring->inFlight;
+	}
+
+#ifdef ION_IO_URING
+	if (ring->fd >= 0)
+	{
+		while (1)
+		{
+			head = *(ring->cqHead);
+			tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+			while (head != tail && count < maxCompletions)
+			{
+				struct io_uring_cqe	*cqe;
+
+				cqe = ring->cqes + (head & ring->cqMask);
+				completeRequest(ring, (int) cqe->user_data,
+						cqe->res, completions + count);
+				count++;
+				head++;
+			}
+
+			__atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+			if (count >= minCompletions || count == maxCompletions)
+			{
+				return count;
+			}
+
+			result = syscall(__NR_io_uring_enter, ring->fd, 0,
+					minCompletions - count,
+					IORING_ENTER_GETEVENTS, NULL, 0);
+			if (result < 0)
+			{
+				if (errno == EINTR)
+				{
+					return count;
+				}
+
+				putSysErrmsg("io_uring_enter() failed", NULL);
+				return -1;
+			}
+		}
+	}
+#endif
+	while (count < ring->doneLength && count < maxCompletions)
+	{
+		completeRequest(ring, ring->done[count],
+				ring->requests[ring->done[count]].length,
+				completions + count);
+		count++;
+	}
+
+	ring->doneLength -= count;
+	memmove((char *) ring->done, (char *) (ring->done + count),
+			ring->doneLength * sizeof(int));
+	return count;
+}
+
+int	ioRingInFlight(IoRing ring)
+{
+	CHKZERO(ring);
+	return ring->inFlight + ring->queueLength;
+}
+
+void	ioRingDestroy(IoRing ring)
+{
+	if (ring == NULL)
+	{
+		return;
+	}
+
+#ifdef ION_IO_URING
+	uringTeardown(ring);
+#endif
+	if (ring->buffers)
+	{
+		free(ring->buffers);
+	}
+
+	if (ring->done)
+	{
+		free(ring->done);
+	}
+
+	if (ring->queue)
+	{
+		free(ring->queue);
+	}
+
+	if (ring->freeSlots)
+	{
+		free(ring->freeSlots);
+	}
+
+	if (ring->requests)
+	{
+		free(ring->requests);
+	}
+
+	free(ring);
+}
+
+#endif	/*	end of #if !defined (mingw, VXWORKS)			*/
@@ -17,6 +17,11 @@
 #include "rfx.h"
 #include "lyst.h"
 
+#if !(defined (mingw) || defined (VXWORKS) || defined (RTEMS))
+#include <sys/mman.h>
+#define	RFX_MMAP_PLANS
+#endif
+
 /*	*	Red-black tree ordering and deletion functions	*	*/
 
 static int	rfx_order_nodes(PsmPartition partition, PsmAddress nodeData,
@@ -220,6 +225,27 @@ int	rfx_order_events(PsmPartition partition, PsmAddress nodeData,
 	return 0;
 }
 
+int	rfx_order_rate_changes(PsmPartition partition, PsmAddress nodeData,
+		void *dataBuffer)
+{
+	IonRateChange	*change;
+	IonRateChange	*argChange;
+
+	change = (IonRateChange *) psp(partition, nodeData);
+	argChange = (IonRateChange *) dataBuffer;
+	if (change->time < argChange->time)
+	{
+		return -1;
+	}
+
+	if (change->time > argChange->time)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
 void	rfx_erase_data(PsmPartition partition, PsmAddress nodeData,
 		void *argument)
 {
@@ -507,17 +533,128 @@ PsmAddress	postProbeEvent(IonNode *node, IonSnub *snub)
 	return sm_list_insert_first(ionwm, ionvdb->probes, addr);
 }
 
+int	rfx_insert_rate_change(time_t time, vast netGrowthDelta)
+{
+	PsmPartition	ionwm = getIonwm();
+	IonVdb 		*vdb = getIonVdb();
+	IonRateChange	arg;
+	PsmAddress	elt;
+	PsmAddress	nextElt;
+	PsmAddress	addr;
+	IonRateChange	*change;
+
+	arg.time = time;
+	elt = sm_rbt_search(ionwm, vdb->rateChanges, rfx_order_rate_changes,
+			&arg, &nextElt);
+	if (elt)	/*	Aggregate with other changes at this time.	*/
+	{
+		change = (IonRateChange *) psp(ionwm, sm_rbt_data(ionwm, elt));
+		change->netGrowthDelta += netGrowthDelta;
+		change->eventsCount++;
+		return 0;
+	}
+
+	addr = psm_zalloc(ionwm, sizeof(IonRateChange));
+	if (addr == 0)
+	{
+		putErrmsg("Can't add rate change.", NULL);
+		return -1;
+	}
+
+	change = (IonRateChange *) psp(ionwm, addr);
+	change->time = time;
+	change->netGrowthDelta = netGrowthDelta;
+	change->eventsCount = 1;
+	if (sm_rbt_insert(ionwm, vdb->rateChanges, addr, rfx_order_rate_changes,
+			change) == 0)
+	{
+		psm_free(ionwm, addr);
+		putErrmsg("Can't add rate change.", NULL);
+		return -1;
+	}
+
+	return 0;
+}
+
+void	rfx_remove_rate_change(time_t time, vast netGrowthDelta)
+{
+	PsmPartition	ionwm = getIonwm();
+	IonVdb 		*vdb = getIonVdb();
+	IonRateChange	arg;
+	PsmAddress	elt;
+	PsmAddress	nextElt;
+	IonRateChange	*change;
+
+	arg.time = time;
+	elt = sm_rbt_search(ionwm, vdb->rateChanges, rfx_order_rate_changes,
+			&arg, &nextElt);
+	if (elt == 0)
+	{
+		return;		/*	Nothing to remove.		*/
+	}
+
+	change = (IonRateChange *) psp(ionwm, sm_rbt_data(ionwm, elt));
+	change->netGrowthDelta -= netGrowthDelta;
+	change->eventsCount--;
+	if (change->eventsCount <= 0)
+	{
+		sm_rbt_delete(ionwm, vdb->rateChanges, rfx_order_rate_changes,
+				&arg, rfx_erase_data, NULL);
+	}
+}
+
 /*	*	RFX contact list management functions	*	*	*/
 
-static PsmAddress	insertCXref(IonCXref *cxref)
+static void	clearContactEdits(PsmPartition ionwm, IonVdb *vdb,
+			time_t currentTime)
+{
+	/*	All routes will have to be recomputed, so the record
+	 *	of individual contact edits is of no further use.	*/
+
+	sm_list_clear(ionwm, vdb->contactEdits, rfx_erase_data, NULL);
+	vdb->lastEditTime = currentTime;
+}
+
+static void	noteContactEdit(IonCXref *cxref, IonContactEditType type,
+			time_t currentTime)
+{
+	PsmPartition	ionwm = getIonwm();
+	IonVdb 		*vdb = getIonVdb();
+	PsmAddress	addr;
+	IonContactEdit	*edit;
+
+	if (sm_list_length(ionwm, vdb->contactEdits) >= ION_MAX_CONTACT_EDITS)
+	{
+		clearContactEdits(ionwm, vdb, currentTime);
+		return;
+	}
+
+	addr = psm_zalloc(ionwm, sizeof(IonContactEdit));
+	if (addr == 0)
+	{
+		clearContactEdits(ionwm, vdb, currentTime);
+		return;
+	}
+
+	edit = (IonContactEdit *) psp(ionwm, addr);
+	edit->type = type;
+	edit->fromNode = cxref->fromNode;
+	edit->toNode = cxref->toNode;
+	edit->fromTime = cxref->fromTime;
+	if (sm_list_insert_last(ionwm, vdb->contactEdits, addr) == 0)
+	{
+		psm_free(ionwm, addr);
+		clearContactEdits(ionwm, vdb, currentTime);
+	}
+}
+
+static PsmAddress	insertCXref(IonCXref *cxref, IonDB *iondb, int noteEdit)
 {
 	PsmPartition	ionwm = getIonwm();
 	IonVdb 		*vdb = getIonVdb();
 	IonNode		*node;
 	PsmAddress	nextElt;
 	PsmAddress	cxaddr;
-	Object		iondbObj;
-	IonDB		iondb;
 	PsmAddress	cxelt;
 	PsmAddress	addr;
 	IonEvent	*event;
@@ -555,8 +692,6 @@ static PsmAddress	insertCXref(IonCXref *cxref)
 
 	/*	Compute times of relevant events.			*/
 
-	iondbObj = getIonDbObject();
-	sdr_read(getIonsdr(), (char *) &iondb, iondbObj, sizeof(IonDB));
 	if (cxref->fromNode == getOwnNodeNbr())
 	{
 		/*	Be a little slow to start transmission, and
@@ -564,8 +699,8 @@ static PsmAddress	insertCXref(IonCXref *cxref)
 		 *	segments arrive only when neighbor is
 		 *	expecting them.					*/
 
-		cxref->startXmit = cxref->fromTime + iondb.maxClockError;
-		cxref->stopXmit = cxref->toTime - iondb.maxClockError;
+		cxref->startXmit = cxref->fromTime + iondb->maxClockError;
+		cxref->stopXmit = cxref->toTime - iondb->maxClockError;
 	}
 
 	if (cxref->toNode == getOwnNodeNbr())
@@ -574,8 +709,8 @@ static PsmAddress	insertCXref(IonCXref *cxref)
 		 *	little quick to suspend them, to minimize the
 		 *	chance of premature timeout.			*/
 
-		cxref->startFire = cxref->fromTime + iondb.maxClockError;
-		cxref->stopFire = cxref->toTime - iondb.maxClockError;
+		cxref->startFire = cxref->fromTime + iondb->maxClockError;
+		cxref->stopFire = cxref->toTime - iondb->maxClockError;
 	}
 	else	/*	Not a transmission to the local node.		*/
 	{
@@ -611,6 +746,18 @@ static PsmAddress	insertCXref(IonCXref *cxref)
 			psm_free(ionwm, addr);
 			return 0;
 		}
+
+		/*	A loopback contact has no net effect on
+		 *	congestion.					*/
+
+		if (cxref->toNode != cxref->fromNode)
+		{
+			if (rfx_insert_rate_change(cxref->startXmit,
+					-((vast) cxref->xmitRate)) < 0)
+			{
+				return 0;
+			}
+		}
 	}
 
 	if (cxref->stopXmit)
@@ -631,6 +778,15 @@ static PsmAddress	insertCXref(IonCXref *cxref)
 			psm_free(ionwm, addr);
 			return 0;
 		}
+
+		if (cxref->toNode != cxref->fromNode)
+		{
+			if (rfx_insert_rate_change(cxref->stopXmit,
+					cxref->xmitRate) < 0)
+			{
+				return 0;
+			}
+		}
 	}
 
 	if (cxref->startFire)
@@ -693,9 +849,9 @@ static PsmAddress	insertCXref(IonCXref *cxref)
 		}
 	}
 
-	if (cxref->toTime > currentTime)	/*	Affects routes.	*/
+	if (noteEdit && cxref->toTime > currentTime)	/*	Affects routes.	*/
 	{
-		vdb->lastEditTime = currentTime;
+		noteContactEdit(cxref, IonContactAdded, currentTime);
 	}
 
 	return cxaddr;
@@ -811,7 +967,7 @@ PsmAddress	rfx_insert_contact(time_t fromTime, time_t toTime,
 		if (elt)
 		{
 			arg.contactElt = elt;
-			cxaddr = insertCXref(&arg);
+			cxaddr = insertCXref(&arg, &iondb, 1);
 			if (cxaddr == 0)
 			{
 				sdr_cancel_xn(sdr);
@@ -828,6 +984,210 @@ PsmAddress	rfx_insert_contact(time_t fromTime, time_t toTime,
 	return cxaddr;
 }
 
+static int	orderContactArray(const void *a, const void *b)
+{
+	IonContact	*c1 = (IonContact *) a;
+	IonContact	*c2 = (IonContact *) b;
+
+	/*	Same ordering as for the contact index.			*/
+
+	if (c1->fromNode < c2->fromNode) return -1;
+	if (c1->fromNode > c2->fromNode) return 1;
+	if (c1->toNode < c2->toNode) return -1;
+	if (c1->toNode > c2->toNode) return 1;
+	if (c1->fromTime < c2->fromTime) return -1;
+	if (c1->fromTime > c2->fromTime) return 1;
+	return 0;
+}
+
+static int	contactPrecedes(IonCXref *cxref, IonContact *contact)
+{
+	if (cxref->fromNode < contact->fromNode) return 1;
+	if (cxref->fromNode > contact->fromNode) return 0;
+	if (cxref->toNode < contact->toNode) return 1;
+	if (cxref->toNode > contact->toNode) return 0;
+	return (cxref->fromTime < contact->fromTime);
+}
+
+int	rfx_insert_contacts(IonContact *contacts, int count)
+{
+	Sdr		sdr = getIonsdr();
+	PsmPartition	ionwm = getIonwm();
+	IonVdb 		*vdb = getIonVdb();
+	Object		iondbObj;
+	IonDB		iondb;
+	PsmAddress	nextElt;
+	PsmAddress	prevElt = 0;
+	IonCXref	*next;
+	IonCXref	*prev;
+	IonContact	*contact;
+	IonContact	*lastContact = NULL;
+	int		duplicate;
+	unsigned int	xmitRate = 0;
+	int		noteEdits;
+	char		contactIdString[128];
+	IonCXref	arg;
+	Object		obj;
+	Object		elt;
+	int		inserted = 0;
+	int		i;
+
+	CHKERR(contacts);
+	CHKERR(count >= 0);
+
+	/*	Sort the contacts into contact index order, so that
+	 *	each one can be checked for overlap against both its
+	 *	neighbors in the array and its neighbors in the index
+	 *	in a single merging pass through the index.		*/
+
+	qsort((char *) contacts, count, sizeof(IonContact), orderContactArray);
+
+	/*	Noting each new contact individually is pointless if
+	 *	the contacts are so numerous that all routes will have
+	 *	to be recomputed anyway.				*/
+
+	noteEdits = (count < ION_MAX_CONTACT_EDITS);
+	CHKERR(sdr_begin_xn(sdr));
+	iondbObj = getIonDbObject();
+	sdr_read(sdr, (char *) &iondb, iondbObj, sizeof(IonDB));
+	nextElt = sm_rbt_first(ionwm, vdb->contactIndex);
+	for (i = 0, contact = contacts; i < count; i++, contact++)
+	{
+		if (contact->fromTime == 0 || contact->toTime <= contact->fromTime
+		|| contact->fromNode == 0 || contact->toNode == 0)
+		{
+			writeMemoNote("[?] Invalid contact", utoa(contact->fromNode));
+			continue;
+		}
+
+		/*	Find the first contact in the index that
+		 *	doesn't precede this one.			*/
+
+		while (nextElt)
+		{
+			next = (IonCXref *) psp(ionwm, sm_rbt_data(ionwm,
+					nextElt));
+			if (!contactPrecedes(next, contact))
+			{
+				break;
+			}
+
+			prevElt = nextElt;
+			nextElt = sm_rbt_next(ionwm, nextElt);
+		}
+
+		/*	Contact may be in the database already, or may
+		 *	duplicate a contact earlier in the array.	*/
+
+		next = NULL;
+		duplicate = 0;
+		if (nextElt)
+		{
+			next = (IonCXref *) psp(ionwm, sm_rbt_data(ionwm,
+					nextElt));
+			if (next->fromNode == contact->fromNode
+			&& next->toNode == contact->toNode
+			&& next->fromTime == contact->fromTime)
+			{
+				duplicate = 1;
+				xmitRate = next->xmitRate;
+			}
+		}
+
+		if (lastContact && orderContactArray(lastContact, contact) == 0)
+		{
+			duplicate = 1;
+			xmitRate = lastContact->xmitRate;
+		}
+
+		if (duplicate)
+		{
+			if (xmitRate != contact->xmitRate)
+			{
+				isprintf(contactIdString,
+					sizeof contactIdString,
+					"at %lu, %lu->%lu", contact->fromTime,
+					contact->fromNode, contact->toNode);
+				writeMemoNote("[?] Contact data rate not \
+revised", contactIdString);
+			}
+
+			continue;
+		}
+
+		/*	Check for overlap, which is not allowed.	*/
+
+		prev = prevElt ? (IonCXref *) psp(ionwm,
+				sm_rbt_data(ionwm, prevElt)) : NULL;
+		if ((next && next->fromNode == contact->fromNode
+			&& next->toNode == contact->toNode
+			&& contact->toTime > next->fromTime)
+		|| (prev && prev->fromNode == contact->fromNode
+			&& prev->toNode == contact->toNode
+			&& contact->fromTime < prev->toTime)
+		|| (lastContact && lastContact->fromNode == contact->fromNode
+			&& lastContact->toNode == contact->toNode
+			&& contact->fromTime < lastContact->toTime))
+		{
+			writeMemoNote("[?] Overlapping contact",
+					utoa(contact->fromNode));
+			continue;
+		}
+
+		/*	Okay to add.					*/
+
+		obj = sdr_malloc(sdr, sizeof(IonContact));
+		if (obj == 0)
+		{
+			sdr_cancel_xn(sdr);
+			break;
+		}
+
+		sdr_write(sdr, obj, (char *) contact, sizeof(IonContact));
+		elt = sdr_list_insert_last(sdr, iondb.contacts, obj);
+		if (elt == 0)
+		{
+			sdr_cancel_xn(sdr);
+			break;
+		}
+
+		memset((char *) &arg, 0, sizeof(IonCXref));
+		arg.fromNode = contact->fromNode;
+		arg.toNode = contact->toNode;
+		arg.fromTime = contact->fromTime;
+		arg.toTime = contact->toTime;
+		arg.xmitRate = contact->xmitRate;
+		arg.contactElt = elt;
+		if (insertCXref(&arg, &iondb, noteEdits) == 0)
+		{
+			sdr_cancel_xn(sdr);
+			break;
+		}
+
+		lastContact = contact;
+		inserted++;
+	}
+
+	if (i < count)		/*	Transaction was canceled.	*/
+	{
+		putErrmsg("Can't insert contacts.", itoa(count));
+		return -1;
+	}
+
+	if (!noteEdits && inserted > 0)
+	{
+		clearContactEdits(ionwm, vdb, getUTCTime());
+	}
+
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't insert contacts.", itoa(count));
+		return -1;
+	}
+
+	return inserted;
+}
+
 char	*rfx_print_contact(PsmAddress cxaddr, char *buffer)
 {
 	IonCXref	*contact;
@@ -924,6 +1284,36 @@ static void	deleteContact(PsmAddress cxaddr)
 				&event, rfx_erase_data, NULL);
 	}
 
+	/*	Delete contact's changes in rate of growth in
+	 *	occupancy from the congestion forecasting index.	*/
+
+	if (cxref->toNode != cxref->fromNode)
+	{
+		if (cxref->startXmit)
+		{
+			rfx_remove_rate_change(cxref->startXmit,
+					-((vast) cxref->xmitRate));
+		}
+
+		if (cxref->stopXmit)
+		{
+			rfx_remove_rate_change(cxref->stopXmit,
+					cxref->xmitRate);
+		}
+
+		if (cxref->startRecv)
+		{
+			rfx_remove_rate_change(cxref->startRecv,
+					cxref->xmitRate);
+		}
+
+		if (cxref->stopRecv)
+		{
+			rfx_remove_rate_change(cxref->stopRecv,
+					-((vast) cxref->xmitRate));
+		}
+	}
+
 	/*	Apply to current state as necessary.			*/
 
 	if (currentTime >= cxref->startXmit && currentTime <= cxref->stopXmit)
@@ -953,11 +1343,14 @@ static void	deleteContact(PsmAddress cxaddr)
 		}
 	}
 
-	/*	Delete contact from index.				*/
+	/*	Delete contact from index.  A contact that has already
+	 *	ended can no longer be cited by any usable route (every
+	 *	route expires no later than its earliest contact), so
+	 *	its removal is not an edit that CGR needs to apply.	*/
 
-	if (cxref->toTime > currentTime)	/*	Affects routes.	*/
+	if (cxref->toTime > currentTime)
 	{
-		vdb->lastEditTime = currentTime;
+		noteContactEdit(cxref, IonContactRemoved, currentTime);
 	}
 
 	sm_rbt_delete(ionwm, vdb->contactIndex, rfx_order_contacts, cxref,
@@ -1628,6 +2021,237 @@ int	rfx_remove_range(time_t fromTime, uvast fromNode, uvast toNode)
 	return 0;
 }
 
+/*	*	RFX binary contact plan functions	*	*	*/
+
+static void	encodePlanInt(uvast value, int length, unsigned char *cursor)
+{
+	while (length > 0)
+	{
+		length--;
+		cursor[length] = value & 0xff;
+		value >>= 8;
+	}
+}
+
+static uvast	decodePlanInt(unsigned char *cursor, int length)
+{
+	uvast	value = 0;
+
+	while (length > 0)
+	{
+		value = (value << 8) | *cursor;
+		cursor++;
+		length--;
+	}
+
+	return value;
+}
+
+void	rfx_encode_plan_header(int contactsCount, int rangesCount,
+		unsigned char *buffer)
+{
+	CHKVOID(buffer);
+	memcpy((char *) buffer, RFX_PLAN_MAGIC, 8);
+	encodePlanInt(RFX_PLAN_VERSION, 4, buffer + 8);
+	encodePlanInt(contactsCount, 4, buffer + 12);
+	encodePlanInt(rangesCount, 4, buffer + 16);
+}
+
+void	rfx_encode_plan_record(RfxPlanRecord *record, unsigned char *buffer)
+{
+	CHKVOID(record);
+	CHKVOID(buffer);
+	encodePlanInt((uvast) ((vast) record->fromTime), 8, buffer);
+	encodePlanInt((uvast) ((vast) record->toTime), 8, buffer + 8);
+	encodePlanInt(record->fromNode, 8, buffer + 16);
+	encodePlanInt(record->toNode, 8, buffer + 24);
+	encodePlanInt(record->value, 4, buffer + 32);
+	encodePlanInt(record->flags, 4, buffer + 36);
+}
+
+static void	decodePlanRecord(unsigned char *buffer, time_t loadTime,
+			RfxPlanRecord *record)
+{
+	record->fromTime = (time_t) ((vast) decodePlanInt(buffer, 8));
+	record->toTime = (time_t) ((vast) decodePlanInt(buffer + 8, 8));
+	record->fromNode = decodePlanInt(buffer + 16, 8);
+	record->toNode = decodePlanInt(buffer + 24, 8);
+	record->value = decodePlanInt(buffer + 32, 4);
+	record->flags = decodePlanInt(buffer + 36, 4);
+	if (record->flags & RFX_PLAN_FROM_RELATIVE)
+	{
+		record->fromTime += loadTime;
+	}
+
+	if (record->flags & RFX_PLAN_TO_RELATIVE)
+	{
+		record->toTime += loadTime;
+	}
+}
+
+static int	loadPlan(unsigned char *plan, size_t planLength, char *fileName,
+			int *contactsLoaded, int *rangesLoaded)
+{
+	time_t		loadTime = getUTCTime();
+	unsigned int	contactsCount;
+	unsigned int	rangesCount;
+	unsigned char	*cursor;
+	RfxPlanRecord	record;
+	IonContact	*contacts;
+	unsigned int	i;
+	int		result;
+
+	if (planLength < RFX_PLAN_HDR_LEN
+	|| memcmp((char *) plan, RFX_PLAN_MAGIC, 8) != 0)
+	{
+		writeMemoNote("[?] Not a binary contact plan", fileName);
+		return 0;
+	}
+
+	if (decodePlanInt(plan + 8, 4) != RFX_PLAN_VERSION)
+	{
+		writeMemoNote("[?] Unknown binary contact plan version",
+				fileName);
+		return 0;
+	}
+
+	contactsCount = decodePlanInt(plan + 12, 4);
+	rangesCount = decodePlanInt(plan + 16, 4);
+	if (contactsCount > (planLength - RFX_PLAN_HDR_LEN) / RFX_PLAN_REC_LEN
+	|| rangesCount > (planLength - RFX_PLAN_HDR_LEN) / RFX_PLAN_REC_LEN
+	|| planLength != RFX_PLAN_HDR_LEN + (((size_t) contactsCount)
+			+ rangesCount) * RFX_PLAN_REC_LEN)
+	{
+		writeMemoNote("[?] Binary contact plan length is wrong",
+				fileName);
+		return 0;
+	}
+
+	/*	Ranges first, then contacts, as in rfx_start.		*/
+
+	cursor = plan + RFX_PLAN_HDR_LEN + (contactsCount * RFX_PLAN_REC_LEN);
+	for (i = 0; i < rangesCount; i++, cursor += RFX_PLAN_REC_LEN)
+	{
+		decodePlanRecord(cursor, loadTime, &record);
+		if (rfx_insert_range(record.fromTime, record.toTime,
+				record.fromNode, record.toNode, record.value))
+		{
+			(*rangesLoaded)++;
+		}
+	}
+
+	if (contactsCount == 0)
+	{
+		return 0;
+	}
+
+	contacts = (IonContact *) malloc(contactsCount * sizeof(IonContact));
+	if (contacts == NULL)
+	{
+		putErrmsg("Can't load contacts from plan.", fileName);
+		return -1;
+	}
+
+	cursor = plan + RFX_PLAN_HDR_LEN;
+	for (i = 0; i < contactsCount; i++, cursor += RFX_PLAN_REC_LEN)
+	{
+		decodePlanRecord(cursor, loadTime, &record);
+		contacts[i].fromTime = record.fromTime;
+		contacts[i].toTime = record.toTime;
+		contacts[i].fromNode = record.fromNode;
+		contacts[i].toNode = record.toNode;
+		contacts[i].xmitRate = record.value;
+	}
+
+	result = rfx_insert_contacts(contacts, contactsCount);
+	free(contacts);
+	if (result < 0)
+	{
+		putErrmsg("Can't load contacts from plan.", fileName);
+		return -1;
+	}
+
+	*contactsLoaded = result;
+	return 0;
+}
+
+int	rfx_load_plan(char *fileName, int *contactsLoaded, int *rangesLoaded)
+{
+	int		fd;
+	struct stat	stats;
+	size_t		planLength;
+	unsigned char	*plan;
+	int		result;
+
+	CHKERR(fileName);
+	CHKERR(contactsLoaded);
+	CHKERR(rangesLoaded);
+	*contactsLoaded = 0;
+	*rangesLoaded = 0;
+	fd = iopen(fileName, O_RDONLY, 0);
+	if (fd < 0)
+	{
+		putSysErrmsg("Can't open binary contact plan", fileName);
+		return -1;
+	}
+
+	if (fstat(fd, &stats) < 0)
+	{
+		close(fd);
+		putSysErrmsg("Can't stat binary contact plan", fileName);
+		return -1;
+	}
+
+	planLength = stats.st_size;
+	if (planLength < RFX_PLAN_HDR_LEN)
+	{
+		close(fd);
+		writeMemoNote("[?] Not a binary contact plan", fileName);
+		return 0;
+	}
+
+	/*	Map the whole plan into memory where possible, rather
+	 *	than reading and parsing it piecemeal.  Otherwise it is
+	 *	read into private memory: a plan may be much larger
+	 *	than the ION working memory that all ION tasks share.	*/
+
+#ifdef RFX_MMAP_PLANS
+	plan = (unsigned char *) mmap(NULL, planLength, PROT_READ, MAP_PRIVATE,
+			fd, 0);
+	if (plan == (unsigned char *) MAP_FAILED)
+	{
+		close(fd);
+		putSysErrmsg("Can't map binary contact plan", fileName);
+		return -1;
+	}
+#else
+	plan = (unsigned char *) malloc(planLength);
+	if (plan == NULL)
+	{
+		close(fd);
+		putErrmsg("Can't load binary contact plan", fileName);
+		return -1;
+	}
+
+	if (read(fd, (char *) plan, planLength) != (int) planLength)
+	{
+		free(plan);
+		close(fd);
+		putSysErrmsg("Can't read binary contact plan", fileName);
+		return -1;
+	}
+#endif
+	result = loadPlan(plan, planLength, fileName, contactsLoaded,
+			rangesLoaded);
+#ifdef RFX_MMAP_PLANS
+	oK(munmap((char *) plan, planLength));
+#else
+	free(plan);
+#endif
+	close(fd);
+	return result;
+}
+
 /*	*	*	RFX control functions	*	*	*	*/
 
 static int	loadRange(Object elt)
@@ -1656,7 +2280,7 @@ static int	loadRange(Object elt)
 	return 0;
 }
 
-static int	loadContact(Object elt)
+static int	loadContact(Object elt, IonDB *iondb)
 {
 	Sdr		sdr = getIonsdr();
 	Object		obj;
@@ -1668,6 +2292,7 @@ static int	loadContact(Object elt)
 
 	/*	Load contact index entry.				*/
 
+	memset((char *) &cxref, 0, sizeof(IonCXref));
 	cxref.fromNode = contact.fromNode;
 	cxref.toNode = contact.toNode;
 	cxref.fromTime = contact.fromTime;
@@ -1675,7 +2300,7 @@ static int	loadContact(Object elt)
 	cxref.xmitRate = contact.xmitRate;
 	cxref.contactElt = elt;
 	cxref.routingObject = 0;
-	if (insertCXref(&cxref) == 0)
+	if (insertCXref(&cxref, iondb, 0) == 0)
 	{
 		return -1;
 	}
@@ -1696,13 +2321,17 @@ int	rfx_start()
 	CHKERR(sdr_begin_xn(sdr));	/*	To lock memory.		*/
 	sdr_read(sdr, (char *) &iondb, iondbObj, sizeof(IonDB));
 
-	/* Destroy and re-create volatile contact and range databases.
+	/* Destroy and re-create volatile contact and range databases,
+	 * and the rate changes of the contacts, which are all counted
+	 * again as the contacts are reloaded.
 	 * This prevents contact/range duplication as a result of adds
 	 * before starting ION. */
 	sm_rbt_destroy(ionwm, vdb->contactIndex, rfx_erase_data, NULL);
 	sm_rbt_destroy(ionwm, vdb->rangeIndex, rfx_erase_data, NULL);
+	sm_rbt_destroy(ionwm, vdb->rateChanges, rfx_erase_data, NULL);
 	vdb->contactIndex = sm_rbt_create(ionwm);
 	vdb->rangeIndex = sm_rbt_create(ionwm);
+	vdb->rateChanges = sm_rbt_create(ionwm);
 
 	/*	Load range index for all asserted ranges.  In so
 	 *	doing, load the nodes for which ranges are known
@@ -1722,14 +2351,16 @@ int	rfx_start()
 	/*	Load contact index for all contacts.  In so doing,
 	 *	load the nodes for which contacts are planned (as
 	 *	necessary) and load events for all planned changes
-	 *	in data rate affecting the local node.			*/
+	 *	in data rate affecting the local node.  No contact
+	 *	edits are noted, since all routes must be recomputed
+	 *	in any case.						*/
 
 	iondbObj = getIonDbObject();
 	sdr_read(sdr, (char *) &iondb, iondbObj, sizeof(IonDB));
 	for (elt = sdr_list_first(sdr, iondb.contacts); elt;
 			elt = sdr_list_next(sdr, elt))
 	{
-		if (loadContact(elt) < 0)
+		if (loadContact(elt, &iondb) < 0)
 		{
 			putErrmsg("Can't load contact.", NULL);
 			sdr_exit_xn(sdr);
@@ -1737,6 +2368,11 @@ int	rfx_start()
 		}
 	}
 
+	/*	Every contact has been reloaded at a new address, so
+	 *	no previously computed route is still valid.		*/
+
+	clearContactEdits(ionwm, vdb, getUTCTime());
+
 	/*	Start the rfx clock if necessary.			*/
 
 	if (vdb->clockPid == ERROR || sm_TaskExists(vdb->clockPid) == 0)
@@ -1778,7 +2414,10 @@ void	rfx_stop()
 	sm_rbt_destroy(ionwm, vdb->contactIndex, rfx_erase_data, NULL);
 	sm_rbt_destroy(ionwm, vdb->rangeIndex, rfx_erase_data, NULL);
 	sm_rbt_destroy(ionwm, vdb->timeline, rfx_erase_data, NULL);
+	sm_rbt_destroy(ionwm, vdb->rateChanges, rfx_erase_data, NULL);
+	clearContactEdits(ionwm, vdb, getUTCTime());
 	vdb->contactIndex = sm_rbt_create(ionwm);
 	vdb->rangeIndex = sm_rbt_create(ionwm);
 	vdb->timeline = sm_rbt_create(ionwm);
+	vdb->rateChanges = sm_rbt_create(ionwm);
 }
@@ -13,6 +13,39 @@
 #include "platform.h"
 #include "zco.h"
 
+/*	Descriptors of files that are the source text of ZCO extents
+ *	are cached, so that a file need not be opened and closed for
+ *	every transmission of a segment of a ZCO; ZCO_FD_CACHE_SIZE
+ *	is the number of files this process may hold open.  Reading
+ *	ahead is advised ZCO_READAHEAD_LEN bytes at a time.  The
+ *	recorded transmission progress of a file is updated only
+ *	when it has advanced by ZCO_XMIT_PROGRESS_INTERVAL bytes or
+ *	has reached the end of the file.  Whenever the cache is
+ *	consulted, every cached descriptor whose file has since been
+ *	unlinked, or that has been idle for ZCO_FD_IDLE_SECS, is
+ *	closed, so that the space occupied by an unlinked file is
+ *	soon released.							*/
+
+#ifndef ZCO_FD_CACHE_SIZE
+#define	ZCO_FD_CACHE_SIZE		(8)
+#endif
+
+#ifndef ZCO_READAHEAD_LEN
+#define	ZCO_READAHEAD_LEN		(1048576)
+#endif
+
+#ifndef ZCO_FD_IDLE_SECS
+#define	ZCO_FD_IDLE_SECS		(5)
+#endif
+
+#ifndef ZCO_XMIT_PROGRESS_INTERVAL
+#define	ZCO_XMIT_PROGRESS_INTERVAL	(1048576)
+#endif
+
+#if defined (mingw) || defined (VXWORKS) || defined (RTEMS)
+#define	ZCO_NO_PREAD
+#endif
+
 typedef struct
 {
 	vast		heapOccupancy;
@@ -365,6 +398,187 @@ vast	zco_get_max_file_occupancy(Sdr sdr)
 	}
 }
 
+/*	*	*	File descriptor cache functions	*	*	*/
+
+typedef struct
+{
+	int		fd;		/*	-1 if entry is unused.	*/
+	unsigned long	inode;
+	char		pathName[256];
+	unsigned long	lastUse;	/*	For LRU replacement.	*/
+	time_t		lastAccess;	/*	For idle closure.	*/
+	unsigned long	readaheadLimit;
+} ZcoCachedFile;
+
+static ZcoCachedFile	*_fdCache()
+{
+	static ZcoCachedFile	cache[ZCO_FD_CACHE_SIZE];
+	static int		initialized = 0;
+	int			i;
+
+	/*	The cache is private to the process.  Access to it
+	 *	is serialized by SDR transactions, since files are
+	 *	read and file references destroyed only within
+	 *	transactions.						*/
+
+	if (!initialized)
+	{
+		for (i = 0; i < ZCO_FD_CACHE_SIZE; i++)
+		{
+			cache[i].fd = -1;
+		}
+
+		initialized = 1;
+	}
+
+	return cache;
+}
+
+static void	closeCachedFile(ZcoCachedFile *file)
+{
+	if (file->fd >= 0)
+	{
+		close(file->fd);
+		file->fd = -1;
+	}
+}
+
+static int	cachedFileIsStale(ZcoCachedFile *file, time_t currentTime)
+{
+	struct stat	statbuf;
+
+	if (currentTime - file->lastAccess > ZCO_FD_IDLE_SECS)
+	{
+		return 1;
+	}
+
+	/*	A file that has been unlinked (by any process) must
+	 *	not be held open, as its space is not released until
+	 *	the last descriptor for it is closed.			*/
+
+	if (fstat(file->fd, &statbuf) < 0 || statbuf.st_nlink == 0)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+static void	forgetCachedFile(FileRef *fileRef)
+{
+	ZcoCachedFile	*cache = _fdCache();
+	int		i;
+
+	for (i = 0; i < ZCO_FD_CACHE_SIZE; i++)
+	{
+		if (cache[i].fd >= 0 && cache[i].inode == fileRef->inode
+		&& strcmp(cache[i].pathName, fileRef->pathName) == 0)
+		{
+			closeCachedFile(cache + i);
+		}
+	}
+}
+
+static ZcoCachedFile	*getCachedFile(FileRef *fileRef)
+{
+	static unsigned long	useCount = 0;
+	ZcoCachedFile		*cache = _fdCache();
+	ZcoCachedFile		*file = NULL;
+	time_t			currentTime = time(NULL);
+	int			fd;
+	struct stat		statbuf;
+	int			i;
+
+	useCount++;
+	for (i = 0; i < ZCO_FD_CACHE_SIZE; i++)
+	{
+		if (cache[i].fd >= 0 && cachedFileIsStale(cache + i,
+				currentTime))
+		{
+			closeCachedFile(cache + i);
+		}
+
+		if (cache[i].fd >= 0 && cache[i].inode == fileRef->inode
+		&& strcmp(cache[i].pathName, fileRef->pathName) == 0)
+		{
+			cache[i].lastUse = useCount;
+			cache[i].lastAccess = currentTime;
+			return cache + i;
+		}
+
+		/*	Note the unused or least recently used entry,
+		 *	in case the file isn't cached.			*/
+
+		if (file == NULL || (file->fd >= 0
+		&& (cache[i].fd < 0 || cache[i].lastUse < file->lastUse)))
+		{
+			file = cache + i;
+		}
+	}
+
+	fd = iopen(fileRef->pathName, O_RDONLY, 0);
+	if (fd < 0)
+	{
+		return NULL;
+	}
+
+	if (fstat(fd, &statbuf) < 0 || statbuf.st_ino != fileRef->inode)
+	{
+		close(fd);		/*	Can't check, or changed.*/
+		return NULL;
+	}
+
+#ifdef FD_CLOEXEC
+	oK(fcntl(fd, F_SETFD, FD_CLOEXEC));
+#endif
+#ifdef POSIX_FADV_SEQUENTIAL
+	oK(posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL));
+#endif
+	closeCachedFile(file);
+	file->fd = fd;
+	file->inode = fileRef->inode;
+	istrcpy(file->pathName, fileRef->pathName, sizeof file->pathName);
+	file->lastUse = useCount;
+	file->lastAccess = currentTime;
+	file->readaheadLimit = 0;
+	return file;
+}
+
+static int	readCachedFile(ZcoCachedFile *file, char *buffer,
+			unsigned long offset, int length)
+{
+	int	bytesRead;
+
+#ifdef POSIX_FADV_WILLNEED
+	/*	Advise reading ahead whenever reading comes within
+	 *	half a readahead window of the end of the data
+	 *	already requested.					*/
+
+	if (offset + length + (ZCO_READAHEAD_LEN / 2) > file->readaheadLimit)
+	{
+		if (offset + length > file->readaheadLimit)
+		{
+			file->readaheadLimit = offset + length;
+		}
+
+		oK(posix_fadvise(file->fd, file->readaheadLimit,
+				ZCO_READAHEAD_LEN, POSIX_FADV_WILLNEED));
+		file->readaheadLimit += ZCO_READAHEAD_LEN;
+	}
+#endif
+#ifdef ZCO_NO_PREAD
+	if (lseek(file->fd, offset, SEEK_SET) < 0)
+	{
+		return -1;
+	}
+
+	bytesRead = read(file->fd, buffer, length);
+#else
+	bytesRead = pread(file->fd, buffer, length, offset);
+#endif
+	return bytesRead;
+}
+
 Object	zco_create_file_ref(Sdr sdr, char *pathName, char *cleanupScript)
 {
 	int		pathLen;
@@ -558,6 +772,7 @@ int	zco_revise_file_ref(Sdr sdr, Object fileRefObj, char *pathName,
 
 	close(sourceFd);
 	sdr_stage(sdr, (char *) &fileRef, fileRefObj, sizeof(FileRef));
+	forgetCachedFile(&fileRef);
 	fileRef.inode = statbuf.st_ino;
 	memcpy(fileRef.pathName, pathName, pathLen);
 	fileRef.pathName[pathLen] = '\0';
@@ -611,6 +826,7 @@ static void	destroyFileReference(Sdr sdr, FileRef *fileRef,
 	/*	Destroy the file reference.  Invoke file cleanup
 	 *	script if provided.					*/
 
+	forgetCachedFile(fileRef);
 	sdr_free(sdr, fileRefObj);
 	zco_reduce_heap_occupancy(sdr, sizeof(FileRef));
 	if (fileRef->unlinkOnDestroy)
@@ -1507,15 +1723,28 @@ vast	zco_source_data_length(Sdr sdr, Object zco)
 	return zcoBuf.sourceLength + headersLength + trailersLength;
 }
 
+static void	noteXmitProgress(Sdr sdr, Object fileRefObj, FileRef *fileRef,
+			unsigned long xmitProgress)
+{
+	/*	Update xmit progress, but not for every segment read.	*/
+
+	if (xmitProgress > fileRef->xmitProgress
+	&& (xmitProgress == fileRef->fileLength
+	|| xmitProgress >= fileRef->xmitProgress + ZCO_XMIT_PROGRESS_INTERVAL))
+	{
+		fileRef->xmitProgress = xmitProgress;
+		sdr_write(sdr, fileRefObj, (char *) fileRef, sizeof(FileRef));
+	}
+}
+
 static int	copyFromSource(Sdr sdr, char *buffer, SourceExtent *extent,
 			vast bytesToSkip, vast bytesAvbl, ZcoReader *reader,
 			ZcoMedium sourceMedium)
 {
 	SdrRef		sdrRef;
 	FileRef		fileRef;
-	int		fd;
+	ZcoCachedFile	*file;
 	int		bytesRead;
-	struct stat	statbuf;
 	unsigned long	xmitProgress = 0;
 
 	if (sourceMedium == ZcoSdrSource)
@@ -1533,44 +1762,22 @@ static int	copyFromSource(Sdr sdr, char *buffer, SourceExtent *extent,
 			xmitProgress = extent->offset + bytesToSkip + bytesAvbl;
 		}
 
-		sdr_stage(sdr, (char *) &fileRef, extent->location,
+		sdr_read(sdr, (char *) &fileRef, extent->location,
 				sizeof(FileRef));
-		fd = iopen(fileRef.pathName, O_RDONLY, 0);
-		if (fd >= 0)
+		file = getCachedFile(&fileRef);
+		if (file)
 		{
-			if (fstat(fd, &statbuf) < 0)
-			{
-				close(fd);	/*	Can't check.	*/
-			}
-			else if (statbuf.st_ino != fileRef.inode)
-			{
-				close(fd);	/*	File changed.	*/
-			}
-			else if (lseek(fd, extent->offset + bytesToSkip,
-					SEEK_SET) < 0)
-			{
-				close(fd);	/*	Can't position.	*/
-			}
-			else
+			bytesRead = readCachedFile(file, buffer,
+					extent->offset + bytesToSkip,
+					bytesAvbl);
+			if (bytesRead == bytesAvbl)
 			{
-				bytesRead = read(fd, buffer, bytesAvbl);
-				close(fd);
-				if (bytesRead == bytesAvbl)
-				{
-					/*	Update xmit progress.	*/
-
-					if (xmitProgress > fileRef.xmitProgress)
-					{
-						fileRef.xmitProgress
-							= xmitProgress;
-						sdr_write(sdr, extent->location,
-							(char *) &fileRef,
-							sizeof(FileRef));
-					}
-
-					return bytesAvbl;
-				}
+				noteXmitProgress(sdr, extent->location,
+						&fileRef, xmitProgress);
+				return bytesAvbl;
 			}
+
+			closeCachedFile(file);	/*	Unreadable.	*/
 		}
 
 		/*	On any problem reading from file, write fill
@@ -1599,6 +1806,14 @@ void	zco_track_file_offset(ZcoReader *reader)
 	}
 }
 
+void	zco_gather_in_place(ZcoReader *reader)
+{
+	if (reader)
+	{
+		reader->gatherInPlace = 1;
+	}
+}
+
 vast	zco_transmit(Sdr sdr, ZcoReader *reader, vast length, char *buffer)
 {
 	Zco		zco;
@@ -1744,6 +1959,315 @@ vast	zco_transmit(Sdr sdr, ZcoReader *reader, vast length, char *buffer)
 	return bytesTransmitted;
 }
 
+typedef struct
+{
+	ZcoMedium	sourceMedium;
+	Object		location;	/*	of bytes, if in SDR	*/
+	SourceExtent	extent;		/*	if in file		*/
+	vast		bytesToSkip;	/*	within file extent	*/
+	vast		length;		/*	to end of piece		*/
+} ZcoPiece;
+
+static int	findCapsulePiece(Sdr sdr, Object obj, vast *bytesToSkip,
+			ZcoPiece *piece)
+{
+	Capsule	capsule;
+
+	for (; obj; obj = capsule.nextCapsule)
+	{
+		sdr_read(sdr, (char *) &capsule, obj, sizeof(Capsule));
+		if (*bytesToSkip >= capsule.length)
+		{
+			*bytesToSkip -= capsule.length;
+			continue;	/*	Already copied.		*/
+		}
+
+		piece->sourceMedium = ZcoSdrSource;
+		piece->location = capsule.text + *bytesToSkip;
+		piece->length = capsule.length - *bytesToSkip;
+		return 1;
+	}
+
+	return 0;
+}
+
+static int	findExtentPiece(Sdr sdr, Object obj, vast *bytesToSkip,
+			ZcoPiece *piece)
+{
+	SdrRef	sdrRef;
+
+	for (; obj; obj = piece->extent.nextExtent)
+	{
+		sdr_read(sdr, (char *) &(piece->extent), obj,
+				sizeof(SourceExtent));
+		if (*bytesToSkip >= piece->extent.length)
+		{
+			*bytesToSkip -= piece->extent.length;
+			continue;	/*	Already copied.		*/
+		}
+
+		piece->sourceMedium = piece->extent.sourceMedium;
+		piece->bytesToSkip = *bytesToSkip;
+		piece->length = piece->extent.length - *bytesToSkip;
+		if (piece->sourceMedium == ZcoSdrSource)
+		{
+			sdr_read(sdr, (char *) &sdrRef,
+					piece->extent.location, sizeof(SdrRef));
+			piece->location = sdrRef.location
+					+ piece->extent.offset + *bytesToSkip;
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
+
+static int	findPiece(Sdr sdr, ZcoReader *reader, ZcoPiece *piece)
+{
+	Zco	zco;
+	vast	bytesToSkip;
+
+	/*	Finds the longest contiguous run of the reader's
+	 *	as-yet-uncopied bytes of the entire ZCO.		*/
+
+	sdr_read(sdr, (char *) &zco, reader->zco, sizeof(Zco));
+	bytesToSkip = reader->lengthCopied;
+	return findCapsulePiece(sdr, zco.firstHeader, &bytesToSkip, piece)
+		|| findExtentPiece(sdr, zco.firstExtent, &bytesToSkip, piece)
+		|| findCapsulePiece(sdr, zco.firstTrailer, &bytesToSkip,
+				piece);
+}
+
+static int	findSourcePiece(Sdr sdr, ZcoReader *reader, ZcoPiece *piece)
+{
+	Zco	zco;
+	vast	bytesToSkip;
+
+	/*	Finds the longest contiguous run of the reader's
+	 *	as-yet-unreceived bytes of the ZCO's source data.	*/
+
+	sdr_read(sdr, (char *) &zco, reader->zco, sizeof(Zco));
+	bytesToSkip = zco.headersLength + reader->sourceLengthCopied;
+	return findExtentPiece(sdr, zco.firstExtent, &bytesToSkip, piece);
+}
+
+static int	describeFilePiece(Sdr sdr, ZcoPiece *piece, vast length,
+			ZcoReader *reader, ZcoExtentDescriptor *descriptor)
+{
+	FileRef		fileRef;
+	ZcoCachedFile	*file;
+
+	sdr_read(sdr, (char *) &fileRef, piece->extent.location,
+			sizeof(FileRef));
+	file = getCachedFile(&fileRef);
+	if (file == NULL)
+	{
+		return -1;		/*	Can't read file.	*/
+	}
+
+	descriptor->fd = dup(file->fd);
+	if (descriptor->fd < 0)
+	{
+		return -1;
+	}
+
+	descriptor->sourceMedium = ZcoFileSource;
+	descriptor->offset = piece->extent.offset + piece->bytesToSkip;
+	descriptor->length = length;
+	if (reader->trackFileOffset)
+	{
+		noteXmitProgress(sdr, piece->extent.location, &fileRef,
+				descriptor->offset + length);
+	}
+
+	return 0;
+}
+
+vast	zco_transmit_extent(Sdr sdr, ZcoReader *reader, vast length,
+		ZcoExtentDescriptor *descriptor)
+{
+	ZcoPiece	piece;
+
+	CHKERR(sdr);
+	CHKERR(reader);
+	CHKERR(descriptor);
+	CHKERR(length >= 0);
+	memset((char *) descriptor, 0, sizeof(ZcoExtentDescriptor));
+	descriptor->fd = -1;
+	if (length == 0 || !findPiece(sdr, reader, &piece))
+	{
+		return 0;
+	}
+
+	if (length > piece.length)
+	{
+		length = piece.length;
+	}
+
+	if (piece.sourceMedium == ZcoFileSource)
+	{
+		if (describeFilePiece(sdr, &piece, length, reader, descriptor)
+				< 0)
+		{
+			/*	File can't be read, so the caller
+			 *	must transmit fill instead, as
+			 *	zco_transmit would.			*/
+
+			descriptor->sourceMedium = ZcoFileSource;
+			descriptor->fd = -1;
+			descriptor->offset = piece.extent.offset
+					+ piece.bytesToSkip;
+			descriptor->length = length;
+		}
+	}
+	else
+	{
+		descriptor->sourceMedium = ZcoSdrSource;
+		descriptor->location = piece.location;
+		descriptor->length = length;
+	}
+
+	reader->lengthCopied += length;
+	return length;
+}
+
+static vast	gatherIov(Sdr sdr, ZcoReader *reader, int receiving,
+			vast length, struct iovec *iov, int *iovCount,
+			char *buffer, int bufferLength,
+			ZcoExtentDescriptor *fileExtent)
+{
+	vast		*lengthCopied;
+	int		iovMax = *iovCount;
+	int		bufferUsed = 0;
+	vast		bytesGathered = 0;
+	ZcoPiece	piece;
+	vast		bytesAvbl;
+	char		*text;
+
+	/*	Transmission gathers from the entire ZCO, reception
+	 *	only from its source data.				*/
+
+	lengthCopied = receiving ? &reader->sourceLengthCopied
+			: &reader->lengthCopied;
+	*iovCount = 0;
+	if (fileExtent)
+	{
+		memset((char *) fileExtent, 0, sizeof(ZcoExtentDescriptor));
+		fileExtent->fd = -1;
+	}
+
+	while (bytesGathered < length && *iovCount < iovMax)
+	{
+		if (!(receiving ? findSourcePiece(sdr, reader, &piece)
+				: findPiece(sdr, reader, &piece)))
+		{
+			break;		/*	Nothing more to copy.	*/
+		}
+
+		bytesAvbl = length - bytesGathered;
+		if (bytesAvbl > piece.length)
+		{
+			bytesAvbl = piece.length;
+		}
+
+		if (piece.sourceMedium == ZcoFileSource && fileExtent)
+		{
+			/*	Gathering stops at the first file
+			 *	extent, which the caller must send
+			 *	after the gathered bytes.  But if
+			 *	the file can't be read, fill is
+			 *	copied into the buffer instead.		*/
+
+			if (describeFilePiece(sdr, &piece, bytesAvbl, reader,
+					fileExtent) == 0)
+			{
+				*lengthCopied += bytesAvbl;
+				bytesGathered += bytesAvbl;
+				break;
+			}
+		}
+
+		text = NULL;
+		if (piece.sourceMedium == ZcoSdrSource && reader->gatherInPlace)
+		{
+			text = (char *) sdr_pointer(sdr, piece.location);
+		}
+
+		if (text == NULL)
+		{
+			/*	Must copy into the buffer.		*/
+
+			if (bytesAvbl > bufferLength - bufferUsed)
+			{
+				bytesAvbl = bufferLength - bufferUsed;
+			}
+
+			if (bytesAvbl == 0)
+			{
+				break;		/*	Buffer is full.	*/
+			}
+
+			text = buffer + bufferUsed;
+			bufferUsed += bytesAvbl;
+			if (piece.sourceMedium == ZcoSdrSource)
+			{
+				sdr_read(sdr, text, piece.location, bytesAvbl);
+			}
+			else
+			{
+				/*	On any problem reading from
+				 *	the file, copyFromSource writes
+				 *	fill, as for zco_transmit.	*/
+
+				oK(copyFromSource(sdr, text, &piece.extent,
+						piece.bytesToSkip, bytesAvbl,
+						reader, ZcoFileSource));
+			}
+		}
+
+		/*	Coalesce contiguous runs of bytes.		*/
+
+		if (*iovCount > 0 && (char *) iov[*iovCount - 1].iov_base
+				+ iov[*iovCount - 1].iov_len == text)
+		{
+			iov[*iovCount - 1].iov_len += bytesAvbl;
+		}
+		else
+		{
+			iov[*iovCount].iov_base = text;
+			iov[*iovCount].iov_len = bytesAvbl;
+			(*iovCount)++;
+		}
+
+		*lengthCopied += bytesAvbl;
+		bytesGathered += bytesAvbl;
+	}
+
+	return bytesGathered;
+}
+
+vast	zco_transmit_iov(Sdr sdr, ZcoReader *reader, vast length,
+		struct iovec *iov, int *iovCount, char *buffer,
+		int bufferLength, ZcoExtentDescriptor *fileExtent)
+{
+	CHKERR(sdr);
+	CHKERR(reader);
+	CHKERR(length >= 0);
+	CHKERR(iov);
+	CHKERR(iovCount);
+	CHKERR(*iovCount > 0);
+	CHKERR(bufferLength >= 0);
+	CHKERR(buffer || bufferLength == 0);
+
+	/*	Pointers into the SDR heap are stable only until the
+	 *	transaction ends, so the caller must hold one open.	*/
+
+	CHKERR(sdr_in_xn(sdr));
+	return gatherIov(sdr, reader, 0, length, iov, iovCount, buffer,
+			bufferLength, fileExtent);
+}
+
 /*	Functions for delivery to overlying protocol or application
  *	layer.								*/
 
@@ -1924,6 +2448,23 @@ vast	zco_receive_source(Sdr sdr, ZcoReader *reader, vast length,
 	return bytesReceived;
 }
 
+vast	zco_receive_iov(Sdr sdr, ZcoReader *reader, vast length,
+		struct iovec *iov, int *iovCount, char *buffer,
+		int bufferLength, ZcoExtentDescriptor *fileExtent)
+{
+	CHKERR(sdr);
+	CHKERR(reader);
+	CHKERR(length >= 0);
+	CHKERR(iov);
+	CHKERR(iovCount);
+	CHKERR(*iovCount > 0);
+	CHKERR(bufferLength >= 0);
+	CHKERR(buffer || bufferLength == 0);
+	CHKERR(sdr_in_xn(sdr));
+	return gatherIov(sdr, reader, 1, length, iov, iovCount, buffer,
+			bufferLength, fileExtent);
+}
+
 vast	zco_receive_trailers(Sdr sdr, ZcoReader *reader, vast length,
 		char *buffer)
 {
@@ -85,6 +85,7 @@ typedef struct sdr_str
 	pthread_t	sdrOwnerThread;		/*	thread ID	*/
 	int		xnDepth;
 	int		xnCanceled;		/*	boolean		*/
+	unsigned long	xnCount;		/*	since start	*/
 
 		/*	SDR trace data access.			*/
 
@@ -407,6 +407,7 @@ static int	lockSdr(SdrState *sdr)
 	sdr->sdrOwnerThread = pthread_self();
 	sdr->sdrOwnerTask = sm_TaskIdSelf();
 	sdr->xnDepth = 1;
+	sdr->xnCount++;
 	return 0;
 }
 
@@ -1642,6 +1643,12 @@ int	sdr_in_xn(Sdr sdrv)
 		&& pthread_equal(sdrv->sdr->sdrOwnerThread, pthread_self()));
 }
 
+unsigned long	sdr_xn_count(Sdr sdrv)
+{
+	CHKZERO(sdrv);
+	return (sdrv->sdr == NULL ? 0 : sdrv->sdr->xnCount);
+}
+
 int	sdr_heap_is_halted(Sdr sdrv)
 {
 	CHKZERO(sdrv);
@@ -21,7 +21,7 @@ typedef struct
 	unsigned short	myPortNbr;
 	char		destHostName[MAXHOSTNAMELEN + 1];
 	unsigned short	destPortNbr;
-	unsigned short	owlt;
+	uvast		owlt;		/*	In microseconds.	*/
 	int		insock;
 	int		outsock;
 	Lyst		transmission;
@@ -66,10 +66,28 @@ static void	*sendUdp(void *parm)
 	LystElt		nextElt;
 	DG		*dg;
 	char		timebuf[256];
+	unsigned int	interval;
+
+	/*	Check the transmission queue ten times per simulated
+	 *	one-way light time, but not more often than once per
+	 *	millisecond nor less often than once per 1/10 second.	*/
+
+	if (stp->owlt < 10000)
+	{
+		interval = 1000;
+	}
+	else if (stp->owlt > 1000000)
+	{
+		interval = 100000;
+	}
+	else
+	{
+		interval = stp->owlt / 10;
+	}
 
 	while (1)
 	{
-		microsnooze(100000);	/*	Sleep 1/10 second.	*/
+		microsnooze(interval);
 		getCurrentTime(&currentTime);
 		if (sm_SemTake(stp->mutex) < 0)
 		{
@@ -265,8 +283,16 @@ a dg of length %d from %s destined for %s.\n", timebuf, datagramLen,
 			owltsimExit(0);
 		}
 
-		dg->xmitTime.tv_sec = currentTime.tv_sec + stp->owlt;
-		dg->xmitTime.tv_usec = currentTime.tv_usec;
+		dg->xmitTime.tv_sec = currentTime.tv_sec
+				+ (stp->owlt / 1000000);
+		dg->xmitTime.tv_usec = currentTime.tv_usec
+				+ (stp->owlt % 1000000);
+		if (dg->xmitTime.tv_usec >= 1000000)
+		{
+			dg->xmitTime.tv_sec++;
+			dg->xmitTime.tv_usec -= 1000000;
+		}
+
 		dg->length = datagramLen;
 		memcpy(dg->content, buffer, datagramLen);
 		if (sm_SemTake(stp->mutex) < 0)
@@ -324,6 +350,8 @@ int	main(int argc, char *argv[])
 	SimThreadParms		stpBuf;
 	SimThreadParms		*stp;
 	pthread_t		simThread;
+	char			owltString[32];
+	double			owlt;
 
 	/*	Read configuration file, parsing each line.  For
 	 *	each line, start a thread that simulates owlt on
@@ -357,6 +385,7 @@ int	main(int argc, char *argv[])
 		puts("Each line of config file must be of this form:");
 		puts("\t<to> <from> <my port#> <dest hostname> <dest port#> \
 <OWLT in seconds> <modulus>");
+		puts("<OWLT in seconds> may be fractional, e.g., 0.025.");
 		puts("where <to> and <from> are ION node numbers.  These node");
 		puts("numbers are intended to make the configuration file");
 		puts("somewhat self-documenting.  <from> may be '*' if 'all'.");
@@ -379,10 +408,10 @@ int	main(int argc, char *argv[])
 	while (reading)
 	{
 		lineNbr++;
-		switch (fscanf(configFile, "%32s %32s %hu %255s %hu %hu %hu",
+		switch (fscanf(configFile, "%32s %32s %hu %255s %hu %31s %hu",
 				stpBuf.toNode, stpBuf.fromNode,
 				&stpBuf.myPortNbr, stpBuf.destHostName,
-				&stpBuf.destPortNbr, &stpBuf.owlt,
+				&stpBuf.destPortNbr, owltString,
 				&stpBuf.modulus))
 		{
 		case EOF:
@@ -397,6 +426,15 @@ int	main(int argc, char *argv[])
 			owltsimExit(1);
 
 		case 7:
+			owlt = atof(owltString);
+			if (owlt < 0.0 || owlt > 65535.0)
+			{
+				printf("owlt stopped: invalid OWLT '%s' in \
+config file line %d.\n", owltString, lineNbr);
+				owltsimExit(1);
+			}
+
+			stpBuf.owlt = (uvast) (owlt * 1000000.0);
 			stp = (SimThreadParms *) malloc(sizeof(SimThreadParms));
 			if (stp == NULL)
 			{
@@ -105,6 +105,8 @@ relative times (+ss) are computed.");
 <xmit rate in bytes per second>");
 	PUTS("\t   a range <from time> <until time> <from node#> <to node#> \
 <OWLT, i.e., range in light seconds>");
+	PUTS("\t   a contacts <contact plan file name>");
+	PUTS("\t   a plan <binary contact plan file name>");
 	PUTS("\t\tTime format is either +ss or yyyy/mm/dd-hh:mm:ss.");
 	PUTS("\td\tDelete");
 	PUTS("\ti\tInfo");
@@ -125,6 +127,8 @@ relative times (+ss) are computed.");
 \"unchanged\"> [<new ZCO file occupancy limit, in MB>]");
 	PUTS("\t   m horizon { 0 | <end time for congestion forecasts> }");
 	PUTS("\t   m alarm '<congestion alarm script>'");
+	PUTS("\t   m routes <max CGR routes per destination; 0 means one \
+per leading contact>");
 	PUTS("\t   m usage");
 	PUTS("\tr\tRun a script or another program, such as an admin progrm");
 	PUTS("\t   r '<command>'");
@@ -167,6 +171,163 @@ static void	initializeNode(int tokenCount, char **tokens)
 	}
 }
 
+static int	parseContact(char *line, int lineNbr, IonContact *contact)
+{
+	char	*cursor = line;
+	char	*tokens[8];
+	int	tokenCount = 0;
+	char	**fields = tokens;
+	time_t	refTime;
+	char	buffer[80];
+
+	while (tokenCount < 8)
+	{
+		findToken(&cursor, &(tokens[tokenCount]));
+		if (tokens[tokenCount] == NULL)
+		{
+			break;
+		}
+
+		tokenCount++;
+	}
+
+	if (tokenCount == 0 || *(tokens[0]) == '#')
+	{
+		return 0;	/*	Blank line or comment.		*/
+	}
+
+	/*	Each line of a contact plan is either the parameters
+	 *	of a contact or a complete "a contact" command.		*/
+
+	if (tokenCount == 7 && strcmp(tokens[0], "a") == 0
+	&& strcmp(tokens[1], "contact") == 0)
+	{
+		fields += 2;
+		tokenCount -= 2;
+	}
+
+	if (tokenCount != 5)
+	{
+		isprintf(buffer, sizeof buffer, "Contact plan syntax error at \
+line %d.", lineNbr);
+		printText(buffer);
+		return 0;
+	}
+
+	refTime = _referenceTime(NULL);
+	contact->fromTime = readTimestampUTC(fields[0], refTime);
+	contact->toTime = readTimestampUTC(fields[1], refTime);
+	contact->fromNode = strtouvast(fields[2]);
+	contact->toNode = strtouvast(fields[3]);
+	contact->xmitRate = strtol(fields[4], NULL, 0);
+	return 1;
+}
+
+static void	importContacts(char *fileName)
+{
+	int		planFile;
+	char		line[256];
+	int		len;
+	int		lineNbr = 0;
+	IonContact	*contacts;
+	IonContact	*larger;
+	int		capacity = 1024;
+	int		count = 0;
+	int		inserted;
+	char		buffer[80];
+
+	/*	Read the entire contact plan, then insert all of its
+	 *	contacts at once.  The plan is staged in private
+	 *	memory, as it may be much larger than the ION working
+	 *	memory that all ION tasks share.			*/
+
+	planFile = iopen(fileName, O_RDONLY, 0777);
+	if (planFile < 0)
+	{
+		putSysErrmsg("Can't open contact plan file", fileName);
+		return;
+	}
+
+	contacts = (IonContact *) malloc(capacity * sizeof(IonContact));
+	if (contacts == NULL)
+	{
+		close(planFile);
+		putErrmsg("Can't load contact plan.", fileName);
+		return;
+	}
+
+	while (1)
+	{
+		if (igets(planFile, line, sizeof line, &len) == NULL)
+		{
+			if (len == 0)
+			{
+				break;			/*	EOF.	*/
+			}
+
+			putErrmsg("igets failed.", fileName);
+			break;
+		}
+
+		lineNbr++;
+		if (parseContact(line, lineNbr, contacts + count) == 0)
+		{
+			continue;
+		}
+
+		count++;
+		if (count < capacity)
+		{
+			continue;
+		}
+
+		larger = (IonContact *) realloc(contacts, 2 * capacity
+				* sizeof(IonContact));
+		if (larger == NULL)
+		{
+			free(contacts);
+			close(planFile);
+			putErrmsg("Can't load contact plan.", fileName);
+			return;
+		}
+
+		contacts = larger;
+		capacity *= 2;
+	}
+
+	close(planFile);
+	inserted = rfx_insert_contacts(contacts, count);
+	free(contacts);
+	if (inserted < 0)
+	{
+		putErrmsg("Can't import contact plan.", fileName);
+		return;
+	}
+
+	isprintf(buffer, sizeof buffer, "Imported %d of %d contacts.",
+			inserted, count);
+	printText(buffer);
+	oK(_forecastNeeded(1));
+}
+
+static void	loadPlan(char *fileName)
+{
+	int	contactsLoaded;
+	int	rangesLoaded;
+	char	buffer[80];
+
+	if (rfx_load_plan(fileName, &contactsLoaded, &rangesLoaded) < 0)
+	{
+		putErrmsg("Can't load binary contact plan.", fileName);
+		return;
+	}
+
+	isprintf(buffer, sizeof buffer, "Loaded %d contacts and %d ranges.",
+			contactsLoaded, rangesLoaded);
+	printText(buffer);
+	oK(_forecastNeeded(1));
+}
+
 static void	executeAdd(int tokenCount, char **tokens)
 {
 	time_t		refTime;
@@ -183,6 +344,30 @@ static void	executeAdd(int tokenCount, char **tokens)
 		return;
 	}
 
+	if (strcmp(tokens[1], "contacts") == 0)
+	{
+		if (tokenCount != 3)
+		{
+			SYNTAX_ERROR;
+			return;
+		}
+
+		importContacts(tokens[2]);
+		return;
+	}
+
+	if (strcmp(tokens[1], "plan") == 0)
+	{
+		if (tokenCount != 3)
+		{
+			SYNTAX_ERROR;
+			return;
+		}
+
+		loadPlan(tokens[2]);
+		return;
+	}
+
 	if (tokenCount != 7)
 	{
 		SYNTAX_ERROR;
@@ -687,6 +872,42 @@ static void	manageAlarm(int tokenCount, char **tokens)
 	}
 }
 
+static void	manageRoutes(int tokenCount, char **tokens)
+{
+	Sdr	sdr = getIonsdr();
+	Object	iondbObj = getIonDbObject();
+	IonDB	iondb;
+	int	maxRoutes;
+
+	if (tokenCount != 3)
+	{
+		SYNTAX_ERROR;
+		return;
+	}
+
+	maxRoutes = atoi(tokens[2]);
+	if (maxRoutes < 0)
+	{
+		putErrmsg("Maximum number of routes can't be negative.",
+				tokens[2]);
+		return;
+	}
+
+	CHKVOID(sdr_begin_xn(sdr));
+	sdr_stage(sdr, (char *) &iondb, iondbObj, sizeof(IonDB));
+	iondb.maxRoutes = maxRoutes;
+	sdr_write(sdr, iondbObj, (char *) &iondb, sizeof(IonDB));
+
+	/*	Routes already computed under the former limit must
+	 *	all be recomputed.					*/
+
+	getIonVdb()->lastEditTime = getUTCTime();
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("Can't change maximum number of routes.", NULL);
+	}
+}
+
 static void	manageUsage(int tokenCount, char **tokens)
 {
 	Sdr	sdr = getIonsdr();
@@ -780,6 +1001,12 @@ static void	executeManage(int tokenCount, char **tokens)
 		return;
 	}
 
+	if (strcmp(tokens[1], "routes") == 0)
+	{
+		manageRoutes(tokenCount, tokens);
+		return;
+	}
+
 	if (strcmp(tokens[1], "usage") == 0)
 	{
 		manageUsage(tokenCount, tokens);
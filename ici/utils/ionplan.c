@@ -0,0 +1,335 @@
+/*
+
+	ionplan.c:	converts the contacts and ranges asserted in
+			an ionadmin command file into a binary contact
+			plan, for loading by "a plan" ionadmin commands.
+
+									*/
+
+#include "rfx.h"
+
+#define	PLAN_BUFFER_RECORDS	256
+
+typedef struct
+{
+	time_t		refTime;
+	int		refIsRelative;	/*	To time of loading.	*/
+	int		lineNbr;
+} PlanState;
+
+typedef struct
+{
+	int		fd;
+	int		recordsCount;
+	int		buffered;
+	unsigned char	buffer[PLAN_BUFFER_RECORDS * RFX_PLAN_REC_LEN];
+} PlanFile;
+
+static int	flushPlan(PlanFile *planFile)
+{
+	int	length = planFile->buffered * RFX_PLAN_REC_LEN;
+
+	if (planFile->buffered == 0)
+	{
+		return 0;
+	}
+
+	if (write(planFile->fd, (char *) planFile->buffer, length) != length)
+	{
+		putSysErrmsg("Can't write binary contact plan", NULL);
+		return -1;
+	}
+
+	planFile->buffered = 0;
+	return 0;
+}
+
+static int	writeRecord(PlanFile *planFile, RfxPlanRecord *record)
+{
+	rfx_encode_plan_record(record, planFile->buffer
+			+ (planFile->buffered * RFX_PLAN_REC_LEN));
+	planFile->buffered++;
+	planFile->recordsCount++;
+	if (planFile->buffered < PLAN_BUFFER_RECORDS)
+	{
+		return 0;
+	}
+
+	return flushPlan(planFile);
+}
+
+static void	printSyntaxError(PlanState *state)
+{
+	char	buffer[80];
+
+	isprintf(buffer, sizeof buffer, "Syntax error at line %d; line \
+ignored.", state->lineNbr);
+	PUTS(buffer);
+}
+
+static int	readTime(PlanState *state, char *token, time_t *time,
+			int *isRelative)
+{
+	/*	A relative time is an offset from the reference time,
+	 *	which may itself be relative to the time at which the
+	 *	plan is loaded; any other time is absolute.		*/
+
+	if (*token == '+')
+	{
+		*time = state->refTime + strtol(token + 1, NULL, 0);
+		*isRelative = state->refIsRelative;
+		return 0;
+	}
+
+	*time = readTimestampUTC(token, 0);
+	*isRelative = 0;
+	return (*time == 0 ? -1 : 0);
+}
+
+static void	setReferenceTime(PlanState *state, char *token)
+{
+	if (strcmp(token, "0") == 0)
+	{
+		state->refTime = 0;
+		state->refIsRelative = 1;
+		return;
+	}
+
+	if (*token == '+')
+	{
+		state->refTime += strtol(token + 1, NULL, 0);
+		return;
+	}
+
+	state->refTime = readTimestampUTC(token, 0);
+	state->refIsRelative = 0;
+}
+
+static int	convertLine(PlanState *state, char *line, char *recordType,
+			PlanFile *planFile)
+{
+	char		*cursor = line;
+	char		*tokens[9];
+	int		tokenCount = 0;
+	RfxPlanRecord	record;
+	int		isRelative;
+
+	while (tokenCount < 9)
+	{
+		findToken(&cursor, &(tokens[tokenCount]));
+		if (tokens[tokenCount] == NULL)
+		{
+			break;
+		}
+
+		tokenCount++;
+	}
+
+	if (tokenCount == 0)
+	{
+		return 0;
+	}
+
+	if (strcmp(tokens[0], "@") == 0)
+	{
+		if (tokenCount != 2)
+		{
+			printSyntaxError(state);
+			return 0;
+		}
+
+		setReferenceTime(state, tokens[1]);
+		return 0;
+	}
+
+	/*	All other commands are ignored, except the assertions
+	 *	of contacts or ranges that are being converted.		*/
+
+	if (tokenCount < 2 || strcmp(tokens[0], "a") != 0
+	|| strcmp(tokens[1], recordType) != 0)
+	{
+		return 0;
+	}
+
+	if (tokenCount != 7)
+	{
+		printSyntaxError(state);
+		return 0;
+	}
+
+	memset((char *) &record, 0, sizeof record);
+	if (readTime(state, tokens[2], &record.fromTime, &isRelative) < 0)
+	{
+		printSyntaxError(state);
+		return 0;
+	}
+
+	if (isRelative)
+	{
+		record.flags |= RFX_PLAN_FROM_RELATIVE;
+	}
+
+	if (readTime(state, tokens[3], &record.toTime, &isRelative) < 0)
+	{
+		printSyntaxError(state);
+		return 0;
+	}
+
+	if (isRelative)
+	{
+		record.flags |= RFX_PLAN_TO_RELATIVE;
+	}
+
+	record.fromNode = strtouvast(tokens[4]);
+	record.toNode = strtouvast(tokens[5]);
+	record.value = strtoul(tokens[6], NULL, 0);
+	return writeRecord(planFile, &record);
+}
+
+static int	convertFile(char *rcFileName, char *recordType,
+			PlanFile *planFile)
+{
+	int		rcFile;
+	PlanState	state;
+	char		line[256];
+	int		len;
+	int		result = 0;
+
+	rcFile = iopen(rcFileName, O_RDONLY, 0777);
+	if (rcFile < 0)
+	{
+		putSysErrmsg("Can't open command file", rcFileName);
+		return -1;
+	}
+
+	/*	As in ionadmin, the reference time is initially the
+	 *	time at which the commands are executed.		*/
+
+	state.refTime = 0;
+	state.refIsRelative = 1;
+	state.lineNbr = 0;
+	planFile->recordsCount = 0;
+	while (result == 0)
+	{
+		if (igets(rcFile, line, sizeof line, &len) == NULL)
+		{
+			if (len != 0)
+			{
+				putErrmsg("igets failed.", rcFileName);
+				result = -1;
+			}
+
+			break;
+		}
+
+		state.lineNbr++;
+		if (len == 0 || line[0] == '#')
+		{
+			continue;
+		}
+
+		result = convertLine(&state, line, recordType, planFile);
+	}
+
+	close(rcFile);
+	if (result == 0)
+	{
+		result = flushPlan(planFile);
+	}
+
+	return result;
+}
+
+static int	convertPlan(char *rcFileName, char *planFileName)
+{
+	PlanFile	*planFile;
+	int		contactsCount;
+	int		rangesCount;
+	unsigned char	header[RFX_PLAN_HDR_LEN];
+	char		buffer[80];
+
+	planFile = (PlanFile *) malloc(sizeof(PlanFile));
+	if (planFile == NULL)
+	{
+		putErrmsg("Can't allocate plan buffer.", NULL);
+		return -1;
+	}
+
+	memset((char *) planFile, 0, sizeof(PlanFile));
+	planFile->fd = iopen(planFileName, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (planFile->fd < 0)
+	{
+		free(planFile);
+		putSysErrmsg("Can't create binary contact plan", planFileName);
+		return -1;
+	}
+
+	/*	The header isn't complete until all records have been
+	 *	written, so first skip over it.  All contact records
+	 *	precede all range records.				*/
+
+	if (lseek(planFile->fd, RFX_PLAN_HDR_LEN, SEEK_SET) < 0
+	|| convertFile(rcFileName, "contact", planFile) < 0)
+	{
+		close(planFile->fd);
+		free(planFile);
+		putErrmsg("Can't convert contacts.", rcFileName);
+		return -1;
+	}
+
+	contactsCount = planFile->recordsCount;
+	if (convertFile(rcFileName, "range", planFile) < 0)
+	{
+		close(planFile->fd);
+		free(planFile);
+		putErrmsg("Can't convert ranges.", rcFileName);
+		return -1;
+	}
+
+	rangesCount = planFile->recordsCount;
+	rfx_encode_plan_header(contactsCount, rangesCount, header);
+	if (lseek(planFile->fd, 0, SEEK_SET) < 0
+	|| write(planFile->fd, (char *) header, RFX_PLAN_HDR_LEN)
+			!= RFX_PLAN_HDR_LEN)
+	{
+		close(planFile->fd);
+		free(planFile);
+		putSysErrmsg("Can't write binary contact plan", planFileName);
+		return -1;
+	}
+
+	close(planFile->fd);
+	free(planFile);
+	isprintf(buffer, sizeof buffer, "Converted %d contacts and %d ranges.",
+			contactsCount, rangesCount);
+	PUTS(buffer);
+	return 0;
+}
+
+#if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
+int	ionplan(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	char	*rcFileName = (char *) a1;
+	char	*planFileName = (char *) a2;
+#else
+int	main(int argc, char **argv)
+{
+	char	*rcFileName = (argc > 1 ? argv[1] : NULL);
+	char	*planFileName = (argc > 2 ? argv[2] : NULL);
+#endif
+	if (rcFileName == NULL || planFileName == NULL)
+	{
+		PUTS("Usage: ionplan <ionadmin command file name> <binary \
+contact plan file name>");
+		return 0;
+	}
+
+	if (convertPlan(rcFileName, planFileName) < 0)
+	{
+		writeErrmsgMemos();
+		return 1;
+	}
+
+	return 0;
+}
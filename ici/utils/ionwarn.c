@@ -16,101 +16,6 @@
 									*/
 #include "zco.h"
 #include "rfx.h"
-#include "lyst.h"
-
-typedef struct
-{
-	time_t	time;
-	int	prevXmitRate;
-	int	xmitRate;
-	int	fromNeighbor;		/*	Boolean.		*/
-} RateChange;
-
-static char	*_cannotForecast()
-{
-	return "Can't complete congestion forecast.";
-}
-
-static IonNeighbor	*retrieveNeighbor(uvast nodeNbr, Lyst neighbors)
-{
-	LystElt		elt3;
-	IonNeighbor	*np = NULL;
-
-	for (elt3 = lyst_first(neighbors); elt3; elt3 = lyst_next(elt3))
-	{
-		np = (IonNeighbor *) lyst_data(elt3);
-		if (np->nodeNbr == nodeNbr)
-		{
-			break;
-		}
-	}
-
-	if (elt3 == NULL)		/*	This is a new neighbor.	*/
-	{
-		np = (IonNeighbor *) MTAKE(sizeof(IonNeighbor));
-		if (np == NULL)
-		{
-			putErrmsg(_cannotForecast() , NULL);
-			return NULL;
-		}
-
-		memset((char *) np, 0, sizeof(IonNeighbor));
-		np->nodeNbr = nodeNbr;
-		if (lyst_insert_last(neighbors, np) == NULL)
-		{
-			putErrmsg(_cannotForecast() , NULL);
-			return NULL;
-		}
-	}
-
-	return np;
-}
-
-static int	insertRateChange(time_t time, unsigned int xmitRate,
-			int fromNeighbor, unsigned int prevXmitRate,
-			Lyst changes)
-{
-	RateChange	*newChange;
-	LystElt		elt4;
-	RateChange	*change;
-
-	newChange = (RateChange *) MTAKE(sizeof(RateChange));
-	if (newChange == NULL)
-	{
-		putErrmsg(_cannotForecast() , NULL);
-		return -1;			/*	Out of memory.	*/
-	}
-
-	newChange->time = time;
-	newChange->xmitRate = xmitRate;
-	newChange->fromNeighbor = fromNeighbor;	/*	Boolean.	*/
-	newChange->prevXmitRate = prevXmitRate;
-	for (elt4 = lyst_last(changes); elt4; elt4 = lyst_prev(elt4))
-	{
-		change = (RateChange *) lyst_data(elt4);
-		if (change->time <= newChange->time)
-		{
-			break;
-		}
-	}
-
-	if (elt4)
-	{
-		elt4 = lyst_insert_after(elt4, newChange);
-	}
-	else
-	{
-		elt4 = lyst_insert_first(changes, newChange);
-	}
-
-	if (elt4 == NULL)
-	{
-		putErrmsg(_cannotForecast() , NULL);
-		return -1;			/*	Out of memory.	*/
-	}
-
-	return 0;
-}
 
 int	checkForCongestion()
 {
@@ -119,9 +24,6 @@ int	checkForCongestion()
 	Object		iondbObj;
 	IonDB		iondb;
 	PsmPartition	ionwm;
-	int		ionMemIdx;
-	Lyst		neighbors;
-	Lyst		changes;
 	vast		fileOccupancy;
 	vast		heapOccupancy;
 	double		currentOccupancy;
@@ -133,21 +35,16 @@ int	checkForCongestion()
 	double		netGrowth;
 	PsmAddress	elt1;
 	IonNeighbor	*neighbor;
+	IonRateChange	arg;
 	PsmAddress	elt2;
-	PsmAddress	addr;
-	IonEvent	*event;
-	IonCXref	*contact;
-	LystElt		elt3;
-	IonNeighbor	*np = NULL;
-	LystElt		elt4;
-	RateChange	*change;
+	PsmAddress	nextElt;
+	IonRateChange	*change;
 	unsigned long	secInEpoch;
 	double		spaceRemaining;
 	double		secUntilOutOfSpace;
 	unsigned long	secAdvanced;
 	double		increment;
 	time_t		alarmTime = 0;
-	double		delta;
 	char		timestampBuffer[TIMESTAMPBUFSZ];
 	char		alarmBuffer[40 + TIMESTAMPBUFSZ];
 	int		result;
@@ -165,14 +62,6 @@ int	checkForCongestion()
 	}
 
 	ionwm = getIonwm();
-	ionMemIdx = getIonMemoryMgr();
-	neighbors = lyst_create_using(ionMemIdx);
-	changes = lyst_create_using(ionMemIdx);
-	if (neighbors == NULL || changes == NULL)
-	{
-		putErrmsg(_cannotForecast() , NULL);
-		return -1;		/*	Out of memory.		*/
-	}
 
 	/*	First get current occupancy (both file space and heap).	*/
 
@@ -211,217 +100,47 @@ int	checkForCongestion()
 
 		netInTransitGrowth += neighbor->recvRate;
 		netInTransitGrowth -= neighbor->xmitRate;
-		np = (IonNeighbor *) MTAKE(sizeof(IonNeighbor));
-		if (np == NULL)
-		{
-			putErrmsg(_cannotForecast() , NULL);
-			sdr_cancel_xn(sdr);
-			return -1;	/*	Out of memory.		*/
-		}
-
-		memcpy((char *) np, (char *) neighbor, sizeof(IonNeighbor));
-		if (lyst_insert_last(neighbors, np) == NULL)
-		{
-			putErrmsg(_cannotForecast() , NULL);
-			sdr_cancel_xn(sdr);
-			return -1;	/*	Out of memory.		*/
-		}
 	}
 
 	/*	Have now got *current* occupancy and growth rate.
-	 *	Next, extract list of all relevant growth rate changes.	*/
+	 *	Next, find the first of all relevant growth rate
+	 *	changes.  These are indexed by time, as rate change
+	 *	deltas, as contacts are inserted into and removed
+	 *	from the contact plan: loopback contacts and contacts
+	 *	in which the local node neither transmits nor receives
+	 *	have no effect on congestion and are not indexed.	*/
 
 	netGrowth = netDomesticGrowth + netInTransitGrowth;
-	for (elt2 = sm_rbt_first(ionwm, ionvdb->timeline); elt2;
-			elt2 = sm_rbt_next(ionwm, elt2))
+	arg.time = forecastTime;
+	elt2 = sm_rbt_search(ionwm, ionvdb->rateChanges,
+			rfx_order_rate_changes, &arg, &nextElt);
+	if (elt2 == 0)
 	{
-		addr = sm_rbt_data(ionwm, elt2);
-		event = (IonEvent *) psp(ionwm, addr);
-		if (event->time < forecastTime)
-		{
-			continue;	/*	Happened in the past.	*/
-		}
-
-		/*	Start of transmission?				*/
-
-		if (event->type == IonStartXmit)
-		{
-			contact = (IonCXref *) psp(ionwm, event->ref);
-			if (contact->fromNode == contact->toNode)
-			{
-				/*	This is a loopback contact,
-				 *	which has no net effect on
-				 *	congestion.  Ignore it.		*/
-
-				continue;
-			}
-			
-			if (contact->fromNode != iondb.ownNodeNbr)
-			{
-				continue;	/*	Not relevant.	*/
-			}
-
-			/*	Find affected neighbor; add if nec.	*/
-
-			np = retrieveNeighbor(contact->toNode, neighbors);
-			if (np == NULL)
-			{
-				sdr_cancel_xn(sdr);
-				return -1;	/*	Out of memory.	*/
-			}
-
-			if (insertRateChange(event->time, contact->xmitRate,
-					0, np->xmitRate, changes) < 0)
-			{
-				sdr_cancel_xn(sdr);
-				return -1;	/*	Out of memory.	*/
-			}
-
-			np->xmitRate = contact->xmitRate;
-			continue;
-		}
-
-		/*	End of transmission?				*/
-
-		if (event->type == IonStopXmit)
-		{
-			contact = (IonCXref *) psp(ionwm, event->ref);
-			if (contact->fromNode == contact->toNode)
-			{
-				/*	This is a loopback contact,
-				 *	which has no net effect on
-				 *	congestion.  Ignore it.		*/
-
-				continue;
-			}
-			
-			if (contact->fromNode != iondb.ownNodeNbr)
-			{
-				continue;	/*	Not relevant.	*/
-			}
-
-			/*	Find affected neighbor; add if nec.	*/
-
-			np = retrieveNeighbor(contact->toNode, neighbors);
-			if (np == NULL)
-			{
-				sdr_cancel_xn(sdr);
-				return -1;	/*	Out of memory.	*/
-			}
-
-			if (insertRateChange(event->time, 0,
-					0, np->xmitRate, changes) < 0)
-			{
-				sdr_cancel_xn(sdr);
-				return -1;	/*	Out of memory.	*/
-			}
-
-			np->xmitRate = 0;
-			continue;
-		}
-
-		/*	Start of reception?				*/
-
-		if (event->type == IonStartRecv)
-		{
-			contact = (IonCXref *) psp(ionwm, event->ref);
-			if (contact->fromNode == contact->toNode)
-			{
-				/*	This is a loopback contact,
-				 *	which has no net effect on
-				 *	congestion.  Ignore it.		*/
-
-				continue;
-			}
-			
-			if (contact->toNode != iondb.ownNodeNbr)
-			{
-				continue;	/*	Not relevant.	*/
-			}
-
-			/*	Find affected neighbor; add if nec.	*/
-
-			np = retrieveNeighbor(contact->fromNode, neighbors);
-			if (np == NULL)
-			{
-				sdr_cancel_xn(sdr);
-				return -1;	/*	Out of memory.	*/
-			}
-
-			if (insertRateChange(event->time, contact->xmitRate,
-					1, np->recvRate, changes) < 0)
-			{
-				sdr_cancel_xn(sdr);
-				return -1;	/*	Out of memory.	*/
-			}
-
-			np->recvRate = contact->xmitRate;
-			continue;
-		}
-
-		/*	End of reception?				*/
-
-		if (event->type == IonStopRecv)
-		{
-			contact = (IonCXref *) psp(ionwm, event->ref);
-			if (contact->fromNode == contact->toNode)
-			{
-				/*	This is a loopback contact,
-				 *	which has no net effect on
-				 *	congestion.  Ignore it.		*/
-
-				continue;
-			}
-			
-			if (contact->toNode != iondb.ownNodeNbr)
-			{
-				continue;	/*	Not relevant.	*/
-			}
-
-			/*	Find affected neighbor; add if nec.	*/
-
-			np = retrieveNeighbor(contact->fromNode, neighbors);
-			if (np == NULL)
-			{
-				sdr_cancel_xn(sdr);
-				return -1;	/*	Out of memory.	*/
-			}
-
-			if (insertRateChange(event->time, 0,
-					1, np->recvRate, changes) < 0)
-			{
-				sdr_cancel_xn(sdr);
-				return -1;	/*	Out of memory.	*/
-			}
-
-			np->recvRate = 0;
-			continue;
-		}
+		elt2 = nextElt;	/*	Changes in the past are ignored.*/
 	}
 
 	/*	Now revise occupancy level over time as growth occurs
 	 *	and growth rates change.  Occupancy computation
 	 *	optimized by Greg Menke 22 September 2011.		*/
 
-	for (elt4 = lyst_first(changes); elt4; elt4 = lyst_next(elt4))
+	for (; elt2; elt2 = sm_rbt_next(ionwm, elt2))
 	{
-		change = (RateChange *) lyst_data(elt4);
+		change = (IonRateChange *) psp(ionwm, sm_rbt_data(ionwm, elt2));
+		if (change == NULL)
+		{
+			putErrmsg("Corrupted rate changes index.", NULL);
+			sdr_cancel_xn(sdr);
+			return -1;
+		}
 
 		/*	Let occupancy level change per current rate
 		 *	up to time of next rate change.
 		 *
 		 *	NOTE: change->time can never be less than
-		 *	forecastTime because contacts that started
-		 *	in the past are reflected in the initial
-		 *	netGrowth; the start of such a contact
-		 *	is never posted to the list of RateChanges. 	*/
-
-		if (change->time < forecastTime)
-		{
-			putErrmsg("Investigate congestion check error.",
-					utoa(change->time));
-			continue;
-		}
+		 *	forecastTime because the search for the first
+		 *	change skips all changes that are in the past;
+		 *	the effects of contacts that started in the
+		 *	past are reflected in the initial netGrowth.	*/
 
 		if (iondb.horizon > 0 && iondb.horizon < change->time) 
 		{
@@ -503,7 +222,7 @@ int	checkForCongestion()
 			break;		/*	Done forecasting.	*/
 		}
 
-		if (forecastTime > iondb.horizon)
+		if (iondb.horizon > 0 && forecastTime > iondb.horizon)
 		{
 			break;		/*	Done forecasting.	*/
 		}
@@ -511,17 +230,7 @@ int	checkForCongestion()
 		/*	Apply the adjustment that occurs at the time
 		 *	of this change (the end of the prior epoch).	*/
 
-		delta = change->xmitRate - change->prevXmitRate;
-		if (change->fromNeighbor)
-		{
-			netGrowth += delta;
-			netInTransitGrowth += delta;
-		}
-		else
-		{
-			netGrowth -= delta;
-			netInTransitGrowth -= delta;
-		}
+		netGrowth += change->netGrowthDelta;
 	}
 
 	/*	Have determined final net growth rate as of end of
@@ -606,28 +315,6 @@ int	checkForCongestion()
 	sdr_write(sdr, iondbObj, (char *) &iondb, sizeof(IonDB));
 	result = sdr_end_xn(sdr);
 
-	/*	Release memory used for neighbors and changes lists.	*/
-
-	elt3 = lyst_first(neighbors);
-	while (elt3)
-	{
-		np = (IonNeighbor *) lyst_data(elt3);
-		MRELEASE(np);
-		lyst_delete(elt3);
-		elt3 = lyst_first(neighbors);
-	}
-
-	lyst_destroy(neighbors);
-	elt4 = lyst_first(changes);
-	while (elt4)
-	{
-		change = (RateChange *) lyst_data(elt4);
-		MRELEASE(change);
-		lyst_delete(elt4);
-		elt4 = lyst_first(changes);
-	}
-
-	lyst_destroy(changes);
 	if (result < 0)
 	{
 		putErrmsg("Failed on check for congestion.", NULL);
@@ -35,13 +35,20 @@ static void	shutDown()	/*	Commands ltpclock termination.	*/
 	oK(_running(&stop));	/*	Terminates ltpclock.		*/
 }
 
-static int	dispatchEvents(Sdr sdr, Object events, time_t currentTime)
+static int	dispatchEvents(Sdr sdr, Object events,
+			struct timeval *currentTime, struct timeval *nextEvent)
 {
 	Object		elt;
 	Object		eventObj;
 	LtpEvent	event;
 	int		result;
 
+	/*	*nextEvent is set to the scheduled time of the first
+	 *	event that is not yet due, or to zero if there is no
+	 *	such event.						*/
+
+	nextEvent->tv_sec = 0;
+	nextEvent->tv_usec = 0;
 	while (1)
 	{
 		CHKERR(sdr_begin_xn(sdr));
@@ -54,11 +61,15 @@ static int	dispatchEvents(Sdr sdr, Object events, time_t currentTime)
 
 		eventObj = sdr_list_data(sdr, elt);
 		sdr_read(sdr, (char *) &event, eventObj, sizeof(LtpEvent));
-		if (event.scheduledTime > currentTime)
+		if (event.scheduledTime > currentTime->tv_sec
+		|| (event.scheduledTime == currentTime->tv_sec
+			&& event.scheduledUsec > currentTime->tv_usec))
 		{
 			/*	This is the first future event.		*/
 
 			sdr_exit_xn(sdr);
+			nextEvent->tv_sec = event.scheduledTime;
+			nextEvent->tv_usec = event.scheduledUsec;
 			return 0;
 		}
 
@@ -121,6 +132,9 @@ static int	manageLinks(Sdr sdr, time_t currentTime)
 	IonNeighbor	*neighbor;
 	PsmAddress	nextElt;
 	unsigned int	priorXmitRate;
+	LtpBlockBuffer	*buffer;
+	int		closed;
+	int		i;
 
 	CHKERR(sdr_begin_xn(sdr));
 	for (elt = sm_list_first(ionwm, ltpvdb->spans); elt;
@@ -132,16 +146,35 @@ static int	manageLinks(Sdr sdr, time_t currentTime)
 
 		obj = sdr_list_data(sdr, vspan->spanElt);
 		sdr_stage(sdr, (char *) &span, obj, sizeof(LtpSpan));
-		if (span.lengthOfBufferedBlock > 0)
+		closed = 0;
+		for (i = 0; i < LTP_MAX_NBR_OF_CLIENTS; i++)
 		{
-			span.ageOfBufferedBlock++;
-			sdr_write(sdr, obj, (char *) &span, sizeof(LtpSpan));
-			if (span.ageOfBufferedBlock >= span.aggrTimeLimit)
+			buffer = span.buffers + i;
+			if (buffer->length == 0)
+			{
+				continue;
+			}
+
+			buffer->age++;
+			if (buffer->age >= span.aggrTimeLimit)
 			{
-				sm_SemGive(vspan->bufClosedSemaphore);
+				if (closeBlockBuffer(sdr, &span, i) < 0)
+				{
+					putErrmsg("Can't close block.", NULL);
+					sdr_cancel_xn(sdr);
+					return -1;
+				}
+
+				closed = 1;
 			}
 		}
 
+		sdr_write(sdr, obj, (char *) &span, sizeof(LtpSpan));
+		if (closed)
+		{
+			sm_SemGive(vspan->bufClosedSemaphore);
+		}
+
 		/*	Find Neighbor object encapsulating the current
 		 *	known state of this LTP engine.			*/
 
@@ -226,7 +259,11 @@ int	main(int argc, char *argv[])
 	Sdr	sdr;
 	LtpDB	*ltpConstants;
 	long	state = 1;
-	time_t	currentTime;
+	struct timeval	currentTime;
+	struct timeval	nextEvent;
+	time_t	lastLinkCheck = 0;
+	long	interval;
+	long	usecs;
 
 	if (ltpInit(0) < 0)
 	{
@@ -245,34 +282,61 @@ int	main(int argc, char *argv[])
 	writeMemo("[i] ltpclock is running.");
 	while (_running(NULL))
 	{
-		/*	Sleep for 1 second, then dispatch all events
-		 *	whose executions times have now been reached.	*/
+		getLtpCurrentTime(&currentTime);
 
-		snooze(1);
-		currentTime = getUTCTime();
+		/*	Once per second, infer link state changes from
+		 *	rate changes noted in the shared ION database.	*/
 
-		/*	Infer link state changes from rate changes
-		 *	noted in the shared ION database.		*/
-
-		if (manageLinks(sdr, currentTime) < 0)
+		if (currentTime.tv_sec != lastLinkCheck)
 		{
-			putErrmsg("Can't manage links.", NULL);
-			state = 0;	/*	Terminate loop.		*/
-			oK(_running(&state));
-			continue;
+			lastLinkCheck = currentTime.tv_sec;
+			if (manageLinks(sdr, currentTime.tv_sec) < 0)
+			{
+				putErrmsg("Can't manage links.", NULL);
+				state = 0;	/*	Terminate loop.	*/
+				oK(_running(&state));
+				continue;
+			}
 		}
 
 		/*	Then dispatch retransmission events, as
 		 *	constrained by the new link state.		*/
 
-		if (dispatchEvents(sdr, ltpConstants->timeline, currentTime)
-				< 0)
+		if (dispatchEvents(sdr, ltpConstants->timeline, &currentTime,
+				&nextEvent) < 0)
 		{
 			putErrmsg("Can't dispatch events.", NULL);
 			state = 0;	/*	Terminate loop.		*/
 			oK(_running(&state));
 			continue;
 		}
+
+		/*	Sleep until the next event is due or the next
+		 *	second begins, whichever is sooner, but for at
+		 *	least one clock tick.  Timers may be armed at
+		 *	sub-second resolution, but an idle node needn't
+		 *	wake more than once per second.			*/
+
+		getLtpCurrentTime(&currentTime);
+		usecs = 1000000 - currentTime.tv_usec;
+		if (nextEvent.tv_sec != 0
+		&& nextEvent.tv_sec - currentTime.tv_sec < 2)
+		{
+			interval = (nextEvent.tv_sec - currentTime.tv_sec)
+					* 1000000;
+			interval += nextEvent.tv_usec - currentTime.tv_usec;
+			if (interval < usecs)
+			{
+				usecs = interval;
+			}
+		}
+
+		if (usecs < LTP_CLOCK_TICK)
+		{
+			usecs = LTP_CLOCK_TICK;
+		}
+
+		microsnooze(usecs);
 	}
 
 	writeErrmsgMemos();
@@ -28,6 +28,8 @@ int	main(int argc, char *argv[])
 	LtpSpan		span;
 	int		returnCode = 0;
 	char		memo[64];
+	Object		elt;
+	Object		sessionObj;
 	ExportSession	session;
 	Lyst		extents;
 	ExportExtent	*extent;
@@ -68,30 +70,23 @@ int	main(int argc, char *argv[])
 	/*	All command-line arguments are now validated.		*/
 
 	spanObj = sdr_list_data(sdr, vspan->spanElt);
-	sdr_stage(sdr, (char *) &span, spanObj, sizeof(LtpSpan));
-	if (span.currentExportSessionObj == 0)	/*	New span.	*/
+	sdr_exit_xn(sdr);
+	writeMemo("[i] ltpmeter is running.");
+	while (1)
 	{
-		/*	Must start span's initial session.		*/
-
-		sdr_exit_xn(sdr);
-		if (startExportSession(sdr, spanObj, vspan) < 0)
-		{
-			putErrmsg("ltpmeter can't start new session.",
-					itoa(remoteEngineId));
-			return 1;
-		}
+		/*	First wait until some block aggregation buffer
+		 *	for this span is closed.			*/
 
 		CHKZERO(sdr_begin_xn(sdr));
-		sdr_stage(sdr, (char *) &span, spanObj, sizeof(LtpSpan));
-	}
 
-	writeMemo("[i] ltpmeter is running.");
-	while (1)
-	{
-		/*	First wait until block aggregation buffer for
-		 *	this span is closed.				*/
+		/*	Re-read the span on every pass, so that the
+		 *	segmentation of this block reflects any changes
+		 *	made to the span (e.g., maximum segment size)
+		 *	since the last one.				*/
 
-		if (span.lengthOfBufferedBlock < span.aggrSizeLimit)
+		sdr_read(sdr, (char *) &span, spanObj, sizeof(LtpSpan));
+		elt = sdr_list_first(sdr, span.closedBlocks);
+		if (elt == 0)
 		{
 			sdr_exit_xn(sdr);
 			if (sm_SemTake(vspan->bufClosedSemaphore) < 0)
@@ -110,26 +105,18 @@ engine " UVAST_FIELDSPEC " is stopped.", remoteEngineId);
 				break;		/*	Outer loop.	*/
 			}
 
-			CHKZERO(sdr_begin_xn(sdr));
-			sdr_stage(sdr, (char *) &span, spanObj,
-					sizeof(LtpSpan));
-		}
-
-		if (span.lengthOfBufferedBlock == 0)
-		{
-			continue;	/*	Nothing to do yet.	*/
+			continue;
 		}
 
-		/*	Now segment the block that is currently
-		 *	aggregated in the buffer, giving the span's
-		 *	segSemaphore once per segment.			*/
+		/*	Now segment the oldest closed block, giving the
+		 *	span's segSemaphore once per segment.  Clients
+		 *	may meanwhile be aggregating their next blocks
+		 *	in the span's block buffers.			*/
 
-		sdr_stage(sdr, (char *) &session, span.currentExportSessionObj,
+		sessionObj = sdr_list_data(sdr, elt);
+		sdr_list_delete(sdr, elt, NULL, NULL);
+		sdr_stage(sdr, (char *) &session, sessionObj,
 				sizeof(ExportSession));
-		session.clientSvcId = span.clientSvcIdOfBufferedBlock;
-		encodeSdnv(&(session.clientSvcIdSdnv), session.clientSvcId);
-		session.totalLength = span.lengthOfBufferedBlock;
-		session.redPartLength = span.redLengthOfBufferedBlock;
 		if ((extents = lyst_create_using(getIonMemoryMgr())) == NULL
 		|| (extent = (ExportExtent *) MTAKE(sizeof(ExportExtent)))
 				== NULL
@@ -144,51 +131,34 @@ engine " UVAST_FIELDSPEC " is stopped.", remoteEngineId);
 		extent->offset = 0;
 		extent->length = session.totalLength;
 		segmentsIssued = issueSegments(sdr, &span, vspan, &session,
-				span.currentExportSessionObj, extents, 0);
+				sessionObj, extents, 0);
 		MRELEASE(extent);
 		lyst_destroy(extents);
-		switch (segmentsIssued)
+		if (segmentsIssued < 0)
 		{
-		case -1:		/*	System error.		*/
 			putErrmsg("Can't segment block.", NULL);
 			sdr_cancel_xn(sdr);
 			returnCode = 1;
 			break;			/*	Outer loop.	*/
-
-		case 0:			/*	Database too full.	*/
-			sdr_cancel_xn(sdr);
-
-			/*	Wait one second and try again.		*/
-
-			snooze(1);
-			CHKZERO(sdr_begin_xn(sdr));
-			sdr_stage(sdr, (char *) &span, spanObj,
-					sizeof(LtpSpan));
-			continue;
 		}
 
-		/*	Segment issuance succeeded.			*/
-
-		if (vdb->watching & WATCH_f)
+		if (segmentsIssued > 0)
 		{
-			putchar('f');
-			fflush(stdout);
-		}
+			/*	Segment issuance succeeded.		*/
 
-		/*	Commit changes to current session to the
-		 *	database.					*/
+			if (vdb->watching & WATCH_f)
+			{
+				putchar('f');
+				fflush(stdout);
+			}
 
-		sdr_write(sdr, span.currentExportSessionObj, (char *) &session,
-				sizeof(ExportSession));
+			/*	Commit changes to the session to the
+			 *	database.				*/
 
-		/*	Reinitialize span's block buffer.		*/
+			sdr_write(sdr, sessionObj, (char *) &session,
+					sizeof(ExportSession));
+		}
 
-		span.ageOfBufferedBlock = 0;
-		span.lengthOfBufferedBlock = 0;
-		span.redLengthOfBufferedBlock = 0;
-		span.clientSvcIdOfBufferedBlock = 0;
-		span.currentExportSessionObj = 0;
-		sdr_write(sdr, spanObj, (char *) &span, sizeof(LtpSpan));
 		if (sdr_end_xn(sdr))
 		{
 			putErrmsg("Can't finish session.", NULL);
@@ -196,25 +166,9 @@ engine " UVAST_FIELDSPEC " is stopped.", remoteEngineId);
 			break;			/*	Outer loop.	*/
 		}
 
-		/*	Start an export session for the next block.	*/
-
-		if (startExportSession(sdr, spanObj, vspan) < 0)
-		{
-			putErrmsg("ltpmeter can't start new session.",
-					utoa(remoteEngineId));
-			returnCode = 1;
-			break;			/*	Outer loop.	*/
-		}
-
 		/*	Make sure other tasks have a chance to run.	*/
 
 		sm_TaskYield();
-
-		/*	Now start next cycle of main loop, waiting
-		 *	for the new session's buffer to be closed.	*/
-
-		CHKZERO(sdr_begin_xn(sdr));
-		sdr_stage(sdr, (char *) &span, spanObj, sizeof(LtpSpan));
 	}
 
 	writeErrmsgMemos();
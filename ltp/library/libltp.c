@@ -35,30 +35,32 @@ static int	sduCanBeAppendedToBlock(LtpSpan *span,
 			unsigned int clientSvcId,
 			unsigned int redPartLength)
 {
-	Sdr	sdr = getIonsdr();
+	Sdr		sdr = getIonsdr();
+	LtpBlockBuffer	*buffer = span->buffers + clientSvcId;
 
-	if (span->lengthOfBufferedBlock == 0)
+	if (buffer->sessionObj == 0)
 	{
-		/*	This is a brand-new, empty block.
+		/*	Client's next block is not yet started; a
+		 *	new export session must be started for it.
 		 *
-		 *	If the span's session count exceeds the
-		 *	limit, then this is the over-limit session
-		 *	and it can ONLY be used for transmission
-		 *	of an all-green block.
+		 *	If the span's session count has reached the
+		 *	limit, then the new session would be the
+		 *	over-limit session and it can ONLY be used
+		 *	for transmission of an all-green block.
 		 *
 		 *	Note that appending any single SDU with
 		 *	green length greater than zero terminates
 		 *	aggregation for this session (whether the
 		 *	block was previously empty or not) and
-		 *	causes the block to be segmented immediately.
-		 *	When transmission via the Span is enabled,
-		 *	these segments will be dequeued; dequeuing
-		 *	the last segment in the block -- a green
-		 *	EOB -- will cause the session to be closed,
-		 *	reducing the length of the session list to
-		 *	no more than the limit.  This will enable
-		 *	another (possibly over-limit) session to
-		 *	be started, which again can be used for
+		 *	causes the block to be closed and segmented
+		 *	immediately.  When transmission via the Span
+		 *	is enabled, these segments will be dequeued;
+		 *	dequeuing the last segment in the block -- a
+		 *	green EOB -- will cause the session to be
+		 *	closed, reducing the length of the session
+		 *	list to no more than the limit.  This will
+		 *	enable another (possibly over-limit) session
+		 *	to be started, which again can be used for
 		 *	transmission of all-green data even if the
 		 *	session limit has been reached (meaning
 		 *	the transmission of new red data must wait
@@ -74,7 +76,7 @@ static int	sduCanBeAppendedToBlock(LtpSpan *span,
 		 *	of red data.					*/
 
 		if (sdr_list_length(sdr, span->exportSessions)
-				> span->maxExportSessions)
+				>= span->maxExportSessions)
 		{
 			if (redPartLength == 0)	/*	All-green SDU.	*/
 			{
@@ -91,48 +93,13 @@ static int	sduCanBeAppendedToBlock(LtpSpan *span,
 		return 1;			/*	Okay.		*/
 	}
 
-	/*	The current export block already contains some data.	*/
-
-	if (span->lengthOfBufferedBlock > span->redLengthOfBufferedBlock)
-	{
-		/*	Block contains some green data, so it's
-		 *	already released for transmission and just
-		 *	hasn't been fully segmented yet, possibly
-		 *	because transmission is stopped.  Can't
-		 *	append the SDU to this block, must wait for
-		 *	the next session.				*/
-
-		return 0;
-	}
-
-	if (span->lengthOfBufferedBlock >= span->aggrSizeLimit)
-	{
-		/*	Block has reached its aggregation limit, so
-		 *	it's already released for transmission and
-		 *	just hasn't been fully segmented yet, possibly
-		 *	because transmission is stopped.  Can't
-		 *	append the SDU to this block, must wait for
-		 *	the next session.				*/
-
-		return 0;
-	}
-
-	if (clientSvcId != span->clientSvcIdOfBufferedBlock)
-	{
-		/*	This SDU is destined for a different client
-		 *	than the client for all other data in the
-		 *	block.  Can't append the SDU to this block,
-		 *	must wait for the next session.  (This block
-		 *	will be released for transmission either when
-		 *	its aggregation size limit is reached, due to
-		 *	additional traffic inserted by some other
-		 *	thread, or when the session's aggregation
-		 *	time limit is reached.				*/
-
-		return 0;
-	}
-
-	/*	No problems, can append SDU to this block.		*/
+	/*	The client's current block already contains some
+	 *	data.  It is necessarily all red and smaller than
+	 *	the aggregation size limit, because otherwise it
+	 *	would already have been closed and handed off to
+	 *	ltpmeter for segmentation.  Blocks for different
+	 *	clients are aggregated in separate buffers, so no
+	 *	problems: can append SDU to this block.			*/
 
 	return 1;
 }
@@ -148,6 +115,7 @@ int	ltp_send(uvast destinationEngineId, unsigned int clientSvcId,
 	unsigned int	dataLength;
 	Object		spanObj;
 	LtpSpan		span;
+	LtpBlockBuffer	*buffer;
 			OBJ_POINTER(ExportSession, session);
 
 	CHKERR(clientSvcId <= MAX_LTP_CLIENT_NBR);
@@ -179,24 +147,18 @@ int	ltp_send(uvast destinationEngineId, unsigned int clientSvcId,
 	sdr_stage(sdr, (char *) &span, spanObj, sizeof(LtpSpan));
 
 	/*	All service data units aggregated into any single
-	 *	block must have the same client service ID, and
-	 *	no service data unit can be added to a block that
-	 *	has any green data (only all-red service data units
-	 *	can be aggregated in a single block).			*/
+	 *	block must have the same client service ID, so each
+	 *	client service has its own block buffer; and no
+	 *	service data unit can be added to a block that has
+	 *	any green data (only all-red service data units can
+	 *	be aggregated in a single block).			*/
 
 	while (1)
 	{
-		if (span.currentExportSessionObj)
+		if (sduCanBeAppendedToBlock(&span, clientSvcId,
+				redPartLength))
 		{
-			/*	Span has been initialized with a
-			 *	session buffer (block) into which
-			 *	service data can be inserted.		*/
-
-			if (sduCanBeAppendedToBlock(&span, clientSvcId,
-					redPartLength))
-			{
-				break;		/*	Out of loop.	*/
-			}
+			break;			/*	Out of loop.	*/
 		}
 
 		/*	Can't append service data unit to block.  Wait
@@ -242,25 +204,50 @@ int	ltp_send(uvast destinationEngineId, unsigned int clientSvcId,
 		sdr_stage(sdr, (char *) &span, spanObj, sizeof(LtpSpan));
 	}
 
-	/*	Now append the outbound SDU to the block that is
-	 *	currently being aggregated for this span and, if the
-	 *	block buffer is now full or the block buffer contains
-	 *	any green data, notify ltpmeter that block segmentation
-	 *	can begin.						*/
+	buffer = span.buffers + clientSvcId;
+	if (buffer->sessionObj == 0)
+	{
+		/*	Start an export session for the client's
+		 *	next block.					*/
 
-	GET_OBJ_POINTER(sdr, ExportSession, session,
-			span.currentExportSessionObj);
+		if (startExportSession(sdr, spanObj, clientSvcId) < 0)
+		{
+			putErrmsg("Can't start new session.",
+					itoa(vspan->engineId));
+			return -1;
+		}
+
+		sdr_stage(sdr, (char *) &span, spanObj, sizeof(LtpSpan));
+	}
+
+	/*	Now append the outbound SDU to the block that is
+	 *	currently being aggregated for this client and, if
+	 *	the block buffer is now full or the block buffer
+	 *	contains any green data, close the block and notify
+	 *	ltpmeter that block segmentation can begin.  The
+	 *	client's next SDU goes into a new block, which can
+	 *	be filled while this one is being segmented.		*/
+
+	GET_OBJ_POINTER(sdr, ExportSession, session, buffer->sessionObj);
 	sdr_list_insert_last(sdr, session->svcDataObjects, clientServiceData);
-	span.clientSvcIdOfBufferedBlock = clientSvcId;
-	span.lengthOfBufferedBlock += dataLength;
-	span.redLengthOfBufferedBlock += redPartLength;
-	sdr_write(sdr, spanObj, (char *) &span, sizeof(LtpSpan));
-	if (span.lengthOfBufferedBlock >= span.aggrSizeLimit
-	|| span.redLengthOfBufferedBlock < span.lengthOfBufferedBlock)
+	sessionId->sessionNbr = session->sessionNbr;
+	buffer->length += dataLength;
+	buffer->redLength += redPartLength;
+	if (buffer->length >= span.aggrSizeLimit
+	|| buffer->redLength < buffer->length)
 	{
+		if (closeBlockBuffer(sdr, &span, clientSvcId) < 0)
+		{
+			sdr_cancel_xn(sdr);
+			putErrmsg("Can't send data.", NULL);
+			return -1;
+		}
+
 		sm_SemGive(vspan->bufClosedSemaphore);
 	}
 
+	sdr_write(sdr, spanObj, (char *) &span, sizeof(LtpSpan));
+
 	if (vdb->watching & WATCH_d)
 	{
 		putchar('d');
@@ -274,7 +261,6 @@ int	ltp_send(uvast destinationEngineId, unsigned int clientSvcId,
 	}
 
 	sessionId->sourceEngineId = vdb->ownEngineId;
-	sessionId->sessionNbr = session->sessionNbr;
 	return 1;
 }
 
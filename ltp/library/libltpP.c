@@ -75,10 +75,9 @@ static LtpDB	*_ltpConstants()
 /*	Note: to avoid running out of database heap space, LTP uses
  *	flow control based on limiting the number of export sessions
  *	that can be concurrently active; this value constitutes the
- *	flow control "window" for LTP.  The limit is set at the time
- *	LTP is initialized and is used to fix the size of the window
- *	at that time; specifically, it establishes the size of the
- *	exportSessions hash table.					*/
+ *	flow control "window" for LTP.  The estimated limit is set at
+ *	the time LTP is initialized and is used to size the volatile
+ *	export sessions table at the time that table is raised.	*/
 
 void	ltpSpanTally(LtpVspan *vspan, unsigned int idx, unsigned int size)
 {
@@ -380,6 +379,193 @@ static void	waitForSpan(LtpVspan *vspan)
 	}
 }
 
+/*	*	*	Volatile export sessions table	*	*	*/
+
+static LtpVexport	*findVexport(LtpVdb *vdb, unsigned int sessionNbr)
+{
+	LtpVexport	*table;
+	unsigned int	i;
+
+	table = (LtpVexport *) psp(getIonwm(), vdb->exports);
+	for (i = sessionNbr & vdb->exportsMask; table[i].sessionObj;
+			i = (i + 1) & vdb->exportsMask)
+	{
+		if (table[i].sessionNbr == sessionNbr)
+		{
+			return table + i;
+		}
+	}
+
+	return NULL;
+}
+
+static void	placeVexport(LtpVexport *table, unsigned int mask,
+			LtpVexport *vexport)
+{
+	unsigned int	i;
+
+	for (i = vexport->sessionNbr & mask; table[i].sessionObj;
+			i = (i + 1) & mask)
+	{
+		continue;
+	}
+
+	table[i] = *vexport;
+}
+
+static int	sizeVexports(LtpVdb *vdb, unsigned int tableSize)
+{
+	PsmPartition	ltpwm = getIonwm();
+	PsmAddress	newTableAddr;
+	LtpVexport	*newTable;
+	LtpVexport	*oldTable;
+	unsigned int	i;
+
+	newTableAddr = psm_malloc(ltpwm, tableSize * sizeof(LtpVexport));
+	if (newTableAddr == 0)
+	{
+		putErrmsg("No space for export sessions table.",
+				utoa(tableSize));
+		return -1;
+	}
+
+	newTable = (LtpVexport *) psp(ltpwm, newTableAddr);
+	memset((char *) newTable, 0, tableSize * sizeof(LtpVexport));
+	if (vdb->exports)
+	{
+		oldTable = (LtpVexport *) psp(ltpwm, vdb->exports);
+		for (i = 0; i <= vdb->exportsMask; i++)
+		{
+			if (oldTable[i].sessionObj)
+			{
+				placeVexport(newTable, tableSize - 1,
+						oldTable + i);
+			}
+		}
+
+		psm_free(ltpwm, vdb->exports);
+	}
+
+	vdb->exports = newTableAddr;
+	vdb->exportsMask = tableSize - 1;
+	return 0;
+}
+
+static int	insertVexport(LtpVdb *vdb, unsigned int sessionNbr,
+			Object sessionObj, Object sessionElt, int canceled)
+{
+	LtpVexport	vexport;
+
+	/*	Table occupancy is held to no more than half, so that
+	 *	probe sequences stay short and always end at an
+	 *	empty slot.						*/
+
+	if ((vdb->exportsCount + 1) * 2 > vdb->exportsMask + 1)
+	{
+		if (sizeVexports(vdb, (vdb->exportsMask + 1) * 2) < 0)
+		{
+			return -1;
+		}
+	}
+
+	vexport.sessionObj = sessionObj;
+	vexport.sessionElt = sessionElt;
+	vexport.sessionNbr = sessionNbr;
+	vexport.canceled = canceled;
+	placeVexport((LtpVexport *) psp(getIonwm(), vdb->exports),
+			vdb->exportsMask, &vexport);
+	vdb->exportsCount++;
+	return 0;
+}
+
+static void	deleteVexport(LtpVdb *vdb, LtpVexport *vexport)
+{
+	LtpVexport	*table;
+	unsigned int	mask = vdb->exportsMask;
+	unsigned int	i;
+	unsigned int	j;
+	unsigned int	k;
+
+	/*	Shift back any subsequent entries in the same probe
+	 *	sequence that would otherwise become unreachable.	*/
+
+	table = (LtpVexport *) psp(getIonwm(), vdb->exports);
+	i = j = vexport - table;
+	while (1)
+	{
+		j = (j + 1) & mask;
+		if (table[j].sessionObj == 0)
+		{
+			break;
+		}
+
+		k = table[j].sessionNbr & mask;
+		if ((j > i && (k <= i || k > j))
+		|| (j < i && (k <= i && k > j)))
+		{
+			table[i] = table[j];
+			i = j;
+		}
+	}
+
+	memset((char *) (table + i), 0, sizeof(LtpVexport));
+	vdb->exportsCount--;
+}
+
+static int	raiseVexports(LtpVdb *vdb, LtpDB *db)
+{
+	Sdr		ltpSdr = getIonsdr();
+	unsigned int	tableSize = 16;
+	Object		spanElt;
+	Object		elt;
+	Object		sessionObj;
+			OBJ_POINTER(LtpSpan, span);
+			OBJ_POINTER(ExportSession, session);
+
+	while (tableSize < db->estMaxExportSessions * 2)
+	{
+		tableSize <<= 1;
+	}
+
+	if (sizeVexports(vdb, tableSize) < 0)
+	{
+		return -1;
+	}
+
+	for (spanElt = sdr_list_first(ltpSdr, db->spans); spanElt;
+			spanElt = sdr_list_next(ltpSdr, spanElt))
+	{
+		GET_OBJ_POINTER(ltpSdr, LtpSpan, span,
+				sdr_list_data(ltpSdr, spanElt));
+		for (elt = sdr_list_first(ltpSdr, span->exportSessions); elt;
+				elt = sdr_list_next(ltpSdr, elt))
+		{
+			sessionObj = sdr_list_data(ltpSdr, elt);
+			GET_OBJ_POINTER(ltpSdr, ExportSession, session,
+					sessionObj);
+			if (insertVexport(vdb, session->sessionNbr, sessionObj,
+					elt, 0) < 0)
+			{
+				return -1;
+			}
+		}
+	}
+
+	for (elt = sdr_list_first(ltpSdr, db->deadExports); elt;
+			elt = sdr_list_next(ltpSdr, elt))
+	{
+		sessionObj = sdr_list_data(ltpSdr, elt);
+		GET_OBJ_POINTER(ltpSdr, ExportSession, session, sessionObj);
+		if (insertVexport(vdb, session->sessionNbr, sessionObj, elt, 1)
+				< 0)
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 static char 	*_ltpvdbName()
 {
 	return "ltpvdb";
@@ -473,6 +659,15 @@ static LtpVdb		*_ltpvdb(char **name)
 			}
 		}
 
+		/*	Index all export sessions.			*/
+
+		if (raiseVexports(vdb, db) < 0)
+		{
+			sdr_exit_xn(sdr);
+			putErrmsg("Can't raise export sessions table.", NULL);
+			return NULL;
+		}
+
 		sdr_exit_xn(sdr);	/*	Unlock memory.		*/
 	}
 
@@ -544,9 +739,6 @@ int	ltpInit(int estMaxExportSessions)
 			ltpdbBuf.clients[i].notices = sdr_list_create(ltpSdr);
 		}
 
-		ltpdbBuf.exportSessionsHash = sdr_hash_create(ltpSdr,
-				sizeof(unsigned int), estMaxExportSessions,
-				LTP_MEAN_SEARCH_LENGTH);
 		ltpdbBuf.deadExports = sdr_list_create(ltpSdr);
 		ltpdbBuf.spans = sdr_list_create(ltpSdr);
 		ltpdbBuf.timeline = sdr_list_create(ltpSdr);
@@ -604,6 +796,10 @@ static void	dropVdb(PsmPartition wm, PsmAddress vdbAddress)
 	}
 
 	sm_list_destroy(wm, vdb->spans, NULL, NULL);
+	if (vdb->exports)
+	{
+		psm_free(wm, vdb->exports);
+	}
 }
 
 void	ltpDropVdb()
@@ -660,6 +856,19 @@ LtpVdb	*getLtpVdb()
 	return _ltpvdb(NULL);
 }
 
+void	getLtpCurrentTime(struct timeval *currentTime)
+{
+	IonVdb	*ionvdb = getIonVdb();
+
+	/*	Same clock as getUTCTime(), at microsecond resolution.	*/
+
+	getCurrentTime(currentTime);
+	if (ionvdb)
+	{
+		currentTime->tv_sec -= ionvdb->deltaFromUTC;
+	}
+}
+
 int	ltpStart(char *lsiCmd)
 {
 	Sdr		ltpSdr = getIonsdr();
@@ -974,6 +1183,7 @@ int	addSpan(uvast engineId, unsigned int maxExportSessions,
 	spanBuf.aggrSizeLimit = aggrSizeLimit;
 	spanBuf.aggrTimeLimit = aggrTimeLimit;
 	spanBuf.maxSegmentSize = maxSegmentSize;
+	spanBuf.closedBlocks = sdr_list_create(ltpSdr);
 	spanBuf.exportSessions = sdr_list_create(ltpSdr);
 	spanBuf.segments = sdr_list_create(ltpSdr);
 	spanBuf.importSessions = sdr_list_create(ltpSdr);
@@ -1187,6 +1397,7 @@ removed yet.", itoa(engineId));
 		sdr_free(ltpSdr, span->lsoCmd);
 	}
 
+	sdr_list_destroy(ltpSdr, span->closedBlocks, NULL, NULL);
 	sdr_list_destroy(ltpSdr, span->exportSessions, NULL, NULL);
 	sdr_list_destroy(ltpSdr, span->segments, NULL, NULL);
 	sdr_list_destroy(ltpSdr, span->importSessions, NULL, NULL);
@@ -1248,7 +1459,7 @@ void	ltpStopSpan(uvast engineId)
 	sdr_exit_xn(ltpSdr);	/*	Unlock memory.			*/
 }
 
-int	startExportSession(Sdr sdr, Object spanObj, LtpVspan *vspan)
+int	startExportSession(Sdr sdr, Object spanObj, unsigned int clientSvcId)
 {
 	Object		dbobj;
 	LtpSpan		span;
@@ -1258,7 +1469,7 @@ int	startExportSession(Sdr sdr, Object spanObj, LtpVspan *vspan)
 	Object		elt;
 	ExportSession	session;
 
-	CHKERR(vspan);
+	CHKERR(clientSvcId <= MAX_LTP_CLIENT_NBR);
 	CHKERR(sdr_begin_xn(sdr));
 	sdr_stage(sdr, (char *) &span, spanObj, sizeof(LtpSpan));
 
@@ -1272,15 +1483,14 @@ int	startExportSession(Sdr sdr, Object spanObj, LtpVspan *vspan)
 
 	/*	Record the session object in the database. The
 	 *	exportSessions list element points to the session
-	 *	structure.  exportSessionHash entry points to the
-	 *	list element.						*/
+	 *	structure.  The volatile export sessions table entry
+	 *	points to both.						*/
 
 	sessionObj = sdr_malloc(sdr, sizeof(ExportSession));
 	if (sessionObj == 0
 	|| (elt = sdr_list_insert_last(sdr, span.exportSessions,
 			sessionObj)) == 0
-	|| sdr_hash_insert(sdr, ltpdb.exportSessionsHash,
-			(char *) &sessionNbr, elt, NULL) < 0)
+	|| insertVexport(_ltpvdb(NULL), sessionNbr, sessionObj, elt, 0) < 0)
 	{
 		putErrmsg("Can't start session.", NULL);
 		sdr_cancel_xn(sdr);
@@ -1298,22 +1508,15 @@ int	startExportSession(Sdr sdr, Object spanObj, LtpVspan *vspan)
 	session.greenSegments = sdr_list_create(sdr);
 	session.claims = sdr_list_create(sdr);
 	session.checkpoints = sdr_list_create(sdr);
+	session.retransmissions = sdr_list_create(sdr);
 	sdr_write(sdr, sessionObj, (char *) &session, sizeof(ExportSession));
 
-	/*	Note session address in span, then finish: unless span
-	 *	is currently inactive (i.e., localXmitRate is currently
-	 *	zero), give the buffer-empty semaphore so that the
-	 *	pending service data object (if any) can be inserted
+	/*	Note session address in the client's block buffer.
+	 *	The pending service data object can now be inserted
 	 *	into the buffer.					*/
 
-	span.currentExportSessionObj = sessionObj;
+	span.buffers[clientSvcId].sessionObj = sessionObj;
 	sdr_write(sdr, spanObj, (char *) &span, sizeof(LtpSpan));
-	if (vspan->localXmitRate > 0)
-	{
-		sm_SemGive(vspan->bufOpenRedSemaphore);
-		sm_SemGive(vspan->bufOpenGreenSemaphore);
-	}
-
 	if (sdr_end_xn(sdr))
 	{
 		putErrmsg("Can't start session.", NULL);
@@ -1323,6 +1526,44 @@ int	startExportSession(Sdr sdr, Object spanObj, LtpVspan *vspan)
 	return 0;
 }
 
+int	closeBlockBuffer(Sdr sdr, LtpSpan *span, unsigned int clientSvcId)
+{
+	LtpBlockBuffer	*buffer;
+	ExportSession	session;
+
+	CHKERR(ionLocked());
+	CHKERR(span);
+	CHKERR(clientSvcId <= MAX_LTP_CLIENT_NBR);
+	buffer = span->buffers + clientSvcId;
+	if (buffer->sessionObj == 0 || buffer->length == 0)
+	{
+		return 0;		/*	Nothing to close.	*/
+	}
+
+	/*	Finish up the session's block so that it can be
+	 *	segmented, then hand it off to ltpmeter and empty
+	 *	the buffer for the client's next block.  The caller
+	 *	must write the span and give bufClosedSemaphore.	*/
+
+	sdr_stage(sdr, (char *) &session, buffer->sessionObj,
+			sizeof(ExportSession));
+	session.clientSvcId = clientSvcId;
+	encodeSdnv(&(session.clientSvcIdSdnv), session.clientSvcId);
+	session.totalLength = buffer->length;
+	session.redPartLength = buffer->redLength;
+	sdr_write(sdr, buffer->sessionObj, (char *) &session,
+			sizeof(ExportSession));
+	if (sdr_list_insert_last(sdr, span->closedBlocks, buffer->sessionObj)
+			== 0)
+	{
+		putErrmsg("Can't close block buffer.", utoa(clientSvcId));
+		return -1;
+	}
+
+	memset((char *) buffer, 0, sizeof(LtpBlockBuffer));
+	return 1;
+}
+
 /*	*	*	LTP event mgt and access functions	*	*/
 
 static Object	insertLtpTimelineEvent(LtpEvent *newEvent)
@@ -1351,7 +1592,9 @@ static Object	insertLtpTimelineEvent(LtpEvent *newEvent)
 	{
 		GET_OBJ_POINTER(ltpSdr, LtpEvent, event, sdr_list_data(ltpSdr,
 				elt));
-		if (event->scheduledTime <= newEvent->scheduledTime)
+		if (event->scheduledTime < newEvent->scheduledTime
+		|| (event->scheduledTime == newEvent->scheduledTime
+			&& event->scheduledUsec <= newEvent->scheduledUsec))
 		{
 			return sdr_list_insert_after(ltpSdr, elt, eventObj);
 		}
@@ -1497,14 +1740,13 @@ int	enqueueNotice(LtpVclient *client, uvast sourceEngineId,
 
 static void	getExportSession(unsigned int sessionNbr, Object *sessionObj)
 {
-	Sdr	ltpSdr = getIonsdr();
-	Object	elt;
+	LtpVexport	*vexport;
 
 	CHKVOID(ionLocked());
-	if (sdr_hash_retrieve(ltpSdr, (_ltpConstants())->exportSessionsHash,
-			(char *) &sessionNbr, (Address *) &elt, NULL) == 1)
+	vexport = findVexport(_ltpvdb(NULL), sessionNbr);
+	if (vexport && !vexport->canceled)
 	{
-		*sessionObj = sdr_list_data(ltpSdr, elt);
+		*sessionObj = vexport->sessionObj;
 		return; 
 	}
 
@@ -1516,23 +1758,15 @@ static void	getExportSession(unsigned int sessionNbr, Object *sessionObj)
 static void	getCanceledExport(unsigned int sessionNbr, Object *sessionObj,
 			Object *sessionElt)
 {
-	Sdr	ltpSdr = getIonsdr();
-		OBJ_POINTER(ExportSession, session);
-	Object	elt;
-	Object	obj;
+	LtpVexport	*vexport;
 
 	CHKVOID(ionLocked());
-	for (elt = sdr_list_first(ltpSdr, (_ltpConstants())->deadExports); elt;
-			elt = sdr_list_next(ltpSdr, elt))
+	vexport = findVexport(_ltpvdb(NULL), sessionNbr);
+	if (vexport && vexport->canceled)
 	{
-		obj = sdr_list_data(ltpSdr, elt);
-		GET_OBJ_POINTER(ltpSdr, ExportSession, session, obj);
-		if (session->sessionNbr == sessionNbr)
-		{
-			*sessionObj = obj;
-			*sessionElt = elt;
-			return;
-		}
+		*sessionObj = vexport->sessionObj;
+		*sessionElt = vexport->sessionElt;
+		return;
 	}
 
 	/*	Not a known canceled export session.			*/
@@ -1541,6 +1775,22 @@ static void	getCanceledExport(unsigned int sessionNbr, Object *sessionObj,
 	*sessionElt = 0;
 }
 
+static void	forgetCanceledExport(unsigned int sessionNbr)
+{
+	LtpVdb		*ltpvdb = _ltpvdb(NULL);
+	LtpVexport	*vexport;
+
+	/*	Only a canceled export session's entry may be dropped
+	 *	here; an active session with the same number must stay
+	 *	indexed until closeExportSession removes it.		*/
+
+	vexport = findVexport(ltpvdb, sessionNbr);
+	if (vexport && vexport->canceled)
+	{
+		deleteVexport(ltpvdb, vexport);
+	}
+}
+
 static void	destroyDataXmitSeg(Object dsElt, Object dsObj, LtpXmitSeg *ds)
 {
 	Sdr	ltpSdr = getIonsdr();
@@ -1622,6 +1872,14 @@ has reception claims", itoa(sdr_list_length(ltpSdr, session->claims)));
 
 	sdr_list_destroy(ltpSdr, session->claims, NULL, NULL);
 	session->claims = 0;
+	for (elt = sdr_list_first(ltpSdr, session->retransmissions); elt;
+			elt = sdr_list_next(ltpSdr, elt))
+	{
+		sdr_free(ltpSdr, sdr_list_data(ltpSdr, elt));
+	}
+
+	sdr_list_destroy(ltpSdr, session->retransmissions, NULL, NULL);
+	session->retransmissions = 0;
 }
 
 static void	closeExportSession(Object sessionObj)
@@ -1636,6 +1894,7 @@ static void	closeExportSession(Object sessionObj)
 	LtpDB		db;
 	Object		elt;
 	Object		sdu;	/*	A ZcoRef object.		*/
+	LtpVexport	*vexport;
 
 	CHKVOID(ionLocked());
 	GET_OBJ_POINTER(ltpSdr, ExportSession, session, sessionObj);
@@ -1687,9 +1946,13 @@ notice.", NULL);
 	 *	list length and thereby possibly enabling a blocked
 	 *	client to append an SDU to the current block.		*/
 
-	sdr_hash_remove(ltpSdr, db.exportSessionsHash,
-			(char *) &(session->sessionNbr), (Address *) &elt);
-	sdr_list_delete(ltpSdr, elt, NULL, NULL);
+	vexport = findVexport(ltpvdb, session->sessionNbr);
+	if (vexport)
+	{
+		sdr_list_delete(ltpSdr, vexport->sessionElt, NULL, NULL);
+		deleteVexport(ltpvdb, vexport);
+	}
+
 	sdr_free(ltpSdr, sessionObj);
 #if LTPDEBUG
 putErrmsg("Closed export session.", itoa(session->sessionNbr));
@@ -2410,8 +2673,117 @@ static void	serializeCancelAckSegment(LtpXmitSeg *segment, char *buf)
 	/*	No content for cancel acknowledgment, just header.	*/
 }
 
-static int	setTimer(LtpTimer *timer, Address timerAddr, time_t currentSec,
-			LtpVspan *vspan, int segmentLength, LtpEvent *event)
+static void	noteRttSample(LtpVspan *vspan, LtpTimer *timer)
+{
+	struct timeval	currentTime;
+	vast		sample;
+	unsigned int	delta;
+
+	/*	Per Karn's algorithm, the response to a segment that
+	 *	has been retransmitted is ambiguous and must not be
+	 *	used as an RTT sample.					*/
+
+	if (timer->expirationCount > 0 || timer->xmitTime.tv_sec == 0)
+	{
+		return;
+	}
+
+	getLtpCurrentTime(&currentTime);
+	sample = ((currentTime.tv_sec - timer->xmitTime.tv_sec) * 1000000)
+			+ (currentTime.tv_usec - timer->xmitTime.tv_usec);
+	if (sample <= 0)
+	{
+		sample = 1;
+	}
+	else if (sample > 0x7fffffff)
+	{
+		sample = 0x7fffffff;
+	}
+
+	if (vspan->rttSamples == 0)
+	{
+		vspan->srtt = sample;
+		vspan->rttvar = sample >> 1;
+	}
+	else
+	{
+		/*	RTTVAR <- 3/4 RTTVAR + 1/4 |SRTT - R'|,
+		 *	then SRTT <- 7/8 SRTT + 1/8 R' (RFC 6298).	*/
+
+		if (vspan->srtt > sample)
+		{
+			delta = vspan->srtt - sample;
+		}
+		else
+		{
+			delta = sample - vspan->srtt;
+		}
+
+		vspan->rttvar = ((3 * (uvast) vspan->rttvar) + delta) >> 2;
+		vspan->srtt = ((7 * (uvast) vspan->srtt) + sample) >> 3;
+	}
+
+	if (vspan->rttSamples < ((unsigned int) -1))
+	{
+		vspan->rttSamples++;
+	}
+}
+
+static void	applyAdaptiveDeadline(LtpTimer *timer, LtpVspan *vspan,
+			int segmentLength)
+{
+	uvast	rto;
+	uvast	interval;
+	uvast	limit;
+	uvast	deadline;
+	int	i;
+
+	/*	RTO = SRTT + max(G, 4 * RTTVAR), doubled for each
+	 *	expiration of this timer so far, plus the time needed
+	 *	to radiate the segment itself.				*/
+
+	rto = 4 * (uvast) vspan->rttvar;
+	if (rto < LTP_CLOCK_TICK)
+	{
+		rto = LTP_CLOCK_TICK;
+	}
+
+	rto += vspan->srtt;
+	if (rto < LTP_MIN_RTO)
+	{
+		rto = LTP_MIN_RTO;
+	}
+
+	limit = ((uvast) (timer->ackDeadline - timer->xmitTime.tv_sec))
+			* 1000000;
+	for (i = 0; i < timer->expirationCount && rto < limit; i++)
+	{
+		rto <<= 1;
+	}
+
+	interval = rto;
+	if (vspan->localXmitRate > 0)
+	{
+		interval += (((uvast) (segmentLength + EST_LINK_OHD))
+				* 1000000) / vspan->localXmitRate;
+	}
+
+	/*	Never wait longer than the configured OWLT-based
+	 *	deadline would have us wait.				*/
+
+	if (interval >= limit)
+	{
+		return;
+	}
+
+	deadline = timer->xmitTime.tv_usec + interval;
+	timer->ackDeadline = timer->xmitTime.tv_sec + (deadline / 1000000);
+	timer->ackDeadlineUsec = deadline % 1000000;
+}
+
+static int	setTimer(LtpTimer *timer, Address timerAddr,
+			struct timeval *currentTime, LtpVspan *vspan,
+			int segmentLength, LtpEvent *event)
 {
 	Sdr	ltpSdr = getIonsdr();
 	LtpDB	ltpdb;
@@ -2437,7 +2809,10 @@ static int	setTimer(LtpTimer *timer, Address timerAddr, time_t currentSec,
 	 *	current transmission rate over this span, plus
 	 *	the current outbound signal propagation time (owlt).	*/
 
-	timer->segArrivalTime = currentSec + radTime + vspan->owltOutbound
+	timer->xmitTime.tv_sec = currentTime->tv_sec;
+	timer->xmitTime.tv_usec = currentTime->tv_usec;
+	timer->segArrivalTime = currentTime->tv_sec + radTime
+			+ vspan->owltOutbound
 			+ ((ltpdb.ownQtime >> 1) & 0x7fffffff);
 	GET_OBJ_POINTER(ltpSdr, LtpSpan, span, sdr_list_data(ltpSdr,
 			vspan->spanElt));
@@ -2462,9 +2837,22 @@ static int	setTimer(LtpTimer *timer, Address timerAddr, time_t currentSec,
 	timer->ackDeadline = timer->segArrivalTime
 			+ span->remoteQtime + vspan->owltInbound
 			+ ((ltpdb.ownQtime >> 1) & 0x7fffffff);
+	timer->ackDeadlineUsec = currentTime->tv_usec;
+
+	/*	Once the actual round-trip time over this span has
+	 *	been measured, the response can be expected much
+	 *	sooner than the configured worst case on a link whose
+	 *	real RTT is well under a second.			*/
+
+	if (vspan->rttSamples > 0)
+	{
+		applyAdaptiveDeadline(timer, vspan, segmentLength);
+	}
+
 	if (vspan->remoteXmitRate > 0)
 	{
 		event->scheduledTime = timer->ackDeadline;
+		event->scheduledUsec = timer->ackDeadlineUsec;
 		if (insertLtpTimelineEvent(event) == 0)
 		{
 			putErrmsg("Can't set timer.", NULL);
@@ -2544,7 +2932,7 @@ static int	readFromExportBlock(char *buffer, Object svcDataObjects,
 	return totalBytesRead;
 }
 
-int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
+static int	dequeueSegment(LtpVspan *vspan, char *buf, int bufLength)
 {
 	Sdr		ltpSdr = getIonsdr();
 	LtpVdb		*ltpvdb = _ltpvdb(NULL);
@@ -2560,14 +2948,14 @@ int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
 	Object		sessionElt;
 			OBJ_POINTER(LtpReceptionClaim, claim);
 	ExportSession	xsessionBuf;
-	time_t		currentTime;
+	struct timeval	currentTime;
 	LtpEvent	event;
 	LtpTimer	*timer;
 	ImportSession	rsessionBuf;
 
-	CHKERR(vspan);
-	CHKERR(buf);
-	*buf = (char *) psp(getIonwm(), vspan->segmentBuffer);
+	/*	A bufLength of zero indicates that buf is the span's
+	 *	own segment buffer, which can hold a max-size segment.	*/
+
 	CHKERR(sdr_begin_xn(ltpSdr));
 	spanObj = sdr_list_data(ltpSdr, vspan->spanElt);
 	sdr_stage(ltpSdr, (char *) &spanBuf, spanObj, sizeof(LtpSpan));
@@ -2628,11 +3016,22 @@ int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
 	if (segment.segmentClass == LtpDataSeg)
 	{
 		segmentLength += segment.pdu.length;
+	}
 
+	if (bufLength > 0 && segmentLength > bufLength)
+	{
+		putErrmsg("Segment is too big for buffer.",
+				itoa(segmentLength));
+		sdr_cancel_xn(ltpSdr);
+		return -1;
+	}
+
+	if (segment.segmentClass == LtpDataSeg)
+	{
 		/*	Load client service data at the end of the
 		 *	segment first, before filling in the header.	*/
 
-		if (readFromExportBlock((*buf) + segment.ohdLength,
+		if (readFromExportBlock(buf + segment.ohdLength,
 				segment.pdu.block, segment.pdu.offset,
 				segment.pdu.length) < 0)
 		{
@@ -2662,7 +3061,7 @@ int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
 
 	/*	Post timeout event as necessary.			*/
 
-	currentTime = getUTCTime();
+	getLtpCurrentTime(&currentTime);
 	event.parm = 0;
 	switch (segment.pdu.segTypeCode)
 	{
@@ -2675,7 +3074,7 @@ int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
 		event.refNbr3 = segment.pdu.ckptSerialNbr;
 		timer = &segment.pdu.timer;
 		if (setTimer(timer, segAddr + FLD_OFFSET(timer, &segment),
-				currentTime, vspan, segmentLength, &event) < 0)
+				&currentTime, vspan, segmentLength, &event) < 0)
 		{
 			putErrmsg("Can't schedule event.", NULL);
 			sdr_cancel_xn(ltpSdr);
@@ -2700,7 +3099,7 @@ int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
 		event.refNbr3 = segment.pdu.rptSerialNbr;
 		timer = &segment.pdu.timer;
 		if (setTimer(timer, segAddr + FLD_OFFSET(timer, &segment),
-				currentTime, vspan, segmentLength, &event) < 0)
+				&currentTime, vspan, segmentLength, &event) < 0)
 		{
 			putErrmsg("Can't schedule event.", NULL);
 			sdr_cancel_xn(ltpSdr);
@@ -2745,7 +3144,7 @@ int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
 		event.refNbr3 = 0;
 		timer = &(xsessionBuf.timer);
 		if (setTimer(timer, sessionObj + FLD_OFFSET(timer,
-				&xsessionBuf), currentTime, vspan,
+				&xsessionBuf), &currentTime, vspan,
 				segmentLength, &event) < 0)
 		{
 			putErrmsg("Can't schedule event.", NULL);
@@ -2782,7 +3181,7 @@ int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
 		event.refNbr3 = 0;
 		timer = &(rsessionBuf.timer);
 		if (setTimer(timer, sessionObj + FLD_OFFSET(timer,
-				&rsessionBuf), currentTime, vspan,
+				&rsessionBuf), &currentTime, vspan,
 				segmentLength, &event) < 0)
 		{
 			putErrmsg("Can't schedule event.", NULL);
@@ -2857,28 +3256,28 @@ int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
 	if (segment.pdu.segTypeCode < 8)
 	{
 		ltpSpanTally(vspan, OUT_SEG_POPPED, segment.pdu.length);
-		serializeDataSegment(&segment, *buf);
+		serializeDataSegment(&segment, buf);
 	}
 	else
 	{
 		switch (segment.pdu.segTypeCode)
 		{
 			case 8:		/*	Report.			*/
-				serializeReportSegment(&segment, *buf);
+				serializeReportSegment(&segment, buf);
 				break;
 
 			case 9:		/*	Report acknowledgment.	*/
-				serializeReportAckSegment(&segment, *buf);
+				serializeReportAckSegment(&segment, buf);
 				break;
 
 			case 12:	/*	Cancel by sender.	*/
 			case 14:	/*	Cancel by receiver.	*/
-				serializeCancelSegment(&segment, *buf);
+				serializeCancelSegment(&segment, buf);
 				break;
 
 			case 13:	/*	Cancel acknowledgment.	*/
 			case 15:	/*	Cancel acknowledgment.	*/
-				serializeCancelAckSegment(&segment, *buf);
+				serializeCancelAckSegment(&segment, buf);
 				break;
 
 			default:
@@ -2901,6 +3300,23 @@ int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
 	return segmentLength;
 }
 
+int	ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf)
+{
+	CHKERR(vspan);
+	CHKERR(buf);
+	*buf = (char *) psp(getIonwm(), vspan->segmentBuffer);
+	return dequeueSegment(vspan, *buf, 0);
+}
+
+int	ltpDequeueOutboundSegmentInto(LtpVspan *vspan, char *buf,
+		int bufLength)
+{
+	CHKERR(vspan);
+	CHKERR(buf);
+	CHKERR(bufLength > 0);
+	return dequeueSegment(vspan, buf, bufLength);
+}
+
 /*	*	Control segment construction functions		*	*/
 
 static void	signalLso(unsigned int engineId)
@@ -2988,6 +3404,9 @@ static int	cancelSessionBySender(ExportSession *session,
 	PsmAddress	vspanElt;
 	Object		elt;
 	Object		sdu;	/*	A ZcoRef object.		*/
+	LtpBlockBuffer	*buffer = NULL;
+	LtpVexport	*vexport;
+	int		i;
 
 	CHKERR(ionLocked());
 	session->reasonCode = reasonCode;	/*	(For CS resend.)*/
@@ -2999,14 +3418,36 @@ static int	cancelSessionBySender(ExportSession *session,
 		return -1;
 	}
 
-	if (sessionObj == span.currentExportSessionObj)
+	for (i = 0; i < LTP_MAX_NBR_OF_CLIENTS; i++)
 	{
-		/*	Finish up session so it can be reported.	*/
+		if (span.buffers[i].sessionObj == sessionObj)
+		{
+			buffer = span.buffers + i;
+
+			/*	Finish up session so it can be reported.*/
 
-		session->clientSvcId = span.clientSvcIdOfBufferedBlock;
-		encodeSdnv(&(session->clientSvcIdSdnv), session->clientSvcId);
-		session->totalLength = span.lengthOfBufferedBlock;
-		session->redPartLength = span.redLengthOfBufferedBlock;
+			session->clientSvcId = i;
+			encodeSdnv(&(session->clientSvcIdSdnv),
+					session->clientSvcId);
+			session->totalLength = buffer->length;
+			session->redPartLength = buffer->redLength;
+			break;
+		}
+	}
+
+	if (buffer == NULL)
+	{
+		/*	Block might be closed but not yet segmented.	*/
+
+		for (elt = sdr_list_first(ltpSdr, span.closedBlocks); elt;
+				elt = sdr_list_next(ltpSdr, elt))
+		{
+			if (sdr_list_data(ltpSdr, elt) == sessionObj)
+			{
+				sdr_list_delete(ltpSdr, elt, NULL, NULL);
+				break;
+			}
+		}
 	}
 
 	if (ltpvdb->watching & WATCH_CS)
@@ -3040,47 +3481,36 @@ static int	cancelSessionBySender(ExportSession *session,
 	/*	Remove session from active sessions pool, so that the
 	 *	cancellation won't affect flow control.			*/
 
-	sdr_hash_remove(ltpSdr, db.exportSessionsHash,
-			(char *) &(session->sessionNbr), (Address *) &elt);
-	sdr_list_delete(ltpSdr, elt, NULL, NULL);
+	vexport = findVexport(ltpvdb, session->sessionNbr);
+	if (vexport)
+	{
+		sdr_list_delete(ltpSdr, vexport->sessionElt, NULL, NULL);
 
-	/*	Insert into list of canceled sessions instead.		*/
+		/*	Insert into list of canceled sessions instead.	*/
 
-	elt = sdr_list_insert_last(ltpSdr, db.deadExports, sessionObj);
+		vexport->sessionElt = sdr_list_insert_last(ltpSdr,
+				db.deadExports, sessionObj);
+		vexport->canceled = 1;
+	}
 
 	/*	Span now has room for another session to start.		*/
 
-	if (sessionObj == span.currentExportSessionObj)
+	if (buffer)
 	{
-		/*	Reinitialize span's block buffer.		*/
+		/*	Reinitialize client's block buffer; the next
+		 *	SDU sent will start a new export session.	*/
 
-		span.ageOfBufferedBlock = 0;
-		span.lengthOfBufferedBlock = 0;
-		span.redLengthOfBufferedBlock = 0;
-		span.clientSvcIdOfBufferedBlock = 0;
-		span.currentExportSessionObj = 0;
-		sdr_write(ltpSdr, spanObj, (char *) &span, sizeof(LtpSpan));
+		memset((char *) buffer, 0, sizeof(LtpBlockBuffer));
+	}
 
-		/*	Re-start the current export session.		*/
+	sdr_write(ltpSdr, spanObj, (char *) &span, sizeof(LtpSpan));
 
-		if (startExportSession(ltpSdr, spanObj, vspan) < 0)
-		{
-			putErrmsg("Can't re-start the current session.",
-					utoa(span.engineId));
-			return -1;
-		}
-	}
-	else
-	{
-		/*	The canceled session isn't the current
-		 *	session, but cancelling this session
-		 *	reduced the session list length, possibly
-		 *	enabling a blocked client to append an SDU
-		 *	to the current block.				*/
+	/*	Cancelling this session reduced the session list
+	 *	length, possibly enabling a blocked client to start
+	 *	a new block.						*/
 
-		sm_SemGive(vspan->bufOpenRedSemaphore);
-		sm_SemGive(vspan->bufOpenGreenSemaphore);
-	}
+	sm_SemGive(vspan->bufOpenRedSemaphore);
+	sm_SemGive(vspan->bufOpenGreenSemaphore);
 
 	/*	Finally, inform receiver of cancellation.		*/
 
@@ -4981,6 +5411,170 @@ putErrmsg("Discarding stray segment.", itoa(sessionNbr));
 	}
 }
 
+static void	retireRetransmissions(ExportSession *session,
+			unsigned int rptSerialNbr)
+{
+	Sdr		ltpSdr = getIonsdr();
+	Object		elt;
+	Object		nextElt;
+	Object		rexmitObj;
+			OBJ_POINTER(LtpRexmit, rexmit);
+
+	/*	A report citing a checkpoint that ended the
+	 *	retransmission triggered by report N covers all
+	 *	data retransmitted in response to report N and all
+	 *	earlier reports: none of it is in flight any more.	*/
+
+	for (elt = sdr_list_first(ltpSdr, session->retransmissions); elt;
+			elt = nextElt)
+	{
+		nextElt = sdr_list_next(ltpSdr, elt);
+		rexmitObj = sdr_list_data(ltpSdr, elt);
+		GET_OBJ_POINTER(ltpSdr, LtpRexmit, rexmit, rexmitObj);
+		if (((int) (rptSerialNbr - rexmit->rptSerialNbr)) >= 0)
+		{
+			sdr_free(ltpSdr, rexmitObj);
+			sdr_list_delete(ltpSdr, elt, NULL, NULL);
+		}
+	}
+}
+
+static int	coalesceRetransmissions(ExportSession *session, LtpSpan *span,
+			Lyst extents, unsigned int rptSerialNbr)
+{
+	Sdr		ltpSdr = getIonsdr();
+	unsigned int	maxPayload;
+	LystElt		elt;
+	LystElt		nextElt;
+	ExportExtent	*extent;
+	ExportExtent	*nextExtent;
+	unsigned int	extentEnd;
+	Object		elt2;
+	Object		rexmitObj;
+			OBJ_POINTER(LtpRexmit, rexmit);
+	LtpRexmit	rexmitBuf;
+	unsigned int	rexmitEnd;
+
+	/*	First bridge each pair of adjacent gaps that together
+	 *	fit in a single worst-case data segment, so that the
+	 *	retransmission is batched into the smallest number of
+	 *	maximally sized segments.  (The bridged bytes have
+	 *	been received already, but resending them is cheaper
+	 *	than sending the overhead of one more segment.)	The
+	 *	worst-case overhead includes SDNV-encoded offset and
+	 *	length and both checkpoint and report serial numbers.	*/
+
+	maxPayload = 1 + (_ltpConstants())->ownEngineIdSdnv.length
+			+ session->sessionNbrSdnv.length + 1
+			+ session->clientSvcIdSdnv.length + 5 + 5 + 10 + 10;
+	if (span->maxSegmentSize > maxPayload)
+	{
+		maxPayload = span->maxSegmentSize - maxPayload;
+		elt = lyst_first(extents);
+		while (elt && (nextElt = lyst_next(elt)) != NULL)
+		{
+			extent = (ExportExtent *) lyst_data(elt);
+			nextExtent = (ExportExtent *) lyst_data(nextElt);
+			extentEnd = nextExtent->offset + nextExtent->length;
+			if (extentEnd - extent->offset > maxPayload)
+			{
+				elt = nextElt;
+				continue;
+			}
+
+			extent->length = extentEnd - extent->offset;
+			MRELEASE(nextExtent);
+			lyst_delete(nextElt);
+		}
+	}
+
+	/*	Next remove from the retransmission extents all data
+	 *	that has already been retransmitted in response to
+	 *	other reports and is still in flight, so that no byte
+	 *	is retransmitted more than once per checkpoint round.	*/
+
+	for (elt2 = sdr_list_first(ltpSdr, session->retransmissions); elt2;
+			elt2 = sdr_list_next(ltpSdr, elt2))
+	{
+		GET_OBJ_POINTER(ltpSdr, LtpRexmit, rexmit,
+				sdr_list_data(ltpSdr, elt2));
+		rexmitEnd = rexmit->offset + rexmit->length;
+		for (elt = lyst_first(extents); elt; elt = nextElt)
+		{
+			nextElt = lyst_next(elt);
+			extent = (ExportExtent *) lyst_data(elt);
+			extentEnd = extent->offset + extent->length;
+			if (rexmitEnd <= extent->offset
+			|| rexmit->offset >= extentEnd)
+			{
+				continue;	/*	No overlap.	*/
+			}
+
+			if (rexmit->offset <= extent->offset)
+			{
+				if (rexmitEnd >= extentEnd)
+				{
+					/*	Entirely in flight.	*/
+
+					MRELEASE(extent);
+					lyst_delete(elt);
+					continue;
+				}
+
+				/*	Head of extent is in flight.	*/
+
+				extent->offset = rexmitEnd;
+				extent->length = extentEnd - rexmitEnd;
+				continue;
+			}
+
+			/*	Tail of extent, or some portion in the
+			 *	middle of it, is in flight.		*/
+
+			extent->length = rexmit->offset - extent->offset;
+			if (rexmitEnd < extentEnd)
+			{
+				nextExtent = (ExportExtent *)
+					MTAKE(sizeof(ExportExtent));
+				if (nextExtent == NULL
+				|| lyst_insert_after(elt, nextExtent) == NULL)
+				{
+					putErrmsg("Can't split extent.", NULL);
+					return -1;
+				}
+
+				nextExtent->offset = rexmitEnd;
+				nextExtent->length = extentEnd - rexmitEnd;
+				nextElt = lyst_next(elt);
+			}
+		}
+	}
+
+	/*	Finally, note that the remaining extents are now in
+	 *	flight.							*/
+
+	rexmitBuf.rptSerialNbr = rptSerialNbr;
+	for (elt = lyst_first(extents); elt; elt = lyst_next(elt))
+	{
+		extent = (ExportExtent *) lyst_data(elt);
+		rexmitBuf.offset = extent->offset;
+		rexmitBuf.length = extent->length;
+		rexmitObj = sdr_malloc(ltpSdr, sizeof(LtpRexmit));
+		if (rexmitObj == 0
+		|| sdr_list_insert_last(ltpSdr, session->retransmissions,
+				rexmitObj) == 0)
+		{
+			putErrmsg("Can't note retransmission.", NULL);
+			return -1;
+		}
+
+		sdr_write(ltpSdr, rexmitObj, (char *) &rexmitBuf,
+				sizeof(LtpRexmit));
+	}
+
+	return 0;
+}
+
 static int	handleRS(LtpDB *ltpdb, unsigned int sessionNbr,
 			LtpRecvSeg *segment, LtpPdu *pdu, char **cursor,
 			int *bytesRemaining)
@@ -5123,8 +5717,22 @@ putErrmsg("Discarding report.", NULL);
 		 *	retransmit it.					*/
 
 		sdr_stage(ltpSdr, (char *) &dsBuf, dsObj, sizeof(LtpXmitSeg));
+		if (dsBuf.pdu.timer.segArrivalTime != 0)
+		{
+			noteRttSample(vspan, &dsBuf.pdu.timer);
+		}
+
 		dsBuf.pdu.timer.segArrivalTime = 0;
 		sdr_write(ltpSdr, dsObj, (char *) &dsBuf, sizeof(LtpXmitSeg));
+
+		/*	All data retransmitted ahead of the cited
+		 *	checkpoint is accounted for by this report.	*/
+
+		if (dsBuf.pdu.rptSerialNbr != 0)
+		{
+			retireRetransmissions(&sessionBuf,
+					dsBuf.pdu.rptSerialNbr);
+		}
 	}
 
 	/*	Now apply reception claims to the transmission session.	*/
@@ -5429,8 +6037,17 @@ putErrmsg(buf, itoa(sessionBuf.sessionNbr));
 
 	lyst_destroy(claims);
 
-	/*	List of retransmission extents is now complete;
-	 *	retransmit data as needed.  				*/
+	/*	List of gaps in reception is now complete; consolidate
+	 *	it with the data that are already being retransmitted
+	 *	and then retransmit data as needed.			*/
+
+	if (coalesceRetransmissions(&sessionBuf, &spanBuf, extents,
+			rptSerialNbr) < 0)
+	{
+		putErrmsg("Can't coalesce retransmissions.", NULL);
+		sdr_cancel_xn(ltpSdr);
+		return -1;
+	}
 
 	if (issueSegments(ltpSdr, &spanBuf, vspan, &sessionBuf, sessionObj,
 			extents, rptSerialNbr) < 0)
@@ -5532,6 +6149,7 @@ putErrmsg("Discarding stray segment.", itoa(sessionNbr));
 		 *	detection of session closure opportunity easy.	*/
 
 		GET_OBJ_POINTER(ltpSdr, LtpXmitSeg, rs, rsObj);
+		noteRttSample(vspan, &rs->pdu.timer);
 		destroyRsXmitSeg(elt, rsObj, rs);
 		if (session.redPartLength > 0	/*	EORP received.	*/
 		&& session.redPartReceived == session.redPartLength)
@@ -5678,6 +6296,7 @@ putErrmsg("Handling ack of cancel by sender.", utoa(sessionNbr));
 
 	sdr_list_delete(ltpSdr, sessionElt, NULL, NULL);
 	sdr_free(ltpSdr, sessionObj);
+	forgetCanceledExport(sessionNbr);
 	if (sdr_end_xn(ltpSdr) < 0)
 	{
 		putErrmsg("Can't handle ack of cancel by source.", NULL);
@@ -6250,6 +6869,7 @@ static int	resumeTimer(time_t resumeTime, LtpTimer *timer,
 	event.refNbr3 = refNbr3;
 	event.parm = 0;
 	event.scheduledTime = timer->ackDeadline;
+	event.scheduledUsec = timer->ackDeadlineUsec;
 	if (insertLtpTimelineEvent(&event) == 0)
 	{
 		putErrmsg("Can't insert timeout event.", NULL);
@@ -6543,6 +7163,7 @@ putErrmsg("Retransmission limit exceeded.", itoa(sessionNbr));
 #endif
 		sdr_list_delete(ltpSdr, sessionElt, NULL, NULL);
 		sdr_free(ltpSdr, sessionObj);
+		forgetCanceledExport(sessionNbr);
 	}
 	else	/*	Haven't given up yet.				*/
 	{
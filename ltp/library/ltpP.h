@@ -36,6 +36,25 @@ extern "C" {
 #define MAX_CLAIMS_PER_RS	20
 #define	MAX_TIMEOUTS		2
 
+/*	Checkpoint and report timers are armed at microsecond
+ *	resolution from the span's measured round-trip time, but
+ *	are never armed later than the deadline computed from
+ *	the configured one-way light times and queuing latencies.
+ *	LTP_CLOCK_TICK is the shortest interval (in microseconds)
+ *	for which ltpclock sleeps between dispatches of timeline
+ *	events, i.e., the clock granularity G of RFC 6298; when no
+ *	event is due within the current second, ltpclock sleeps
+ *	until the next second begins.  LTP_MIN_RTO is the floor for
+ *	the adaptive retransmission timeout.				*/
+
+#ifndef LTP_CLOCK_TICK
+#define	LTP_CLOCK_TICK		10000
+#endif
+
+#ifndef LTP_MIN_RTO
+#define	LTP_MIN_RTO		(2 * LTP_CLOCK_TICK)
+#endif
+
 /*	LTP segment structure definitions.				*/
 
 typedef struct
@@ -75,6 +94,8 @@ typedef struct
 {
 	time_t			segArrivalTime;
 	time_t			ackDeadline;
+	unsigned int		ackDeadlineUsec;
+	struct timeval		xmitTime;	/*	For RTT sampling.	*/
 	int			expirationCount;
 	LtpTimerState		state;
 } LtpTimer;
@@ -247,6 +268,7 @@ typedef struct
 	Object		svcDataObjects;	/*	SDR list of ZCOs	*/
 	Object		claims;		/*	reception claims list	*/
 	Object		checkpoints;	/*	SDR list of LtpCkpts	*/
+	Object		retransmissions;/*	SDR list: LtpRexmit	*/
 
 	/*	Segments are retained in these lists only up to the
 	 *	time of initial transmission, and only to support
@@ -263,6 +285,20 @@ typedef struct
 	unsigned int	length;
 } ExportExtent;
 
+/*	An LtpRexmit records an extent of an export session's red
+ *	data that has been retransmitted in response to a report and
+ *	is presumed to be still in flight.  That extent is not
+ *	retransmitted again in response to any other report until
+ *	a report citing the checkpoint that ended the retransmission
+ *	(or a later one) has been received.				*/
+
+typedef struct
+{
+	unsigned int	offset;
+	unsigned int	length;
+	unsigned int	rptSerialNbr;	/*	Report that caused it.	*/
+} LtpRexmit;
+
 /* Timeline event structure */
 
 typedef enum
@@ -281,9 +317,25 @@ typedef struct
 	unsigned int	refNbr3;	/*	Serial number.		*/
 	Object		parm;		/*	Non-specific use.	*/
 	time_t		scheduledTime;	/*	Seconds since Jan 1970.	*/
+	unsigned int	scheduledUsec;	/*	Past scheduledTime.	*/
 	LtpEventType	type;
 } LtpEvent;
 
+/* Block buffer structure.  Outbound service data units are aggregated
+ * into blocks concurrently, one block buffer per client service, so
+ * that each client's block is closed independently of all others.  A
+ * closed block is moved to the span's closedBlocks list for segmentation
+ * by ltpmeter and the buffer is immediately made available for the
+ * client's next block. */
+
+typedef struct
+{
+	Object		sessionObj;	/*	0 if no block started.	*/
+	unsigned int	age;		/*	Seconds.		*/
+	unsigned int	length;		/*	Bytes.			*/
+	unsigned int	redLength;	/*	Bytes.			*/
+} LtpBlockBuffer;
+
 /* Span structure characterizing the communication span between the
  * local engine and some remote engine.  Note that a single LTP span
  * might be serviced by multiple communication links, e.g., simultaneous
@@ -304,11 +356,8 @@ typedef struct
 	Object		stats;		/*	LtpSpanStats address.	*/
 	int		updateStats;	/*	Boolean.		*/
 
-	Object		currentExportSessionObj;
-	unsigned int	ageOfBufferedBlock;
-	unsigned int	lengthOfBufferedBlock;
-	unsigned int	redLengthOfBufferedBlock;
-	unsigned int	clientSvcIdOfBufferedBlock;
+	LtpBlockBuffer	buffers[LTP_MAX_NBR_OF_CLIENTS];
+	Object		closedBlocks;	/*	SDR list: ExportSession	*/
 
 	Object		exportSessions;	/*	SDR list: ExportSession	*/
 	Object		segments;	/*	SDR list: LtpXmitSeg	*/
@@ -367,6 +416,13 @@ typedef struct
 	unsigned int	receptionRate;	/*	Bytes per second.	*/
 	unsigned int	owltInbound;	/*	In seconds.		*/
 	unsigned int	owltOutbound;	/*	In seconds.		*/
+
+	/*	Round-trip time estimation per RFC 6298, from samples
+	 *	taken on checkpoint/RS and RS/RA exchanges.		*/
+
+	unsigned int	rttSamples;	/*	0 until first sample.	*/
+	unsigned int	srtt;		/*	In microseconds.	*/
+	unsigned int	rttvar;		/*	In microseconds.	*/
 	int		meterPid;	/*	For stopping ltpmeter.	*/
 	int		lsoPid;		/*	For stopping the LSO.	*/
 	PsmAddress	importSessions;	/*	RBT of VImportSessions	*/
@@ -382,17 +438,17 @@ typedef struct
 	PsmAddress	segmentBuffer;	/*	Holds one max-size seg.	*/
 
 	/*	The bufOpenRedSemaphore and bufOpenGreenSemaphore
-	 *	of an LtpVspan are given by the span's ltpmeter task
-	 *	upon construction of a new export session, or by the
-	 *	ltpclo task upon cancellation of an export session.
-	 *	This signifies that it may now be possible to begin
-	 *	or, if halted, resume the aggregation of service
-	 *	client data objects in this session's block.  The
-	 *	ltp_send function takes this semaphore when it
-	 *	determines that its client service data object
-	 *	cannot be appended to the current export session's
-	 *	block, for some reason, so it must wait for the
-	 *	block to be reopened.  The rules for appending an
+	 *	of an LtpVspan are given upon closure or cancellation
+	 *	of an export session, and upon resumption of
+	 *	transmission on the span.  This signifies that it may
+	 *	now be possible to begin or, if halted, resume the
+	 *	aggregation of service client data objects in a new
+	 *	block.  The ltp_send function takes this semaphore
+	 *	when it determines that its client service data object
+	 *	cannot be appended to its client's block buffer, for
+	 *	some reason (i.e., the span's export session limit
+	 *	has been reached), so it must wait for the block to
+	 *	be reopened.  The rules for appending an
 	 *	SDU to a block differ depending on whether or not
 	 *	the SDU contains any "red" data; ltp_send will take
 	 *	the bufOpenRedSemaphore if its SDU's red length is
@@ -402,21 +458,22 @@ typedef struct
 	sm_SemId	bufOpenGreenSemaphore;
 
 	/*	The bufClosedSemaphore of an LtpVspan is given by
-	 *	the LtpSend function every time the appending of a
-	 *	client service data unit to the list of service data
-	 *	objects for the current export session causes the
-	 *	aggregate length of data buffered in that session to
-	 *	reach the nominal block size for the span.  This
-	 *	signifies that the session is ready for transmission.
-	 *	(This semaphore is also given by the ltpclock task
-	 *	when the aggregate length of data buffered has been
-	 *	non-zero for aggrTimeLimit seconds.  This serves to
-	 *	prevent a partially filled session buffer from
+	 *	the ltp_send function every time the appending of a
+	 *	client service data unit to one of the span's block
+	 *	buffers causes the aggregate length of data buffered
+	 *	in that block to reach the nominal block size for the
+	 *	span (or causes the block to contain green data), at
+	 *	which point the block is moved to the span's list of
+	 *	closed blocks.  This signifies that the session is
+	 *	ready for transmission.  (This semaphore is also given
+	 *	by the ltpclock task when a block buffer's aggregate
+	 *	length has been non-zero for aggrTimeLimit seconds.
+	 *	This serves to prevent a partially filled block from
 	 *	remaining untransmitted indefinitely after the end
 	 *	of a period of client service activity.)  The span's
 	 *	ltpmeter task takes this semaphore before proceeding
-	 *	to segment the current outbound block and append
-	 *	its segments to the span's segments queue.		*/
+	 *	to segment all closed blocks and append their
+	 *	segments to the span's segments queue.			*/
 
 	sm_SemId	bufClosedSemaphore;
 
@@ -468,18 +525,18 @@ typedef struct
 	uvast		ownEngineId;
 	Sdnv		ownEngineIdSdnv;
 
-	/*	estMaxExportSessions is used to compute the number
-	 *	of rows in the export sessions hash table in the LTP
-	 *	database.  If the summation of maxExportSessions over
-	 *	all spans exceeds estMaxExportSessions, LTP export
-	 *	session lookup performance may be compromised.		*/
+	/*	estMaxExportSessions is used to compute the initial
+	 *	size of the volatile export sessions table in the
+	 *	LTP volatile database.  If the summation of
+	 *	maxExportSessions over all spans exceeds
+	 *	estMaxExportSessions, the table is enlarged as
+	 *	necessary.						*/
 
 	int		estMaxExportSessions;
 	unsigned int	ownQtime;
 	unsigned int	enforceSchedule;/*	Boolean.		*/
 	LtpClient	clients[LTP_MAX_NBR_OF_CLIENTS];
 	unsigned int	sessionCount;
-	Object		exportSessionsHash;
 	Object		deadExports;	/*	SDR list: ExportSession	*/
 	Object		spans;		/*	SDR list: LtpSpan	*/
 	Object		timeline;	/*	SDR list: LtpEvent	*/
@@ -504,6 +561,24 @@ typedef struct
 #define WATCH_resendCP		(4096)
 #define WATCH_resendRS		(8192)
 
+/*	An LtpVexport is the entry for a single export session in the
+ *	volatile export sessions table, an open-addressed hash table in
+ *	ION working memory whose size is always a power of 2.  Each
+ *	session's entry is sought starting at the slot indexed by its
+ *	session number modulo the size of the table; since session
+ *	numbers are assigned sequentially, the entries for the sessions
+ *	that are currently open seldom collide.  The table is rebuilt
+ *	from the exportSessions lists of all spans, and the deadExports
+ *	list, whenever the LTP volatile database is raised.		*/
+
+typedef struct
+{
+	Object		sessionObj;	/*	0 if slot is empty.	*/
+	Object		sessionElt;	/*	In span or deadExports.	*/
+	unsigned int	sessionNbr;
+	int		canceled;	/*	Boolean.		*/
+} LtpVexport;
+
 typedef struct
 {
 	uvast		ownEngineId;
@@ -512,6 +587,9 @@ typedef struct
 	int		watching;	/*	Boolean activity watch.	*/
 	PsmAddress	spans;		/*	SM list: LtpVspan*	*/
 	LtpVclient	clients[LTP_MAX_NBR_OF_CLIENTS];
+	PsmAddress	exports;	/*	Array of LtpVexport	*/
+	unsigned int	exportsMask;	/*	Table size minus 1.	*/
+	unsigned int	exportsCount;	/*	Occupied slots.		*/
 } LtpVdb;
 
 extern int		ltpInit(int estMaxExportSessions);
@@ -526,6 +604,8 @@ extern Object		getLtpDbObject();
 extern LtpDB		*getLtpConstants();
 extern LtpVdb		*getLtpVdb();
 
+extern void		getLtpCurrentTime(struct timeval *currentTime);
+
 extern void		findSpan(uvast engineId, LtpVspan **vspan,
 				PsmAddress *vspanElt);
 extern int		addSpan(uvast engineId,
@@ -548,8 +628,10 @@ extern void		checkReservationLimit();
 extern int		ltpStartSpan(uvast engineId);
 extern void		ltpStopSpan(uvast engineId);
 
+extern int		closeBlockBuffer(Sdr sdr, LtpSpan *span,
+				unsigned int clientSvcId);
 extern int		startExportSession(Sdr sdr, Object spanObj,
-				LtpVspan *vspan);
+				unsigned int clientSvcId);
 extern int		issueSegments(Sdr sdr, LtpSpan *span, LtpVspan *vspan,
 				ExportSession *session, Object sessionObj,
 				Lyst extents, unsigned int reportSerialNbr);
@@ -568,6 +650,8 @@ extern int		enqueueNotice(LtpVclient *client,
 				Object data);
 
 extern int		ltpDequeueOutboundSegment(LtpVspan *vspan, char **buf);
+extern int		ltpDequeueOutboundSegmentInto(LtpVspan *vspan,
+				char *buf, int bufLength);
 extern int		ltpHandleInboundSegment(char *buf, int length);
 
 extern void		ltpStartXmit(LtpVspan *vspan);
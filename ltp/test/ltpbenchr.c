@@ -0,0 +1,475 @@
+/*
+	ltpbenchr.c:	receiver for LTP engine benchmark.  Receives
+			the service data units sent by ltpbenchs and
+			prints goodput, per-block latency percentiles,
+			and SDR transaction and CPU overhead figures.
+
+			Each red part delivered to ltpbenchr may
+			contain multiple aggregated service data units,
+			each of which begins with the 16-byte header
+			described in ltpbenchs.c.  For an all-green
+			block, latency is measured upon arrival of the
+			green segment that carries the header, at
+			block offset zero.
+									*/
+/*									*/
+/*	Copyright (c) 2026, California Institute of Technology.		*/
+/*	All rights reserved.						*/
+/*									*/
+
+#include "platform.h"
+#include "zco.h"
+#include "ltpP.h"
+
+#define	LTPBENCH_HDR_LEN	(16)
+
+static int	_running(int *newState)
+{
+	static int	state = 1;
+
+	if (newState)
+	{
+		state = *newState;
+	}
+
+	return state;
+}
+
+static int	_clientId(int *newId)
+{
+	static int	id = 0;
+
+	if (newId)
+	{
+		id = *newId;
+	}
+
+	return id;
+}
+
+static int	_idleLimit(int *newLimit)
+{
+	static int	limit = 10;
+
+	if (newLimit)
+	{
+		limit = *newLimit;
+	}
+
+	return limit;
+}
+
+static int	_secondsIdle(int increment)
+{
+	static int	count = 0;
+
+	if (increment)
+	{
+		count += increment;
+	}
+	else
+	{
+		count = 0;
+	}
+
+	return count;
+}
+
+static void	handleQuit()
+{
+	int	stop = 0;
+
+	oK(_running(&stop));
+	ltp_interrupt(_clientId(NULL));
+}
+
+static int	checkIdle(void *userData)
+{
+	/*	Stop if nothing has been received for the idle limit,
+	 *	e.g., because some blocks were lost to injected loss
+	 *	of green data or to cancellation.			*/
+
+	if (_secondsIdle(1) > _idleLimit(NULL))
+	{
+		handleQuit();
+	}
+
+	return 0;
+}
+
+static double	elapsedUsec(struct timeval *from, struct timeval *to)
+{
+	return ((to->tv_sec - from->tv_sec) * 1000000.0)
+			+ (to->tv_usec - from->tv_usec);
+}
+
+static double	cpuUsec()
+{
+#if defined (VXWORKS) || defined (RTEMS) || defined (mingw)
+	return -1.0;
+#else
+	struct rusage	usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) < 0)
+	{
+		return -1.0;
+	}
+
+	return ((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000.0)
+			+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+static int	compareLatencies(const void *a, const void *b)
+{
+	double	la = *((const double *) a);
+	double	lb = *((const double *) b);
+
+	return (la < lb ? -1 : (la > lb ? 1 : 0));
+}
+
+typedef struct
+{
+	int		sdusExpected;
+	int		sdusReceived;
+	int		blocksReceived;
+	double		bytesReceived;
+	double		*latencies;	/*	In microseconds.	*/
+	struct timeval	firstSendTime;
+	struct timeval	lastArrivalTime;
+} BenchState;
+
+static int	noteSdu(BenchState *bench, unsigned char *hdr,
+			struct timeval *arrivalTime)
+{
+	unsigned int	fields[4];
+	int		i;
+	struct timeval	sendTime;
+
+	for (i = 0; i < 4; i++)
+	{
+		memcpy((char *) (fields + i), hdr + (i * 4), 4);
+		fields[i] = ntohl(fields[i]);
+	}
+
+	if (fields[1] <= LTPBENCH_HDR_LEN)
+	{
+		return -1;		/*	Not an ltpbenchs SDU.	*/
+	}
+
+	sendTime.tv_sec = fields[2];
+	sendTime.tv_usec = fields[3];
+	if (bench->sdusReceived == 0
+	|| elapsedUsec(&sendTime, &bench->firstSendTime) > 0.0)
+	{
+		bench->firstSendTime.tv_sec = sendTime.tv_sec;
+		bench->firstSendTime.tv_usec = sendTime.tv_usec;
+	}
+
+	if (bench->sdusReceived < bench->sdusExpected)
+	{
+		bench->latencies[bench->sdusReceived] =
+				elapsedUsec(&sendTime, arrivalTime);
+	}
+
+	bench->sdusReceived++;
+	return fields[1];
+}
+
+static int	handleRedPart(BenchState *bench, Object data,
+			unsigned int dataLength, struct timeval *arrivalTime)
+{
+	Sdr		sdr = getIonsdr();
+	ZcoReader	reader;
+	unsigned char	hdr[LTPBENCH_HDR_LEN];
+	unsigned int	bytesRemaining = dataLength;
+	int		sduLength;
+
+	/*	Walk the (possibly aggregated) block, noting the
+	 *	header of each service data unit and skipping over
+	 *	the rest of it.						*/
+
+	CHKERR(sdr_begin_xn(sdr));
+	zco_start_receiving(data, &reader);
+	while (bytesRemaining > LTPBENCH_HDR_LEN)
+	{
+		if (zco_receive_source(sdr, &reader, LTPBENCH_HDR_LEN,
+				(char *) hdr) != LTPBENCH_HDR_LEN)
+		{
+			break;
+		}
+
+		sduLength = noteSdu(bench, hdr, arrivalTime);
+		if (sduLength < 0 || sduLength > bytesRemaining)
+		{
+			break;
+		}
+
+		if (zco_receive_source(sdr, &reader,
+				sduLength - LTPBENCH_HDR_LEN, NULL) < 0)
+		{
+			break;
+		}
+
+		bytesRemaining -= sduLength;
+	}
+
+	sdr_exit_xn(sdr);
+	bench->bytesReceived += dataLength;
+	return 0;
+}
+
+static int	handleGreenSegment(BenchState *bench, Object data,
+			unsigned int dataOffset, unsigned int dataLength,
+			struct timeval *arrivalTime)
+{
+	Sdr		sdr = getIonsdr();
+	ZcoReader	reader;
+	unsigned char	hdr[LTPBENCH_HDR_LEN];
+	vast		len;
+
+	bench->bytesReceived += dataLength;
+	if (dataOffset != 0 || dataLength < LTPBENCH_HDR_LEN)
+	{
+		return 0;
+	}
+
+	CHKERR(sdr_begin_xn(sdr));
+	zco_start_receiving(data, &reader);
+	len = zco_receive_source(sdr, &reader, LTPBENCH_HDR_LEN, (char *) hdr);
+	sdr_exit_xn(sdr);
+	if (len == LTPBENCH_HDR_LEN)
+	{
+		oK(noteSdu(bench, hdr, arrivalTime));
+	}
+
+	return 0;
+}
+
+static void	printPercentile(char *label, double *latencies, int count,
+			int percentile)
+{
+	int	i;
+	char	buf[64];
+
+	i = ((count * percentile) + 99) / 100;
+	if (i > 0)
+	{
+		i--;
+	}
+
+	isprintf(buf, sizeof buf, "%.3f", latencies[i] / 1000.0);
+	PUTMEMO(label, buf);
+}
+
+static void	printResults(BenchState *bench, unsigned long xnCount,
+			double cpu, int sessionsCanceled)
+{
+	int	count;
+	double	usec;
+	char	buf[128];
+
+	PUTMEMO("SDUs received", itoa(bench->sdusReceived));
+	PUTMEMO("Blocks received", itoa(bench->blocksReceived));
+	isprintf(buf, sizeof buf, "%.0f", bench->bytesReceived);
+	PUTMEMO("Bytes received", buf);
+	PUTMEMO("Sessions canceled", itoa(sessionsCanceled));
+	if (bench->sdusReceived == 0)
+	{
+		return;
+	}
+
+	usec = elapsedUsec(&bench->firstSendTime, &bench->lastArrivalTime);
+	isprintf(buf, sizeof buf, "%.3f", usec / 1000000.0);
+	PUTMEMO("Elapsed time (seconds)", buf);
+	if (usec > 0.0)
+	{
+		isprintf(buf, sizeof buf, "%.3f",
+				(bench->bytesReceived * 8.0) / usec);
+		PUTMEMO("Goodput (Mbps)", buf);
+	}
+
+	count = bench->sdusReceived;
+	if (count > bench->sdusExpected)
+	{
+		count = bench->sdusExpected;
+	}
+
+	qsort(bench->latencies, count, sizeof(double), compareLatencies);
+	printPercentile("Latency p50 (msec)", bench->latencies, count, 50);
+	printPercentile("Latency p90 (msec)", bench->latencies, count, 90);
+	printPercentile("Latency p99 (msec)", bench->latencies, count, 99);
+	printPercentile("Latency max (msec)", bench->latencies, count, 100);
+	if (bench->blocksReceived > 0)
+	{
+		isprintf(buf, sizeof buf, "%.2f",
+				((double) xnCount) / bench->blocksReceived);
+		PUTMEMO("SDR transactions per block (receiver)", buf);
+	}
+
+	if (cpu >= 0.0 && bench->bytesReceived > 0.0)
+	{
+		isprintf(buf, sizeof buf, "%.3f",
+				(cpu * 1000.0) / bench->bytesReceived);
+		PUTMEMO("ltpbenchr CPU per byte (nsec)", buf);
+	}
+}
+
+#if defined (VXWORKS) || defined (RTEMS)
+int	ltpbenchr(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	int		clientId = a1;
+	int		sduCount = a2;
+	int		idleLimit = a3;
+#else
+int	main(int argc, char **argv)
+{
+	int		clientId = (argc > 1 ? strtol(argv[1], NULL, 0) : 0);
+	int		sduCount = (argc > 2 ? strtol(argv[2], NULL, 0) : 0);
+	int		idleLimit = (argc > 3 ? strtol(argv[3], NULL, 0) : 0);
+#endif
+	Sdr		sdr;
+	IonAlarm	alarm = { 1, 0, checkIdle, NULL };
+	pthread_t	alarmThread;
+	BenchState	bench;
+	LtpNoticeType	type;
+	LtpSessionId	sessionId;
+	unsigned char	reasonCode;
+	unsigned char	endOfBlock;
+	unsigned int	dataOffset;
+	unsigned int	dataLength;
+	Object		data;
+	struct timeval	arrivalTime;
+	int		sessionsCanceled = 0;
+	unsigned long	startXnCount = 0;
+	double		startCpu = 0.0;
+	double		cpu;
+
+	if (clientId < 1 || sduCount < 1)
+	{
+		PUTS("Usage: ltpbenchr <client ID> <number of SDUs> \
+[<idle limit, in seconds>]");
+		PUTS("  Idle limit defaults to 10 seconds.");
+		PUTS("");
+		PUTS("  Expected source (sending) application is ltpbenchs.");
+		return 0;
+	}
+
+	oK(_clientId(&clientId));
+	if (idleLimit > 0)
+	{
+		oK(_idleLimit(&idleLimit));
+	}
+
+	memset((char *) &bench, 0, sizeof(BenchState));
+	bench.sdusExpected = sduCount;
+	bench.latencies = (double *) malloc(sduCount * sizeof(double));
+	if (bench.latencies == NULL)
+	{
+		putErrmsg("ltpbenchr can't allocate latency table.",
+				itoa(sduCount));
+		return 1;
+	}
+
+	if (ltp_attach() < 0)
+	{
+		putErrmsg("ltpbenchr can't initialize LTP.", NULL);
+		free(bench.latencies);
+		return 1;
+	}
+
+	if (ltp_open(_clientId(NULL)) < 0)
+	{
+		putErrmsg("ltpbenchr can't open client access.",
+				itoa(_clientId(NULL)));
+		free(bench.latencies);
+		return 1;
+	}
+
+	sdr = getIonsdr();
+	isignal(SIGINT, handleQuit);
+	ionSetAlarm(&alarm, &alarmThread);
+	while (_running(NULL) && bench.sdusReceived < bench.sdusExpected)
+	{
+		if (ltp_get_notice(_clientId(NULL), &type, &sessionId,
+				&reasonCode, &endOfBlock, &dataOffset,
+				&dataLength, &data) < 0)
+		{
+			putErrmsg("Can't get LTP notice.", NULL);
+			break;
+		}
+
+		getCurrentTime(&arrivalTime);
+
+		/*	Transaction and CPU overhead are measured
+		 *	from the start of reception.			*/
+
+		if (bench.sdusReceived == 0 && bench.bytesReceived == 0.0)
+		{
+			startXnCount = sdr_xn_count(sdr);
+			startCpu = cpuUsec();
+		}
+
+		switch (type)
+		{
+		case LtpImportSessionCanceled:
+			sessionsCanceled++;
+			break;
+
+		case LtpRecvGreenSegment:
+			oK(_secondsIdle(0));
+
+			/*	The green segment at offset zero is
+			 *	the start of an all-green block; the
+			 *	green part of a mixed block starts
+			 *	after its red part.			*/
+
+			if (dataOffset == 0)
+			{
+				bench.blocksReceived++;
+			}
+
+			oK(handleGreenSegment(&bench, data, dataOffset,
+					dataLength, &arrivalTime));
+			bench.lastArrivalTime = arrivalTime;
+			break;
+
+		case LtpRecvRedPart:
+			oK(_secondsIdle(0));
+			bench.blocksReceived++;
+			oK(handleRedPart(&bench, data, dataLength,
+					&arrivalTime));
+			bench.lastArrivalTime = arrivalTime;
+			break;
+
+		default:
+			break;
+		}
+
+		if (data)
+		{
+			ltp_release_data(data);
+		}
+	}
+
+	ionCancelAlarm(alarmThread);
+	cpu = cpuUsec();
+	if (cpu >= 0.0 && startCpu >= 0.0)
+	{
+		cpu -= startCpu;
+	}
+	else
+	{
+		cpu = -1.0;
+	}
+
+	writeErrmsgMemos();
+	printResults(&bench, sdr_xn_count(sdr) - startXnCount, cpu,
+			sessionsCanceled);
+	fflush(stdout);
+	free(bench.latencies);
+	ltp_close(_clientId(NULL));
+	ltp_detach();
+	return (bench.sdusReceived < bench.sdusExpected ? 1 : 0);
+}
@@ -0,0 +1,417 @@
+/*
+	ltpbenchs.c:	sender for LTP engine benchmark.  Sends a
+			number of service data units of fixed length
+			to a remote ltpbenchr, waits for all of the
+			resulting export sessions to be completed or
+			canceled, and prints performance statistics.
+
+			The first 16 bytes of each service data unit
+			are a header comprising four 32-bit unsigned
+			integers in network byte order: the number of
+			the service data unit (counting from 1), its
+			total length including the header, and the
+			seconds and microseconds of the time at which
+			it was passed to ltp_send.  This enables
+			ltpbenchr to compute per-block latency, since
+			both engines run on the same computer.
+									*/
+/*									*/
+/*	Copyright (c) 2026, California Institute of Technology.		*/
+/*	All rights reserved.						*/
+/*									*/
+
+#include "platform.h"
+#include "zco.h"
+#include "ltpP.h"
+
+#define	LTPBENCH_HDR_LEN	(16)
+#define	LTPBENCH_IDLE_LIMIT	(30)
+
+static int	_running(int *newState)
+{
+	static int	state = 1;
+
+	if (newState)
+	{
+		state = *newState;
+	}
+
+	return state;
+}
+
+static int	_clientId(int *newId)
+{
+	static int	id = 0;
+
+	if (newId)
+	{
+		id = *newId;
+	}
+
+	return id;
+}
+
+static int	_secondsIdle(int increment)
+{
+	static int	count = 0;
+
+	if (increment)
+	{
+		count += increment;
+	}
+	else
+	{
+		count = 0;
+	}
+
+	return count;
+}
+
+static void	handleQuit()
+{
+	int	stop = 0;
+
+	oK(_running(&stop));
+	ltp_interrupt(_clientId(NULL));
+}
+
+static int	checkIdle(void *userData)
+{
+	/*	Stop waiting for export session completion if no
+	 *	notice has been received for LTPBENCH_IDLE_LIMIT
+	 *	seconds, e.g., because loss was so heavy that some
+	 *	sessions are still retransmitting.			*/
+
+	if (_secondsIdle(1) > LTPBENCH_IDLE_LIMIT)
+	{
+		handleQuit();
+	}
+
+	return 0;
+}
+
+static double	elapsedUsec(struct timeval *from, struct timeval *to)
+{
+	return ((to->tv_sec - from->tv_sec) * 1000000.0)
+			+ (to->tv_usec - from->tv_usec);
+}
+
+static double	cpuUsec()
+{
+#if defined (VXWORKS) || defined (RTEMS) || defined (mingw)
+	return -1.0;
+#else
+	struct rusage	usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) < 0)
+	{
+		return -1.0;
+	}
+
+	return ((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000.0)
+			+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+static void	encodeHeader(unsigned char *hdr, unsigned int sduNbr,
+			unsigned int sduLength, struct timeval *sendTime)
+{
+	unsigned int	fields[4];
+	int		i;
+
+	fields[0] = htonl(sduNbr);
+	fields[1] = htonl(sduLength);
+	fields[2] = htonl((unsigned int) sendTime->tv_sec);
+	fields[3] = htonl((unsigned int) sendTime->tv_usec);
+	for (i = 0; i < 4; i++)
+	{
+		memcpy(hdr + (i * 4), (char *) (fields + i), 4);
+	}
+}
+
+static int	run_ltpbenchs(uvast destEngineId, int clientId,
+			int sduCount, int sduLength, int greenPercent)
+{
+	static char	buffer[4096];
+	Sdr		sdr;
+	int		aduFile;
+	int		bytesRemaining;
+	int		bytesToWrite;
+	Object		fileRef;
+	Object		zco;
+	unsigned char	hdr[LTPBENCH_HDR_LEN];
+	unsigned int	redLength;
+	LtpSessionId	sessionId;
+	IonAlarm	alarm = { 1, 0, checkIdle, NULL };
+	pthread_t	alarmThread;
+	LtpNoticeType	type;
+	unsigned char	reasonCode;
+	unsigned char	endOfBlock;
+	unsigned int	dataOffset;
+	unsigned int	dataLength;
+	Object		data;
+	int		sdusSent = 0;
+	int		sdusCompleted = 0;
+	int		sdusCanceled = 0;
+	double		bytesSent = 0.0;
+	unsigned long	startXnCount;
+	double		startCpu;
+	struct timeval	startTime;
+	struct timeval	sendEndTime;
+	struct timeval	endTime;
+	struct timeval	sendTime;
+	double		usec;
+	double		cpu;
+	char		buf[128];
+
+	if (destEngineId == 0 || clientId < 1 || sduCount < 1
+	|| sduLength <= LTPBENCH_HDR_LEN
+	|| greenPercent < 0 || greenPercent > 100)
+	{
+		PUTS("Usage: ltpbenchs <destination engine ID> <client ID> \
+<number of SDUs> <SDU length> [<green percentage>]");
+		PUTS("  SDU length must exceed 16 bytes.");
+		PUTS("  Green percentage defaults to 0 (all red).");
+		PUTS("");
+		PUTS("  Expected destination (receiving) application is");
+		PUTS("  ltpbenchr.");
+		return 0;
+	}
+
+	oK(_clientId(&clientId));
+	if (ltp_attach() < 0)
+	{
+		putErrmsg("ltpbenchs can't initialize LTP.", NULL);
+		return 1;
+	}
+
+	/*	Open the client service so that the completion (or
+	 *	cancellation) of every export session is reported.	*/
+
+	if (ltp_open(clientId) < 0)
+	{
+		putErrmsg("ltpbenchs can't open client access.",
+				itoa(clientId));
+		return 1;
+	}
+
+	sdr = getIonsdr();
+	aduFile = iopen("ltpbenchsSduFile", O_WRONLY | O_CREAT | O_TRUNC,
+			0666);
+	if (aduFile < 0)
+	{
+		putSysErrmsg("Can't create SDU file", NULL);
+		ltp_close(clientId);
+		return 1;
+	}
+
+	memset(buffer, 'x', sizeof buffer);
+	bytesRemaining = sduLength - LTPBENCH_HDR_LEN;
+	while (bytesRemaining > 0)
+	{
+		bytesToWrite = bytesRemaining;
+		if (bytesToWrite > sizeof buffer)
+		{
+			bytesToWrite = sizeof buffer;
+		}
+
+		if (write(aduFile, buffer, bytesToWrite) < 0)
+		{
+			close(aduFile);
+			putSysErrmsg("Error writing to SDU file", NULL);
+			ltp_close(clientId);
+			return 1;
+		}
+
+		bytesRemaining -= bytesToWrite;
+	}
+
+	close(aduFile);
+	CHKZERO(sdr_begin_xn(sdr));
+	fileRef = zco_create_file_ref(sdr, "ltpbenchsSduFile", NULL);
+	if (sdr_end_xn(sdr) < 0 || fileRef == 0)
+	{
+		putErrmsg("ltpbenchs can't create file ref.", NULL);
+		ltp_close(clientId);
+		return 1;
+	}
+
+	redLength = sduLength - ((sduLength / 100) * greenPercent);
+	if (greenPercent == 100)
+	{
+		redLength = 0;
+	}
+
+	isignal(SIGINT, handleQuit);
+	startXnCount = sdr_xn_count(sdr);
+	startCpu = cpuUsec();
+	getCurrentTime(&startTime);
+	while (_running(NULL) && sdusSent < sduCount)
+	{
+		zco = ionCreateZco(ZcoFileSource, fileRef, 0,
+				sduLength - LTPBENCH_HDR_LEN, NULL);
+		if (zco == 0)
+		{
+			putErrmsg("ltpbenchs can't create ZCO.", NULL);
+			break;
+		}
+
+		getCurrentTime(&sendTime);
+		encodeHeader(hdr, sdusSent + 1, sduLength, &sendTime);
+		CHKZERO(sdr_begin_xn(sdr));
+		oK(zco_prepend_header(sdr, zco, (char *) hdr,
+				LTPBENCH_HDR_LEN));
+		oK(zco_bond(sdr, zco));
+		if (sdr_end_xn(sdr) < 0)
+		{
+			putErrmsg("ltpbenchs can't prepend header.", NULL);
+			break;
+		}
+
+		switch (ltp_send(destEngineId, clientId, zco, redLength,
+				&sessionId))
+		{
+		case 0:
+			putErrmsg("ltpbenchs can't send SDU.",
+					itoa(sduLength));
+			handleQuit();
+			continue;
+
+		case -1:
+			putErrmsg("ltp_send failed.", NULL);
+			handleQuit();
+			continue;
+		}
+
+		sdusSent++;
+		bytesSent += sduLength;
+	}
+
+	getCurrentTime(&sendEndTime);
+
+	/*	Now collect all export session completion notices.	*/
+
+	ionSetAlarm(&alarm, &alarmThread);
+	while (_running(NULL) && sdusCompleted + sdusCanceled < sdusSent)
+	{
+		if (ltp_get_notice(clientId, &type, &sessionId, &reasonCode,
+				&endOfBlock, &dataOffset, &dataLength, &data)
+				< 0)
+		{
+			putErrmsg("Can't get LTP notice.", NULL);
+			break;
+		}
+
+		oK(_secondsIdle(0));
+		switch (type)
+		{
+		case LtpExportSessionComplete:
+			sdusCompleted++;
+			break;
+
+		case LtpExportSessionCanceled:
+			sdusCanceled++;
+			break;
+
+		default:
+			break;
+		}
+
+		if (data)
+		{
+			ltp_release_data(data);
+		}
+	}
+
+	getCurrentTime(&endTime);
+	ionCancelAlarm(alarmThread);
+	writeErrmsgMemos();
+	PUTMEMO("SDUs sent", itoa(sdusSent));
+	PUTMEMO("SDU length (bytes)", itoa(sduLength));
+	PUTMEMO("Red length (bytes)", itoa(redLength));
+	PUTMEMO("SDUs completed", itoa(sdusCompleted));
+	PUTMEMO("SDUs canceled", itoa(sdusCanceled));
+	usec = elapsedUsec(&startTime, &sendEndTime);
+	isprintf(buf, sizeof buf, "%.3f", usec / 1000000.0);
+	PUTMEMO("Send time (seconds)", buf);
+	if (usec > 0.0)
+	{
+		isprintf(buf, sizeof buf, "%.3f", (bytesSent * 8.0) / usec);
+		PUTMEMO("Offered load (Mbps)", buf);
+	}
+
+	usec = elapsedUsec(&startTime, &endTime);
+	isprintf(buf, sizeof buf, "%.3f", usec / 1000000.0);
+	PUTMEMO("Time to complete (seconds)", buf);
+	if (sdusSent > 0)
+	{
+		isprintf(buf, sizeof buf, "%.2f",
+				((double) (sdr_xn_count(sdr) - startXnCount))
+				/ sdusSent);
+		PUTMEMO("SDR transactions per SDU (sender)", buf);
+	}
+
+	cpu = cpuUsec();
+	if (startCpu >= 0.0 && cpu >= 0.0 && bytesSent > 0.0)
+	{
+		isprintf(buf, sizeof buf, "%.3f",
+				((cpu - startCpu) * 1000.0) / bytesSent);
+		PUTMEMO("ltpbenchs CPU per byte (nsec)", buf);
+	}
+
+	fflush(stdout);
+	CHKZERO(sdr_begin_xn(sdr));
+	zco_destroy_file_ref(sdr, fileRef);
+	if (sdr_end_xn(sdr) < 0)
+	{
+		putErrmsg("ltpbenchs can't destroy file reference.", NULL);
+	}
+
+	ltp_close(clientId);
+	ltp_detach();
+	return 0;
+}
+
+#if defined (VXWORKS) || defined (RTEMS)
+int	ltpbenchs(int a1, int a2, int a3, int a4, int a5,
+		int a6, int a7, int a8, int a9, int a10)
+{
+	uvast		destEngineId = (uvast) a1;
+	int		clientId = a2;
+	int		sduCount = a3;
+	int		sduLength = a4;
+	int		greenPercent = a5;
+#else
+int	main(int argc, char **argv)
+{
+	uvast		destEngineId = 0;
+	int		clientId = 0;
+	int		sduCount = 0;
+	int		sduLength = 0;
+	int		greenPercent = 0;
+
+	if (argc > 6) argc = 6;
+	switch (argc)
+	{
+	case 6:
+		greenPercent = strtol(argv[5], NULL, 0);
+
+	case 5:
+		sduLength = strtol(argv[4], NULL, 0);
+
+	case 4:
+		sduCount = strtol(argv[3], NULL, 0);
+
+	case 3:
+		clientId = strtol(argv[2], NULL, 0);
+
+	case 2:
+		destEngineId = strtouvast(argv[1]);
+
+	default:
+		break;
+	}
+#endif
+	return run_ltpbenchs(destEngineId, clientId, sduCount, sduLength,
+			greenPercent);
+}
@@ -33,6 +33,20 @@
 
 #endif
 
+/*	Except on platforms that lack the I/O ring functions, segments
+ *	are dequeued directly into the buffers of an I/O ring and sent
+ *	from there asynchronously, so that up to UDPLSO_RING_DEPTH
+ *	segments may be in flight while the next segment is being
+ *	dequeued.							*/
+
+#if !defined (mingw) && !defined (VXWORKS)
+#define	UDPLSO_RING
+
+#ifndef UDPLSO_RING_DEPTH
+#define	UDPLSO_RING_DEPTH	(32)
+#endif
+#endif
+
 static sm_SemId		udplsoSemaphore(sm_SemId *semid)
 {
 	static sm_SemId	semaphore = -1;
@@ -156,6 +170,114 @@ nbytes=%d, rv=%d, errno=%d", (char *) inet_ntoa(saddr->sin_addr),
 	}
 }
 
+#ifdef UDPLSO_RING
+
+typedef struct
+{
+	IoRing		ring;
+	int		freeBuffers[UDPLSO_RING_DEPTH];
+	int		freeCount;
+	int		bufferNbr;	/*	Being filled, or -1.	*/
+} SendRing;
+
+static int	reapSegmentSends(SendRing *sr, int minCompletions,
+			struct sockaddr_in *destAddr)
+{
+	IoCompletion	completions[UDPLSO_RING_DEPTH];
+	int		count;
+	int		failures = 0;
+	int		i;
+	char		memoBuf[1000];
+
+	/*	Returns the number of failed transmissions reaped, or
+	 *	-1 on any system error.					*/
+
+	count = ioRingReap(sr->ring, completions, UDPLSO_RING_DEPTH,
+			minCompletions);
+	if (count < 0)
+	{
+		putErrmsg("udplso can't reap segment transmissions.", NULL);
+		return -1;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		sr->freeBuffers[sr->freeCount] =
+				(int) (unsigned long) (completions[i].userData);
+		sr->freeCount++;
+		if (completions[i].result < 0)
+		{
+			isprintf(memoBuf, sizeof(memoBuf),
+				"udplso sendmsg() error, dest=[%s:%d], \
+errno=%d", (char *) inet_ntoa(destAddr->sin_addr),
+				ntohs(destAddr->sin_port),
+				-(completions[i].result));
+			writeMemo(memoBuf);
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+static int	dequeueSegmentToRing(SendRing *sr, LtpVspan *vspan,
+			struct sockaddr_in *destAddr)
+{
+	/*	Returns the length of the segment dequeued into a free
+	 *	buffer of the ring, 0 if interrupted, -1 on any error
+	 *	or if any prior transmission has failed.		*/
+
+	if (sr->bufferNbr < 0)
+	{
+		while (sr->freeCount == 0)
+		{
+			if (reapSegmentSends(sr, 1, destAddr) != 0)
+			{
+				return -1;
+			}
+		}
+
+		sr->freeCount--;
+		sr->bufferNbr = sr->freeBuffers[sr->freeCount];
+	}
+
+	return ltpDequeueOutboundSegmentInto(vspan,
+			ioRingBuffer(sr->ring, sr->bufferNbr), UDPLSA_BUFSZ);
+}
+
+static int	sendSegmentByRing(SendRing *sr, int linkSocket, int length,
+			struct sockaddr_in *destAddr)
+{
+	char	*buffer = ioRingBuffer(sr->ring, sr->bufferNbr);
+
+	/*	Returns length if the segment in the buffer being
+	 *	filled was queued and no prior transmission has
+	 *	failed, -1 otherwise.					*/
+
+	if (ioRingSend(sr->ring, linkSocket, buffer, length,
+			(struct sockaddr *) destAddr, sizeof(struct sockaddr),
+			(void *) ((unsigned long) (sr->bufferNbr))) < 1
+	|| ioRingSubmit(sr->ring) < 0)
+	{
+		putErrmsg("udplso can't queue segment transmission.", NULL);
+		return -1;
+	}
+
+	sr->bufferNbr = -1;
+
+	/*	Recover the buffers of segments that have been sent,
+	 *	without waiting for any others.				*/
+
+	if (reapSegmentSends(sr, 0, destAddr) != 0)
+	{
+		return -1;
+	}
+
+	return length;
+}
+
+#endif	/*	UDPLSO_RING						*/
+
 #if defined (VXWORKS) || defined (RTEMS) || defined (bionic)
 int	udplso(int a1, int a2, int a3, int a4, int a5,
 	       int a6, int a7, int a8, int a9, int a10)
@@ -186,13 +308,19 @@ int	main(int argc, char *argv[])
 	ReceiverThreadParms	rtp;
 	pthread_t		receiverThread;
 	int			segmentLength;
+#ifndef UDPLSO_RING
 	char			*segment;
+#endif
 	int			bytesSent;
 	float			sleepSecPerBit = 0;
 	float			sleep_secs;
 	unsigned int		usecs;
 	int			fd;
 	char			quit = '\0';
+#ifdef UDPLSO_RING
+	SendRing		sendRing;
+	int			i;
+#endif
 
 	if( txbps != 0 && remoteEngineId == 0 )
 	{
@@ -297,6 +425,25 @@ int	main(int argc, char *argv[])
 		return 1;
 	}
 
+#ifdef UDPLSO_RING
+	sendRing.ring = ioRingCreate(UDPLSO_RING_DEPTH, UDPLSO_RING_DEPTH,
+			UDPLSA_BUFSZ);
+	if (sendRing.ring == NULL)
+	{
+		closesocket(rtp.linkSocket);
+		putErrmsg("udplso can't create I/O ring.", NULL);
+		return 1;
+	}
+
+	for (i = 0; i < UDPLSO_RING_DEPTH; i++)
+	{
+		sendRing.freeBuffers[i] = i;
+	}
+
+	sendRing.freeCount = UDPLSO_RING_DEPTH;
+	sendRing.bufferNbr = -1;
+#endif
+
 	/*	Set up signal handling.  SIGTERM is shutdown signal.	*/
 
 	oK(udplsoSemaphore(&(vspan->segSemaphore)));
@@ -308,6 +455,9 @@ int	main(int argc, char *argv[])
 	if (pthread_begin(&receiverThread, NULL, handleDatagrams, &rtp))
 	{
 		closesocket(rtp.linkSocket);
+#ifdef UDPLSO_RING
+		ioRingDestroy(sendRing.ring);
+#endif
 		putSysErrmsg("udplsi can't create receiver thread", NULL);
 		return 1;
 	}
@@ -331,7 +481,12 @@ int	main(int argc, char *argv[])
 
 	while (rtp.running && !(sm_SemEnded(vspan->segSemaphore)))
 	{
+#ifdef UDPLSO_RING
+		segmentLength = dequeueSegmentToRing(&sendRing, vspan,
+				peerInetName);
+#else
 		segmentLength = ltpDequeueOutboundSegment(vspan, &segment);
+#endif
 		if (segmentLength < 0)
 		{
 			rtp.running = 0;	/*	Terminate LSO.	*/
@@ -351,8 +506,13 @@ int	main(int argc, char *argv[])
 		}
 		else
 		{
+#ifdef UDPLSO_RING
+			bytesSent = sendSegmentByRing(&sendRing, rtp.linkSocket,
+					segmentLength, peerInetName);
+#else
 			bytesSent = sendSegmentByUDP(rtp.linkSocket, segment,
 					segmentLength, peerInetName);
+#endif
 			if (bytesSent < segmentLength)
 			{
 				rtp.running = 0;/*	Terminate LSO.	*/
@@ -377,6 +537,21 @@ int	main(int argc, char *argv[])
 		sm_TaskYield();
 	}
 
+#ifdef UDPLSO_RING
+	/*	Let all segments still in flight be sent.		*/
+
+	while (ioRingInFlight(sendRing.ring) > 0)
+	{
+		if (reapSegmentSends(&sendRing, ioRingInFlight(sendRing.ring),
+				peerInetName) < 0)
+		{
+			break;
+		}
+	}
+
+	ioRingDestroy(sendRing.ring);
+#endif
+
 	/*	Create one-use socket for the closing quit byte.	*/
 
 	portNbr = bindInetName->sin_port;	/*	From binding.	*/
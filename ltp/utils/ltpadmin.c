@@ -331,6 +331,9 @@ latency: %u  purge: %d", span->maxSegmentSize, span->remoteQtime, span->purge);
 	isprintf(buffer, sizeof buffer, "\towltOutbound: %u  localXmit: %u  \
 owltInbound: %u  remoteXmit: %u", vspan->owltOutbound, vspan->localXmitRate,
 			vspan->owltInbound, vspan->remoteXmitRate);
+	printText(buffer);
+	isprintf(buffer, sizeof buffer, "\tsmoothed RTT (usec): %u  RTT \
+variance: %u  samples: %u", vspan->srtt, vspan->rttvar, vspan->rttSamples);
 	sdr_exit_xn(sdr);
 	printText(buffer);
 }
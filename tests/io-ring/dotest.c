@@ -0,0 +1,392 @@
+/*
+	io-ring/dotest.c:	Test of the asynchronous I/O ring.
+
+	Sends batches of datagrams of several sizes over a UDP
+	socket through an I/O ring, checking that the ring refuses
+	requests beyond its depth, that every request submitted
+	is reaped exactly once with its user data and byte count,
+	that a failed send is reaped with the negated errno, and
+	that every datagram arrives intact.  Then receives a batch
+	of datagrams through the ring, and writes and reads back a
+	file through it, half of the blocks in the ring's own
+	(registered) buffers and half elsewhere.  Does so once with
+	whatever ring the kernel supports and once with a ring
+	that can't be an io_uring, because the process has no
+	file descriptor to spare when the ring is created, so that
+	the synchronous fallback is tested wherever io_uring is
+	available.
+									*/
+
+#include <platform.h>
+#include <sys/resource.h>
+#include "check.h"
+
+#define	RING_DEPTH	(8)
+#define	BUFFER_LEN	(1500)
+#define	ROUNDS		(3)
+
+static int	datagramLength(int round, int bufferNbr)
+{
+	return 1 + (((round * RING_DEPTH) + bufferNbr) * 97) % BUFFER_LEN;
+}
+
+static void	fillDatagram(char *buffer, int length, int round,
+			int bufferNbr)
+{
+	int	i;
+
+	for (i = 0; i < length; i++)
+	{
+		buffer[i] = (char) (round + bufferNbr + i);
+	}
+
+	buffer[0] = (char) bufferNbr;
+}
+
+static IoRing	createRing(int sock, int starveFds)
+{
+	struct rlimit	limit;
+	struct rlimit	starved;
+	int		fd;
+	IoRing		ring;
+
+	if (!starveFds)
+	{
+		return ioRingCreate(RING_DEPTH, RING_DEPTH, BUFFER_LEN);
+	}
+
+	/*	dup() returns the lowest free descriptor, so every
+	 *	descriptor below it is in use.  With the descriptor
+	 *	limit lowered to that number, io_uring_setup() fails
+	 *	and the ring must fall back to synchronous requests.	*/
+
+	fd = dup(sock);
+	fail_unless(fd >= 0);
+	close(fd);
+	fail_unless(getrlimit(RLIMIT_NOFILE, &limit) == 0);
+	starved = limit;
+	starved.rlim_cur = fd;
+	fail_unless(setrlimit(RLIMIT_NOFILE, &starved) == 0);
+	ring = ioRingCreate(RING_DEPTH, RING_DEPTH, BUFFER_LEN);
+	fail_unless(setrlimit(RLIMIT_NOFILE, &limit) == 0);
+	return ring;
+}
+
+static void	reapAll(IoRing ring, int expected, IoCompletion *completions)
+{
+	int	count = 0;
+	int	reaped;
+
+	while (count < expected)
+	{
+		reaped = ioRingReap(ring, completions + count,
+				RING_DEPTH - count, expected - count);
+		fail_unless(reaped >= 0);
+		if (reaped < 0)
+		{
+			break;
+		}
+
+		count += reaped;
+	}
+
+	fail_unless(count == expected);
+	fail_unless(ioRingInFlight(ring) == 0);
+}
+
+static void	checkRound(IoRing ring, int sendSock, int recvSock,
+			struct sockaddr *destName, socklen_t destNameLength,
+			int round)
+{
+	IoCompletion	completions[RING_DEPTH];
+	int		reaped[RING_DEPTH];
+	char		spare[1];
+	char		expected[BUFFER_LEN];
+	char		received[BUFFER_LEN];
+	int		bufferNbr;
+	int		length;
+	int		i;
+
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		length = datagramLength(round, i);
+		fillDatagram(ioRingBuffer(ring, i), length, round, i);
+		fail_unless(ioRingSend(ring, sendSock, ioRingBuffer(ring, i),
+				length, destName, destNameLength,
+				(void *) ((unsigned long) i)) == 1);
+	}
+
+	/*	Every request slot is now taken.			*/
+
+	fail_unless(ioRingSend(ring, sendSock, spare, sizeof spare,
+			destName, destNameLength, NULL) == 0);
+	fail_unless(ioRingInFlight(ring) == RING_DEPTH);
+	fail_unless(ioRingSubmit(ring) == RING_DEPTH);
+	fail_unless(ioRingSubmit(ring) == 0);
+	reapAll(ring, RING_DEPTH, completions);
+	memset((char *) reaped, 0, sizeof reaped);
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		bufferNbr = (int) (unsigned long) (completions[i].userData);
+		fail_unless(bufferNbr >= 0 && bufferNbr < RING_DEPTH);
+		if (bufferNbr < 0 || bufferNbr >= RING_DEPTH)
+		{
+			continue;
+		}
+
+		reaped[bufferNbr]++;
+		fail_unless(completions[i].result
+				== datagramLength(round, bufferNbr),
+				"round %d, buffer %d, result %d", round,
+				bufferNbr, completions[i].result);
+	}
+
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		fail_unless(reaped[i] == 1, "buffer %d reaped %d times", i,
+				reaped[i]);
+	}
+
+	/*	The datagrams may have been sent in any order.		*/
+
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		length = recv(recvSock, received, sizeof received, 0);
+		fail_unless(length > 0);
+		if (length <= 0)
+		{
+			break;
+		}
+
+		bufferNbr = received[0];
+		fail_unless(bufferNbr >= 0 && bufferNbr < RING_DEPTH);
+		if (bufferNbr < 0 || bufferNbr >= RING_DEPTH)
+		{
+			continue;
+		}
+
+		fail_unless(length == datagramLength(round, bufferNbr));
+		fillDatagram(expected, length, round, bufferNbr);
+		fail_unless(memcmp(received, expected, length) == 0,
+				"round %d, datagram %d", round, bufferNbr);
+	}
+}
+
+static void	checkRecv(IoRing ring, int sendSock, int recvSock,
+			struct sockaddr *destName, socklen_t destNameLength)
+{
+	IoCompletion	completions[RING_DEPTH];
+	char		expected[BUFFER_LEN];
+	char		*buffer;
+	int		bufferNbr;
+	int		length;
+	int		i;
+
+	/*	Send first, so that a synchronous ring's blocking
+	 *	receives are satisfied when they are submitted.		*/
+
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		length = datagramLength(ROUNDS, i);
+		fillDatagram(expected, length, ROUNDS, i);
+		fail_unless(sendto(sendSock, expected, length, 0, destName,
+				destNameLength) == length);
+	}
+
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		fail_unless(ioRingRecv(ring, recvSock, ioRingBuffer(ring, i),
+				BUFFER_LEN, (void *) ((unsigned long) i)) == 1);
+	}
+
+	fail_unless(ioRingSubmit(ring) == RING_DEPTH);
+	reapAll(ring, RING_DEPTH, completions);
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		length = completions[i].result;
+		fail_unless(length > 0, "result %d", length);
+		if (length <= 0)
+		{
+			continue;
+		}
+
+		/*	The datagram received into a buffer identifies
+		 *	itself; it needn't be the buffer's own.		*/
+
+		bufferNbr = (int) (unsigned long) (completions[i].userData);
+		buffer = ioRingBuffer(ring, bufferNbr);
+		bufferNbr = buffer[0];
+		fail_unless(bufferNbr >= 0 && bufferNbr < RING_DEPTH);
+		if (bufferNbr < 0 || bufferNbr >= RING_DEPTH)
+		{
+			continue;
+		}
+
+		fail_unless(length == datagramLength(ROUNDS, bufferNbr));
+		fillDatagram(expected, length, ROUNDS, bufferNbr);
+		fail_unless(memcmp(buffer, expected, length) == 0,
+				"received datagram %d", bufferNbr);
+	}
+}
+
+static void	checkBlocks(IoRing ring, IoCompletion *completions)
+{
+	int	reaped[RING_DEPTH];
+	int	blockNbr;
+	int	i;
+
+	reapAll(ring, RING_DEPTH, completions);
+	memset((char *) reaped, 0, sizeof reaped);
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		blockNbr = (int) (unsigned long) (completions[i].userData);
+		fail_unless(blockNbr >= 0 && blockNbr < RING_DEPTH);
+		if (blockNbr < 0 || blockNbr >= RING_DEPTH)
+		{
+			continue;
+		}
+
+		reaped[blockNbr]++;
+		fail_unless(completions[i].result == BUFFER_LEN,
+				"block %d, result %d", blockNbr,
+				completions[i].result);
+	}
+
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		fail_unless(reaped[i] == 1, "block %d reaped %d times", i,
+				reaped[i]);
+	}
+}
+
+static void	checkFile(IoRing ring)
+{
+	char		fileName[] = "/tmp/io-ring.XXXXXX";
+	int		fd;
+	IoCompletion	completions[RING_DEPTH];
+	static char	blocks[RING_DEPTH][BUFFER_LEN];
+	char		expected[BUFFER_LEN];
+	char		*buffer;
+	int		i;
+
+	fd = mkstemp(fileName);
+	fail_unless(fd >= 0);
+	if (fd < 0)
+	{
+		return;
+	}
+
+	unlink(fileName);
+
+	/*	Even-numbered blocks are written from the ring's own
+	 *	buffers, odd-numbered blocks from elsewhere.		*/
+
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		buffer = (i % 2) ? blocks[i] : ioRingBuffer(ring, i);
+		fillDatagram(buffer, BUFFER_LEN, ROUNDS + 1, i);
+		fail_unless(ioRingWrite(ring, fd, buffer, BUFFER_LEN,
+				(vast) i * BUFFER_LEN,
+				(void *) ((unsigned long) i)) == 1);
+	}
+
+	fail_unless(ioRingSubmit(ring) == RING_DEPTH);
+	checkBlocks(ring, completions);
+
+	/*	Read each block back into the other kind of buffer.	*/
+
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		buffer = (i % 2) ? ioRingBuffer(ring, i) : blocks[i];
+		memset(buffer, 0, BUFFER_LEN);
+		fail_unless(ioRingRead(ring, fd, buffer, BUFFER_LEN,
+				(vast) i * BUFFER_LEN,
+				(void *) ((unsigned long) i)) == 1);
+	}
+
+	fail_unless(ioRingSubmit(ring) == RING_DEPTH);
+	checkBlocks(ring, completions);
+	for (i = 0; i < RING_DEPTH; i++)
+	{
+		buffer = (i % 2) ? ioRingBuffer(ring, i) : blocks[i];
+		fillDatagram(expected, BUFFER_LEN, ROUNDS + 1, i);
+		fail_unless(memcmp(buffer, expected, BUFFER_LEN) == 0,
+				"file block %d", i);
+	}
+
+	/*	Reading past the end of the file reads nothing.		*/
+
+	fail_unless(ioRingRead(ring, fd, ioRingBuffer(ring, 0), BUFFER_LEN,
+			(vast) RING_DEPTH * BUFFER_LEN, NULL) == 1);
+	fail_unless(ioRingSubmit(ring) == 1);
+	reapAll(ring, 1, completions);
+	fail_unless(completions[0].result == 0, "result %d",
+			completions[0].result);
+	close(fd);
+}
+
+static void	checkRing(int starveFds)
+{
+	int			sendSock;
+	int			recvSock;
+	struct sockaddr_in	recvName;
+	socklen_t		nameLength = sizeof recvName;
+	IoRing			ring;
+	IoCompletion		completion;
+	int			round;
+
+	sendSock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	recvSock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	fail_unless(sendSock >= 0 && recvSock >= 0);
+	memset((char *) &recvName, 0, sizeof recvName);
+	recvName.sin_family = AF_INET;
+	recvName.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	fail_unless(bind(recvSock, (struct sockaddr *) &recvName,
+			sizeof recvName) == 0);
+	fail_unless(getsockname(recvSock, (struct sockaddr *) &recvName,
+			&nameLength) == 0);
+	ring = createRing(sendSock, starveFds);
+	fail_unless(ring != NULL);
+	if (ring == NULL)
+	{
+		close(sendSock);
+		close(recvSock);
+		return;
+	}
+
+	if (starveFds)
+	{
+		fail_unless(ioRingIsAsync(ring) == 0);
+	}
+
+	printf("Testing %s I/O ring.\n", ioRingIsAsync(ring) ?
+			"asynchronous" : "synchronous");
+	for (round = 0; round < ROUNDS; round++)
+	{
+		checkRound(ring, sendSock, recvSock,
+				(struct sockaddr *) &recvName, nameLength,
+				round);
+	}
+
+	/*	With no destination, the send fails.			*/
+
+	fail_unless(ioRingSend(ring, sendSock, ioRingBuffer(ring, 0), 1,
+			NULL, 0, NULL) == 1);
+	fail_unless(ioRingSubmit(ring) == 1);
+	reapAll(ring, 1, &completion);
+	fail_unless(completion.result == -EDESTADDRREQ, "result %d",
+			completion.result);
+	checkRecv(ring, sendSock, recvSock, (struct sockaddr *) &recvName,
+			nameLength);
+	checkFile(ring);
+	ioRingDestroy(ring);
+	close(sendSock);
+	close(recvSock);
+}
+
+int	main(int argc, char **argv)
+{
+	checkRing(0);
+	checkRing(1);
+	CHECK_FINISH;
+}
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+#
+# TCPCL client for the acknowledgment backpressure test.  Connects to
+# the tcpcli at localhost:<port>, asks for segment acknowledgment, and
+# sends a two-byte bundle in <segments> data segments, all but the
+# first and last of them empty, without reading anything for a few
+# seconds, so that tcpcli's acknowledgments fill the connection's
+# socket buffers.  Then reads the contact header and every
+# acknowledgment, checking that each segment was acknowledged in
+# order.  Exits 0 on success, 1 on failure.
+
+import socket
+import struct
+import sys
+import threading
+import time
+
+def sdnv(value):
+    octets = [value & 0x7f]
+    value >>= 7
+    while value:
+        octets.insert(0, 0x80 | (value & 0x7f))
+        value >>= 7
+    return bytes(octets)
+
+def readSdnv(stream):
+    value = 0
+    while True:
+        octet = stream.read(1)
+        if not octet:
+            raise EOFError
+        value = (value << 7) | (octet[0] & 0x7f)
+        if not octet[0] & 0x80:
+            return value
+
+def receive(sock, segments, result):
+    time.sleep(10)
+    stream = sock.makefile("rb")
+    try:
+        header = stream.read(8)
+        if len(header) < 8 or header[:4] != b"dtn!":
+            print("Didn't receive contact header.")
+            return
+        stream.read(readSdnv(stream))
+        for count in range(1, segments + 1):
+            octet = stream.read(1)
+            if not octet:
+                print("Connection closed after %d acks." % (count - 1))
+                return
+            if octet[0] >> 4 != 2:
+                print("Unexpected segment type %d." % (octet[0] >> 4))
+                return
+            acked = readSdnv(stream)
+            if acked != (2 if count == segments else 1):
+                print("Ack %d reports %d bytes." % (count, acked))
+                return
+    except (EOFError, OSError) as e:
+        print("Reception failed: %s" % e)
+        return
+    result.append(segments)
+
+def main():
+    port = int(sys.argv[1])
+    segments = int(sys.argv[2])
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+    sock.connect(("127.0.0.1", port))
+    eid = b"ipn:9.0"
+    sock.sendall(b"dtn!" + bytes([3, 0x01]) + struct.pack("!H", 0)
+            + sdnv(len(eid)) + eid)
+    result = []
+    receiver = threading.Thread(target=receive,
+            args=(sock, segments, result))
+    receiver.start()
+    data = b"\x12\x01\x00" + b"\x10\x00" * (segments - 2) \
+            + b"\x11\x01\x00"
+    try:
+        sock.sendall(data)
+    except OSError as e:
+        print("Sending failed: %s" % e)
+    receiver.join()
+    sock.close()
+    if not result:
+        return 1
+    print("All %d segments acknowledged." % segments)
+    return 0
+
+sys.exit(main())
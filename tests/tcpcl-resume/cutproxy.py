@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+#
+# TCP proxy for the TCPCL resumption test.  Accepts connections on
+# <listen port> and relays each one to <target port> on localhost,
+# except that the first connection is cut off once <cut bytes> bytes
+# have been relayed from client to server.
+
+import socket
+import sys
+import threading
+
+def relay(source, sink, limit):
+    relayed = 0
+    try:
+        while limit is None or relayed < limit:
+            size = 65536
+            if limit is not None:
+                size = min(size, limit - relayed)
+            data = source.recv(size)
+            if not data:
+                break
+            sink.sendall(data)
+            relayed += len(data)
+    except OSError:
+        pass
+    for sock in (source, sink):
+        try:
+            sock.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
+        sock.close()
+
+def main():
+    listenPort = int(sys.argv[1])
+    targetPort = int(sys.argv[2])
+    cutBytes = int(sys.argv[3])
+    listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    listener.bind(("127.0.0.1", listenPort))
+    listener.listen(5)
+    connections = 0
+    while True:
+        client, _ = listener.accept()
+        server = socket.create_connection(("127.0.0.1", targetPort))
+        limit = cutBytes if connections == 0 else None
+        connections += 1
+        if limit is not None:
+            print("Cutting connection after %d bytes." % limit,
+                    flush=True)
+        threading.Thread(target=relay, args=(client, server, limit),
+                daemon=True).start()
+        threading.Thread(target=relay, args=(server, client, None),
+                daemon=True).start()
+
+main()
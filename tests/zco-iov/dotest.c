@@ -0,0 +1,286 @@
+/*
+	zco-iov/dotest.c:	Test of zco_transmit_iov() and
+				zco_receive_iov().
+
+	Builds a ZCO comprising a header capsule, an extent of SDR
+	heap bytes, an extent of file content, another extent of
+	SDR heap bytes, and a trailer capsule.  Gathers the ZCO
+	with zco_transmit_iov(), both in place and by copying,
+	with and without a file extent descriptor, into small
+	buffers and iovec arrays so that every call stops short,
+	and verifies that the gathered bytes are the bytes of the
+	ZCO.  Then delimits source data spanning all three extents
+	and gathers it the same ways with zco_receive_iov().  Then
+	deletes the file and verifies that its content is gathered
+	as fill.
+
+									*/
+
+#include <ion.h>
+#include <zco.h>
+#include "check.h"
+#include "testutil.h"
+
+#define	HEADER_LEN	(16)
+#define	HEAP1_LEN	(3000)
+#define	FILE_OFFSET	(100)
+#define	FILE_LEN	(5000)
+#define	HEAP2_LEN	(2000)
+#define	TRAILER_LEN	(8)
+#define	ZCO_LEN		(HEADER_LEN + HEAP1_LEN + FILE_LEN + HEAP2_LEN \
+				+ TRAILER_LEN)
+#define	SOURCE_OFFSET	(1000)
+#define	SOURCE_LEN	(HEAP1_LEN - SOURCE_OFFSET + FILE_LEN + 500)
+#define	BUFFER_LEN	(1024)
+#define	FILE_NAME	"zco-iov.dat"
+
+static void	fillPattern(char *buffer, int length, int seed)
+{
+	int	i;
+
+	for (i = 0; i < length; i++)
+	{
+		buffer[i] = 'a' + ((i + seed) % 26);
+	}
+}
+
+static Object	buildZco(Sdr sdr, char *expected, char *fileName)
+{
+	char	header[HEADER_LEN];
+	char	heap1[HEAP1_LEN];
+	char	fileBytes[FILE_OFFSET + FILE_LEN];
+	char	heap2[HEAP2_LEN];
+	char	trailer[TRAILER_LEN];
+	int	fd;
+	Object	obj1;
+	Object	obj2;
+	Object	fileRef;
+	Object	zco;
+
+	fillPattern(header, HEADER_LEN, 1);
+	fillPattern(heap1, HEAP1_LEN, 2);
+	fillPattern(fileBytes, FILE_OFFSET + FILE_LEN, 3);
+	fillPattern(heap2, HEAP2_LEN, 4);
+	fillPattern(trailer, TRAILER_LEN, 5);
+	fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	fail_unless(fd >= 0);
+	fail_unless(write(fd, fileBytes, sizeof fileBytes)
+			== sizeof fileBytes);
+	close(fd);
+
+	memcpy(expected, header, HEADER_LEN);
+	expected += HEADER_LEN;
+	memcpy(expected, heap1, HEAP1_LEN);
+	expected += HEAP1_LEN;
+	memcpy(expected, fileBytes + FILE_OFFSET, FILE_LEN);
+	expected += FILE_LEN;
+	memcpy(expected, heap2, HEAP2_LEN);
+	expected += HEAP2_LEN;
+	memcpy(expected, trailer, TRAILER_LEN);
+
+	fail_unless(sdr_begin_xn(sdr));
+	obj1 = sdr_malloc(sdr, HEAP1_LEN);
+	obj2 = sdr_malloc(sdr, HEAP2_LEN);
+	fileRef = zco_create_file_ref(sdr, fileName, NULL);
+	fail_unless(obj1 != 0 && obj2 != 0 && fileRef != 0);
+	sdr_write(sdr, obj1, heap1, HEAP1_LEN);
+	sdr_write(sdr, obj2, heap2, HEAP2_LEN);
+	zco = zco_create(sdr, ZcoSdrSource, obj1, 0, HEAP1_LEN);
+	fail_unless(zco != 0 && zco != (Object) -1);
+	fail_unless(zco_append_extent(sdr, zco, ZcoFileSource, fileRef,
+			FILE_OFFSET, FILE_LEN) == FILE_LEN);
+	fail_unless(zco_append_extent(sdr, zco, ZcoSdrSource, obj2, 0,
+			HEAP2_LEN) == HEAP2_LEN);
+	fail_unless(zco_prepend_header(sdr, zco, header, HEADER_LEN) == 0);
+	fail_unless(zco_append_trailer(sdr, zco, trailer, TRAILER_LEN) == 0);
+	fail_unless(sdr_end_xn(sdr) == 0);
+	return zco;
+}
+
+/*	Gathers "length" bytes into "gathered": the entire ZCO when
+ *	transmitting, its source data when receiving.  Returns the
+ *	number of iovecs that pointed outside the buffer, i.e., into
+ *	the SDR heap.							*/
+
+static int	gatherZco(Sdr sdr, Object zco, int receiving, vast length,
+			int inPlace, int useFileExtent, int iovMax,
+			char *gathered)
+{
+	ZcoReader		reader;
+	struct iovec		iov[8];
+	int			iovCount;
+	char			buffer[BUFFER_LEN];
+	ZcoExtentDescriptor	fileExtent;
+	vast			bytesGathered;
+	vast			totalGathered = 0;
+	int			inHeap = 0;
+	int			offset = 0;
+	int			i;
+
+	if (receiving)
+	{
+		zco_start_receiving(zco, &reader);
+	}
+	else
+	{
+		zco_start_transmitting(zco, &reader);
+	}
+
+	if (inPlace)
+	{
+		zco_gather_in_place(&reader);
+	}
+
+	while (totalGathered < length)
+	{
+		iovCount = iovMax;
+		fail_unless(sdr_begin_xn(sdr));
+		if (receiving)
+		{
+			bytesGathered = zco_receive_iov(sdr, &reader,
+					length - totalGathered, iov,
+					&iovCount, buffer, BUFFER_LEN,
+					useFileExtent ? &fileExtent : NULL);
+		}
+		else
+		{
+			bytesGathered = zco_transmit_iov(sdr, &reader,
+					length - totalGathered, iov,
+					&iovCount, buffer, BUFFER_LEN,
+					useFileExtent ? &fileExtent : NULL);
+		}
+
+		fail_unless(bytesGathered > 0);
+		if (bytesGathered <= 0)
+		{
+			sdr_exit_xn(sdr);
+			break;
+		}
+
+		fail_unless(iovCount >= 0 && iovCount <= iovMax);
+		for (i = 0; i < iovCount; i++)
+		{
+			if ((char *) iov[i].iov_base < buffer
+			|| (char *) iov[i].iov_base >= buffer + BUFFER_LEN)
+			{
+				inHeap++;
+			}
+
+			memcpy(gathered + offset, iov[i].iov_base,
+					iov[i].iov_len);
+			offset += iov[i].iov_len;
+		}
+
+		if (useFileExtent && fileExtent.fd >= 0)
+		{
+			fail_unless(pread(fileExtent.fd, gathered + offset,
+					fileExtent.length, fileExtent.offset)
+					== fileExtent.length);
+			offset += fileExtent.length;
+			close(fileExtent.fd);
+		}
+
+		/*	Bytes in the heap must be used before the
+		 *	transaction ends.				*/
+
+		sdr_exit_xn(sdr);
+		totalGathered += bytesGathered;
+		fail_unless(offset == totalGathered);
+	}
+
+	fail_unless(totalGathered == length);
+	return inHeap;
+}
+
+static void	checkGather(Sdr sdr, Object zco, char *expected, int receiving,
+			int inPlace, int useFileExtent, int iovMax)
+{
+	char	gathered[ZCO_LEN];
+	vast	length = receiving ? SOURCE_LEN : ZCO_LEN;
+	int	inHeap;
+
+	/*	The source data are delimited within the extents,
+	 *	after the header capsule.				*/
+
+	if (receiving)
+	{
+		expected += HEADER_LEN + SOURCE_OFFSET;
+	}
+
+	memset(gathered, 0, ZCO_LEN);
+	inHeap = gatherZco(sdr, zco, receiving, length, inPlace,
+			useFileExtent, iovMax, gathered);
+	fail_unless(memcmp(gathered, expected, length) == 0,
+			"receiving %d, inPlace %d, fileExtent %d, %d iovecs",
+			receiving, inPlace, useFileExtent, iovMax);
+	if (inPlace)
+	{
+		fail_unless(inHeap > 0);
+	}
+	else
+	{
+		fail_unless(inHeap == 0);
+	}
+}
+
+int	main(int argc, char **argv)
+{
+	char	fileName[MAXPATHLEN + 1];
+	char	expected[ZCO_LEN];
+	Sdr	sdr;
+	Object	zco;
+	int	receiving;
+	int	inPlace;
+	int	useFileExtent;
+	int	iovMax;
+
+	_ionadmin("", "config.ionrc");
+	fail_unless(ionAttach() == 0);
+	sdr = getIonsdr();
+	fail_unless(igetcwd(fileName, sizeof fileName) != NULL);
+	istrcat(fileName, "/" FILE_NAME, sizeof fileName);
+	zco = buildZco(sdr, expected, fileName);
+	fail_unless(sdr_begin_xn(sdr));
+	zco_delimit_source(sdr, zco, SOURCE_OFFSET, SOURCE_LEN);
+	fail_unless(sdr_end_xn(sdr) == 0);
+
+	/*	Gather every way there is.				*/
+
+	for (receiving = 0; receiving < 2; receiving++)
+	{
+		for (inPlace = 0; inPlace < 2; inPlace++)
+		{
+			for (useFileExtent = 0; useFileExtent < 2;
+					useFileExtent++)
+			{
+				for (iovMax = 1; iovMax <= 8; iovMax *= 2)
+				{
+					checkGather(sdr, zco, expected,
+							receiving, inPlace,
+							useFileExtent, iovMax);
+				}
+			}
+		}
+	}
+
+	/*	Once the file is gone, its content is fill.		*/
+
+	fail_unless(unlink(fileName) == 0);
+	memset(expected + HEADER_LEN + HEAP1_LEN, ZCO_FILE_FILL_CHAR,
+			FILE_LEN);
+	for (receiving = 0; receiving < 2; receiving++)
+	{
+		for (useFileExtent = 0; useFileExtent < 2; useFileExtent++)
+		{
+			checkGather(sdr, zco, expected, receiving, 0,
+					useFileExtent, 8);
+		}
+	}
+
+	fail_unless(sdr_begin_xn(sdr));
+	zco_destroy(sdr, zco);
+	fail_unless(sdr_end_xn(sdr) == 0);
+	ionDetach();
+	_ionadmin("", ".");
+	CHECK_FINISH;
+}